@@ -12,6 +12,7 @@
 #include "scone/core/Log.h"
 #include "scone/core/version.h"
 #include "scone/optimization/opt_tools.h"
+#include "scone/optimization/DistributedEvaluator.h"
 #include "scone/sconelib_config.h"
 #include "spot/optimizer_pool.h"
 #include "xo/container/prop_node_tools.h"
@@ -20,7 +21,13 @@
 #include "xo/system/log_sink.h"
 #include "xo/system/system_tools.h"
 #include "scone/core/Benchmark.h"
+#include "scone/core/Settings.h"
+#include "scone/core/TraceRecorder.h"
 #include "xo/filesystem/filesystem.h"
+#include "xo/string/string_tools.h"
+
+#include <filesystem>
+#include <fstream>
 
 using scone::PropNode;
 using scone::String;
@@ -44,6 +51,36 @@ PropNode load_scenario( const path& scenario_file, const TCLAP::UnlabeledMultiAr
 	return scenario_pn;
 }
 
+// find .par files in a folder, matching a pattern, or listed in a text file; also returns the folder for the summary
+std::pair< std::vector< path >, path > find_batch_files( const String& arg )
+{
+	auto p = path( arg );
+	auto folder = p.parent_path().empty() ? path( "." ) : p.parent_path();
+	if ( xo::directory_exists( p ) )
+		return { xo::find_files( p, "*.par", true, 1 ), p };
+	else if ( p.extension_no_dot() == "par" )
+		return { xo::find_files( folder, p.filename().str(), false, 0 ), folder };
+
+	// list file with one .par file per line, relative to the list file
+	std::ifstream str( p.str() );
+	SCONE_ERROR_IF( !str.good(), "Could not open " + arg );
+	std::vector< path > files;
+	for ( string line; std::getline( str, line ); )
+	{
+		line.erase( line.find_last_not_of( " \t\r" ) + 1 );
+		if ( !line.empty() && line[ 0 ] != '#' )
+			files.push_back( std::filesystem::path( line ).is_absolute() ? path( line ) : folder / line );
+	}
+	return { files, folder };
+}
+
+// stop recording trace events and write them to file
+void write_trace( const path& file )
+{
+	scone::StopTraceRecording();
+	scone::WriteTraceRecording( file );
+}
+
 // main
 int main(int argc, char* argv[])
 {
@@ -55,15 +92,20 @@ int main(int argc, char* argv[])
 		TCLAP::CmdLine cmd( "SCONE Command Line Utility", ' ', xo::to_str( scone::GetSconeVersion() ), true );
 		TCLAP::ValueArg< String > optArg( "o", "optimize", "Optimize a scenario file", true, "", "*.scone" );
 		TCLAP::ValueArg< String > parArg( "e", "evaluate", "Evaluate a result from an optimization", false, "", "*.par" );
+		TCLAP::ValueArg< String > batchArg( "E", "evaluate-batch", "Evaluate all results in a folder, matching a pattern, or listed in a text file, using multiple threads", false, "", "folder|*.par|*.txt" );
 		TCLAP::ValueArg< String > benchArg( "b", "benchmark", "Benchmark a scenario or parameter file", false, "", "*.scone" );
+		TCLAP::ValueArg< String > resumeArg( "c", "resume", "Resume an optimization from the checkpoint in its output folder", false, "", "folder" );
+		TCLAP::ValueArg< String > workerArg( "w", "worker", "Evaluate for a distributed optimization (optimizer.evaluator = 4) running on host", false, "", "host[:port]" );
 		TCLAP::ValueArg< int > bxArg( "x", "benchmarkx", "Number of benchmarks to perform", false, 8, ">0", cmd );
 		TCLAP::ValueArg< String > outArg( "r", "result", "Output file for evaluation result", false, "", "Output file (*.sto)", cmd );
 		TCLAP::ValueArg< int > logArg( "l", "log", "Set the log level", false, 1, "1-7", cmd );
 		TCLAP::SwitchArg statusOutput( "s", "status", "Output full status updates", cmd, false );
 		TCLAP::SwitchArg quietOutput( "q", "quiet", "Do not output simulation progress", cmd, false );
+		TCLAP::ValueArg< int > threadsArg( "j", "threads", "Number of threads for batch evaluation (0 = number of cores)", false, 0, ">=0", cmd );
+		TCLAP::ValueArg< String > traceArg( "t", "trace", "Write a trace of the optimization or evaluation in Chrome trace format", false, "", "*.json", cmd );
 		TCLAP::UnlabeledMultiArg< string > propArg( "property", "Override specific scenario property, using <key>=<value>", false, "<key>=<value>", cmd, true );
 
-		auto xor_args = std::vector<TCLAP::Arg*>{ &optArg, &parArg , &benchArg };
+		auto xor_args = std::vector<TCLAP::Arg*>{ &optArg, &resumeArg, &parArg, &batchArg, &benchArg, &workerArg };
 		cmd.xorAdd( xor_args );
 		cmd.parse( argc, argv );
 
@@ -73,19 +115,39 @@ int main(int argc, char* argv[])
 			if ( logArg.isSet() )
 				console_sink.set_log_level( xo::log::level( logArg.getValue() ) );
 
+			// record trace events if requested on the command line or in the settings
+			bool trace = traceArg.isSet() || ( !benchArg.isSet() && !workerArg.isSet() && scone::GetSconeSetting<bool>( "results.trace" ) );
+			if ( trace )
+				scone::StartTraceRecording();
+
 			// do optimization or evaluation
-			if ( optArg.isSet() )
+			if ( optArg.isSet() || resumeArg.isSet() )
 			{
-				path scenario_file = scone::FindScenario( optArg.getValue() );
-				auto scenario_pn = load_scenario( scenario_file, propArg );
-				if ( outArg.isSet() && scenario_pn.count_children() >= 1 )
-					scenario_pn.front().second.set( "output_root", outArg.getValue() );
-				scone::OptimizerUP o = scone::CreateOptimizer( scenario_pn, scenario_file.parent_path() );
+				PropNode scenario_pn;
+				path scenario_dir;
+				if ( optArg.isSet() )
+				{
+					path scenario_file = scone::FindScenario( optArg.getValue() );
+					scenario_pn = load_scenario( scenario_file, propArg );
+					if ( outArg.isSet() && scenario_pn.count_children() >= 1 )
+						scenario_pn.front().second.set( "output_root", outArg.getValue() );
+					scenario_dir = scenario_file.parent_path();
+				}
+				else
+				{
+					// the output folder contains the config and resources of the original scenario
+					scenario_dir = path( resumeArg.getValue() );
+					scenario_pn = scone::LoadResumeScenario( scenario_dir );
+					handle_custom_arguments( scenario_pn, propArg );
+				}
+				scone::OptimizerUP o = scone::CreateOptimizer( scenario_pn, scenario_dir );
 				scone::LogUnusedProperties( scenario_pn );
 				if ( statusOutput.getValue() )
 					o->SetOutputMode( scone::Optimizer::status_console_output );
 				else o->SetOutputMode( quietOutput.getValue() ? scone::Optimizer::no_output : scone::Optimizer::console_output );
 				o->Run();
+				if ( trace )
+					write_trace( traceArg.isSet() ? path( traceArg.getValue() ) : o->GetOutputFolder() / "trace.json" );
 			}
 			else if ( parArg.isSet() )
 			{
@@ -96,11 +158,24 @@ int main(int argc, char* argv[])
 				scone::log::info( "Evaluating ", parArg.getValue() );
 				auto results = scone::EvaluateScenario( scenario_pn, parArg.getValue(), out_path );
 				scone::log::info( results );
+				if ( trace )
+					write_trace( traceArg.isSet() ? path( traceArg.getValue() ) : path( out_path ).replace_extension( "trace.json" ) );
 
 				// store config file if arguments have changed
 				if ( propArg.isSet() && outArg.isSet() )
 					save_file( scenario_pn, out_path.replace_extension( "scone" ) );
 			}
+			else if ( batchArg.isSet() )
+			{
+				auto [files, summary_folder] = find_batch_files( batchArg.getValue() );
+				SCONE_ERROR_IF( files.empty(), "Could not find any .par files in " + batchArg.getValue() );
+				SCONE_ERROR_IF( threadsArg.getValue() < 0, "Number of threads must be 0 or larger" );
+				auto results = scone::EvaluateParFiles( files, threadsArg.getValue(),
+					[&]( PropNode& scenario_pn ) { handle_custom_arguments( scenario_pn, propArg ); } );
+				scone::WriteEvaluationSummary( results, outArg.isSet() ? path( outArg.getValue() ) : summary_folder / "evaluation_summary.txt" );
+				if ( trace )
+					write_trace( traceArg.isSet() ? path( traceArg.getValue() ) : summary_folder / "evaluation_trace.json" );
+			}
 			else if ( benchArg.isSet() )
 			{
 				auto filename = xo::path( benchArg.getValue() );
@@ -119,6 +194,17 @@ int main(int argc, char* argv[])
 					auto scenario_pn = load_scenario( scone::FindScenario( benchArg.getValue() ), propArg );
 					scone::BenchmarkScenario( scenario_pn, f, f.parent_path() / "_benchmark_results", bxArg.getValue() );
 				}
+				if ( trace )
+					write_trace( traceArg.getValue() );
+			}
+			else if ( workerArg.isSet() )
+			{
+				auto [host, port_str] = xo::split_str_at_last( workerArg.getValue(), ":" );
+				auto port = port_str.empty() ? scone::GetSconeSetting<int>( "optimizer.distributed_port" ) : std::stoi( port_str );
+				auto threads = scone::GetSconeSetting<int>( "optimizer.max_threads" );
+				scone::RunDistributedWorker( host, port, threads, scone::GetSconeSetting<double>( "optimizer.distributed_timeout" ) );
+				if ( trace )
+					write_trace( traceArg.getValue() );
 			}
 		}
 		catch ( std::exception& e )
@@ -29,6 +29,11 @@ namespace scone
 
 		INIT_PAR( pn, par, delay, 0.0 );
 
+		// keep sensor values available for the reflex delay
+		m_DelayedPos.RequireDelay( delay );
+		m_DelayedVel.RequireDelay( delay );
+		m_DelayedAcc.RequireDelay( delay );
+
 		INIT_PAR_NAMED( pn, par, P0, "P0", 0.0 );
 		INIT_PAR_NAMED( pn, par, KP, "KP", 0.0 );
 
@@ -56,9 +61,10 @@ namespace scone
 
 	void BodyPointReflex::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		auto name = GetReflexName( actuator_.GetName(), source );
-		frame[ name + ".RBP" ] = u_p;
-		frame[ name + ".RBV" ] = u_v;
-		frame[ name + ".RBA" ] = u_a;
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		const auto& name = GetDataName( source );
+		ch.Set( name, ".RBP", u_p );
+		ch.Set( name, ".RBV", u_v );
+		ch.Set( name, ".RBA", u_a );
 	}
 }
@@ -37,6 +37,10 @@ namespace scone
 
 		INIT_PAR( pn, par, delay, 0.0 );
 
+		// keep sensor values available for the reflex delay
+		m_DelayedPos.RequireDelay( delay );
+		m_DelayedVel.RequireDelay( delay );
+
 		INIT_PAR_NAMED( pn, par, P0, "P0", 0.0 );
 		INIT_PAR_NAMED( pn, par, KP, "KP", 0.0 );
 		INIT_PROP( pn, allow_neg_P, true );
@@ -77,7 +81,11 @@ namespace scone
 
 	void ComPivotReflex::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		frame[ GetReflexName( actuator_.GetName(), m_DelayedPos.GetName() ) ] = u_p;
-		frame[ GetReflexName( actuator_.GetName(), m_DelayedVel.GetName() ) ] = u_v;
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		auto& labels = ch.GetLabels();
+		if ( labels.empty() )
+			labels = { GetReflexName( actuator_.GetName(), m_DelayedPos.GetName() ), GetReflexName( actuator_.GetName(), m_DelayedVel.GetName() ) };
+		ch.Set( labels[ 0 ], u_p );
+		ch.Set( labels[ 1 ], u_v );
 	}
 }
@@ -27,6 +27,10 @@ namespace scone
 		ScopedParamSetPrefixer prefixer( par, GetParName( pn, loc ) + "-" + pn.get< String >( "dof" ) + "." );
 
 		INIT_PAR( pn, par, delay, 0.0 );
+
+		// keep sensor values available for the reflex delay
+		m_pConditionalDofPos->RequireDelay( delay );
+		m_pConditionalDofVel->RequireDelay( delay );
 		INIT_PAR( pn, par, pos_max, 1e12 );
 		INIT_PAR( pn, par, pos_min, -1e12 );
 		m_ConditionalPosRange.max = pos_max;
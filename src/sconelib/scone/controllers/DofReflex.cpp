@@ -34,6 +34,10 @@ namespace scone
 
 		INIT_PAR( pn, par, delay, 0.0 );
 
+		// keep sensor values available for the reflex delay
+		m_DelayedPos.RequireDelay( delay );
+		m_DelayedVel.RequireDelay( delay );
+
 		INIT_PAR_NAMED( pn, par, P0, "P0", 0.0 );
 		INIT_PAR_NAMED( pn, par, KP, "KP", 0.0 );
 		INIT_PROP( pn, allow_neg_P, true );
@@ -91,8 +95,9 @@ namespace scone
 
 	void DofReflex::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		auto name = GetReflexName( actuator_.GetName(), source );
-		frame[ name + ".RDP" ] = u_p;
-		frame[ name + ".RDV" ] = u_v;
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		const auto& name = GetDataName( source );
+		ch.Set( name, ".RDP", u_p );
+		ch.Set( name, ".RDV", u_v );
 	}
 }
@@ -78,6 +78,7 @@ namespace scone
 		{
 			ScopedParamSetPrefixer prefixer( par, symmetric ? "" : leg->GetName() + '.' );
 			m_LegStates.push_back( LegStateUP( new LegState( model, *leg, props, par ) ) );
+			m_LegStates.back()->load_sensor.RequireDelay( leg_load_sensor_delay );
 			//log::TraceF( "leg %d leg_length=%.5f", m_LegStates.back()->leg.GetIndex(), m_LegStates.back()->leg_length );
 		}
 
@@ -289,13 +290,15 @@ namespace scone
 
 	void GaitStateController::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
+		auto& ch = m_StoreDataChannels.Begin( frame );
+
 		// store states
 		for ( size_t idx = 0; idx < m_LegStates.size(); ++idx )
-			frame[ m_LegStates[ idx ]->leg.GetName() + ".state" ] = m_LegStates[ idx ]->state;
+			ch.Set( m_LegStates[ idx ]->leg.GetName(), ".state", m_LegStates[ idx ]->state );
 
 		// store sagittal pos
 		for ( size_t idx = 0; idx < m_LegStates.size(); ++idx )
-			frame[ m_LegStates[ idx ]->leg.GetName() + ".sag_pos" ] = m_LegStates[ idx ]->sagittal_pos;
+			ch.Set( m_LegStates[ idx ]->leg.GetName(), ".sag_pos", m_LegStates[ idx ]->sagittal_pos );
 
 		for ( auto& cc : m_ConditionalControllers )
 		{
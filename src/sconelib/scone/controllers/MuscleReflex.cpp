@@ -68,6 +68,11 @@ namespace scone
 		if ( KA != 0.0 )
 			m_pActivationSensor = &model.AcquireDelayedSensor< MuscleActivationSensor >( source );
 
+		// keep sensor values available for the reflex delay
+		for ( auto* s : { m_pForceSensor, m_pLengthSensor, m_pVelocitySensor, m_pSpindleSensor, m_pActivationSensor } )
+			if ( s )
+				s->RequireDelay( delay );
+
 		//log::TraceF( "MuscleReflex SRC=%s TRG=%s KL=%.2f KF=%.2f C0=%.2f", source.GetName().c_str(), m_Target.GetName().c_str(), length_gain, force_gain, u_constant );
 	}
 
@@ -99,18 +104,19 @@ namespace scone
 
 	void MuscleReflex::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		auto name = GetReflexName( actuator_.GetName(), source.GetName() );
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		const auto& name = GetDataName( source.GetName() );
 
 		if ( m_pLengthSensor )
-			frame[ name + ".RL" ] = u_l;
+			ch.Set( name, ".RL", u_l );
 		if ( m_pVelocitySensor )
-			frame[ name + ".RV" ] = u_v;
+			ch.Set( name, ".RV", u_v );
 		if ( m_pForceSensor )
-			frame[ name + ".RF" ] = u_f;
+			ch.Set( name, ".RF", u_f );
 		if ( m_pSpindleSensor )
-			frame[ name + ".RS" ] = u_s;
+			ch.Set( name, ".RS", u_s );
 		if ( m_pActivationSensor )
-			frame[ name + ".RA" ] = u_a;
+			ch.Set( name, ".RA", u_a );
 		//frame[ name + ".R" ] = u_total;
 	}
 }
@@ -261,19 +261,40 @@ namespace scone
 
 	void NeuralController::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		auto& labels = ch.GetLabels();
+		if ( labels.empty() )
+		{
+			// labels are composed once, in the same order as the values below
+			for ( auto& neuron : m_PatternNeurons )
+				labels.emplace_back( "PN." + neuron->GetName( false ) );
+			for ( auto& neuron : m_SensorNeurons )
+				labels.emplace_back( "SN." + neuron->GetName( false ) );
+			for ( auto& layer : m_InterNeurons )
+				for ( auto& neuron : layer.second )
+					labels.emplace_back( "IN." + neuron->GetName( false ) );
+			for ( auto& neuron : m_MotorNeurons )
+			{
+				auto prefix = "MN." + neuron->GetName( false ) + '.';
+				labels.emplace_back( prefix + "input" );
+				for ( auto& i : neuron->inputs_ )
+					labels.emplace_back( prefix + i.neuron->GetName( false ) );
+			}
+		}
+
+		auto label_it = labels.cbegin();
 		for ( auto& neuron : m_PatternNeurons )
-			frame[ "PN." + neuron->GetName( false ) ] = neuron->output_;
+			ch.Set( *label_it++, neuron->output_ );
 		for ( auto& neuron : m_SensorNeurons )
-			frame[ "SN." + neuron->GetName( false ) ] = neuron->output_;
+			ch.Set( *label_it++, neuron->output_ );
 		for ( auto& layer : m_InterNeurons )
 			for ( auto& neuron : layer.second )
-				frame[ "IN." + neuron->GetName( false ) ] = neuron->output_;
+				ch.Set( *label_it++, neuron->output_ );
 		for ( auto& neuron : m_MotorNeurons )
 		{
-			auto prefix = "MN." + neuron->GetName( false ) + '.';
-			frame[ prefix + "input" ] = neuron->input_;
+			ch.Set( *label_it++, neuron->input_ );
 			for ( auto& i : neuron->inputs_ )
-				frame[ prefix + i.neuron->GetName( false ) ] = i.gain * i.neuron->GetOutput();
+				ch.Set( *label_it++, i.gain * i.neuron->GetOutput() );
 		}
 	}
 
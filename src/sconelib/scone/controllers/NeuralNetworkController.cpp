@@ -3,7 +3,6 @@
 #include "xo/string/string_tools.h"
 #include "xo/utility/irange.h"
 #include "xo/utility/hash.h"
-#include "xo/utility/factory.h"
 
 #include "scone/core/Log.h"
 #include "scone/model/Model.h"
@@ -22,26 +21,48 @@
 
 namespace scone::NN
 {
-	struct linear { static double update( const double v ) { return v; } };
-	struct relu { static double update( const double v ) { return std::max( 0.0, v ); } };
-	struct leaky_relu { static double update( const double v ) { return v >= 0.0 ? v : 0.01 * v; } };
-	struct tanh { static double update( const double v ) { return std::tanh( v ); } };
-	struct tanh_norm { static double update( const double v ) { return 0.5 * std::tanh( 2.0 * v - 1.0 ) + 0.5; } };
-	struct tanh_norm_01 { static double update( const double v ) { return 0.495 * std::tanh( 2.0 * v - 1.0 ) + 0.505; } };
-
-	using OutputUpdaterFactory = xo::factory<OutputUpdater, const PropNode&>;
-	u_ptr<OutputUpdater> make_update_function( const PropNode& pn, const String& default_activation )
+	OutputUpdater make_update_function( const PropNode& pn, const String& default_activation )
 	{
-		static OutputUpdaterFactory fac = OutputUpdaterFactory()
-			.register_type<BasicOutputUpdater<linear>>( "linear" )
-			.register_type<BasicOutputUpdater<relu>>( "relu" )
-			.register_type<BasicOutputUpdater<leaky_relu>>( "leaky_relu" )
-			.register_type<BasicOutputUpdater<tanh>>( "tanh" )
-			.register_type<BasicOutputUpdater<tanh_norm>>( "tanh_norm" )
-			.register_type<BasicOutputUpdater<tanh_norm_01>>( "tanh_norm_01" )
-			.register_type<DynamicOutputUpdater<leaky_relu>>( "dyn_leaky_relu" );
-
-		return fac.create( pn.get<String>( "activation", default_activation ), pn );
+		const auto activation = pn.get<String>( "activation", default_activation );
+		switch ( xo::hash( activation ) )
+		{
+		case "linear"_hash: return BasicOutputUpdate<linear>();
+		case "relu"_hash: return BasicOutputUpdate<relu>();
+		case "leaky_relu"_hash: return BasicOutputUpdate<leaky_relu>();
+		case "tanh"_hash: return BasicOutputUpdate<tanh>();
+		case "tanh_norm"_hash: return BasicOutputUpdate<tanh_norm>();
+		case "tanh_norm_01"_hash: return BasicOutputUpdate<tanh_norm_01>();
+		case "dyn_leaky_relu"_hash: return DynamicOutputUpdate<leaky_relu>{ pn.get<float>( "act_rate" ), pn.get<float>( "deact_rate" ) };
+		default: SCONE_ERROR( "Unknown activation function: " + activation );
+		}
+	}
+
+	void LinkBlock::Apply( NeuronArrays& na ) const
+	{
+		const double* output = na.output_.data();
+		double* input = na.input_.data() + trg_begin_;
+		const double* w = weights_.data();
+		if ( dense_ )
+		{
+			// each source adds to all targets, for each target the sources are added in order
+			for ( index_t s = 0; s < src_count_; ++s, w += trg_count_ )
+			{
+				const double src_value = output[ src_begin_ + s ];
+				for ( index_t t = 0; t < trg_count_; ++t )
+					input[ t ] += w[ t ] * src_value;
+			}
+		}
+		else
+		{
+			const index_t* src_idx = src_idx_.data();
+			for ( index_t t = 0; t < trg_count_; ++t )
+			{
+				double sum = input[ t ];
+				for ( index_t k = row_begin_[ t ]; k < row_begin_[ t + 1 ]; ++k )
+					sum += w[ k ] * output[ src_idx[ k ] ];
+				input[ t ] = sum;
+			}
+		}
 	}
 
 #ifdef USE_OLD_DELAY_SENSORS
@@ -82,10 +103,83 @@ namespace scone::NN
 		// check if everything is ok
 		for ( index_t idx = 0; idx < layers_.size(); ++idx )
 		{
-			SCONE_ERROR_IF( idx > 0 && !layers_[ idx ].update_func_, "Layer " + to_str( idx ) + " has no update function" );
+			SCONE_ERROR_IF( idx > 0 && std::holds_alternative<NoOutputUpdate>( layers_[ idx ].update_func_ ), "Layer " + to_str( idx ) + " has no update function" );
 			SCONE_ERROR_IF( layers_[ idx ].neurons_.empty(), "Layer " + to_str( idx ) + " has no neurons" );
 		}
 
+		CompileNetwork();
+	}
+
+	void NeuralNetworkController::CompileNetwork()
+	{
+		// neuron state of all layers in contiguous arrays
+		size_t neuron_count = 0;
+		for ( auto& layer : layers_ )
+		{
+			layer.begin_ = neuron_count;
+			neuron_count += layer.neurons_.size();
+		}
+		neuron_state_.resize( neuron_count );
+		for ( const auto& layer : layers_ )
+		{
+			for ( auto idx : xo::size_range( layer.neurons_ ) )
+			{
+				const auto& n = layer.neurons_[ idx ];
+				neuron_state_.offset_[ layer.begin_ + idx ] = n.offset_;
+				neuron_state_.sum_[ layer.begin_ + idx ] = n.sum_;
+				neuron_state_.output_[ layer.begin_ + idx ] = n.output_;
+			}
+		}
+
+		// link layers, in the same order as they were added
+		link_blocks_.resize( links_.size() );
+		for ( index_t idx = 0; idx < links_.size(); ++idx )
+		{
+			link_blocks_[ idx ].clear();
+			for ( const auto& ll : links_[ idx ] )
+				link_blocks_[ idx ].emplace_back( CompileLinkLayer( ll, layers_[ ll.input_layer_ ], layers_[ idx + 1 ] ) );
+		}
+	}
+
+	LinkBlock NeuralNetworkController::CompileLinkLayer( const LinkLayer& ll, const NeuronLayer& input_layer, const NeuronLayer& output_layer ) const
+	{
+		LinkBlock lb;
+		lb.src_begin_ = input_layer.begin_;
+		lb.trg_begin_ = output_layer.begin_;
+		lb.src_count_ = input_layer.neurons_.size();
+		lb.trg_count_ = output_layer.neurons_.size();
+
+		// links sorted by target; stable sort keeps the summation order per target
+		std::vector<Link> links = ll.links_;
+		std::stable_sort( links.begin(), links.end(), [&]( const Link& a, const Link& b ) { return a.trg_idx_ < b.trg_idx_; } );
+
+		// use a dense block if all sources are linked to all targets in increasing order
+		lb.dense_ = links.size() == lb.src_count_ * lb.trg_count_;
+		for ( index_t k = 0; k < links.size() && lb.dense_; ++k )
+			lb.dense_ = links[ k ].trg_idx_ == k / lb.src_count_ && links[ k ].src_idx_ == k % lb.src_count_;
+
+		if ( lb.dense_ )
+		{
+			lb.weights_.resize( links.size() );
+			for ( const auto& l : links )
+				lb.weights_[ l.src_idx_ * lb.trg_count_ + l.trg_idx_ ] = l.weight_;
+		}
+		else
+		{
+			lb.row_begin_.assign( lb.trg_count_ + 1, 0 );
+			for ( const auto& l : links )
+				++lb.row_begin_[ l.trg_idx_ + 1 ];
+			for ( index_t t = 0; t < lb.trg_count_; ++t )
+				lb.row_begin_[ t + 1 ] += lb.row_begin_[ t ];
+			lb.weights_.reserve( links.size() );
+			lb.src_idx_.reserve( links.size() );
+			for ( const auto& l : links )
+			{
+				lb.weights_.push_back( l.weight_ );
+				lb.src_idx_.push_back( lb.src_begin_ + l.src_idx_ );
+			}
+		}
+		return lb;
 	}
 
 	NeuronLayer& NeuralNetworkController::AddNeuronLayer( const PropNode& pn, const String& default_activation )
@@ -94,7 +188,7 @@ namespace scone::NN
 		layers_.resize( std::max( layers_.size(), idx + 1 ) );
 		auto& layer = layers_[ idx ];
 		layer.layer_idx_ = idx;
-		if ( !layer.update_func_ )
+		if ( std::holds_alternative<NoOutputUpdate>( layer.update_func_ ) )
 			layer.update_func_ = make_update_function( pn, default_activation );
 		return layer;
 	}
@@ -128,7 +222,11 @@ namespace scone::NN
 			snl.delayed_sensor_value_ = model.GetDelayedSensor( sensor, delay );
 #endif
 		}
-		else snl.delayed_sensor_ = &model.AcquireSensorDelayAdapter( sensor );
+		else
+		{
+			snl.delayed_sensor_ = &model.AcquireSensorDelayAdapter( sensor );
+			snl.delayed_sensor_->RequireDelay( delay );
+		}
 
 		return neuron;
 	}
@@ -162,12 +260,11 @@ namespace scone::NN
 		SCONE_PROFILE_FUNCTION( model.GetProfiler() );
 
 		// clear neuron inputs
-		for ( auto& layer : layers_ )
-			for ( auto& n : layer.neurons_ )
-				n.input_ = 0.0;
+		std::fill( neuron_state_.input_.begin(), neuron_state_.input_.end(), 0.0 );
 
-		// update sensor neurons with sensor values
-		auto& sensor_neurons = layers_.front().neurons_;
+		// update sensor neurons with sensor values, the sensor layer starts at index 0
+		const double* offset = neuron_state_.offset_.data();
+		double* sensor_output = neuron_state_.output_.data();
 		if ( accurate_neural_delays_ )
 		{
 #ifdef USE_OLD_DELAY_SENSORS
@@ -176,13 +273,13 @@ namespace scone::NN
 				for ( const auto& sl : sensor_links_ ) {
 					auto sensor_value = sl.sensor_->GetValue();
 					sl.buffer_channel_.set( sensor_value );
-					sensor_neurons[ sl.neuron_idx_ ].output_ = sensor_value + sensor_neurons[ sl.neuron_idx_ ].offset_;
+					sensor_output[ sl.neuron_idx_ ] = sensor_value + offset[ sl.neuron_idx_ ];
 				}
 			}
 			else {
 				// get delayed value, advance, set current
 				for ( const auto& sl : sensor_links_ )
-					sensor_neurons[ sl.neuron_idx_ ].output_ = sl.buffer_channel_.get() + sensor_neurons[ sl.neuron_idx_ ].offset_;
+					sensor_output[ sl.neuron_idx_ ] = sl.buffer_channel_.get() + offset[ sl.neuron_idx_ ];
 				for ( auto& sbuf : sensor_buffers_ )
 					sbuf.second.advance();
 				for ( const auto& sl : sensor_links_ )
@@ -190,39 +287,36 @@ namespace scone::NN
 			}
 #else
 			for ( const auto& sl : sensor_links_ )
-				sensor_neurons[ sl.neuron_idx_ ].output_ = sl.delayed_sensor_value_.GetValue() + sensor_neurons[ sl.neuron_idx_ ].offset_;
+				sensor_output[ sl.neuron_idx_ ] = sl.delayed_sensor_value_.GetValue() + offset[ sl.neuron_idx_ ];
 #endif
 		}
 		else
 		{
 			for ( const auto& sl : sensor_links_ )
-				sensor_neurons[ sl.neuron_idx_ ].output_ = sl.delayed_sensor_->GetValue( sl.delay_ ) + sensor_neurons[ sl.neuron_idx_ ].offset_;
+				sensor_output[ sl.neuron_idx_ ] = sl.delayed_sensor_->GetValue( sl.delay_ ) + offset[ sl.neuron_idx_ ];
 		}
 
 		// update links and inter neurons
-		for ( index_t idx = 0; idx < links_.size(); ++idx )
+		const auto dt = model.GetDeltaTime();
+		for ( index_t idx = 0; idx < link_blocks_.size(); ++idx )
 		{
-			auto& target_layer = layers_[ idx + 1 ];
-			for ( const auto& link_layer : links_[ idx ] )
-			{
-				auto& source_layer = layers_[ link_layer.input_layer_ ];
-				for ( const auto& link : link_layer.links_ )
-					target_layer.neurons_[ link.trg_idx_ ].input_ += link.weight_ * source_layer.neurons_[ link.src_idx_ ].output_;
-			}
+			for ( const auto& lb : link_blocks_[ idx ] )
+				lb.Apply( neuron_state_ );
 
 			// update outputs
-			target_layer.update_func_->Update( target_layer.neurons_, model.GetDeltaTime() );
+			const auto& target_layer = layers_[ idx + 1 ];
+			UpdateOutputs( target_layer.update_func_, neuron_state_, target_layer.begin_, target_layer.begin_ + target_layer.neurons_.size(), dt );
 		}
 
 		// update actuators with output neurons
-		auto& motor_neurons = layers_[ motor_layer_ ].neurons_;
+		const double* motor_neurons = neuron_state_.output_.data() + layers_[ motor_layer_ ].begin_;
 		if ( accurate_neural_delays_ )
 		{
 #ifdef USE_OLD_DELAY_ACTUATORS
 			if ( timestamp == 0.0 ) {
 				// first run, initialize buffer and use current value (can be called multiple times)
 				for ( const auto& ml : motor_links_ ) {
-					auto motor_value = motor_neurons[ ml.neuron_idx_ ].output_;
+					auto motor_value = motor_neurons[ ml.neuron_idx_ ];
 					ml.buffer_channel_.set( motor_value );
 					ml.actuator_->AddInput( motor_value );
 				}
@@ -234,17 +328,17 @@ namespace scone::NN
 				for ( auto& abuf : actuator_buffers_ )
 					abuf.second.advance();
 				for ( auto& ml : motor_links_ )
-					ml.buffer_channel_.set( motor_neurons[ ml.neuron_idx_ ].output_ );
+					ml.buffer_channel_.set( motor_neurons[ ml.neuron_idx_ ] );
 			}
 #else
 			for ( auto& ml : motor_links_ )
-				ml.delayed_actuator_value_.AddInput( motor_neurons[ ml.neuron_idx_ ].output_ );
+				ml.delayed_actuator_value_.AddInput( motor_neurons[ ml.neuron_idx_ ] );
 #endif
 		}
 		else
 		{
 			for ( auto& ml : motor_links_ )
-				ml.actuator_->AddInput( motor_neurons[ ml.neuron_idx_ ].output_ );
+				ml.actuator_->AddInput( motor_neurons[ ml.neuron_idx_ ] );
 		}
 
 		return false;
@@ -252,9 +346,16 @@ namespace scone::NN
 
 	void NeuralNetworkController::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		for ( auto lidx : xo::size_range( layers_ ) )
-			for ( auto nidx : xo::size_range( layers_[ lidx ].neurons_ ) )
-				frame[ "NN." + GetNeuronName( lidx, nidx ) ] = layers_[ lidx ].neurons_[ nidx ].output_;
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		auto& labels = ch.GetLabels();
+		if ( labels.empty() )
+			for ( auto lidx : xo::size_range( layers_ ) )
+				for ( auto nidx : xo::size_range( layers_[ lidx ].neurons_ ) )
+					labels.emplace_back( "NN." + GetNeuronName( lidx, nidx ) );
+
+		// layers are stored in order, so labels match the neuron arrays
+		for ( auto idx : xo::size_range( labels ) )
+			ch.Set( labels[ idx ], neuron_state_.output_[ idx ] );
 	}
 
 	PropNode NeuralNetworkController::GetInfo() const
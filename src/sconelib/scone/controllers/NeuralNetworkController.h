@@ -7,12 +7,16 @@
 #include "xo/container/circular_buffer.h"
 #include "scone/model/MuscleId.h"
 #include <map>
+#include <variant>
+#include <cmath>
+#include <algorithm>
 #include "scone/model/DelayBuffer.h"
 
 namespace scone
 {
 	namespace NN
 	{
+		/// Initial neuron state, used while building the network
 		struct Neuron {
 			Neuron() : input_(), offset_(), sum_(), output_() {}
 			Neuron( double offset ) : input_(), offset_( offset ), sum_(), output_() {}
@@ -22,43 +26,77 @@ namespace scone
 			double output_;
 		};
 
-		struct OutputUpdater {
-			OutputUpdater( const PropNode& pn ) {}
-			virtual ~OutputUpdater() = default;
-			virtual void Update( std::vector<Neuron>&, const double dt ) = 0;
+		/// Neuron state of all layers in structure-of-arrays form, used during simulation
+		struct NeuronArrays {
+			void resize( size_t n ) { input_.resize( n ); offset_.resize( n ); sum_.resize( n ); output_.resize( n ); }
+			std::vector<double> input_;
+			std::vector<double> offset_;
+			std::vector<double> sum_;
+			std::vector<double> output_;
 		};
 
+		// activation functions
+		struct linear { static double update( const double v ) { return v; } };
+		struct relu { static double update( const double v ) { return std::max( 0.0, v ); } };
+		struct leaky_relu { static double update( const double v ) { return v >= 0.0 ? v : 0.01 * v; } };
+		struct tanh { static double update( const double v ) { return std::tanh( v ); } };
+		struct tanh_norm { static double update( const double v ) { return 0.5 * std::tanh( 2.0 * v - 1.0 ) + 0.5; } };
+		struct tanh_norm_01 { static double update( const double v ) { return 0.495 * std::tanh( 2.0 * v - 1.0 ) + 0.505; } };
+
+		/// Placeholder for layers without output update (i.e. the sensor layer)
+		struct NoOutputUpdate {
+			void Update( NeuronArrays&, index_t, index_t, double ) const {}
+		};
+
+		/// Updates the outputs of neurons [begin, end) with activation function F
 		template< typename F >
-		struct BasicOutputUpdater : public OutputUpdater {
-			BasicOutputUpdater( const PropNode& pn ) : OutputUpdater( pn ) {}
-			virtual void Update( std::vector<Neuron>& nv, const double dt ) override {
-				for ( auto& n : nv )
-					n.output_ = F::update( n.input_ + n.offset_ );
+		struct BasicOutputUpdate {
+			void Update( NeuronArrays& na, index_t begin, index_t end, double ) const {
+				const double* input = na.input_.data();
+				const double* offset = na.offset_.data();
+				double* output = na.output_.data();
+				for ( index_t i = begin; i < end; ++i )
+					output[ i ] = F::update( input[ i ] + offset[ i ] );
 			}
 		};
 
+		/// Updates the outputs of neurons [begin, end) with activation function F, applied to a first-order filtered input
 		template< typename F >
-		struct DynamicOutputUpdater : public OutputUpdater {
-			DynamicOutputUpdater( const PropNode& pn ) :
-				OutputUpdater( pn ),
-				deact_rate_( pn.get<float>( "deact_rate" ) ),
-				act_rate_( pn.get<float>( "act_rate" ) )
-			{}
-			virtual void Update( std::vector<Neuron>& nv, const double dt ) override {
-				for ( auto& n : nv ) {
-					auto ds = n.input_ + n.offset_ - n.sum_;
-					n.sum_ += dt * ds * ( ds > 0 ? act_rate_ : deact_rate_ );
-					n.output_ = F::update( n.sum_ );
+		struct DynamicOutputUpdate {
+			void Update( NeuronArrays& na, index_t begin, index_t end, double dt ) const {
+				const double* input = na.input_.data();
+				const double* offset = na.offset_.data();
+				double* sum = na.sum_.data();
+				double* output = na.output_.data();
+				for ( index_t i = begin; i < end; ++i ) {
+					auto ds = input[ i ] + offset[ i ] - sum[ i ];
+					sum[ i ] += dt * ds * ( ds > 0 ? act_rate_ : deact_rate_ );
+					output[ i ] = F::update( sum[ i ] );
 				}
 			}
-			double act_rate_, deact_rate_;
+			double act_rate_ = 0.0;
+			double deact_rate_ = 0.0;
 		};
 
+		/// Output update of a layer; the variant is visited once per layer, the loop over its neurons is instantiated per activation function
+		using OutputUpdater = std::variant< NoOutputUpdate,
+			BasicOutputUpdate<linear>, BasicOutputUpdate<relu>, BasicOutputUpdate<leaky_relu>,
+			BasicOutputUpdate<tanh>, BasicOutputUpdate<tanh_norm>, BasicOutputUpdate<tanh_norm_01>,
+			DynamicOutputUpdate<leaky_relu> >;
+
+		inline void UpdateOutputs( const OutputUpdater& u, NeuronArrays& na, index_t begin, index_t end, double dt ) {
+			std::visit( [&]( const auto& updater ) { updater.Update( na, begin, end, dt ); }, u );
+		}
+
+		/// Create the output update for the activation function in pn, or default_activation
+		SCONE_API OutputUpdater make_update_function( const PropNode& pn, const String& default_activation );
+
 		struct NeuronLayer {
 			std::vector<Neuron> neurons_;
 			std::vector<String> names_;
-			u_ptr<OutputUpdater> update_func_;
+			OutputUpdater update_func_;
 			index_t layer_idx_ = no_index;
+			index_t begin_ = 0; // index of first neuron in NeuronArrays
 		};
 
 		struct Link {
@@ -74,6 +112,21 @@ namespace scone
 			std::vector<Link> links_;
 		};
 
+		/// LinkLayer compiled for evaluation, with neuron indices into NeuronArrays.
+		/// Dense blocks store weights source-major, so that each source updates all targets in one pass;
+		/// sparse blocks store weights per target neuron (CSR). Both keep the summation order of the LinkLayer.
+		struct LinkBlock {
+			void Apply( NeuronArrays& na ) const;
+			index_t src_begin_;
+			index_t trg_begin_;
+			size_t src_count_;
+			size_t trg_count_;
+			bool dense_;
+			std::vector<double> weights_;
+			std::vector<index_t> row_begin_;
+			std::vector<index_t> src_idx_;
+		};
+
 #ifdef USE_OLD_DELAY_SENSORS
 		using DelayBufferMap = std::map< size_t, xo::circular_buffer<Real> >;
 		using DelayBufferMapIter = DelayBufferMap::iterator;
@@ -134,6 +187,8 @@ namespace scone
 
 			void CreateLinkComponent( const PropNode& pn, Params& par, Model& model );
 			void CreateComponent( const String& key, const PropNode& pn, Params& par, Model& model );
+			void CompileNetwork();
+			LinkBlock CompileLinkLayer( const LinkLayer& ll, const NeuronLayer& input_layer, const NeuronLayer& output_layer ) const;
 
 			const xo::flat_map<String, TimeInSeconds> neural_delays_;
 			const xo::flat_map<String, String> parameter_aliases_;
@@ -144,6 +199,9 @@ namespace scone
 			std::vector<MotorNeuronLink> motor_links_;
 			index_t motor_layer_ = no_index;
 
+			NeuronArrays neuron_state_;
+			std::vector< std::vector< LinkBlock > > link_blocks_;
+
 #ifdef USE_OLD_DELAY_SENSORS
 			DelayBufferMap sensor_buffers_;
 			DelayBufferMap actuator_buffers_;
@@ -42,6 +42,14 @@ namespace scone
 		return ( target == source ) ? target : target + "-" + source;
 	}
 
+	const String& Reflex::GetDataName( const String& source ) const
+	{
+		auto& labels = m_StoreDataChannels.GetLabels();
+		if ( labels.empty() )
+			labels.emplace_back( GetReflexName( actuator_.GetName(), source ) );
+		return labels.front();
+	}
+
 	String Reflex::GetParName( const PropNode& props, const Location& loc )
 	{
 		if ( auto par_name = props.try_get< String >( "par_name" ) )
@@ -44,6 +44,7 @@ namespace scone
 		Real AddTargetControlValue( Real u );
 		Actuator& actuator_;
 		static String GetReflexName( const String& target, const String& source );
+		const String& GetDataName( const String& source ) const;
 		static String GetParName( const PropNode& props, const Location& loc );
 	};
 }
@@ -80,6 +80,9 @@ namespace scone
 			sensor_gain_ *= -1;
 
 		xo_error_if( !input_sensor_, "Unknown type " + type_ );
+		if ( use_sample_delay_ )
+			input_sensor_->RequireAverageValue( sample_delay_frames_, sample_delay_window_ );
+		else input_sensor_->RequireDelay( delay_ );
 		source_name_ = name;
 	}
 
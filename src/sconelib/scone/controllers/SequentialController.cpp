@@ -39,8 +39,10 @@ namespace scone
 
 	void SequentialController::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		auto name = GetName().empty() ? "SequentialController" : GetName();
-		frame[ name + ".active_index" ] = static_cast<double>( active_idx_ );
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		if ( GetName().empty() )
+			ch.Set( "SequentialController.active_index", static_cast<double>( active_idx_ ) );
+		else ch.Set( GetName(), ".active_index", static_cast<double>( active_idx_ ) );
 		CompositeController::StoreData( frame, flags );
 	}
 
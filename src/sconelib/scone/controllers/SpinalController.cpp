@@ -438,13 +438,21 @@ namespace scone
 	void SpinalController::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		SCONE_ASSERT( network_.neuron_count() == neuron_names_.size() );
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		auto& link_labels = ch.GetLabels();
+		if ( link_labels.empty() )
+			for ( index_t i = 0; i < network_.neuron_count(); ++i )
+				for ( auto lid = network_.neurons_[ i ].input_begin_; lid != network_.neurons_[ i ].input_end_; ++lid )
+					link_labels.emplace_back( neuron_names_[ i ] + '-' + neuron_names_[ network_.links_[ lid.idx ].input_.idx ] );
+
+		auto label_it = link_labels.cbegin();
 		for ( index_t i = 0; i < network_.neuron_count(); ++i ) {
-			frame[ neuron_names_[ i ] ] = network_.values_[ i ];
+			ch.Set( neuron_names_[ i ], network_.values_[ i ] );
 			const auto& n = network_.neurons_[ i ];
 			for ( auto lid = n.input_begin_; lid != n.input_end_; ++lid ) {
 				const auto& l = network_.links_[ lid.idx ];
 				auto v = network_.value( l.input_ ) * l.weight_;
-				frame[ neuron_names_[ i ] + '-' + neuron_names_[ l.input_.idx ] ] = v;
+				ch.Set( *label_it++, v );
 			}
 		}
 	}
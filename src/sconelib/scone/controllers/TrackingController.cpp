@@ -6,15 +6,10 @@
 
 #include "scone/core/Factories.h"
 #include "scone/core/profiler_config.h"
-#include "xo/utility/memoize.h"
-#include "scone/core/StorageIo.h"
 #include "scone/core/Log.h"
 
 namespace scone
 {
-	Storage<> read_storage_tmp(const xo::path& f) { Storage<> sto; ReadStorage(sto, f); return sto; }
-	static xo::memoize_thread_safe< Storage<>(const xo::path&) > g_storage_cache(read_storage_tmp);
-
 	// some code was copied from MimicMeasure
 	TrackingController::TrackingController( const PropNode& props, Params& par, Model& model, const Location& target_area ) :
 		Controller( props, par, model, target_area ),
@@ -27,7 +22,7 @@ namespace scone
 		INIT_MEMBER( props, exclude_states, xo::pattern_matcher("")),
 		INIT_MEMBER( props, time_offset, 0),
 		file(FindFile(props.get<path>("file"))),
-		storage_(g_storage_cache(file))
+		storage_(file, model.use_fixed_control_step_size ? model.fixed_control_step_size : 0.0)
 	{
 		INIT_PROP( props, symmetric, target_area.symmetric_ );
 		INIT_PROP( props, min_control_value, xo::constants<Real>::lowest());
@@ -58,11 +53,11 @@ namespace scone
 
 		SCONE_THROW_IF(m_ActInfos.empty(), "No matching actuators");
 
-		SCONE_THROW_IF(storage_.IsEmpty(), file.str() + " contains no data");
+		SCONE_THROW_IF(storage_->IsEmpty(), file.str() + " contains no data");
 
 		// automatically set stop_time to match data, if not set
-		if (stop_time == 0 || stop_time > storage_.Back().GetTime())
-			stop_time = storage_.Back().GetTime();
+		if (stop_time == 0 || stop_time > storage_->Back().GetTime())
+			stop_time = storage_->Back().GetTime();
 
 		auto& state = model.GetState();
 		for (index_t state_idx = 0; state_idx < state.GetSize(); ++state_idx)
@@ -70,7 +65,7 @@ namespace scone
 			auto& name = state.GetName(state_idx);
 			if (include_states(name) && !exclude_states(name))
 			{
-				index_t sto_idx = storage_.TryGetChannelIndex(name);
+				index_t sto_idx = storage_->TryGetChannelIndex(name);
 				if (sto_idx != NoIndex)
 				{
 					auto w = 1.0;
@@ -81,7 +76,7 @@ namespace scone
 			}
 		}
 
-		log::debug("TrackingController found ", state_storage_map_.size(), " of ", storage_.GetChannelCount(), " channels from ", file);
+		log::debug("TrackingController found ", state_storage_map_.size(), " of ", storage_->GetChannelCount(), " channels from ", file);
 
 		SCONE_THROW_IF(state_storage_map_.empty(), "No matching states found in " + file.str());
 
@@ -102,7 +97,7 @@ namespace scone
 
 		auto& state = model.GetState();
 		index_t error_idx = 0;
-		auto frame = storage_.ComputeInterpolatedFrame(time + time_offset);
+		auto frame = storage_.GetFrame(time + time_offset);
 		for (auto& m : state_storage_map_)
 		{
 			auto storage_value = frame.value(m.storage_idx_);
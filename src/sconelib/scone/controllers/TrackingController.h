@@ -10,6 +10,7 @@
 #include "scone/core/PropNode.h"
 #include "scone/optimization/Params.h"
 #include "scone/core/Function.h"
+#include "scone/core/ReferenceStorage.h"
 #include "scone/model/Leg.h"
 
 
@@ -56,7 +57,7 @@ namespace scone
 		virtual bool ComputeControls( Model& model, double timestamp ) override;
 		virtual String GetClassSignature() const override;
 
-		/// Filename of storage (sto).
+		/// Filename of storage (sto, txt or stob).
 		xo::path file;
 
 		/// States to include for comparison; default = *.
@@ -87,7 +88,7 @@ namespace scone
 
 		///Dof& m_SourceDof;
 
-		const Storage<>& storage_;
+		ReferenceStorage storage_;
 		struct Channel {
 			index_t state_idx_;
 			index_t storage_idx_;
@@ -14,6 +14,7 @@
 #include "xo/time/time.h"
 #include "xo/thread/thread_priority.h"
 #include "Log.h"
+#include "Exception.h"
 
 namespace scone
 {
@@ -61,6 +62,21 @@ namespace scone
 				duration = xo::time_from_seconds( model->GetTime() );
 				log::info( "Benchmarked trial ", idx + 1, " of ", evals, "; simulated ", duration, "s in ", total_time, "s (", duration / total_time, "x real-time)" );
 			}
+
+			// run the same evaluation again after resetting the model instead of creating a new one
+			auto result = mo->GetResult( *model );
+			xo::timer rt;
+			if ( mo->ResetModelFromParams( *model, par ) )
+			{
+				auto reset_model_time = rt();
+				mo->AdvanceSimulationTo( *model, model->GetSimulationEndTime() );
+				auto reset_total_time = rt();
+				bm_components[ "EvalCreateModel" ].push_back( create_model_time );
+				bm_components[ "EvalResetModel" ].push_back( reset_model_time );
+				bm_components[ "EvalResetTotal" ].push_back( reset_total_time );
+				auto reset_result = mo->GetResult( *model );
+				SCONE_ERROR_IF( reset_result != result, "Result after model reset differs: " + xo::to_str( reset_result ) + " != " + xo::to_str( result ) );
+			}
 		}
 
 		// read baseline
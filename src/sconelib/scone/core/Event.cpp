@@ -15,14 +15,14 @@ namespace scone
 		std::vector< Event > e;
 
 		// find GRF channels
-		index_t right_idx = s.GetChannelIndex( "leg1_r.grf_y" );
+		auto right_grf = s.GetChannel( s.GetChannelIndex( "leg1_r.grf_y" ) );
 
 		// detect events
 		for ( index_t frame_idx = 1; frame_idx < s.GetFrameCount(); ++frame_idx )
 		{
 			TimeInSeconds time = s.GetFrame( frame_idx ).GetTime();
-			Real grf = s.GetFrame( frame_idx )[ right_idx ];
-			Real prev_grf = s.GetFrame( frame_idx - 1 )[ right_idx ];
+			Real grf = right_grf[ frame_idx ];
+			Real prev_grf = right_grf[ frame_idx - 1 ];
 
 			if ( grf > 0 && prev_grf == 0 )
 				e.push_back( Event{ time, Event::RightHeelStrike } );
@@ -48,6 +48,7 @@
 #include "scone/measures/StepMeasure.h"
 
 #include "scone/core/Exception.h"
+#include "scone/optimization/AsyncCmaOptimizer.h"
 #include "scone/optimization/CmaOptimizerSpot.h"
 #include "scone/optimization/CmaPoolOptimizer.h"
 #include "scone/optimization/ImitationObjective.h"
@@ -184,6 +185,7 @@ namespace scone
 		static OptimizerFactory g_OptimizerFactory = OptimizerFactory()
 			.register_type< CmaOptimizer >( "CmaOptimizer" )
 			.register_type< CmaOptimizer >( "CmaOptimizerSpot" )
+			.register_type< AsyncCmaOptimizer >()
 #ifdef SCONE_EXPERIMENTAL_FEATURES
 			.register_type< MesOptimizer >()
 			.register_type< EvaOptimizer >()
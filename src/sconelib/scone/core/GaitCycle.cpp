@@ -3,14 +3,14 @@
 
 namespace scone
 {
-	index_t FindNextTouch( const Storage<>& sto, index_t idx, const index_t channel_idx, const Real threshold ) {
-		while ( idx != no_index && idx < sto.GetFrameCount() && sto.GetFrame( idx )[ channel_idx ] < threshold ) idx++;
-		return idx < sto.GetFrameCount() ? idx : no_index;
+	index_t FindNextTouch( const Storage<>::ChannelView& grf, index_t idx, const Real threshold ) {
+		while ( idx != no_index && idx < grf.size() && grf[ idx ] < threshold ) idx++;
+		return idx < grf.size() ? idx : no_index;
 	}
 
-	index_t FindNextFlight( const Storage<>& sto, index_t idx, const index_t channel_idx, const Real threshold ) {
-		while ( idx != no_index && idx < sto.GetFrameCount() && sto.GetFrame( idx )[ channel_idx ] >= threshold ) idx++;
-		return idx < sto.GetFrameCount() ? idx : no_index;
+	index_t FindNextFlight( const Storage<>::ChannelView& grf, index_t idx, const Real threshold ) {
+		while ( idx != no_index && idx < grf.size() && grf[ idx ] >= threshold ) idx++;
+		return idx < grf.size() ? idx : no_index;
 	}
 
 	std::vector<GaitCycle> ExtractGaitCycles( const Storage<>& sto, Real threshold, TimeInSeconds min_stance )
@@ -19,24 +19,24 @@ namespace scone
 		for ( auto side : { Side::Left, Side::Right } )
 		{
 			string leg_name = ( side == Side::Left ) ? "leg0_l" : "leg1_r";
-			index_t grf_chan = sto.GetChannelIndex( leg_name + ".grf_norm_y" );
+			auto grf = sto.GetChannel( sto.GetChannelIndex( leg_name + ".grf_norm_y" ) );
 			index_t cop_chan = sto.GetChannelIndex( leg_name + ".cop_x" );
 
 			// skip to first touch down
-			index_t flight_idx = FindNextFlight( sto, 0u, grf_chan, threshold );
-			index_t touch_idx = FindNextTouch( sto, flight_idx, grf_chan, threshold );
+			index_t flight_idx = FindNextFlight( grf, 0u, threshold );
+			index_t touch_idx = FindNextTouch( grf, flight_idx, threshold );
 
 			while ( touch_idx != no_index && touch_idx < sto.GetFrameCount() )
 			{
 				auto begin_time = sto.GetFrame( touch_idx ).GetTime();
 				auto begin_pos = sto.GetFrame( touch_idx ).GetVec3( cop_chan );
 
-				flight_idx = FindNextFlight( sto, touch_idx, grf_chan, threshold );
+				flight_idx = FindNextFlight( grf, touch_idx, threshold );
 				if ( flight_idx == no_index )
 					break;
 				auto swing_time = sto.GetFrame( flight_idx ).GetTime();
 
-				touch_idx = FindNextTouch( sto, flight_idx, grf_chan, threshold );
+				touch_idx = FindNextTouch( grf, flight_idx, threshold );
 				if ( touch_idx == no_index )
 					break;
 				auto end_time = sto.GetFrame( touch_idx ).GetTime();
@@ -0,0 +1,51 @@
+/*
+** HasData.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "HasData.h"
+
+namespace scone
+{
+	StoreDataChannels& StoreDataChannels::Begin( Storage< Real >::Frame& frame )
+	{
+		const auto layout_id = frame.GetStorage().GetLayoutId();
+		if ( layout_id != m_LayoutId )
+		{
+			// storage has changed or was cleared, channel indices must be resolved again
+			m_Channels.clear();
+			m_LayoutId = layout_id;
+		}
+		m_Frame = &frame;
+		m_Position = 0;
+		return *this;
+	}
+
+	void StoreDataChannels::SetVec3( std::string_view prefix, std::string_view postfix, const Vec3& vec )
+	{
+		if ( !Matches( prefix, postfix ) || m_Position + 3 > m_Channels.size() )
+		{
+			auto label = String( prefix ) + String( postfix );
+			Resolve( prefix, postfix, label + "_x" );
+			Resolve( prefix, postfix, label + "_y" );
+			Resolve( prefix, postfix, label + "_z" );
+			m_Position -= 3;
+		}
+		SetValue( Next(), vec.x );
+		SetValue( Next(), vec.y );
+		SetValue( Next(), vec.z );
+	}
+
+	index_t StoreDataChannels::Resolve( std::string_view label, std::string_view postfix, const String& name )
+	{
+		SCONE_ASSERT( m_Frame );
+		Channel ch{ String( label ), String( postfix ), m_Frame->GetStorage().AcquireChannel( name ) };
+		if ( m_Position < m_Channels.size() )
+			m_Channels[ m_Position ] = std::move( ch );
+		else m_Channels.push_back( std::move( ch ) );
+		return m_Channels[ m_Position++ ].index;
+	}
+}
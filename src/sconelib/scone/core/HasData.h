@@ -11,6 +11,9 @@
 #include "Storage.h"
 #include "xo/container/flag_set.h"
 
+#include <string_view>
+#include <vector>
+
 namespace scone
 {
 	enum class StoreDataTypes {
@@ -33,11 +36,52 @@ namespace scone
 
 	using StoreDataFlags = xo::flag_set< StoreDataTypes >;
 
+	/// Channel indices used by StoreData(), resolved by label when the first frame of a Storage layout is stored.
+	/// Call Begin() at the start of StoreData(), then Set() values in the same order for each frame;
+	/// each label is compared to the label of the resolved channel at the same position,
+	/// when the order or labels change, the channel is looked up by name instead.
+	class SCONE_API StoreDataChannels
+	{
+	public:
+		StoreDataChannels& Begin( Storage< Real >::Frame& frame );
+
+		void Set( std::string_view label, Real value ) {
+			SetValue( Matches( label, {} ) ? Next() : Resolve( label, {}, String( label ) ), value );
+		}
+		void Set( std::string_view prefix, std::string_view postfix, Real value ) {
+			SetValue( Matches( prefix, postfix ) ? Next() : Resolve( prefix, postfix, String( prefix ) + String( postfix ) ), value );
+		}
+		void SetVec3( std::string_view prefix, std::string_view postfix, const Vec3& vec );
+
+		/// Labels that are composed once by the owner (when empty) and reused for each frame
+		std::vector< String >& GetLabels() { return m_Labels; }
+
+	private:
+		struct Channel { String label; String postfix; index_t index; };
+
+		bool Matches( std::string_view label, std::string_view postfix ) const {
+			return m_Position < m_Channels.size() && m_Channels[ m_Position ].label == label && m_Channels[ m_Position ].postfix == postfix;
+		}
+		index_t Next() { return m_Channels[ m_Position++ ].index; }
+		index_t Resolve( std::string_view label, std::string_view postfix, const String& name );
+		void SetValue( index_t idx, Real value ) { SCONE_ASSERT( m_Frame ); ( *m_Frame )[ idx ] = value; }
+
+		Storage< Real >::Frame* m_Frame = nullptr;
+		size_t m_LayoutId = 0;
+		std::vector< Channel > m_Channels;
+		std::vector< String > m_Labels;
+		index_t m_Position = 0;
+	};
+
 	/// Objects derived from this class can store data for analysis
 	class SCONE_API HasData
 	{
 	public:
 		virtual void StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const = 0;
 		inline virtual ~HasData() {}
+
+	protected:
+		/// Cached channel indices for StoreData()
+		mutable StoreDataChannels m_StoreDataChannels;
 	};
 }
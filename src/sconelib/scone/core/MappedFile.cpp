@@ -0,0 +1,95 @@
+/*
+** MappedFile.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "MappedFile.h"
+
+#include "Exception.h"
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace scone
+{
+#ifdef _WIN32
+	MappedFile::MappedFile( const xo::path& file ) :
+		data_( nullptr ),
+		size_( 0 ),
+		file_handle_( INVALID_HANDLE_VALUE ),
+		mapping_handle_( nullptr )
+	{
+		file_handle_ = CreateFileA( file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+		SCONE_ERROR_IF( file_handle_ == INVALID_HANDLE_VALUE, "Could not open file " + file.str() );
+
+		LARGE_INTEGER file_size;
+		GetFileSizeEx( file_handle_, &file_size );
+		size_ = static_cast<size_t>( file_size.QuadPart );
+		if ( size_ > 0 )
+		{
+			mapping_handle_ = CreateFileMappingA( file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr );
+			if ( mapping_handle_ )
+				data_ = static_cast<const char*>( MapViewOfFile( mapping_handle_, FILE_MAP_READ, 0, 0, 0 ) );
+			if ( !data_ )
+			{
+				if ( mapping_handle_ )
+					CloseHandle( mapping_handle_ );
+				CloseHandle( file_handle_ );
+				SCONE_ERROR( "Could not map file " + file.str() );
+			}
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if ( data_ )
+			UnmapViewOfFile( data_ );
+		if ( mapping_handle_ )
+			CloseHandle( mapping_handle_ );
+		if ( file_handle_ != INVALID_HANDLE_VALUE )
+			CloseHandle( file_handle_ );
+	}
+#else
+	MappedFile::MappedFile( const xo::path& file ) :
+		data_( nullptr ),
+		size_( 0 ),
+		file_descriptor_( -1 )
+	{
+		file_descriptor_ = open( file.c_str(), O_RDONLY );
+		SCONE_ERROR_IF( file_descriptor_ < 0, "Could not open file " + file.str() );
+
+		struct stat file_stat;
+		fstat( file_descriptor_, &file_stat );
+		size_ = static_cast<size_t>( file_stat.st_size );
+		if ( size_ > 0 )
+		{
+			auto* ptr = mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, file_descriptor_, 0 );
+			if ( ptr == MAP_FAILED )
+			{
+				close( file_descriptor_ );
+				SCONE_ERROR( "Could not map file " + file.str() );
+			}
+			data_ = static_cast<const char*>( ptr );
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if ( data_ )
+			munmap( const_cast<char*>( data_ ), size_ );
+		if ( file_descriptor_ >= 0 )
+			close( file_descriptor_ );
+	}
+#endif
+}
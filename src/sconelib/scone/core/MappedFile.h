@@ -0,0 +1,38 @@
+/*
+** MappedFile.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "xo/filesystem/path.h"
+
+namespace scone
+{
+	/// Read-only memory-mapped file; the contents are valid during the lifetime of this object.
+	class SCONE_API MappedFile
+	{
+	public:
+		MappedFile( const xo::path& file );
+		MappedFile( const MappedFile& ) = delete;
+		MappedFile& operator=( const MappedFile& ) = delete;
+		~MappedFile();
+
+		const char* data() const { return data_; }
+		size_t size() const { return size_; }
+
+	private:
+		const char* data_;
+		size_t size_;
+#ifdef _WIN32
+		void* file_handle_;
+		void* mapping_handle_;
+#else
+		int file_descriptor_;
+#endif
+	};
+}
@@ -0,0 +1,152 @@
+/*
+** ReferenceStorage.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ReferenceStorage.h"
+
+#include "StorageIo.h"
+#include "xo/filesystem/path.h"
+#include <cmath>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+
+namespace scone
+{
+	// values of all channels at multiples of step, stored row-major
+	struct ResampledStorage
+	{
+		ResampledStorage( s_ptr< const Storage<> > sto, TimeInSeconds step ) :
+			source( std::move( sto ) ),
+			step_size( step ),
+			channel_count( source->GetChannelCount() ),
+			frame_count( source->IsEmpty() ? 0 : size_t( source->Back().GetTime() / step_size ) + 1 )
+		{
+			values.resize( frame_count * channel_count );
+			auto cursor = source->GetCursor();
+			for ( index_t fidx = 0; fidx < frame_count; ++fidx )
+				cursor.Interpolate( fidx * step_size, &values[ fidx * channel_count ] );
+		}
+
+		const Real* TryGetFrame( TimeInSeconds time ) const {
+			const auto fidx = std::round( time / step_size );
+			if ( fidx < 0 || fidx >= frame_count || std::abs( time - fidx * step_size ) > 1e-6 * step_size )
+				return nullptr;
+			return &values[ size_t( fidx ) * channel_count ];
+		}
+
+		s_ptr< const Storage<> > source; // keeps the source alive, so it can be used to identify outdated data
+		TimeInSeconds step_size;
+		size_t channel_count;
+		size_t frame_count;
+		std::vector< Real > values;
+	};
+
+	namespace
+	{
+		template< typename T >
+		struct CacheEntry
+		{
+			std::weak_ptr< const T > data;
+			std::shared_future< s_ptr< const T > > loading; // valid while data is being created
+			size_t generation = 0; // identifies the loading thread, incremented when the entry is invalidated
+		};
+
+		struct StorageEntry : CacheEntry< Storage<> >
+		{
+			std::filesystem::file_time_type file_time;
+		};
+
+		std::mutex g_reference_mutex;
+		std::map< String, StorageEntry > g_storage_cache;
+		std::map< std::pair< const Storage<>*, TimeInSeconds >, CacheEntry< ResampledStorage > > g_resampled_cache;
+
+		// data is created by the first thread without holding the lock, other threads that need it wait for its result
+		template< typename T, typename F >
+		s_ptr< const T > AcquireCached( std::unique_lock< std::mutex >& lock, CacheEntry< T >& entry, F create )
+		{
+			if ( auto data = entry.data.lock() )
+				return data;
+			if ( entry.loading.valid() )
+			{
+				auto loading = entry.loading;
+				lock.unlock();
+				return loading.get();
+			}
+
+			std::promise< s_ptr< const T > > promise;
+			entry.loading = promise.get_future().share();
+			const auto generation = ++entry.generation;
+			lock.unlock();
+			try
+			{
+				s_ptr< const T > data = create();
+				promise.set_value( data );
+				lock.lock();
+				if ( entry.generation == generation )
+				{
+					entry.data = data;
+					entry.loading = {};
+				}
+				return data;
+			}
+			catch ( ... )
+			{
+				promise.set_exception( std::current_exception() );
+				lock.lock();
+				if ( entry.generation == generation )
+					entry.loading = {};
+				throw;
+			}
+		}
+
+		s_ptr< const Storage<> > AcquireStorage( const path& file )
+		{
+			std::error_code ec;
+			const auto file_time = std::filesystem::last_write_time( file.str(), ec );
+			std::unique_lock lock( g_reference_mutex );
+			auto& entry = g_storage_cache[ file.str() ];
+			if ( ec || entry.file_time != file_time )
+			{
+				entry.data.reset();
+				entry.loading = {};
+				entry.file_time = file_time;
+				++entry.generation;
+			}
+			return AcquireCached( lock, entry, [&]() {
+				auto sto = std::make_shared< Storage<> >();
+				ReadStorage( *sto, file );
+				return s_ptr< const Storage<> >( std::move( sto ) );
+			} );
+		}
+
+		// the resampled data keeps its source alive, so the address of the source identifies it
+		s_ptr< const ResampledStorage > AcquireResampledStorage( const s_ptr< const Storage<> >& storage, TimeInSeconds step_size )
+		{
+			std::unique_lock lock( g_reference_mutex );
+			auto& entry = g_resampled_cache[ { storage.get(), step_size } ];
+			return AcquireCached( lock, entry, [&]() {
+				return s_ptr< const ResampledStorage >( std::make_shared< ResampledStorage >( storage, step_size ) );
+			} );
+		}
+	}
+
+	ReferenceStorage::ReferenceStorage( const path& file, TimeInSeconds step_size ) :
+		storage_( AcquireStorage( file ) ),
+		resampled_( step_size > 0 ? AcquireResampledStorage( storage_, step_size ) : nullptr ),
+		cursor_( *storage_ )
+	{}
+
+	ReferenceStorage::Frame ReferenceStorage::GetFrame( TimeInSeconds time ) const
+	{
+		Frame f{ resampled_ ? resampled_->TryGetFrame( time ) : nullptr, {} };
+		if ( !f.values )
+			f.interpolated = cursor_.Seek( time );
+		return f;
+	}
+}
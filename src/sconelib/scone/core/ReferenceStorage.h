@@ -0,0 +1,44 @@
+/*
+** ReferenceStorage.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+#include "Storage.h"
+
+namespace scone
+{
+	struct ResampledStorage;
+
+	/// Read-only handle to reference data (e.g. motion files) that is shared between all models in the process.
+	/** Files are read once and released when no longer used; they are read again when the file has changed.
+	If a step size is provided, values are also resampled at multiples of that step size,
+	so that lookups at simulation time steps need no search or interpolation. */
+	class SCONE_API ReferenceStorage
+	{
+	public:
+		ReferenceStorage( const path& file, TimeInSeconds step_size = 0 );
+
+		const Storage<>& GetStorage() const { return *storage_; }
+		const Storage<>* operator->() const { return storage_.get(); }
+
+		/// Channel values at a specific time, from the resampled data if available
+		struct Frame {
+			const Real* values;
+			Storage<>::InterpolatedFrame interpolated;
+			Real value( index_t channel_idx ) const { return values ? values[ channel_idx ] : interpolated.value( channel_idx ); }
+		};
+		Frame GetFrame( TimeInSeconds time ) const;
+
+	private:
+		s_ptr< const Storage<> > storage_;
+		s_ptr< const ResampledStorage > resampled_;
+		mutable Storage<>::Cursor cursor_; // lookups that are not resampled mostly move forward in time
+	};
+}
@@ -0,0 +1,231 @@
+/*
+** Socket.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "Socket.h"
+
+#include "Exception.h"
+#include "string_tools.h"
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <winsock2.h>
+#	include <ws2tcpip.h>
+#	pragma comment( lib, "ws2_32.lib" )
+#else
+#	include <sys/types.h>
+#	include <sys/time.h>
+#	include <sys/socket.h>
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	include <arpa/inet.h>
+#	include <netdb.h>
+#	include <poll.h>
+#	include <unistd.h>
+#endif
+
+namespace scone
+{
+	namespace
+	{
+#ifdef _WIN32
+		using native_t = SOCKET;
+		using pollfd_t = WSAPOLLFD;
+		int close_socket( native_t s ) { return closesocket( s ); }
+		int poll_sockets( pollfd_t* fds, size_t n, int timeout_ms ) { return WSAPoll( fds, ULONG( n ), timeout_ms ); }
+		constexpr int send_flags = 0;
+		void InitializeSockets() {
+			static const bool initialized = [] { WSADATA data; return WSAStartup( MAKEWORD( 2, 2 ), &data ) == 0; }();
+			SCONE_ERROR_IF( !initialized, "Could not initialize Windows sockets" );
+		}
+#else
+		using native_t = int;
+		using pollfd_t = pollfd;
+		int close_socket( native_t s ) { return close( s ); }
+		int poll_sockets( pollfd_t* fds, size_t n, int timeout_ms ) { return poll( fds, nfds_t( n ), timeout_ms ); }
+#	ifdef MSG_NOSIGNAL
+		constexpr int send_flags = MSG_NOSIGNAL; // lost connections should not raise SIGPIPE
+#	else
+		constexpr int send_flags = 0;
+#	endif
+		void InitializeSockets() {}
+#endif
+
+		native_t Native( Socket::handle_t h ) { return static_cast<native_t>( h ); }
+
+		void ConfigureConnection( native_t s ) {
+			int one = 1;
+			setsockopt( s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>( &one ), sizeof( one ) );
+#if defined( SO_NOSIGPIPE )
+			setsockopt( s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof( one ) );
+#endif
+		}
+	}
+
+	Socket& Socket::operator=( Socket&& other ) noexcept
+	{
+		if ( this != &other )
+		{
+			Close();
+			handle_ = other.handle_;
+			other.handle_ = invalid_handle;
+		}
+		return *this;
+	}
+
+	Socket Socket::Listen( int port, bool local_only )
+	{
+		InitializeSockets();
+		auto s = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+		SCONE_ERROR_IF( Socket::handle_t( s ) == invalid_handle, "Could not create socket" );
+		Socket result( static_cast<Socket::handle_t>( s ) );
+
+		int one = 1;
+		setsockopt( s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>( &one ), sizeof( one ) );
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl( local_only ? INADDR_LOOPBACK : INADDR_ANY );
+		addr.sin_port = htons( static_cast<uint16_t>( port ) );
+		SCONE_ERROR_IF( bind( s, reinterpret_cast<sockaddr*>( &addr ), sizeof( addr ) ) != 0, "Could not bind to port " + to_str( port ) );
+		SCONE_ERROR_IF( listen( s, SOMAXCONN ) != 0, "Could not listen on port " + to_str( port ) );
+
+		return result;
+	}
+
+	Socket Socket::Connect( const String& host, int port )
+	{
+		InitializeSockets();
+		addrinfo hints{};
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+		addrinfo* info = nullptr;
+		if ( getaddrinfo( host.c_str(), to_str( port ).c_str(), &hints, &info ) != 0 )
+			return Socket();
+
+		Socket result;
+		for ( auto* ai = info; ai && !result.IsValid(); ai = ai->ai_next )
+		{
+			auto s = socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol );
+			if ( Socket::handle_t( s ) == invalid_handle )
+				continue;
+			if ( connect( s, ai->ai_addr, int( ai->ai_addrlen ) ) == 0 )
+			{
+				ConfigureConnection( s );
+				result = Socket( Socket::handle_t( s ) );
+			}
+			else close_socket( s );
+		}
+		freeaddrinfo( info );
+		return result;
+	}
+
+	Socket Socket::Accept()
+	{
+		auto s = accept( Native( handle_ ), nullptr, nullptr );
+		if ( Socket::handle_t( s ) == invalid_handle )
+			return Socket();
+		ConfigureConnection( s );
+		return Socket( Socket::handle_t( s ) );
+	}
+
+	void Socket::Close()
+	{
+		if ( IsValid() )
+		{
+			close_socket( Native( handle_ ) );
+			handle_ = invalid_handle;
+		}
+	}
+
+	bool Socket::Send( const void* data, size_t size )
+	{
+		auto* ptr = static_cast<const char*>( data );
+		while ( size > 0 )
+		{
+			auto n = send( Native( handle_ ), ptr, int( size ), send_flags );
+			if ( n <= 0 )
+				return false;
+			ptr += n;
+			size -= size_t( n );
+		}
+		return true;
+	}
+
+	void Socket::SetSendTimeout( double timeout )
+	{
+#ifdef _WIN32
+		DWORD tv = DWORD( 1000 * timeout );
+#else
+		timeval tv{};
+		tv.tv_sec = decltype( tv.tv_sec )( timeout );
+		tv.tv_usec = decltype( tv.tv_usec )( 1e6 * ( timeout - double( tv.tv_sec ) ) );
+#endif
+		setsockopt( Native( handle_ ), SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>( &tv ), sizeof( tv ) );
+	}
+
+	size_t Socket::Receive( void* data, size_t size )
+	{
+		auto n = recv( Native( handle_ ), static_cast<char*>( data ), int( size ), 0 );
+		return n > 0 ? size_t( n ) : 0;
+	}
+
+	bool Socket::ReceiveAll( void* data, size_t size )
+	{
+		auto* ptr = static_cast<char*>( data );
+		while ( size > 0 )
+		{
+			auto n = Receive( ptr, size );
+			if ( n == 0 )
+				return false;
+			ptr += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	String Socket::GetPeerName() const
+	{
+		sockaddr_in addr{};
+		socklen_t len = sizeof( addr );
+		if ( getpeername( Native( handle_ ), reinterpret_cast<sockaddr*>( &addr ), &len ) != 0 )
+			return "unknown";
+		char buf[ INET_ADDRSTRLEN ] = {};
+		inet_ntop( AF_INET, &addr.sin_addr, buf, sizeof( buf ) );
+		return String( buf ) + ":" + to_str( ntohs( addr.sin_port ) );
+	}
+
+	int Socket::GetLocalPort() const
+	{
+		sockaddr_in addr{};
+		socklen_t len = sizeof( addr );
+		if ( getsockname( Native( handle_ ), reinterpret_cast<sockaddr*>( &addr ), &len ) != 0 )
+			return 0;
+		return ntohs( addr.sin_port );
+	}
+
+	std::vector< size_t > WaitForReadable( const std::vector< const Socket* >& sockets, double timeout_seconds )
+	{
+		std::vector< pollfd_t > fds( sockets.size() );
+		for ( size_t i = 0; i < sockets.size(); ++i )
+		{
+			fds[ i ].fd = Native( sockets[ i ]->GetHandle() );
+			fds[ i ].events = POLLIN;
+		}
+
+		std::vector< size_t > readable;
+		if ( poll_sockets( fds.data(), fds.size(), int( 1000 * timeout_seconds ) ) > 0 )
+		{
+			for ( size_t i = 0; i < fds.size(); ++i )
+				if ( fds[ i ].revents != 0 ) // also report errors and hang-ups, these are detected when receiving
+					readable.push_back( i );
+		}
+		return readable;
+	}
+}
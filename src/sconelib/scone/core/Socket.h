@@ -0,0 +1,71 @@
+/*
+** Socket.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "types.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace scone
+{
+	/// Minimal TCP socket, sends and receives block unless WaitForReadable() reported data is available.
+	class SCONE_API Socket
+	{
+	public:
+		Socket() : handle_( invalid_handle ) {}
+		Socket( Socket&& other ) noexcept : handle_( other.handle_ ) { other.handle_ = invalid_handle; }
+		Socket& operator=( Socket&& other ) noexcept;
+		Socket( const Socket& ) = delete;
+		Socket& operator=( const Socket& ) = delete;
+		~Socket() { Close(); }
+
+		/// Create a socket that listens on the loopback interface, or on all interfaces if local_only is false; throws on error
+		static Socket Listen( int port, bool local_only = true );
+
+		/// Connect to host:port, returns an invalid socket on failure
+		static Socket Connect( const String& host, int port );
+
+		/// Accept a pending connection, should only be called if the listening socket is readable
+		Socket Accept();
+
+		bool IsValid() const { return handle_ != invalid_handle; }
+		void Close();
+
+		/// Send all data, returns false if the connection is lost
+		bool Send( const void* data, size_t size );
+
+		/// Make Send() fail if it is blocked for more than timeout seconds
+		void SetSendTimeout( double timeout );
+
+		/// Receive at most size bytes, returns 0 if the connection is lost
+		size_t Receive( void* data, size_t size );
+
+		/// Receive exactly size bytes, returns false if the connection is lost
+		bool ReceiveAll( void* data, size_t size );
+
+		/// Get the address of the remote end of a connected socket
+		String GetPeerName() const;
+
+		/// Get the local port, e.g. the port that was assigned when listening on port 0
+		int GetLocalPort() const;
+
+		using handle_t = std::intptr_t;
+		static constexpr handle_t invalid_handle = -1;
+		handle_t GetHandle() const { return handle_; }
+
+	private:
+		explicit Socket( handle_t h ) : handle_( h ) {}
+		handle_t handle_;
+	};
+
+	/// Wait until any of the sockets has data or a pending connection, returns the indices of the readable sockets
+	SCONE_API std::vector< size_t > WaitForReadable( const std::vector< const Socket* >& sockets, double timeout_seconds );
+}
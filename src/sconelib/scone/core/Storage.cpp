@@ -0,0 +1,20 @@
+/*
+** Storage.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "Storage.h"
+
+#include <atomic>
+
+namespace scone
+{
+	size_t NewStorageLayoutId()
+	{
+		static std::atomic< size_t > next_id = 1;
+		return next_id++;
+	}
+}
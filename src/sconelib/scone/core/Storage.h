@@ -14,6 +14,7 @@
 #include "Vec3.h"
 
 #include <memory>
+#include <deque>
 #include <map>
 #include <unordered_map>
 #include <vector>
@@ -23,40 +24,54 @@
 
 namespace scone
 {
+	/// Returns a unique id for Storage::GetLayoutId(), shared by all Storage types
+	SCONE_API size_t NewStorageLayoutId();
+
+	/// Time-indexed multi-channel data, stored column-major in chunks of frames.
+	/// Channel indices are stable; frames are lightweight views into the chunked data.
 	template< typename ValueT = Real, typename TimeT = TimeInSeconds >
 	class Storage
 	{
 	public:
+		/// Number of frames per chunk (must be a power of two)
+		static constexpr size_t chunk_frame_count = 256;
+
 		class Frame
 		{
 		public:
 			friend class Storage;
 
-			Frame( Storage& store, TimeT t, ValueT default_value = ValueT( 0 ) ) :
-			m_Store( store ),
-			m_Time( t ),
-			m_Values( store.GetChannelCount(), default_value ) { }
+			Frame( Storage& store, index_t frame_idx, TimeT t ) :
+			m_Store( &store ),
+			m_Index( frame_idx ),
+			m_Time( t ) {}
 
 			TimeT GetTime() const { return m_Time; }
+			index_t GetIndex() const { return m_Index; }
+			Storage& GetStorage() { return *m_Store; }
+			const Storage& GetStorage() const { return *m_Store; }
 
-			ValueT& operator[]( index_t idx ) { return m_Values[ idx ]; }
+			ValueT& operator[]( index_t idx ) { return m_Store->GetValue( m_Index, idx ); }
 
-			const ValueT& operator[]( index_t idx ) const { return m_Values[ idx ]; }
+			const ValueT& operator[]( index_t idx ) const { return m_Store->GetValue( m_Index, idx ); }
 
 			ValueT& operator[]( const String& label ) {
-				index_t idx = m_Store.TryGetChannelIndex( label );
-				if ( idx == NoIndex )
-					idx = m_Store.AddChannel( label );
-				return m_Values[ idx ];
+				return m_Store->GetValue( m_Index, m_Store->AcquireChannel( label ) );
 			}
 
 			const ValueT& operator[]( const String& label ) const {
-				index_t idx = m_Store.GetChannelIndex( label );
+				index_t idx = m_Store->GetChannelIndex( label );
 				SCONE_ASSERT( idx != NoIndex );
-				return m_Values[ idx ];
+				return m_Store->GetValue( m_Index, idx );
 			}
 
-			const std::vector< ValueT >& GetValues() const { return m_Values; }
+			/// Copy of all channel values in this frame
+			std::vector< ValueT > GetValues() const {
+				std::vector< ValueT > values( m_Store->GetChannelCount() );
+				for ( index_t idx = 0; idx < values.size(); ++idx )
+					values[ idx ] = m_Store->GetValue( m_Index, idx );
+				return values;
+			}
 
 			void SetVec3( const String& label, const Vec3& vec ) {
 				(*this)[ label + "_x" ] = vec.x;
@@ -65,18 +80,36 @@ namespace scone
 			}
 
 			Vec3 GetVec3( index_t idx ) const {
-				SCONE_ASSERT( idx != NoIndex && idx + 2 < m_Values.size() );
-				return Vec3( m_Values[ idx ], m_Values[ idx + 1 ], m_Values[ idx + 2 ] );
+				SCONE_ASSERT( idx != NoIndex && idx + 2 < m_Store->GetChannelCount() );
+				return Vec3( (*this)[ idx ], (*this)[ idx + 1 ], (*this)[ idx + 2 ] );
 			}
 
 		private:
-			Storage< ValueT, TimeT >& m_Store;
+			Storage< ValueT, TimeT >* m_Store;
+			index_t m_Index;
 			TimeT m_Time;
-			std::vector< ValueT > m_Values;
 		};
 
-		using FrameUP = std::unique_ptr< Frame >;
-		using container_t = std::vector< FrameUP >;
+		/// Read-only view of a single channel, does not copy data
+		class ChannelView
+		{
+		public:
+			ChannelView( const Storage& store, index_t channel_idx ) : m_Store( &store ), m_Channel( channel_idx ) {}
+
+			size_t size() const { return m_Store->GetFrameCount(); }
+			const ValueT& operator[]( index_t frame_idx ) const { return m_Store->GetValue( frame_idx, m_Channel ); }
+
+			/// Contiguous block of values for frames [ chunk_idx * chunk_frame_count, +GetChunkSize( chunk_idx ) )
+			size_t GetChunkCount() const { return ( size() + chunk_frame_count - 1 ) / chunk_frame_count; }
+			size_t GetChunkSize( index_t chunk_idx ) const { return std::min( chunk_frame_count, size() - chunk_idx * chunk_frame_count ); }
+			const ValueT* GetChunkData( index_t chunk_idx ) const { return &m_Store->m_Chunks[ chunk_idx ][ m_Channel * chunk_frame_count ]; }
+
+		private:
+			const Storage* m_Store;
+			index_t m_Channel;
+		};
+
+		using container_t = std::deque< Frame >;
 
 		Storage() {}
 		Storage( const Storage& other ) {
@@ -92,70 +125,120 @@ namespace scone
 		Storage& operator=( const Storage& other ) {
 			m_Labels = other.m_Labels;
 			m_LabelIndexMap = other.m_LabelIndexMap;
-			m_Data.clear();
-			m_Data.reserve( other.m_Data.size() );
-			for ( auto it = other.m_Data.begin(); it != other.m_Data.end(); ++it )
-				m_Data.push_back( std::make_unique<Frame>( **it ) );
+			m_Chunks = other.m_Chunks;
+			m_Data = other.m_Data;
+			UpdateFrameStore();
 			m_InterpolationCache.clear();
+			m_LayoutId = NewLayoutId();
 			return *this;
 		};
 		Storage& operator=( Storage&& other ) {
 			m_Labels = std::move( other.m_Labels );
 			m_LabelIndexMap = std::move( other.m_LabelIndexMap );
+			m_Chunks = std::move( other.m_Chunks );
 			m_Data = std::move( other.m_Data );
+			UpdateFrameStore();
 			m_InterpolationCache.clear();
+			m_LayoutId = NewLayoutId();
+			other.m_LayoutId = NewLayoutId();
 			return *this;
 		};
 
-		void Clear() { m_Labels.clear(); m_LabelIndexMap.clear(); m_Data.clear(); m_InterpolationCache.clear(); }
+		void Clear() { m_Labels.clear(); m_LabelIndexMap.clear(); m_Chunks.clear(); m_Data.clear(); m_InterpolationCache.clear(); m_LayoutId = NewLayoutId(); }
+
+		/// Unique id of the channel layout, which changes when channels are cleared or the storage is assigned.
+		/// Channel indices obtained earlier remain valid as long as the id is unchanged.
+		size_t GetLayoutId() const { return m_LayoutId; }
 
 		Storage CopySlice( size_t start, size_t size, size_t stride ) const {
 			SCONE_ASSERT( stride > 0 );
-			Storage r;
-			r.m_Labels = m_Labels;
-			r.m_LabelIndexMap = m_LabelIndexMap;
+			Storage r( m_Labels );
 			if ( size == 0 || size > GetFrameCount() / stride )
 				size = ( GetFrameCount() + stride - 1 ) / stride;
-			r.m_Data.reserve( size );
-			for ( size_t i = start; r.m_Data.size() < size && i < m_Data.size(); i += stride )
-				r.m_Data.push_back( std::make_unique<Frame>( *m_Data[ i ] ) );
+			for ( size_t i = start; r.GetFrameCount() < size && i < m_Data.size(); i += stride ) {
+				auto& f = r.AddFrame( m_Data[ i ].GetTime() );
+				for ( index_t c = 0; c < GetChannelCount(); ++c )
+					f[ c ] = m_Data[ i ][ c ];
+			}
 			return r;
 		}
 
 		Frame& AddFrame( TimeT time, ValueT default_value = ValueT( 0 ) ) {
-			SCONE_ERROR_IF( !m_Data.empty() && time <= m_Data.back()->GetTime(),
+			SCONE_ERROR_IF( !m_Data.empty() && time <= m_Data.back().GetTime(),
 				"Timestamp is not higher than previous frame time: " + std::to_string( time ) );
-			m_Data.push_back( std::make_unique<Frame>( *this, time, default_value ) );
+			const auto frame_idx = m_Data.size();
+			if ( frame_idx / chunk_frame_count >= m_Chunks.size() )
+				m_Chunks.emplace_back( GetChannelCount() * chunk_frame_count, default_value );
+			else
+			{
+				for ( index_t c = 0; c < GetChannelCount(); ++c )
+					GetValue( frame_idx, c ) = default_value;
+			}
+			m_Data.emplace_back( *this, frame_idx, time );
 			m_InterpolationCache.clear(); // cached iterators have become invalid
-			return *m_Data.back();
+			return m_Data.back();
 		}
 		
+		/// Remove the oldest chunk_count * chunk_frame_count frames, the remaining frames are re-indexed
+		void EraseFrontChunks( size_t chunk_count ) {
+			const auto frame_count = chunk_count * chunk_frame_count;
+			SCONE_ASSERT( frame_count <= m_Data.size() );
+			m_Chunks.erase( m_Chunks.begin(), m_Chunks.begin() + chunk_count );
+			m_Data.erase( m_Data.begin(), m_Data.begin() + frame_count );
+			for ( auto& f : m_Data )
+				f.m_Index -= frame_count;
+			m_InterpolationCache.clear();
+		}
+
 		bool IsEmpty() const { return m_Data.empty(); }
 
-		Frame& Back() { SCONE_ASSERT( !m_Data.empty() ); return *m_Data.back(); }
-		const Frame& Back() const { SCONE_ASSERT( !m_Data.empty() ); return *m_Data.back(); }
+		Frame& Back() { SCONE_ASSERT( !m_Data.empty() ); return m_Data.back(); }
+		const Frame& Back() const { SCONE_ASSERT( !m_Data.empty() ); return m_Data.back(); }
 
-		Frame& GetFrame( index_t frame_idx ) { SCONE_ASSERT( frame_idx < m_Data.size() ); return *m_Data[ frame_idx ]; }
-		const Frame& GetFrame( index_t frame_idx ) const { SCONE_ASSERT( frame_idx < m_Data.size() ); return *m_Data[ frame_idx ]; }
+		Frame& GetFrame( index_t frame_idx ) { SCONE_ASSERT( frame_idx < m_Data.size() ); return m_Data[ frame_idx ]; }
+		const Frame& GetFrame( index_t frame_idx ) const { SCONE_ASSERT( frame_idx < m_Data.size() ); return m_Data[ frame_idx ]; }
+
+		ValueT& GetValue( index_t frame_idx, index_t channel_idx ) {
+			return m_Chunks[ frame_idx / chunk_frame_count ][ channel_idx * chunk_frame_count + frame_idx % chunk_frame_count ];
+		}
+		const ValueT& GetValue( index_t frame_idx, index_t channel_idx ) const {
+			return m_Chunks[ frame_idx / chunk_frame_count ][ channel_idx * chunk_frame_count + frame_idx % chunk_frame_count ];
+		}
+
+		ChannelView GetChannel( index_t idx ) const { SCONE_ASSERT( idx < GetChannelCount() ); return ChannelView( *this, idx ); }
 
 		std::vector< ValueT > GetChannelData( index_t idx ) const {
-			std::vector< ValueT > result( GetFrameCount() );
-			for ( index_t f = 0; f < GetFrameCount(); ++f )
-				result[ f ] = GetFrame( f )[ idx ];
+			std::vector< ValueT > result;
+			result.reserve( GetFrameCount() );
+			auto channel = GetChannel( idx );
+			for ( index_t ci = 0; ci < channel.GetChunkCount(); ++ci )
+				result.insert( result.end(), channel.GetChunkData( ci ), channel.GetChunkData( ci ) + channel.GetChunkSize( ci ) );
 			return result;
 		}
 
+		/// Contiguous values of a channel within a chunk, for bulk access
+		ValueT* GetChunkData( index_t chunk_idx, index_t channel_idx ) { return &m_Chunks[ chunk_idx ][ channel_idx * chunk_frame_count ]; }
+
 		size_t GetFrameCount() const { return m_Data.size(); }
 
+		/// Number of frames for which memory has been allocated
+		size_t GetFrameCapacity() const { return m_Chunks.size() * chunk_frame_count; }
+
 		index_t AddChannel( const String& label, ValueT default_value = ValueT( 0 ) ) {
 			SCONE_ASSERT_MSG( TryGetChannelIndex( label ) == NoIndex, "Channel " + label + " already exists" );
 			m_Labels.push_back( label );
 			m_LabelIndexMap[ label ] = m_Labels.size() - 1;
-			for ( auto it = m_Data.begin(); it != m_Data.end(); ++it )
-				(*it)->m_Values.resize( m_Labels.size(), default_value ); // resize existing data
+			for ( auto& chunk : m_Chunks )
+				chunk.resize( m_Labels.size() * chunk_frame_count, default_value ); // append column to existing data
 			return m_Labels.size() - 1;
 		}
 
+		/// Get index of existing channel, or add a new channel if it doesn't exist
+		index_t AcquireChannel( const String& label ) {
+			index_t idx = TryGetChannelIndex( label );
+			return idx != NoIndex ? idx : AddChannel( label );
+		}
+
 		index_t GetChannelIndex( const String& label ) const {
 			auto it = m_LabelIndexMap.find( label );
 			SCONE_THROW_IF( it == m_LabelIndexMap.end(), "Could not find channel " + label );
@@ -184,7 +267,7 @@ namespace scone
 			else {
 				auto it0 = it;
 				--it0;
-				if ( time - (*it0)->GetTime() <= (*it)->GetTime() - time )
+				if ( time - it0->GetTime() <= it->GetTime() - time )
 					return it0 - m_Data.begin();
 				else return it - m_Data.begin();
 			}
@@ -196,7 +279,7 @@ namespace scone
 		struct InterpolatedFrame {
 			double upper_weight;
 			typename container_t::const_iterator upper_frame, lower_frame;
-			ValueT value( index_t channel_idx ) const { return upper_weight * (**upper_frame)[ channel_idx ] + ( 1.0 - upper_weight ) * (**lower_frame)[ channel_idx ]; }
+			ValueT value( index_t channel_idx ) const { return upper_weight * (*upper_frame)[ channel_idx ] + ( 1.0 - upper_weight ) * (*lower_frame)[ channel_idx ]; }
 		};
 
 		// Compute interpolated value (always recomputes, slow)
@@ -207,29 +290,70 @@ namespace scone
 
 		// Compute interpolated frame (always recomputes)
 		InterpolatedFrame ComputeInterpolatedFrame( TimeT time ) const {
-			InterpolatedFrame bf;
-			bf.upper_frame = upper_bound( time );
-			if ( bf.upper_frame == m_Data.cend() )
-			{
-				// timestamp too high, point to most recent frame
-				bf.lower_frame = bf.upper_frame = m_Data.begin() + m_Data.size() - 1;
-				bf.upper_weight = 1.0;
+			return MakeInterpolatedFrame( upper_bound( time ) - m_Data.cbegin(), time );
+		}
+
+		/// Interpolated lookups for times that mostly increase, e.g. once per simulation step.
+		/// Non-decreasing times are found in amortized constant time, other times using a binary search.
+		/// Remains valid when frames are added, but not when the storage is moved or destroyed.
+		class Cursor
+		{
+		public:
+			Cursor( const Storage& store ) : m_Store( &store ), m_Upper( 0 ) {}
+
+			/// Same result as ComputeInterpolatedFrame( time )
+			InterpolatedFrame Seek( TimeT time ) { return m_Store->MakeInterpolatedFrame( Advance( time ), time ); }
+
+			/// Interpolate the values of channels at time, values must have room for channels.size() elements
+			void Interpolate( TimeT time, const std::vector< index_t >& channels, ValueT* values ) {
+				Interpolate( time, channels.size(), [&]( index_t i ) { return channels[ i ]; }, values );
 			}
-			else if ( bf.upper_frame == m_Data.cbegin() )
-			{
-				// timestamp too low, point to oldest frame
-				bf.lower_frame = bf.upper_frame;
-				bf.upper_weight = 1.0;
+
+			/// Interpolate the values of all channels at time, values must have room for GetChannelCount() elements
+			void Interpolate( TimeT time, ValueT* values ) {
+				Interpolate( time, m_Store->GetChannelCount(), []( index_t i ) { return i; }, values );
 			}
-			else
-			{
-				// we have an actual interpolation
-				bf.lower_frame = bf.upper_frame - 1;
-				bf.upper_weight = ( time - (*bf.lower_frame)->GetTime() ) / ( (*bf.upper_frame)->GetTime() - (*bf.lower_frame)->GetTime() );
+
+		private:
+			// index of the first frame later than time, starting from the previous result
+			index_t Advance( TimeT time ) {
+				SCONE_ASSERT( !m_Store->IsEmpty() );
+				const auto& data = m_Store->m_Data;
+				const auto n = data.size();
+				index_t lo = std::min( m_Upper, n ), hi = lo;
+				if ( lo > 0 && time < data[ lo - 1 ].GetTime() )
+					lo = 0; // time has decreased, search all frames before the previous result
+				else
+				{
+					for ( size_t step = 1; hi < n && data[ hi ].GetTime() <= time; step *= 2 )
+					{
+						// all frames before lo are not later than time, increase the search range exponentially
+						lo = hi + 1;
+						hi = std::min( lo + step, n );
+					}
+				}
+				m_Upper = std::upper_bound( data.cbegin() + lo, data.cbegin() + hi, time,
+					[]( TimeT lhs, const Frame& rhs ) { return lhs < rhs.GetTime(); } ) - data.cbegin();
+				return m_Upper;
 			}
 
-			return bf;
-		}
+			template< typename ChannelF > void Interpolate( TimeT time, size_t count, ChannelF channel, ValueT* values ) {
+				const auto f = m_Store->MakeInterpolatedFrame( Advance( time ), time );
+				const auto lower_idx = f.lower_frame->GetIndex(), upper_idx = f.upper_frame->GetIndex();
+				const auto* lower = &m_Store->m_Chunks[ lower_idx / chunk_frame_count ][ lower_idx % chunk_frame_count ];
+				const auto* upper = &m_Store->m_Chunks[ upper_idx / chunk_frame_count ][ upper_idx % chunk_frame_count ];
+				for ( index_t i = 0; i < count; ++i )
+				{
+					const auto offset = channel( i ) * chunk_frame_count;
+					values[ i ] = f.upper_weight * upper[ offset ] + ( 1.0 - f.upper_weight ) * lower[ offset ];
+				}
+			}
+
+			const Storage* m_Store;
+			index_t m_Upper;
+		};
+
+		Cursor GetCursor() const { return Cursor( *this ); }
 
 		// Get interpolated value, check cached results first
 		ValueT GetInterpolatedValue( TimeT time, index_t idx ) {
@@ -251,11 +375,45 @@ namespace scone
 
 	private:
 		std::vector< String > m_Labels;
+		std::vector< std::vector< ValueT > > m_Chunks; // column-major blocks of chunk_frame_count frames
 		container_t m_Data;
 		std::unordered_map< String, index_t > m_LabelIndexMap;
+		size_t m_LayoutId = NewLayoutId();
+		static size_t NewLayoutId() { return NewStorageLayoutId(); }
+
+		void UpdateFrameStore() {
+			for ( auto& f : m_Data )
+				f.m_Store = this;
+		}
 
 		auto upper_bound( TimeT time ) const {
-			return std::upper_bound( m_Data.cbegin(), m_Data.cend(), time, []( TimeT lhs, const FrameUP& rhs ) { return lhs < rhs->GetTime(); } );
+			return std::upper_bound( m_Data.cbegin(), m_Data.cend(), time, []( TimeT lhs, const Frame& rhs ) { return lhs < rhs.GetTime(); } );
+		}
+
+		// interpolated frame at time, based on the index of the first frame later than time
+		InterpolatedFrame MakeInterpolatedFrame( index_t upper_idx, TimeT time ) const {
+			SCONE_ASSERT( !m_Data.empty() );
+			InterpolatedFrame bf;
+			bf.upper_frame = m_Data.cbegin() + upper_idx;
+			if ( upper_idx == m_Data.size() )
+			{
+				// timestamp too high, point to most recent frame
+				bf.lower_frame = bf.upper_frame = m_Data.cbegin() + m_Data.size() - 1;
+				bf.upper_weight = 1.0;
+			}
+			else if ( upper_idx == 0 )
+			{
+				// timestamp too low, point to oldest frame
+				bf.lower_frame = bf.upper_frame;
+				bf.upper_weight = 1.0;
+			}
+			else
+			{
+				// we have an actual interpolation
+				bf.lower_frame = bf.upper_frame - 1;
+				bf.upper_weight = ( time - bf.lower_frame->GetTime() ) / ( bf.upper_frame->GetTime() - bf.lower_frame->GetTime() );
+			}
+			return bf;
 		}
 
 		std::map< TimeT, InterpolatedFrame > m_InterpolationCache;
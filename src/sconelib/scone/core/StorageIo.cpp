@@ -7,6 +7,7 @@
 */
 
 #include "StorageIo.h"
+#include "MappedFile.h"
 
 #include "xo/string/string_tools.h"
 #include "xo/filesystem/path.h"
@@ -14,6 +15,7 @@
 #include "xo/numerical/constants.h"
 #include <sstream>
 #include <fstream>
+#include <cstring>
 #include "xo/utility/hash.h"
 
 #ifdef XO_COMP_MSVC
@@ -23,6 +25,39 @@
 namespace scone
 {
 	constexpr double interval_epsilon = 1e-6;
+	constexpr char binary_magic[ 8 ] = { 'S', 'C', 'O', 'N', 'E', 'S', 'T', 'B' };
+	constexpr std::uint32_t binary_version = 1;
+
+	struct BinaryStorageHeader {
+		char magic[ 8 ];
+		std::uint32_t version;
+		std::uint32_t encoding;
+		std::uint64_t frame_count;
+		std::uint64_t channel_count;
+		std::uint64_t block_frame_count;
+		std::uint64_t label_size;
+	};
+	static_assert( sizeof( BinaryStorageHeader ) == 48, "Unexpected BinaryStorageHeader size" );
+
+	size_t GetPaddedSize( size_t s ) { return ( s + 7 ) / 8 * 8; }
+	size_t GetValueSize( StorageEncoding e ) { return e == StorageEncoding::Float64 ? sizeof( double ) : sizeof( float ); }
+
+	std::vector< index_t > GetFrameIndices( const Storage<Real, TimeInSeconds>& storage, TimeInSeconds min_interval )
+	{
+		std::vector< index_t > indices;
+		indices.reserve( storage.GetFrameCount() );
+		auto prev_time = xo::constantsd::lowest();
+		for ( index_t idx = 0; idx < storage.GetFrameCount(); ++idx )
+		{
+			auto t = storage.GetFrame( idx ).GetTime();
+			if ( xo::greater_than_or_equal( t - prev_time, min_interval, interval_epsilon ) )
+			{
+				indices.push_back( idx );
+				prev_time = t;
+			}
+		}
+		return indices;
+	}
 
 	size_t CountFrames( const Storage<Real, TimeInSeconds>& storage, TimeInSeconds min_interval )
 	{
@@ -33,7 +68,7 @@ namespace scone
 		auto prev_time = xo::constantsd::lowest();
 		for ( auto& frame : storage.GetData() )
 		{
-			auto t = frame->GetTime();
+			auto t = frame.GetTime();
 			if ( xo::greater_than_or_equal( t - prev_time, min_interval, interval_epsilon ) )
 			{
 				++frames;
@@ -54,12 +89,12 @@ namespace scone
 		auto prev_time = xo::constantsd::lowest();
 		for ( auto& frame : storage.GetData() )
 		{
-			auto t = frame->GetTime();
+			auto t = frame.GetTime();
 			if ( xo::greater_than_or_equal( t - prev_time, min_interval, interval_epsilon ) )
 			{
-				str << frame->GetTime();
+				str << frame.GetTime();
 				for ( size_t idx = 0; idx < storage.GetChannelCount(); ++idx )
-					str << "\t" << ( *frame )[ idx ];
+					str << "\t" << frame[ idx ];
 				str << "\n";
 				prev_time = t;
 			}
@@ -76,12 +111,12 @@ namespace scone
 		auto prev_time = xo::constantsd::lowest();
 		for ( auto& frame : storage.GetData() )
 		{
-			auto t = frame->GetTime();
+			auto t = frame.GetTime();
 			if ( xo::greater_than_or_equal( t - prev_time, min_interval, interval_epsilon ) )
 			{
-				fprintf( f, "%g", frame->GetTime() );
+				fprintf( f, "%g", frame.GetTime() );
 				for ( size_t idx = 0; idx < storage.GetChannelCount(); ++idx )
-					fprintf( f, "\t%g", ( *frame )[ idx ] );
+					fprintf( f, "\t%g", frame[ idx ] );
 				fprintf( f, "\n" );
 				prev_time = t;
 			}
@@ -137,6 +172,219 @@ namespace scone
 #endif
 	}
 
+	void WriteStorageBinaryHeader( std::ostream& str, const std::vector< String >& labels, StorageEncoding encoding, size_t frame_count, size_t block_frame_count )
+	{
+		String label_data;
+		for ( const auto& l : labels )
+			label_data.append( l.c_str(), l.size() + 1 );
+		label_data.resize( GetPaddedSize( label_data.size() ), '\0' );
+		BinaryStorageHeader header{ {}, binary_version, std::uint32_t( encoding ), frame_count, labels.size(), block_frame_count, label_data.size() };
+		std::memcpy( header.magic, binary_magic, sizeof( binary_magic ) );
+		str.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+		str.write( label_data.data(), label_data.size() );
+	}
+
+	void WriteStorageBinary( const Storage<Real, TimeInSeconds>& storage, const xo::path& file, StorageEncoding encoding, TimeInSeconds min_interval )
+	{
+		std::ofstream ofs( file.str(), std::ios::binary );
+		SCONE_ERROR_IF( !ofs.good(), "Could not open file " + file.str() );
+
+		const auto frames = GetFrameIndices( storage, min_interval );
+		const auto channel_count = storage.GetChannelCount();
+		const size_t block_frame_count = Storage<Real, TimeInSeconds>::chunk_frame_count;
+		WriteStorageBinaryHeader( ofs, storage.GetLabels(), encoding, frames.size(), block_frame_count );
+
+		// times and initial values
+		std::vector< double > values;
+		values.reserve( std::max( frames.size(), channel_count ) );
+		for ( auto fidx : frames )
+			values.push_back( storage.GetFrame( fidx ).GetTime() );
+		ofs.write( reinterpret_cast<const char*>( values.data() ), values.size() * sizeof( double ) );
+
+		std::vector< double > reconstructed( channel_count, 0.0 );
+		if ( encoding == StorageEncoding::DeltaFloat32 )
+		{
+			for ( index_t c = 0; c < channel_count && !frames.empty(); ++c )
+				reconstructed[ c ] = storage.GetValue( frames.front(), c );
+			ofs.write( reinterpret_cast<const char*>( reconstructed.data() ), reconstructed.size() * sizeof( double ) );
+		}
+
+		// column-major blocks
+		std::vector< float > fvalues;
+		for ( size_t block_start = 0; block_start < frames.size(); block_start += block_frame_count )
+		{
+			const auto block_end = std::min( block_start + block_frame_count, frames.size() );
+			for ( index_t c = 0; c < channel_count; ++c )
+			{
+				switch ( encoding )
+				{
+				case StorageEncoding::Float64:
+					values.clear();
+					for ( auto i = block_start; i < block_end; ++i )
+						values.push_back( storage.GetValue( frames[ i ], c ) );
+					ofs.write( reinterpret_cast<const char*>( values.data() ), values.size() * sizeof( double ) );
+					break;
+				case StorageEncoding::Float32:
+					fvalues.clear();
+					for ( auto i = block_start; i < block_end; ++i )
+						fvalues.push_back( float( storage.GetValue( frames[ i ], c ) ) );
+					ofs.write( reinterpret_cast<const char*>( fvalues.data() ), fvalues.size() * sizeof( float ) );
+					break;
+				case StorageEncoding::DeltaFloat32:
+					// deltas are relative to the reconstructed values, so that errors do not accumulate
+					fvalues.clear();
+					for ( auto i = block_start; i < block_end; ++i )
+					{
+						auto delta = float( storage.GetValue( frames[ i ], c ) - reconstructed[ c ] );
+						reconstructed[ c ] += delta;
+						fvalues.push_back( delta );
+					}
+					ofs.write( reinterpret_cast<const char*>( fvalues.data() ), fvalues.size() * sizeof( float ) );
+					break;
+				default: SCONE_ERROR( "Unsupported storage encoding" );
+				}
+			}
+		}
+		SCONE_ERROR_IF( !ofs.good(), "Error writing " + file.str() );
+	}
+
+	void ReadStorageBinary( Storage<Real, TimeInSeconds>& storage, const xo::path& file )
+	{
+		using StorageT = Storage<Real, TimeInSeconds>;
+		StorageFileView view( file );
+
+		storage = StorageT( view.GetLabels() );
+		for ( index_t fidx = 0; fidx < view.GetFrameCount(); ++fidx )
+			storage.AddFrame( view.GetTimes()[ fidx ] );
+
+		const auto channel_count = view.GetChannelCount();
+		std::vector< double > reconstructed;
+		if ( view.GetEncoding() == StorageEncoding::DeltaFloat32 )
+			reconstructed.assign( view.GetInitialValues(), view.GetInitialValues() + channel_count );
+
+		for ( index_t b = 0; b < view.GetBlockCount(); ++b )
+		{
+			const auto block_start = b * view.GetBlockFrameCount();
+			const auto block_size = view.GetBlockSize( b );
+			for ( index_t c = 0; c < channel_count; ++c )
+			{
+				const auto* data = view.GetBlockData( b, c );
+				switch ( view.GetEncoding() )
+				{
+				case StorageEncoding::Float64:
+					if ( view.GetBlockFrameCount() == StorageT::chunk_frame_count )
+						std::memcpy( storage.GetChunkData( b, c ), data, block_size * sizeof( double ) ); // same layout
+					else for ( index_t i = 0; i < block_size; ++i )
+						storage.GetValue( block_start + i, c ) = static_cast<const double*>( data )[ i ];
+					break;
+				case StorageEncoding::Float32:
+					for ( index_t i = 0; i < block_size; ++i )
+						storage.GetValue( block_start + i, c ) = static_cast<const float*>( data )[ i ];
+					break;
+				case StorageEncoding::DeltaFloat32:
+					for ( index_t i = 0; i < block_size; ++i )
+						storage.GetValue( block_start + i, c ) = reconstructed[ c ] += static_cast<const float*>( data )[ i ];
+					break;
+				}
+			}
+		}
+	}
+
+	StorageFileView::StorageFileView( const xo::path& file ) :
+		file_( std::make_unique<MappedFile>( file ) ),
+		times_( nullptr ),
+		initial_values_( nullptr ),
+		blocks_( nullptr )
+	{
+		BinaryStorageHeader header;
+		SCONE_ERROR_IF( file_->size() < sizeof( header ), "Invalid binary storage file: " + file.str() );
+		std::memcpy( &header, file_->data(), sizeof( header ) );
+		SCONE_ERROR_IF( std::memcmp( header.magic, binary_magic, sizeof( binary_magic ) ) != 0, "Invalid binary storage file: " + file.str() );
+		SCONE_ERROR_IF( header.version > binary_version, "Unsupported binary storage version in " + file.str() );
+		SCONE_ERROR_IF( header.encoding > std::uint32_t( StorageEncoding::DeltaFloat32 ), "Unsupported storage encoding in " + file.str() );
+		SCONE_ERROR_IF( header.block_frame_count == 0 || header.label_size % 8 != 0, "Invalid binary storage file: " + file.str() );
+
+		encoding_ = StorageEncoding( header.encoding );
+		frame_count_ = header.frame_count;
+		block_frame_count_ = header.block_frame_count;
+		value_size_ = GetValueSize( encoding_ );
+
+		// validate all sizes against the file size before using them, dividing instead of multiplying to prevent overflow
+		size_t remaining = file_->size() - sizeof( header );
+		auto consume = [&]( std::uint64_t count, size_t element_size ) {
+			SCONE_ERROR_IF( element_size > 0 && count > remaining / element_size, "Binary storage file is incomplete: " + file.str() );
+			remaining -= size_t( count ) * element_size;
+		};
+		consume( header.label_size, 1 );
+		SCONE_ERROR_IF( header.channel_count > header.label_size, "Invalid binary storage labels in " + file.str() ); // labels are zero-terminated
+		consume( header.frame_count, sizeof( double ) );
+		if ( encoding_ == StorageEncoding::DeltaFloat32 )
+			consume( header.channel_count, sizeof( double ) );
+		if ( header.channel_count > 0 )
+		{
+			SCONE_ERROR_IF( header.frame_count > remaining / value_size_ / header.channel_count, "Binary storage file is incomplete: " + file.str() );
+			consume( header.frame_count * header.channel_count, value_size_ );
+		}
+
+		// labels
+		const char* pos = file_->data() + sizeof( header );
+		const char* labels_end = pos + header.label_size;
+		labels_.reserve( header.channel_count );
+		while ( labels_.size() < header.channel_count && pos < labels_end )
+		{
+			auto len = strnlen( pos, labels_end - pos );
+			labels_.emplace_back( pos, len );
+			pos += len + 1;
+		}
+		SCONE_ERROR_IF( labels_.size() != header.channel_count, "Invalid binary storage labels in " + file.str() );
+
+		// times, initial values and blocks
+		times_ = reinterpret_cast<const double*>( labels_end );
+		pos = labels_end + frame_count_ * sizeof( double );
+		if ( encoding_ == StorageEncoding::DeltaFloat32 )
+		{
+			initial_values_ = reinterpret_cast<const double*>( pos );
+			pos += GetChannelCount() * sizeof( double );
+		}
+		blocks_ = pos;
+	}
+
+	StorageFileView::StorageFileView( StorageFileView&& ) = default;
+	StorageFileView::~StorageFileView() {}
+
+	index_t StorageFileView::TryGetChannelIndex( const String& label ) const
+	{
+		auto it = std::find( labels_.begin(), labels_.end(), label );
+		return it != labels_.end() ? index_t( it - labels_.begin() ) : NoIndex;
+	}
+
+	const void* StorageFileView::GetBlockData( index_t block_idx, index_t channel_idx ) const
+	{
+		SCONE_ASSERT( block_idx < GetBlockCount() && channel_idx < GetChannelCount() );
+		auto offset = block_idx * block_frame_count_ * GetChannelCount() + channel_idx * GetBlockSize( block_idx );
+		return blocks_ + offset * value_size_;
+	}
+
+	double StorageFileView::GetValue( index_t frame_idx, index_t channel_idx ) const
+	{
+		SCONE_ERROR_IF( encoding_ == StorageEncoding::DeltaFloat32, "Random access is not supported for DeltaFloat32 storage" );
+		const auto* data = GetBlockData( frame_idx / block_frame_count_, channel_idx );
+		if ( encoding_ == StorageEncoding::Float64 )
+			return static_cast<const double*>( data )[ frame_idx % block_frame_count_ ];
+		else return static_cast<const float*>( data )[ frame_idx % block_frame_count_ ];
+	}
+
+	void WriteStorage( const Storage<Real, TimeInSeconds>& storage, const xo::path& file, const String& name, TimeInSeconds min_interval )
+	{
+		switch ( xo::hash( file.extension_no_dot().str() ) )
+		{
+		case "txt"_hash: return WriteStorageTxt( storage, file, "time", min_interval );
+		case "sto"_hash: return WriteStorageSto( storage, file, name, min_interval );
+		case "stob"_hash: return WriteStorageBinary( storage, file, StorageEncoding::Float64, min_interval );
+		default: SCONE_ERROR( "Unsupported file format: " + file.str() );
+		}
+	}
+
 	void ReadStorageSto( Storage<Real, TimeInSeconds>& storage, const xo::path& file )
 	{
 		auto str = xo::char_stream( xo::load_string( file ) );
@@ -161,6 +409,7 @@ namespace scone
 		{
 		case "txt"_hash: return ReadStorageTxt( storage, file );
 		case "sto"_hash: return ReadStorageSto( storage, file );
+		case "stob"_hash: return ReadStorageBinary( storage, file );
 		default: SCONE_ERROR( "Unsupported file format: " + file.str() );
 		}
 	}
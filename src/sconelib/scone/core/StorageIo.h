@@ -13,6 +13,8 @@
 #include "xo/serialization/char_stream.h"
 #include <iosfwd>
 #include <cstdio>
+#include <cstdint>
+#include <memory>
 
 namespace scone
 {
@@ -30,6 +32,72 @@ namespace scone
 	void SCONE_API ReadStorageSto( Storage< Real, TimeInSeconds >& storage, const xo::path& file );
 	void SCONE_API ReadStorageSto( Storage< Real, TimeInSeconds >& storage, xo::char_stream& str );
 
-	/// read storage file, autodetect format (txt or sto)
+	class MappedFile;
+
+	/// Encoding of values in binary storage files
+	enum class StorageEncoding : std::uint32_t {
+		Float64 = 0, // lossless
+		Float32 = 1, // half the size, ~7 significant digits
+		DeltaFloat32 = 2 // float32 differences between subsequent frames, with float64 initial values
+	};
+
+	/// Write storage in binary format (.stob), which consists of:
+	/// - header: "SCONESTB", version, encoding, frame count, channel count, block size, label size (native byte order)
+	/// - channel labels (null-terminated), padded to 8 bytes
+	/// - frame times (float64), followed by initial channel values (float64) for DeltaFloat32
+	/// - channel values in column-major blocks of block size frames
+	void SCONE_API WriteStorageBinary( const Storage< Real, TimeInSeconds >& storage, const xo::path& file, StorageEncoding encoding = StorageEncoding::Float64, TimeInSeconds min_interval = 0.0 );
+	void SCONE_API ReadStorageBinary( Storage< Real, TimeInSeconds >& storage, const xo::path& file );
+
+	/// Write the header and labels of a binary storage file, used for writing .stob files incrementally
+	void SCONE_API WriteStorageBinaryHeader( std::ostream& str, const std::vector< String >& labels, StorageEncoding encoding, size_t frame_count, size_t block_frame_count );
+
+	/// read storage file, autodetect format (txt, sto or stob)
 	void SCONE_API ReadStorage( Storage< Real, TimeInSeconds >& storage, const xo::path& file );
+
+	/// write storage file, format is based on extension (txt, sto or stob)
+	void SCONE_API WriteStorage( const Storage< Real, TimeInSeconds >& storage, const xo::path& file, const String& name, TimeInSeconds min_interval = 0.0 );
+
+	/// Read-only view of a binary storage file (.stob), which is memory-mapped instead of read
+	class SCONE_API StorageFileView
+	{
+	public:
+		StorageFileView( const xo::path& file );
+		StorageFileView( StorageFileView&& );
+		~StorageFileView();
+
+		StorageEncoding GetEncoding() const { return encoding_; }
+		size_t GetFrameCount() const { return frame_count_; }
+		size_t GetChannelCount() const { return labels_.size(); }
+		const std::vector< String >& GetLabels() const { return labels_; }
+		index_t TryGetChannelIndex( const String& label ) const;
+
+		/// Frame times, GetFrameCount() values
+		const double* GetTimes() const { return times_; }
+
+		/// Initial channel values, only for DeltaFloat32 encoding
+		const double* GetInitialValues() const { return initial_values_; }
+
+		/// Values are stored in blocks of GetBlockFrameCount() frames, the last block may be smaller
+		size_t GetBlockFrameCount() const { return block_frame_count_; }
+		size_t GetBlockCount() const { return ( frame_count_ + block_frame_count_ - 1 ) / block_frame_count_; }
+		size_t GetBlockSize( index_t block_idx ) const { return std::min( block_frame_count_, frame_count_ - block_idx * block_frame_count_ ); }
+
+		/// Contiguous values of a channel within a block, of type double (Float64) or float (Float32, DeltaFloat32)
+		const void* GetBlockData( index_t block_idx, index_t channel_idx ) const;
+
+		/// Value at a specific frame, only for Float64 and Float32 encoding
+		double GetValue( index_t frame_idx, index_t channel_idx ) const;
+
+	private:
+		std::unique_ptr< MappedFile > file_;
+		StorageEncoding encoding_;
+		size_t frame_count_;
+		size_t block_frame_count_;
+		size_t value_size_;
+		std::vector< String > labels_;
+		const double* times_;
+		const double* initial_values_;
+		const char* blocks_;
+	};
 }
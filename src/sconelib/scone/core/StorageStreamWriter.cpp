@@ -0,0 +1,244 @@
+/*
+** StorageStreamWriter.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "StorageStreamWriter.h"
+
+#include "Exception.h"
+#include "Log.h"
+#include "StorageIo.h"
+#include "TraceRecorder.h"
+#include "xo/numerical/constants.h"
+#include "xo/numerical/math.h"
+#include "xo/string/pattern_matcher.h"
+
+#ifdef XO_COMP_MSVC
+#pragma warning( disable: 4996 )
+#endif
+
+namespace scone
+{
+	constexpr double interval_epsilon = 1e-6;
+
+	StorageStreamWriter::StorageStreamWriter( const xo::path& file, const String& name, TimeInSeconds min_interval, size_t max_queued_chunks ) :
+		file_( file ),
+		name_( name ),
+		file_handle_( nullptr ),
+		row_count_pos_( 0 ),
+		row_count_( 0 ),
+		channel_count_( NoIndex ),
+		min_interval_( min_interval ),
+		prev_time_( xo::constantsd::lowest() ),
+		added_channel_warning_( false ),
+		binary_block_frames_( 0 ),
+		channel_handle_( nullptr ),
+		max_queued_chunks_( std::max<size_t>( max_queued_chunks, 1 ) ),
+		finished_( false )
+	{
+		file_handle_ = std::fopen( file_.c_str(), "w" );
+		SCONE_ERROR_IF( !file_handle_, "Could not open file " + file_.str() );
+		thread_ = std::thread( &StorageStreamWriter::Run, this );
+	}
+
+	StorageStreamWriter::~StorageStreamWriter()
+	{
+		Finish();
+	}
+
+	void StorageStreamWriter::AddBinaryOutput( const xo::path& file )
+	{
+		SCONE_ERROR_IF( channel_count_ != NoIndex, "Binary output must be added before writing to " + file_.str() );
+		binary_file_ = file;
+		binary_blocks_.open( ( binary_file_ + ".tmp" ).str(), std::ios::binary );
+		SCONE_ERROR_IF( !binary_blocks_.good(), "Could not open file " + binary_file_.str() + ".tmp" );
+	}
+
+	void StorageStreamWriter::AddChannelOutput( const xo::path& file, const String& channel_pattern )
+	{
+		SCONE_ERROR_IF( channel_count_ != NoIndex, "Channel output must be added before writing to " + file_.str() );
+		channel_file_ = file;
+		channel_pattern_ = channel_pattern;
+		channel_handle_ = std::fopen( channel_file_.c_str(), "w" );
+		SCONE_ERROR_IF( !channel_handle_, "Could not open file " + channel_file_.str() );
+	}
+
+	void StorageStreamWriter::Write( const Storage< Real, TimeInSeconds >& storage, index_t begin, index_t end )
+	{
+		SCONE_ASSERT( begin <= end && end <= storage.GetFrameCount() );
+		SCONE_ERROR_IF( finished_, "Cannot write to " + file_.str() + " after it was finished" );
+
+		// the header is written before the writer thread receives any data
+		if ( channel_count_ == NoIndex )
+			WriteHeader( storage.GetLabels() );
+		else if ( storage.GetChannelCount() > channel_count_ && !added_channel_warning_ )
+		{
+			added_channel_warning_ = true;
+			log::warning( "Channel ", storage.GetLabel( channel_count_ ), " was added after data streaming to ", file_.str(), " has started and is not written; disable results.stream_data to store this data" );
+		}
+
+		Chunk chunk;
+		chunk.times.reserve( end - begin );
+		chunk.values.reserve( ( end - begin ) * channel_count_ );
+		for ( index_t fidx = begin; fidx < end; ++fidx )
+		{
+			chunk.times.push_back( storage.GetFrame( fidx ).GetTime() );
+			for ( index_t c = 0; c < channel_count_; ++c )
+				chunk.values.push_back( storage.GetValue( fidx, c ) );
+		}
+
+		std::unique_lock lock( mutex_ );
+		queue_changed_.wait( lock, [&]() { return queue_.size() < max_queued_chunks_; } );
+		queue_.emplace_back( std::move( chunk ) );
+		queue_changed_.notify_all();
+	}
+
+	void StorageStreamWriter::Finish()
+	{
+		{
+			std::scoped_lock lock( mutex_ );
+			if ( finished_ )
+				return;
+			finished_ = true;
+			queue_changed_.notify_all();
+		}
+		thread_.join();
+
+		if ( channel_count_ == NoIndex )
+			WriteHeader( {} );
+
+		// update the row count in the header
+		std::fseek( file_handle_, row_count_pos_, SEEK_SET );
+		std::fprintf( file_handle_, "%-20zu", row_count_ );
+		std::fclose( file_handle_ );
+		file_handle_ = nullptr;
+
+		if ( channel_handle_ )
+		{
+			std::fclose( channel_handle_ );
+			channel_handle_ = nullptr;
+		}
+
+		if ( !binary_file_.empty() )
+			FinishBinary();
+	}
+
+	void StorageStreamWriter::FinishBinary()
+	{
+		if ( binary_block_frames_ > 0 )
+			WriteBinaryBlock();
+		binary_blocks_.close();
+
+		// header, labels and times are followed by the blocks from the temporary file
+		const auto blocks_file = binary_file_ + ".tmp";
+		{
+			std::ofstream ofs( binary_file_.str(), std::ios::binary );
+			SCONE_ERROR_IF( !ofs.good(), "Could not open file " + binary_file_.str() );
+			WriteStorageBinaryHeader( ofs, labels_, StorageEncoding::Float64, binary_times_.size(), Storage< Real, TimeInSeconds >::chunk_frame_count );
+			ofs.write( reinterpret_cast<const char*>( binary_times_.data() ), binary_times_.size() * sizeof( double ) );
+			std::ifstream blocks( blocks_file.str(), std::ios::binary );
+			if ( blocks.peek() != std::ifstream::traits_type::eof() )
+				ofs << blocks.rdbuf();
+			SCONE_ERROR_IF( !ofs.good(), "Error writing " + binary_file_.str() );
+		}
+		std::remove( blocks_file.c_str() );
+	}
+
+	void StorageStreamWriter::WriteHeader( const std::vector< String >& labels )
+	{
+		labels_ = labels;
+		channel_count_ = labels.size();
+		std::fprintf( file_handle_, "%s\nversion=1\nnRows=", name_.c_str() );
+		row_count_pos_ = std::ftell( file_handle_ );
+		std::fprintf( file_handle_, "%-20zu\nnColumns=%zu\ninDegrees=no\nendheader\ntime", size_t( 0 ), channel_count_ + 1 );
+		for ( const auto& label : labels )
+			std::fprintf( file_handle_, "\t%s", label.c_str() );
+		std::fprintf( file_handle_, "\n" );
+
+		if ( channel_handle_ )
+		{
+			xo::pattern_matcher match( channel_pattern_ );
+			std::fprintf( channel_handle_, "time" );
+			for ( index_t c = 0; c < channel_count_; ++c )
+			{
+				if ( match( labels[ c ] ) )
+				{
+					channel_indices_.push_back( c );
+					std::fprintf( channel_handle_, "\t%s", labels[ c ].c_str() );
+				}
+			}
+			std::fprintf( channel_handle_, "\n" );
+		}
+	}
+
+	void StorageStreamWriter::WriteChunk( const Chunk& chunk )
+	{
+		ScopedTraceEvent trace_event( "StorageStreamWriter::WriteChunk" );
+		for ( index_t i = 0; i < chunk.times.size(); ++i )
+		{
+			auto t = chunk.times[ i ];
+			if ( xo::greater_than_or_equal( t - prev_time_, min_interval_, interval_epsilon ) )
+			{
+				const auto* row = chunk.values.data() + i * channel_count_;
+				std::fprintf( file_handle_, "%g", t );
+				for ( index_t c = 0; c < channel_count_; ++c )
+					std::fprintf( file_handle_, "\t%g", row[ c ] );
+				std::fprintf( file_handle_, "\n" );
+				prev_time_ = t;
+				++row_count_;
+
+				if ( channel_handle_ )
+				{
+					std::fprintf( channel_handle_, "%g", t );
+					for ( auto c : channel_indices_ )
+						std::fprintf( channel_handle_, "\t%g", row[ c ] );
+					std::fprintf( channel_handle_, "\n" );
+				}
+
+				if ( !binary_file_.empty() )
+				{
+					binary_times_.push_back( t );
+					binary_block_.insert( binary_block_.end(), row, row + channel_count_ );
+					if ( ++binary_block_frames_ == Storage< Real, TimeInSeconds >::chunk_frame_count )
+						WriteBinaryBlock();
+				}
+			}
+		}
+	}
+
+	void StorageStreamWriter::WriteBinaryBlock()
+	{
+		// blocks are column-major
+		std::vector< double > values( binary_block_frames_ );
+		for ( index_t c = 0; c < channel_count_; ++c )
+		{
+			for ( index_t i = 0; i < binary_block_frames_; ++i )
+				values[ i ] = binary_block_[ i * channel_count_ + c ];
+			binary_blocks_.write( reinterpret_cast<const char*>( values.data() ), values.size() * sizeof( double ) );
+		}
+		binary_block_.clear();
+		binary_block_frames_ = 0;
+	}
+
+	void StorageStreamWriter::Run()
+	{
+		std::unique_lock lock( mutex_ );
+		while ( true )
+		{
+			queue_changed_.wait( lock, [&]() { return !queue_.empty() || finished_; } );
+			if ( queue_.empty() )
+				return; // finished and nothing left to write
+
+			// write the chunk without holding the lock, so that new chunks can be queued
+			auto chunk = std::move( queue_.front() );
+			queue_.pop_front();
+			queue_changed_.notify_all();
+			lock.unlock();
+			WriteChunk( chunk );
+			lock.lock();
+		}
+	}
+}
@@ -0,0 +1,95 @@
+/*
+** StorageStreamWriter.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "Storage.h"
+#include "xo/filesystem/path.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace scone
+{
+	/// Writes Storage frames to a .sto file in a background thread, while the Storage is still being filled.
+	/// Frames are copied in chunks; Write() blocks when max_queued_chunks are waiting, so memory use is bounded.
+	/// The same frames can also be written to a binary (.stob) file and to a text file with selected channels.
+	class SCONE_API StorageStreamWriter
+	{
+	public:
+		StorageStreamWriter( const xo::path& file, const String& name, TimeInSeconds min_interval = 0.0, size_t max_queued_chunks = 4 );
+		StorageStreamWriter( const StorageStreamWriter& ) = delete;
+		StorageStreamWriter& operator=( const StorageStreamWriter& ) = delete;
+		~StorageStreamWriter();
+
+		/// Also write frames to a binary storage file (Float64); must be called before the first Write()
+		void AddBinaryOutput( const xo::path& file );
+
+		/// Also write the channels matching channel_pattern to a text file; must be called before the first Write()
+		void AddChannelOutput( const xo::path& file, const String& channel_pattern );
+
+		/// Queue frames [ begin, end ) for writing; channels are fixed by the first call, channels added later are not written
+		void Write( const Storage< Real, TimeInSeconds >& storage, index_t begin, index_t end );
+
+		/// Write all queued frames and finalize the file header
+		void Finish();
+
+		const xo::path& GetFile() const { return file_; }
+		const xo::path& GetBinaryFile() const { return binary_file_; }
+		const xo::path& GetChannelFile() const { return channel_file_; }
+		bool IsFinished() const { return finished_; }
+
+	private:
+		struct Chunk {
+			std::vector< TimeInSeconds > times;
+			std::vector< Real > values; // row-major
+		};
+
+		void WriteHeader( const std::vector< String >& labels );
+		void WriteChunk( const Chunk& chunk );
+		void WriteBinaryBlock();
+		void FinishBinary();
+		void Run();
+
+		xo::path file_;
+		String name_;
+		std::FILE* file_handle_;
+		long row_count_pos_;
+		size_t row_count_;
+		size_t channel_count_;
+		TimeInSeconds min_interval_;
+		TimeInSeconds prev_time_;
+		std::vector< String > labels_;
+		bool added_channel_warning_;
+
+		// binary output: blocks are written to a temporary file, because the times precede the blocks
+		xo::path binary_file_;
+		std::ofstream binary_blocks_;
+		std::vector< TimeInSeconds > binary_times_;
+		std::vector< Real > binary_block_; // row-major
+		size_t binary_block_frames_;
+
+		// channel output
+		xo::path channel_file_;
+		String channel_pattern_;
+		std::FILE* channel_handle_;
+		std::vector< index_t > channel_indices_;
+
+		std::deque< Chunk > queue_;
+		size_t max_queued_chunks_;
+		bool finished_;
+		std::mutex mutex_;
+		std::condition_variable queue_changed_;
+		std::thread thread_;
+	};
+}
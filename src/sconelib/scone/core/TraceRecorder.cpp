@@ -0,0 +1,206 @@
+/*
+** TraceRecorder.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "TraceRecorder.h"
+
+#include "Exception.h"
+#include "Log.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef XO_COMP_MSVC
+#pragma warning( disable: 4996 )
+#endif
+
+namespace scone
+{
+	std::atomic_bool g_trace_recording( false );
+
+	namespace
+	{
+		struct TraceEvent {
+			const char* name;
+			int64_t time_ns;
+			char phase;
+		};
+
+		// fixed-size block of events, filled by a single thread and read while holding g_buffers_mutex
+		struct TraceChunk {
+			static constexpr size_t capacity = 4096;
+			TraceEvent events[ capacity ];
+			std::atomic< size_t > size{ 0 };
+			std::atomic< TraceChunk* > next{ nullptr };
+		};
+
+		struct TraceThreadBuffer {
+			TraceThreadBuffer( int id ) : thread_id( id ), first( new TraceChunk ), last( first ), session( 0 ) {}
+			~TraceThreadBuffer() { Reset(); delete first; }
+
+			// only called by the owning thread, while holding g_buffers_mutex
+			void Reset() {
+				for ( auto* c = first->next.exchange( nullptr ); c; ) {
+					auto* next = c->next.load();
+					delete c;
+					c = next;
+				}
+				first->size.store( 0, std::memory_order_release );
+				last = first;
+			}
+
+			void Add( const TraceEvent& e ) {
+				auto s = last->size.load( std::memory_order_relaxed );
+				if ( s == TraceChunk::capacity ) {
+					auto* c = new TraceChunk;
+					last->next.store( c, std::memory_order_release );
+					last = c;
+					s = 0;
+				}
+				last->events[ s ] = e;
+				last->size.store( s + 1, std::memory_order_release );
+			}
+
+			const int thread_id;
+			TraceChunk* first;
+			TraceChunk* last;
+			std::atomic< size_t > session;
+		};
+
+		using trace_clock = std::chrono::steady_clock;
+
+		std::mutex g_buffers_mutex;
+		std::vector< std::unique_ptr< TraceThreadBuffer > > g_buffers; // at most one per concurrently running thread
+		std::vector< TraceThreadBuffer* > g_free_buffers; // buffers of threads that have exited
+		std::atomic< size_t > g_session( 0 );
+		std::atomic< int64_t > g_origin_ns( 0 );
+
+		// hands the buffer back for reuse when its thread exits, events that were recorded are kept
+		struct TraceBufferOwner {
+			~TraceBufferOwner() {
+				if ( buffer ) {
+					std::scoped_lock lock( g_buffers_mutex );
+					g_free_buffers.push_back( buffer );
+				}
+			}
+			TraceThreadBuffer* buffer = nullptr;
+		};
+		thread_local TraceBufferOwner t_owner;
+
+		int64_t TraceTime() {
+			return std::chrono::duration_cast< std::chrono::nanoseconds >( trace_clock::now().time_since_epoch() ).count();
+		}
+
+		TraceThreadBuffer& GetThreadBuffer() {
+			if ( !t_owner.buffer ) {
+				std::scoped_lock lock( g_buffers_mutex );
+				if ( !g_free_buffers.empty() ) {
+					t_owner.buffer = g_free_buffers.back();
+					g_free_buffers.pop_back();
+				}
+				else {
+					g_buffers.emplace_back( std::make_unique< TraceThreadBuffer >( int( g_buffers.size() ) ) );
+					t_owner.buffer = g_buffers.back().get();
+				}
+			}
+			return *t_owner.buffer;
+		}
+
+		struct TraceThreadEvents {
+			int thread_id;
+			std::vector< TraceEvent > events;
+		};
+
+		// copy the events of a recording, Reset() cannot remove chunks while the lock is held
+		std::vector< TraceThreadEvents > GetTraceEvents( size_t session ) {
+			std::scoped_lock lock( g_buffers_mutex );
+			std::vector< TraceThreadEvents > result;
+			for ( const auto& buf : g_buffers )
+			{
+				if ( buf->session != session )
+					continue;
+				auto& te = result.emplace_back( TraceThreadEvents{ buf->thread_id, {} } );
+				for ( const TraceChunk* c = buf->first; c; c = c->next.load( std::memory_order_acquire ) )
+				{
+					auto size = c->size.load( std::memory_order_acquire );
+					te.events.insert( te.events.end(), c->events, c->events + size );
+				}
+			}
+			return result;
+		}
+
+		void WriteEscaped( std::FILE* f, const char* str ) {
+			for ( ; *str; ++str ) {
+				if ( *str == '"' || *str == '\\' )
+					std::fputc( '\\', f );
+				std::fputc( *str, f );
+			}
+		}
+	}
+
+	void StartTraceRecording()
+	{
+		g_origin_ns = TraceTime();
+		++g_session;
+		g_trace_recording = true;
+	}
+
+	void StopTraceRecording()
+	{
+		g_trace_recording = false;
+	}
+
+	void RecordTraceEvent( const char* name, char phase )
+	{
+		auto& buf = GetThreadBuffer();
+		auto session = g_session.load( std::memory_order_relaxed );
+		if ( buf.session.load( std::memory_order_relaxed ) != session ) {
+			// events from a previous recording are discarded by the owning thread
+			std::scoped_lock lock( g_buffers_mutex );
+			buf.Reset();
+			buf.session.store( session, std::memory_order_relaxed );
+			if ( phase == 'E' )
+				return; // begin event was part of the previous recording
+		}
+		buf.Add( TraceEvent{ name, TraceTime(), phase } );
+	}
+
+	void WriteTraceRecording( const xo::path& file )
+	{
+		auto* f = std::fopen( file.c_str(), "w" );
+		SCONE_ERROR_IF( !f, "Could not open file " + file.str() );
+
+		const auto origin_ns = g_origin_ns.load();
+		const auto trace_events = GetTraceEvents( g_session.load() );
+		size_t event_count = 0;
+		bool first_event = true;
+		auto separator = [&]() { std::fputs( first_event ? "\n" : ",\n", f ); first_event = false; };
+
+		std::fputs( "{\"traceEvents\":[", f );
+		for ( const auto& te : trace_events )
+		{
+			separator();
+			std::fprintf( f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}", te.thread_id, te.thread_id );
+			for ( const auto& e : te.events )
+			{
+				separator();
+				std::fputs( "{\"name\":\"", f );
+				WriteEscaped( f, e.name );
+				std::fprintf( f, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", e.phase, 1e-3 * double( e.time_ns - origin_ns ), te.thread_id );
+			}
+			event_count += te.events.size();
+		}
+		std::fputs( "\n],\"displayTimeUnit\":\"ms\"}\n", f );
+		std::fclose( f );
+
+		log::info( "Written ", event_count, " trace events to ", file );
+	}
+}
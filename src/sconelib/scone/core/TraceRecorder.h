@@ -0,0 +1,49 @@
+/*
+** TraceRecorder.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "platform.h"
+#include "xo/filesystem/path.h"
+
+#include <atomic>
+
+namespace scone
+{
+	/// Trace events are recorded per thread, without locking, and exported in the Chrome trace event format,
+	/// which can be inspected using chrome://tracing or https://ui.perfetto.dev.
+	/// Event names are not copied and must remain valid until the trace is written (e.g. string literals).
+
+	/// Start recording trace events, previously recorded events are discarded
+	SCONE_API void StartTraceRecording();
+
+	/// Stop recording trace events, scopes that are still open will record their end event
+	SCONE_API void StopTraceRecording();
+
+	/// Write recorded events in Chrome trace event format (JSON), should be called after StopTraceRecording()
+	SCONE_API void WriteTraceRecording( const xo::path& file );
+
+	/// Record a begin ( phase = 'B' ) or end ( phase = 'E' ) event for the current thread
+	SCONE_API void RecordTraceEvent( const char* name, char phase );
+
+	extern SCONE_API std::atomic_bool g_trace_recording;
+	inline bool IsTraceRecording() { return g_trace_recording.load( std::memory_order_relaxed ); }
+
+	/// Records begin and end events for the lifetime of the object
+	class ScopedTraceEvent
+	{
+	public:
+		ScopedTraceEvent( const char* name ) : name_( IsTraceRecording() ? name : nullptr ) { if ( name_ ) RecordTraceEvent( name_, 'B' ); }
+		ScopedTraceEvent( const ScopedTraceEvent& ) = delete;
+		ScopedTraceEvent& operator=( const ScopedTraceEvent& ) = delete;
+		~ScopedTraceEvent() { if ( name_ ) RecordTraceEvent( name_, 'E' ); }
+
+	private:
+		const char* name_;
+	};
+}
@@ -34,6 +34,13 @@ constexpr bool SCONE_DEBUG = true;
 #	define SCONE_EXPERIMENTAL_FEATURES_ENABLED 0
 #endif
 
+// spot::optimizer::get_state() / set_state() and spot::file_reporter::step_offset_ are required for exact resuming
+#ifdef SCONE_SPOT_OPTIMIZER_STATE
+#	define SCONE_SPOT_OPTIMIZER_STATE_ENABLED 1
+#else
+#	define SCONE_SPOT_OPTIMIZER_STATE_ENABLED 0
+#endif
+
 #if defined(_MSC_VER)
 #	pragma warning( disable: 4251 ) // disable W4251, unfortunately there's no nice way to do this
 #endif
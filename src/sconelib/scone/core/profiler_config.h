@@ -3,6 +3,12 @@
 #pragma once
 
 #include "platform.h"
+#include "TraceRecorder.h"
+
+// unique variable names, so that multiple scopes can be profiled within the same block
+#define SCONE_PROFILE_CONCAT_IMPL( a, b ) a##b
+#define SCONE_PROFILE_CONCAT( a, b ) SCONE_PROFILE_CONCAT_IMPL( a, b )
+#define SCONE_PROFILE_VAR( name ) SCONE_PROFILE_CONCAT( name, __LINE__ )
 
 #if defined SCONE_ENABLE_PROFILING
 #	include "Profiler.h"
@@ -12,11 +18,11 @@
 #	define SCONE_PROFILE_REPORT log::info( Profiler::GetGlobalInstance().GetReport() )
 #elif defined SCONE_ENABLE_XO_PROFILING
 #	include "xo/system/profiler.h"
-#	define SCONE_PROFILE_FUNCTION( profiler ) xo::scoped_profiler_section scoped_profile_var( __FUNCTION__, profiler )
-#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) xo::scoped_profiler_section scoped_profile_var( scope_name_arg, profiler )
+#	define SCONE_PROFILE_FUNCTION( profiler ) xo::scoped_profiler_section SCONE_PROFILE_VAR( scoped_profile_var_ )( __FUNCTION__, profiler ); scone::ScopedTraceEvent SCONE_PROFILE_VAR( scoped_trace_var_ )( __FUNCTION__ )
+#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) xo::scoped_profiler_section SCONE_PROFILE_VAR( scoped_profile_var_ )( scope_name_arg, profiler ); scone::ScopedTraceEvent SCONE_PROFILE_VAR( scoped_trace_var_ )( scope_name_arg )
 #else 
-#	define SCONE_PROFILE_FUNCTION( profiler ) void()
-#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) void()
+#	define SCONE_PROFILE_FUNCTION( profiler ) scone::ScopedTraceEvent SCONE_PROFILE_VAR( scoped_trace_var_ )( __FUNCTION__ )
+#	define SCONE_PROFILE_SCOPE( profiler, scope_name_arg ) scone::ScopedTraceEvent SCONE_PROFILE_VAR( scoped_trace_var_ )( scope_name_arg )
 #endif
 
 namespace scone
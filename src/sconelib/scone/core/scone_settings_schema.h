@@ -27,12 +27,19 @@ results {
 	controller { type = bool label = "Output Controller and Measure results" default = 0 }
 	extract_channels { type = bool label = "Extract specific channels to separate file" default = 0 }
 	extract_channel_names { type = string label = "Channels to extract to separate file" default = "*.activation;*.excitation" }
+	binary_storage { type = bool label = "Also output results in binary format (.stob)" default = 0 }
+	stream_data { type = bool label = "Write data to file during evaluation, to limit memory use" default = 0 }
+	stream_window { type = number label = "Number of frames kept in memory when streaming data" default = 1024 }
+	trace { type = bool label = "Write a trace of optimizations and evaluations (Chrome trace format)" default = 0 }
 }
 
 optimizer {
-	evaluator { type = number label = "Evaluate sync=0, batch=1, async=2, pool=3" default = 2 }
+	evaluator { type = number label = "Evaluate sync=0, batch=1, async=2, pool=3, distributed=4" default = 2 }
 	max_threads { type = number label = "Max optimization threads (0=hardware)" default = 0 }
 	thread_priority{ type = number label = "thread priority: 0-6 (default=2)" default = 2 }
+	distributed_port { type = number label = "Port on which workers connect for distributed evaluation" default = 8473 }
+	distributed_timeout { type = number label = "Seconds without response after which a distributed worker is dropped" default = 30 }
+	distributed_remote { type = bool label = "Accept distributed workers from other computers (otherwise only from this computer)" default = 0 }
 		output_fitness_history{ type = bool default = 1 label = "Output fitness history to history.txt" }
 		output_par_history{ type = bool default = 0 label = "Output parameter history to history_par.txt" }
 }
@@ -7,9 +7,10 @@ namespace scone
 	Storage<> ExtractNormalized( const Storage<>& sto, TimeInSeconds begin, TimeInSeconds end )
 	{
 		Storage<> new_sto( sto.GetLabels() );
+		auto cursor = sto.GetCursor();
 		for ( Real perc : xo::frange<Real>( 0.0, 100.0, 0.5 ) )
 		{
-			auto inter = sto.ComputeInterpolatedFrame( begin + perc * ( end - begin ) / 100.0 );
+			auto inter = cursor.Seek( begin + perc * ( end - begin ) / 100.0 );
 			auto& f = new_sto.AddFrame( perc );
 			for ( index_t i = 0; i < sto.GetChannelCount(); ++i )
 				f[ i ] = inter.value( i );
@@ -20,12 +21,12 @@ namespace scone
 	Storage<> ExtractGaitCycle( const Storage<>& sto, const String& force_channel, const Real threshold )
 	{
 		SCONE_ASSERT( sto.GetFrameCount() > 0 );
-		auto force_idx = sto.GetChannelIndex( force_channel );
-		auto prev_force = sto.GetFrame( 0 )[ force_idx ];
+		auto force_data = sto.GetChannel( sto.GetChannelIndex( force_channel ) );
+		auto prev_force = force_data[ 0 ];
 		std::vector< TimeInSeconds > cycle_start_times;
 		for ( index_t idx = 1; idx < sto.GetFrameCount(); ++idx )
 		{
-			auto force = sto.GetFrame( idx )[ force_idx ];
+			auto force = force_data[ idx ];
 			if ( prev_force <= threshold && force > threshold )
 			{
 				cycle_start_times.push_back( sto.GetFrame( idx ).GetTime() );
@@ -34,6 +34,11 @@ namespace scone
 		return std::max( 0.0, ( model.GetSimulationEndTime() - model.GetTime() ) / model.GetSimulationEndTime() );
 	}
 
+	double BalanceMeasure::ComputeResultBound( const Model& model )
+	{
+		return 0.0; // remaining fraction of the simulation
+	}
+
 	String BalanceMeasure::GetClassSignature() const
 	{
 		return "B";
@@ -23,6 +23,7 @@ namespace scone
 
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) override;
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 
 	protected:
 		virtual String GetClassSignature() const override;
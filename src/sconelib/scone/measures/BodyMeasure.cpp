@@ -61,6 +61,20 @@ namespace scone
 		return  penalty;
 	}
 
+	double BodyMeasure::ComputeResultBound( const Model& model )
+	{
+		double bound = 0.0;
+		if ( !position.IsNull() )
+			bound += position.GetResultBound();
+		if ( !velocity.IsNull() )
+			bound += velocity.GetResultBound();
+		if ( !angular_velocity.IsNull() )
+			bound += angular_velocity.GetResultBound();
+		if ( !acceleration.IsNull() )
+			bound += acceleration.GetResultBound();
+		return bound;
+	}
+
 	bool BodyMeasure::UpdateMeasure( const Model& model, double timestamp )
 	{
 		if ( !position.IsNull() )
@@ -100,13 +114,14 @@ namespace scone
 
 	void BodyMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
+		auto& ch = m_StoreDataChannels.Begin( frame );
 		if ( !position.IsNull() )
-			frame[ body.GetName() + ".pos_penalty" ] = position.GetLatest();
+			ch.Set( body.GetName(), ".pos_penalty", position.GetLatest() );
 		if ( !velocity.IsNull() )
-			frame[ body.GetName() + ".vel_penalty" ] = velocity.GetLatest();
+			ch.Set( body.GetName(), ".vel_penalty", velocity.GetLatest() );
 		if ( !angular_velocity.IsNull() )
-			frame[ body.GetName() + ".ang_vel_penalty" ] = angular_velocity.GetLatest();
+			ch.Set( body.GetName(), ".ang_vel_penalty", angular_velocity.GetLatest() );
 		if ( !acceleration.IsNull() )
-			frame[ body.GetName() + ".acc_penalty" ] = acceleration.GetLatest();
+			ch.Set( body.GetName(), ".acc_penalty", acceleration.GetLatest() );
 	}
 }
@@ -22,6 +22,7 @@ namespace scone
 	public:
 		BodyMeasure( const PropNode& props, Params& par, const Model& model, const Location& loc );
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 
 		/// Body to which to apply the penalty to.
 		const Body& body;
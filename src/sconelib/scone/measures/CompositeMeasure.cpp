@@ -94,6 +94,18 @@ namespace scone
 		return total;
 	}
 
+	double CompositeMeasure::ComputeResultBound( const Model& model )
+	{
+		double total = 0.0;
+		for ( MeasureUP& m : m_Measures )
+		{
+			if ( m->minimize != minimize )
+				return UnboundedResult(); // child bound is in the wrong direction
+			total += m->GetWeightedResultBound( model );
+		}
+		return total;
+	}
+
 	String CompositeMeasure::GetClassSignature() const
 	{
 		std::vector< String > strset;
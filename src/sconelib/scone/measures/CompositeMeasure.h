@@ -57,6 +57,7 @@ namespace scone
 
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) override;
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 
 		const PropNode* Measures;
 
@@ -98,6 +98,15 @@ namespace scone
 		return result;
 	}
 
+	double DofLimitMeasure::ComputeResultBound( const Model& model )
+	{
+		for ( const Limit& l : m_Limits )
+			if ( l.squared_range_penalty < 0 || l.abs_range_penalty < 0 || l.squared_velocity_range_penalty < 0 ||
+				l.abs_velocity_range_penalty < 0 || l.squared_force_penalty < 0 || l.abs_force_penalty < 0 )
+				return UnboundedResult(); // penalties can decrease
+		return 0.0; // average of non-negative penalties
+	}
+
 	scone::String DofLimitMeasure::GetClassSignature() const
 	{
 		return "";
@@ -105,7 +114,8 @@ namespace scone
 
 	void DofLimitMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
+		auto& ch = m_StoreDataChannels.Begin( frame );
 		for ( auto& l : m_Limits )
-			frame[ l.dof.GetName() + ".limit_penalty" ] = l.penalty.GetLatest();
+			ch.Set( l.dof.GetName(), ".limit_penalty", l.penalty.GetLatest() );
 	}
 }
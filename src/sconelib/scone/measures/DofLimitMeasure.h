@@ -26,6 +26,7 @@ namespace scone
 		DofLimitMeasure( const PropNode& props, Params& par, const Model& model, const Location& loc );
 
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 
 	protected:
 		virtual String GetClassSignature() const override;
@@ -62,6 +62,20 @@ namespace scone
 		return penalty;
 	}
 
+	double DofMeasure::ComputeResultBound( const Model& model )
+	{
+		double bound = 0.0;
+		if ( !position.IsNull() )
+			bound += position.GetResultBound().value;
+		if ( !velocity.IsNull() )
+			bound += velocity.GetResultBound().value;
+		if ( !acceleration.IsNull() )
+			bound += acceleration.GetResultBound().value;
+		if ( !force.IsNull() )
+			bound += force.GetResultBound();
+		return bound;
+	}
+
 	bool DofMeasure::UpdateMeasure( const Model& model, double timestamp )
 	{
 		if ( !position.IsNull() )
@@ -82,13 +96,14 @@ namespace scone
 
 	void DofMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
+		auto& ch = m_StoreDataChannels.Begin( frame );
 		if ( !position.IsNull() )
-			frame[ dof.GetName() + ".position_penalty" ] = position.GetLatest().value;
+			ch.Set( dof.GetName(), ".position_penalty", position.GetLatest().value );
 		if ( !velocity.IsNull() )
-			frame[ dof.GetName() + ".velocity_penalty" ] = velocity.GetLatest().value;
+			ch.Set( dof.GetName(), ".velocity_penalty", velocity.GetLatest().value );
 		if ( !acceleration.IsNull() )
-			frame[ dof.GetName() + ".acceleration_penalty" ] = acceleration.GetLatest().value;
+			ch.Set( dof.GetName(), ".acceleration_penalty", acceleration.GetLatest().value );
 		if ( !force.IsNull() )
-			frame[ dof.GetName() + ".force_penalty" ] = force.GetLatest();
+			ch.Set( dof.GetName(), ".force_penalty", force.GetLatest() );
 	}
 }
@@ -30,6 +30,7 @@ namespace scone
 	public:
 		DofMeasure( const PropNode& props, Params& par, const Model& model, const Location& loc );
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 
 		/// Dof to which to apply the penalty to.
 		Dof& dof;
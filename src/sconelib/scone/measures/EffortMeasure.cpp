@@ -102,6 +102,14 @@ namespace scone
 		return *result;
 	}
 
+	double EffortMeasure::ComputeResultBound( const Model& model )
+	{
+		// metabolic energy and mechanical work can be negative
+		if ( measure_type == EffortMeasureType::Uchida2016 || measure_type == EffortMeasureType::MechnicalWork )
+			return UnboundedResult();
+		return 0.0;
+	}
+
 	double EffortMeasure::GetCurrentEffort( const Model& model ) const
 	{
 		switch ( measure_type )
@@ -344,6 +352,6 @@ namespace scone
 
 	void EffortMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		frame[ name_ + ".penalty" ] = m_Effort.GetLatest();
+		m_StoreDataChannels.Begin( frame ).Set( name_, ".penalty", m_Effort.GetLatest() );
 	}
 }
@@ -26,6 +26,11 @@ namespace scone
 		return GetStateSimilarity( model.GetState() );
 	}
 
+	double GaitCycleMeasure::ComputeResultBound( const Model& model )
+	{
+		return 0.0; // sum of squared state differences
+	}
+
 	Real GaitCycleMeasure::GetStateSimilarity( const State& state )
 	{
 		Real total_diff = 0.0;
@@ -21,6 +21,7 @@ namespace scone
 		GaitCycleMeasure( const PropNode& props, Params& par, const Model& model, const Location& loc );
 
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 
 		/// Use half gait cycle instead of full cycle; default = false.
 		bool use_half_cycle;
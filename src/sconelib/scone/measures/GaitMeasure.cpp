@@ -126,9 +126,14 @@ namespace scone
 		return 1.0 - step_measure / step_time;
 	}
 
+	double GaitMeasure::ComputeResultBound( const Model& model )
+	{
+		return 0.0; // normalized step velocities are at most one
+	}
+
 	void GaitMeasure::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		frame[ "step_length" ] = steps_.empty() ? 0 : steps_.back().length;
+		m_StoreDataChannels.Begin( frame ).Set( "step_length", steps_.empty() ? 0 : steps_.back().length );
 	}
 
 	void GaitMeasure::AddStep( const Model &model, double timestamp )
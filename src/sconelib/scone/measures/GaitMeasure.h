@@ -62,6 +62,7 @@ namespace scone
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) override;
 		void AddStep( const Model &model, double timestamp );
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 		virtual void StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const override;
 
 	protected:
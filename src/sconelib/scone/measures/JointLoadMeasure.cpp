@@ -26,6 +26,11 @@ namespace scone
 		return RangePenalty<Real>::GetResult();
 	}
 
+	double JointLoadMeasure::ComputeResultBound( const Model& model )
+	{
+		return RangePenalty<Real>::GetResultBound();
+	}
+
 	bool JointLoadMeasure::UpdateMeasure( const Model& model, double timestamp )
 	{
 		joint_load = joint.GetLoad();
@@ -42,6 +47,6 @@ namespace scone
 	void JointLoadMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		// #todo: store joint load value
-		frame[ joint.GetName() + ".load_penalty" ] = GetLatest();
+		m_StoreDataChannels.Begin( frame ).Set( joint.GetName(), ".load_penalty", GetLatest() );
 	}
 }
@@ -159,7 +159,7 @@ namespace scone
 	void JumpMeasure::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		if ( flags.get< StoreDataTypes::ControllerData >() )
-			frame[ "jump_dist" ] = dot_dir( current_pos );
+			m_StoreDataChannels.Begin( frame ).Set( "jump_dist", dot_dir( current_pos ) );
 	}
 
 	double JumpMeasure::GetHighJumpResult( const Model& model )
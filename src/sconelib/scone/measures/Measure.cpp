@@ -33,16 +33,35 @@ namespace scone
 	{
 		if ( !result_ )
 			result_ = ComputeResult( model );
+		return ApplyWeighting( *result_ );
+	}
+
+	double Measure::GetWeightedResultBound( const Model& model )
+	{
+		if ( result_ )
+			return ApplyWeighting( *result_ );
+
+		// bounds are lower bounds on minimized results,
+		// weighting preserves the bound only if it is monotonically increasing
+		if ( !minimize || weight < 0 || threshold < 0 )
+			return UnboundedResult();
+		auto bound = ComputeResultBound( model );
+		if ( bound == UnboundedResult() )
+			return threshold > 0 ? 0.0 : bound; // results below threshold are weighted to zero
+		return ApplyWeighting( bound );
+	}
 
-		Real m = *result_ + GetOffset();
-		if ( minimize && GetThreshold() != 0 )
+	double Measure::ApplyWeighting( double result ) const
+	{
+		Real m = result + result_offset;
+		if ( minimize && threshold != 0 )
 		{
-			if ( m < GetThreshold() )
+			if ( m < threshold )
 				m = 0;
-			else if ( m < GetThreshold() + threshold_transition )
-				m = m * ( m - GetThreshold() ) / threshold_transition;
+			else if ( m < threshold + threshold_transition )
+				m = m * ( m - threshold ) / threshold_transition;
 		}
-		return GetWeight() * m;
+		return weight * m;
 	}
 
 	const String& Measure::GetName() const
@@ -63,4 +82,9 @@ namespace scone
 		return minimize ? xo::constants<double>::max() : xo::constants<double>::lowest();
 	}
 
+	double Measure::UnboundedResult() const
+	{
+		return minimize ? -xo::constants<double>::infinity() : xo::constants<double>::infinity();
+	}
+
 }
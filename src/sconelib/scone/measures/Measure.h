@@ -41,6 +41,11 @@ namespace scone
 		double GetResult( const Model& model );
 		double GetWeightedResult( const Model& model );
 
+		/// Best weighted result that can still be achieved at the end of the simulation,
+		/// i.e. a lower bound when minimizing and an upper bound when maximizing.
+		/// Measures that are not minimized are unbounded.
+		double GetWeightedResultBound( const Model& model );
+
 		PropNode& GetReport() { return report_; }
 		const PropNode& GetReport() const { return report_; }
 	
@@ -55,7 +60,10 @@ namespace scone
 		virtual bool ComputeControls( Model& model, double timestamp ) override final { return false; }
 		virtual bool PerformAnalysis( const Model& model, double timestamp ) override final;
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) = 0;
+		virtual double ComputeResultBound( const Model& model ) { return UnboundedResult(); }
 		double WorstResult() const;
+		double UnboundedResult() const;
+		double ApplyWeighting( double result ) const;
 
 		PropNode report_;
 		xo::optional< double > result_; // caches result so it's only computed once
@@ -8,18 +8,13 @@
 
 #include "MimicMeasure.h"
 
-#include "scone/core/StorageIo.h"
 #include "scone/model/Model.h"
 #include "xo/numerical/math.h"
 #include "scone/core/Log.h"
 #include "scone/core/profiler_config.h"
-#include "xo/utility/memoize.h"
 
 namespace scone
 {
-	Storage<> read_storage( const xo::path& f ) { Storage<> sto; ReadStorage( sto, f ); return sto; } 
-	static xo::memoize_thread_safe< Storage<>( const xo::path& ) > g_storage_cache( read_storage );
-
 	MimicMeasure::MimicMeasure( const PropNode& pn, Params& par, const Model& model, const Location& loc ) :
 		Measure( pn, par, model, loc ),
 		file( FindFile( pn.get<path>( "file" ) ) ),
@@ -30,15 +25,15 @@ namespace scone
 		INIT_MEMBER( pn, peak_error_limit, 2 * average_error_limit ),
 		INIT_MEMBER( pn, time_offset, 0 ),
 		INIT_MEMBER( pn, activation_error_weight, 1.0 ),
-		storage_( g_storage_cache( file ) )
+		storage_( file, model.use_fixed_control_step_size ? model.fixed_measure_step_size : 0.0 )
 	{
 		SCONE_PROFILE_FUNCTION( model.GetProfiler() );
 
-		SCONE_THROW_IF( storage_.IsEmpty(), file.str() + " contains no data" );
+		SCONE_THROW_IF( storage_->IsEmpty(), file.str() + " contains no data" );
 
 		// automatically set stop_time to match data, if not set
-		if ( stop_time == 0 || stop_time > storage_.Back().GetTime() )
-			stop_time = storage_.Back().GetTime();
+		if ( stop_time == 0 || stop_time > storage_->Back().GetTime() )
+			stop_time = storage_->Back().GetTime();
 
 		auto& state = model.GetState();
 		for ( index_t state_idx = 0; state_idx < state.GetSize(); ++state_idx )
@@ -46,7 +41,7 @@ namespace scone
 			auto& name = state.GetName( state_idx );
 			if ( include_states( name ) && !exclude_states( name ) )
 			{
-				index_t sto_idx = storage_.TryGetChannelIndex( name );
+				index_t sto_idx = storage_->TryGetChannelIndex( name );
 				if ( sto_idx != NoIndex )
 				{
 					auto w = xo::str_ends_with( name, "activation" ) ? activation_error_weight : 1.0;
@@ -56,7 +51,7 @@ namespace scone
 			}
 		}
 
-		log::debug( "MimicMeasure found ", state_storage_map_.size(), " of ", storage_.GetChannelCount(), " channels from ", file );
+		log::debug( "MimicMeasure found ", state_storage_map_.size(), " of ", storage_->GetChannelCount(), " channels from ", file );
 
 		SCONE_THROW_IF( state_storage_map_.empty(), "No matching states found in " + file.str() );
 
@@ -67,13 +62,13 @@ namespace scone
 	{
 		// when using a full motion, skip when there's no more data
 		// we don't terminate because there may be other measures
-		if ( !use_best_match && timestamp > storage_.Back().GetTime() )
+		if ( !use_best_match && timestamp > storage_->Back().GetTime() )
 			return false;
 
 		auto& state = model.GetState();
 		double error = 0.0;
 		index_t error_idx = 0;
-		auto frame = storage_.ComputeInterpolatedFrame( timestamp + time_offset );
+		auto frame = storage_.GetFrame( timestamp + time_offset );
 		for ( auto& m : state_storage_map_ )
 		{
 			auto storage_value = frame.value( m.storage_idx_ );
@@ -102,13 +97,19 @@ namespace scone
 		return result + penalty;
 	}
 
+	double MimicMeasure::ComputeResultBound( const Model& model )
+	{
+		return peak_error_limit >= 0 ? 0.0 : UnboundedResult();
+	}
+
 	void MimicMeasure::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		frame[ "mimic_error" ] = result_.GetLatest();
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		ch.Set( "mimic_error", result_.GetLatest() );
 		if ( flags.get<StoreDataTypes::DebugData>() )
 		{
 			for ( auto& c : channel_errors_ )
-				frame[ c.first + "_mimic_error" ] = c.second;
+				ch.Set( c.first, "_mimic_error", c.second );
 		}
 	}
 
@@ -10,6 +10,7 @@
 
 #include "Measure.h"
 #include "scone/core/Statistic.h"
+#include "scone/core/ReferenceStorage.h"
 #include "xo/string/pattern_matcher.h"
 
 namespace scone
@@ -23,7 +24,7 @@ namespace scone
 	public:
 		MimicMeasure( const PropNode& props, Params& par, const Model& model, const Location& loc );
 
-		/// Filename of storage (sto).
+		/// Filename of storage (sto, txt or stob).
 		xo::path file;
 
 		/// States to include for comparison; default = *.
@@ -49,11 +50,12 @@ namespace scone
 
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) override;
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 		virtual void StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const override;
 
 	protected:
 		virtual String GetClassSignature() const override;
-		const Storage<>& storage_;
+		ReferenceStorage storage_;
 		Statistic<> result_;
 		struct Channel {
 			index_t state_idx_;
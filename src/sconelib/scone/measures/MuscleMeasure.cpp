@@ -64,6 +64,22 @@ namespace scone
 		return  penalty;
 	}
 
+	double MuscleMeasure::ComputeResultBound( const Model& model )
+	{
+		double bound = 0.0;
+		if ( !input.IsNull() )
+			bound += input.GetResultBound();
+		if ( !activation.IsNull() )
+			bound += activation.GetResultBound();
+		if ( !length.IsNull() )
+			bound += length.GetResultBound();
+		if ( !velocity.IsNull() )
+			bound += velocity.GetResultBound();
+		if ( !force.IsNull() )
+			bound += force.GetResultBound();
+		return bound;
+	}
+
 	bool MuscleMeasure::UpdateMeasure( const Model& model, double timestamp )
 	{
 		input.AddSample( timestamp, muscle.GetInput() );
@@ -81,15 +97,16 @@ namespace scone
 
 	void MuscleMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
+		auto& ch = m_StoreDataChannels.Begin( frame );
 		if ( !input.IsNull() )
-			frame[ muscle.GetName() + ".input_penalty" ] = input.GetLatest();
+			ch.Set( muscle.GetName(), ".input_penalty", input.GetLatest() );
 		if ( !activation.IsNull() )
-			frame[ muscle.GetName() + ".activation_penalty" ] = activation.GetLatest();
+			ch.Set( muscle.GetName(), ".activation_penalty", activation.GetLatest() );
 		if ( !length.IsNull() )
-			frame[ muscle.GetName() + ".length_penalty" ] = length.GetLatest();
+			ch.Set( muscle.GetName(), ".length_penalty", length.GetLatest() );
 		if ( !velocity.IsNull() )
-			frame[ muscle.GetName() + ".velocity_penalty" ] = velocity.GetLatest();
+			ch.Set( muscle.GetName(), ".velocity_penalty", velocity.GetLatest() );
 		if ( !force.IsNull() )
-			frame[ muscle.GetName() + ".force_penalty" ] = force.GetLatest();
+			ch.Set( muscle.GetName(), ".force_penalty", force.GetLatest() );
 	}
 }
@@ -104,6 +104,6 @@ namespace scone
 
 	void PointMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		frame[ m_pTargetBody->GetName() + ".point_penalty" ] = penalty.GetLatest();
+		m_StoreDataChannels.Begin( frame ).Set( m_pTargetBody->GetName(), ".point_penalty", penalty.GetLatest() );
 	}
 }
@@ -62,6 +62,17 @@ namespace scone
 			}
 		}
 
+		/// Lowest result that can still be reached after adding more samples
+		T GetResultBound() const {
+			if ( abs_penalty < 0 || squared_penalty < 0 )
+				return T( -xo::constantsd::infinity() ); // penalties can decrease
+			switch ( mode_ ) {
+			case penalty_mode::sum: return penalty.GetTotal();
+			case penalty_mode::highest: return penalty.GetHighest();
+			default: return T( 0 );
+			}
+		}
+
 		size_t GetNumSamples() const { return penalty.GetNumSamples(); }
 
 		bool IsEmpty() const { return penalty.GetNumSamples() == 0; }
@@ -25,6 +25,11 @@ namespace scone
 		return RangePenalty<Real>::GetResult();
 	}
 
+	double ReactionForceMeasure::ComputeResultBound( const Model& model )
+	{
+		return RangePenalty<Real>::GetResultBound();
+	}
+
 	bool ReactionForceMeasure::UpdateMeasure( const Model& model, double timestamp )
 	{
 		Real leg_load = 0.0f;
@@ -46,6 +51,6 @@ namespace scone
 	void ReactionForceMeasure::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		// #todo: store joint load value
-		frame[ "legs.load_penalty" ] = GetLatest();
+		m_StoreDataChannels.Begin( frame ).Set( "legs.load_penalty", GetLatest() );
 	}
 }
@@ -24,6 +24,7 @@ namespace scone
 		bool use_force_per_leg;
 
 		virtual double ComputeResult( const Model& model ) override;
+		virtual double ComputeResultBound( const Model& model ) override;
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) override;
 
 	protected:
@@ -86,6 +86,18 @@ namespace scone
 		return penalty;
 	}
 
+	double StepMeasure::ComputeResultBound( const Model& model )
+	{
+		double bound = 0.0; // stride penalties are only added at the end of the simulation
+		if ( !stride_length.IsNull() )
+			bound += stride_length.GetResultBound();
+		if ( !stride_duration.IsNull() )
+			bound += stride_duration.GetResultBound();
+		if ( !stride_velocity.IsNull() )
+			bound += stride_velocity.GetResultBound();
+		return bound;
+	}
+
 	String StepMeasure::GetClassSignature() const
 	{
 		return stringf( "SL" );
@@ -20,8 +20,9 @@ namespace scone
 
 	void Actuator::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
+		auto& ch = m_StoreDataChannels.Begin( frame );
 		if ( flags( StoreDataTypes::ActuatorInput ) )
-			frame[ GetName() + ".input" ] = GetInput();
+			ch.Set( GetName(), ".input", GetInput() );
 	}
 
 	PropNode Actuator::GetInfo() const
@@ -41,24 +41,13 @@ namespace scone
 	void Body::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		auto& name = GetName();
+		auto& ch = m_StoreDataChannels.Begin( frame );
 		if ( flags( StoreDataTypes::BodyPosition ) )
 		{
-			auto pos = GetComPos();
-			frame[ name + ".com_pos_x" ] = pos.x;
-			frame[ name + ".com_pos_y" ] = pos.y;
-			frame[ name + ".com_pos_z" ] = pos.z;
-			auto lin_vel = GetComVel();
-			frame[ name + ".lin_vel_x" ] = lin_vel.x;
-			frame[ name + ".lin_vel_y" ] = lin_vel.y;
-			frame[ name + ".lin_vel_z" ] = lin_vel.z;
-			auto ori = rotation_vector_from_quat( normalized( GetOrientation() ) );
-			frame[ name + ".ori_x" ] = ori.x;
-			frame[ name + ".ori_y" ] = ori.y;
-			frame[ name + ".ori_z" ] = ori.z;
-			auto ang_vel = GetAngVel();
-			frame[ name + ".ang_vel_x" ] = ang_vel.x;
-			frame[ name + ".ang_vel_y" ] = ang_vel.y;
-			frame[ name + ".ang_vel_z" ] = ang_vel.z;
+			ch.SetVec3( name, ".com_pos", GetComPos() );
+			ch.SetVec3( name, ".lin_vel", GetComVel() );
+			ch.SetVec3( name, ".ori", rotation_vector_from_quat( normalized( GetOrientation() ) ) );
+			ch.SetVec3( name, ".ang_vel", GetAngVel() );
 		}
 	}
 
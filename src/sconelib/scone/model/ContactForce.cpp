@@ -29,11 +29,8 @@ namespace scone
 	void ContactForce::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		const auto& [force, moment, point] = GetForceMomentPoint();
-		frame[ GetName() + ".force_x" ] = force.x;
-		frame[ GetName() + ".force_y" ] = force.y;
-		frame[ GetName() + ".force_z" ] = force.z;
-		frame[ GetName() + ".moment_x" ] = moment.x;
-		frame[ GetName() + ".moment_y" ] = moment.y;
-		frame[ GetName() + ".moment_z" ] = moment.z;
+		auto& ch = m_StoreDataChannels.Begin( frame );
+		ch.SetVec3( GetName(), ".force", force );
+		ch.SetVec3( GetName(), ".moment", moment );
 	}
 }
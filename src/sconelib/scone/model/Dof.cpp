@@ -20,6 +20,10 @@ namespace scone
 
 	Real Dof::GetMuscleMoment() const
 	{
+		const auto& model = GetModel();
+		if ( model.GetMuscleSnapshot().IsValid() )
+			return model.GetMomentArmMatrix().GetMuscleMoment( *this, model.GetMuscleSnapshot().force );
+
 		Real mom = 0.0;
 		for ( const auto& mus : GetModel().GetMuscles() )
 		{
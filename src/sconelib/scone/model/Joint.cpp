@@ -55,8 +55,9 @@ namespace scone
 	void Joint::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		// store joint reaction force magnitude
+		auto& ch = m_StoreDataChannels.Begin( frame );
 		if ( flags( StoreDataTypes::JointReactionForce ) )
-			frame[ GetName() + ".load" ] = GetLoad();
+			ch.Set( GetName(), ".load", GetLoad() );
 	}
 
 	PropNode Joint::GetInfo() const
@@ -25,6 +25,7 @@
 
 #include "xo/container/container_tools.h"
 #include "xo/string/string_tools.h"
+#include "xo/string/pattern_matcher.h"
 #include "xo/filesystem/filesystem.h"
 #include "xo/container/storage.h"
 #include "xo/container/flat_map.h"
@@ -57,6 +58,8 @@ namespace scone
 		m_Controller( nullptr ),
 		m_Measure( nullptr ),
 		m_ShouldTerminate( false ),
+		m_DataStreamWindow( 0 ),
+		m_DataStreamIndex( 0 ),
 		m_PrevStoreDataTime( 0 ),
 		m_PrevStoreDataStep( 0 ),
 		m_SimulationTimer( false ),
@@ -128,6 +131,17 @@ namespace scone
 		else return **it;
 	}
 
+	const MomentArmMatrix& Model::GetMomentArmMatrix() const
+	{
+		SCONE_ASSERT( m_MuscleSnapshot.IsValid() );
+		if ( m_MomentArmMatrix.GetUpdateId() != m_MuscleSnapshot.GetUpdateCount() )
+		{
+			SCONE_PROFILE_FUNCTION( GetProfiler() );
+			m_MomentArmMatrix.Update( m_MusclePtrs, m_DofPtrs, m_MuscleSnapshot.GetUpdateCount() );
+		}
+		return m_MomentArmMatrix;
+	}
+
 	DelayedSensorValue Model::GetDelayedSensor( Sensor& sensor, TimeInSeconds delay )
 	{
 		return m_DelayedSensors.GetDelayedSensorValue( sensor, delay, fixed_control_step_size );
@@ -154,13 +168,13 @@ namespace scone
 
 		if ( !m_SensorDelayAdapters.empty() )
 		{
-			const bool first_frame = GetTime() == 0 && m_SensorDelayStorage.IsEmpty();
-			const bool redo_first_frame = GetTime() == 0 && m_SensorDelayStorage.GetFrameCount() == 1;
-			const bool subsequent_frame = !m_SensorDelayStorage.IsEmpty() && GetTime() > GetPreviousTime() && GetPreviousTime() == m_SensorDelayStorage.Back().GetTime();
+			const bool first_frame = GetTime() == 0 && m_SensorDelayBuffer.IsEmpty();
+			const bool redo_first_frame = GetTime() == 0 && m_SensorDelayBuffer.GetFrameCount() == 1;
+			const bool subsequent_frame = !m_SensorDelayBuffer.IsEmpty() && GetTime() > GetPreviousTime() && GetPreviousTime() == m_SensorDelayBuffer.GetLatestTime();
 			SCONE_ASSERT( first_frame || redo_first_frame || subsequent_frame );
 
 			if ( !redo_first_frame )
-				m_SensorDelayStorage.AddFrame( GetTime() );
+				m_SensorDelayBuffer.AddFrame( GetTime() );
 
 			for ( auto& sda : m_SensorDelayAdapters )
 				sda->UpdateStorage();
@@ -188,6 +202,39 @@ namespace scone
 		}
 	}
 
+	void Model::ResetSimulation( const PropNode& props, Params& par )
+	{
+		SCONE_PROFILE_FUNCTION( GetProfiler() );
+
+		// re-read model parameters
+		INIT_PAR( props, par, initial_load, 0.2 );
+		INIT_PAR( props, par, sensor_delay_scaling_factor, 1.0 );
+		INIT_PAR( props, par, initial_equilibration_activation, 0.05 );
+		INIT_PAR( props, par, initialize_activations_from_controller, xo::optional<bool>() );
+
+		// controllers, measures and the sensors they use are recreated afterwards
+		m_Controller.reset();
+		m_Measure.reset();
+		m_Sensors.clear();
+		m_SensorDelayAdapters.clear();
+		m_DelayedSensors = DelayedSensorGroup();
+		m_DelayedActuators = DelayedActuatorGroup();
+		for ( auto* a : GetActuators() )
+			a->ClearInput();
+
+		// clear simulation data, the channel layout of m_Data is rebuilt on the first frame
+		// clearing also changes its layout id, which invalidates the StoreData channels cached by all components
+		m_ShouldTerminate = false;
+		m_SensorDelayBuffer.Clear();
+		m_MuscleSnapshot.Invalidate();
+		m_Data.Clear();
+		m_DataStream.reset();
+		m_UserData.clear();
+		m_PrevStoreDataTime = 0;
+		m_PrevStoreDataStep = 0;
+		m_SimulationTimer = xo::timer( false );
+	}
+
 	void Model::SetStoreData( bool store )
 	{
 		SCONE_ERROR_IF( store && GetTime() > 0.0, "Model SetStoreData() can only be set at before starting the simulation" );
@@ -205,12 +252,13 @@ namespace scone
 	void Model::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
 		SCONE_PROFILE_FUNCTION( GetProfiler() );
+		auto& ch = m_StoreDataChannels.Begin( frame );
 
 		// store states
 		if ( flags( StoreDataTypes::State ) )
 		{
 			for ( size_t i = 0; i < GetState().GetSize(); ++i )
-				frame[ GetState().GetName( i ) ] = GetState().GetValue( i );
+				ch.Set( GetState().GetName( i ), GetState().GetValue( i ) );
 		}
 
 		// store simulation statistics
@@ -218,7 +266,7 @@ namespace scone
 		{
 			auto dt = GetTime() - m_PrevStoreDataTime;
 			auto step_count = GetIntegrationStep() - m_PrevStoreDataStep;
-			frame[ "simulation_frequency" ] = dt > 0 ? step_count / dt : 0.0;
+			ch.Set( "simulation_frequency", dt > 0 ? step_count / dt : 0.0 );
 		}
 
 		// store actuator data
@@ -239,11 +287,11 @@ namespace scone
 			for ( auto& d : GetDofs() )
 			{
 				auto mom = d->GetMuscleMoment() + d->GetLimitMoment();
-				frame[ d->GetName() + ".moment" ] = mom;
-				frame[ d->GetName() + ".moment_norm" ] = mom / GetMass();
-				frame[ d->GetName() + ".power" ] = mom * d->GetVel();
-				frame[ d->GetName() + ".power_norm" ] = mom * d->GetVel() / GetMass();
-				frame[ d->GetName() + ".acceleration" ] = d->GetAcc();
+				ch.Set( d->GetName(), ".moment", mom );
+				ch.Set( d->GetName(), ".moment_norm", mom / GetMass() );
+				ch.Set( d->GetName(), ".power", mom * d->GetVel() );
+				ch.Set( d->GetName(), ".power_norm", mom * d->GetVel() / GetMass() );
+				ch.Set( d->GetName(), ".acceleration", d->GetAcc() );
 			}
 		}
 
@@ -259,13 +307,13 @@ namespace scone
 			auto cp = GetTotalContactPower();
 			auto gp = xo::dot_product( GetComVel(), GetMass() * GetGravity() );
 			auto external_power = jp + cp + mp + gp;
-			frame[ "total_body.power" ] = bp;
-			frame[ "total_muscle.power" ] = mp;
-			frame[ "total_joint_limit.power" ] = jp;
-			frame[ "total_contact.power" ] = cp;
-			frame[ "total_gravity.power" ] = gp;
-			frame[ "total_external.power" ] = external_power;
-			frame[ "total.power" ] = bp - external_power;
+			ch.Set( "total_body.power", bp );
+			ch.Set( "total_muscle.power", mp );
+			ch.Set( "total_joint_limit.power", jp );
+			ch.Set( "total_contact.power", cp );
+			ch.Set( "total_gravity.power", gp );
+			ch.Set( "total_external.power", external_power );
+			ch.Set( "total.power", bp - external_power );
 		}
 
 		// store controller / measure data
@@ -275,11 +323,11 @@ namespace scone
 			GetMeasure()->StoreData( frame, flags );
 
 		// store sensor data
-		if ( flags( StoreDataTypes::SensorData ) && !m_SensorDelayStorage.IsEmpty() )
+		if ( flags( StoreDataTypes::SensorData ) && !m_SensorDelayBuffer.IsEmpty() )
 		{
-			const auto& sf = m_SensorDelayStorage.Back();
-			for ( index_t i = 0; i < m_SensorDelayStorage.GetChannelCount(); ++i )
-				frame[ m_SensorDelayStorage.GetLabels()[ i ] ] = sf[ i ];
+			const auto* sf = std::as_const( m_SensorDelayBuffer ).GetLatestFrame();
+			for ( index_t i = 0; i < m_SensorDelayBuffer.GetChannelCount(); ++i )
+				ch.Set( m_SensorDelayBuffer.GetLabels()[ i ], sf[ i ] );
 		}
 
 		// store COP data
@@ -287,16 +335,20 @@ namespace scone
 		{
 			auto com = GetComPos();
 			auto com_u = GetComVel();
-			frame[ "com_x" ] = com.x;
-			frame[ "com_y" ] = com.y;
-			frame[ "com_z" ] = com.z;
-			frame[ "com_x_u" ] = com_u.x;
-			frame[ "com_y_u" ] = com_u.y;
-			frame[ "com_z_u" ] = com_u.z;
+			ch.Set( "com_x", com.x );
+			ch.Set( "com_y", com.y );
+			ch.Set( "com_z", com.z );
+			ch.Set( "com_x_u", com_u.x );
+			ch.Set( "com_y_u", com_u.y );
+			ch.Set( "com_z_u", com_u.z );
 
 			const auto mom = GetLinAngMom();
-			frame.SetVec3( "lin_mom", mom.first );
-			frame.SetVec3( "ang_mom", mom.second );
+			ch.Set( "lin_mom_x", mom.first.x );
+			ch.Set( "lin_mom_y", mom.first.y );
+			ch.Set( "lin_mom_z", mom.first.z );
+			ch.Set( "ang_mom_x", mom.second.x );
+			ch.Set( "ang_mom_y", mom.second.y );
+			ch.Set( "ang_mom_z", mom.second.z );
 		}
 
 		// store GRF data (measured in BW)
@@ -308,18 +360,10 @@ namespace scone
 				leg->GetContactForceMomentCop( force, moment, cop );
 				Vec3 grf = force / GetBW();
 
-				frame[ leg->GetName() + ".grf_norm_x" ] = grf.x;
-				frame[ leg->GetName() + ".grf_norm_y" ] = grf.y;
-				frame[ leg->GetName() + ".grf_norm_z" ] = grf.z;
-				frame[ leg->GetName() + ".grf_x" ] = force.x;
-				frame[ leg->GetName() + ".grf_y" ] = force.y;
-				frame[ leg->GetName() + ".grf_z" ] = force.z;
-				frame[ leg->GetName() + ".grm_x" ] = moment.x;
-				frame[ leg->GetName() + ".grm_y" ] = moment.y;
-				frame[ leg->GetName() + ".grm_z" ] = moment.z;
-				frame[ leg->GetName() + ".cop_x" ] = cop.x;
-				frame[ leg->GetName() + ".cop_y" ] = cop.y;
-				frame[ leg->GetName() + ".cop_z" ] = cop.z;
+				ch.SetVec3( leg->GetName(), ".grf_norm", grf );
+				ch.SetVec3( leg->GetName(), ".grf", force );
+				ch.SetVec3( leg->GetName(), ".grm", moment );
+				ch.SetVec3( leg->GetName(), ".cop", cop );
 			}
 		}
 
@@ -339,6 +383,52 @@ namespace scone
 
 		m_PrevStoreDataTime = GetTime();
 		m_PrevStoreDataStep = GetIntegrationStep();
+
+		if ( m_DataStream )
+			UpdateStoreDataStream();
+	}
+
+	void Model::SetStoreDataStream( const path& file_base, size_t window_frames )
+	{
+		SCONE_ERROR_IF( !m_Data.IsEmpty(), "Model SetStoreDataStream() can only be set before starting the simulation" );
+		m_DataStream = std::make_unique<StorageStreamWriter>( file_base + ".sto", ( file_base.parent_path().filename() / file_base.stem() ).str(), m_StoreDataInterval );
+		if ( GetSconeSetting<bool>( "results.binary_storage" ) )
+			m_DataStream->AddBinaryOutput( file_base + ".stob" );
+		if ( GetSconeSetting<bool>( "results.extract_channels" ) )
+			m_DataStream->AddChannelOutput( file_base + ".channels.txt", GetSconeSetting<string>( "results.extract_channel_names" ) );
+		m_DataStreamWindow = window_frames;
+		m_DataStreamIndex = 0;
+	}
+
+	void Model::FinishStoreDataStream()
+	{
+		if ( m_DataStream && !m_DataStream->IsFinished() )
+		{
+			m_DataStream->Write( m_Data, m_DataStreamIndex, m_Data.GetFrameCount() );
+			m_DataStreamIndex = m_Data.GetFrameCount();
+			m_DataStream->Finish();
+		}
+	}
+
+	void Model::UpdateStoreDataStream()
+	{
+		const auto chunk_size = m_Data.chunk_frame_count;
+
+		// the most recent frame can still be updated, so only frames before that are written
+		const auto end = m_Data.GetFrameCount() - 1;
+		if ( end >= m_DataStreamIndex + chunk_size )
+		{
+			m_DataStream->Write( m_Data, m_DataStreamIndex, end );
+			m_DataStreamIndex = end;
+		}
+
+		// remove frames that have been written and are outside the window
+		if ( m_DataStreamIndex > m_DataStreamWindow )
+		{
+			const auto chunk_count = ( m_DataStreamIndex - m_DataStreamWindow ) / chunk_size;
+			m_Data.EraseFrontChunks( chunk_count );
+			m_DataStreamIndex -= chunk_count * chunk_size;
+		}
 	}
 
 	void Model::CreateController( const FactoryProps& controller_fp, Params& par )
@@ -450,9 +540,53 @@ namespace scone
 
 	std::vector<path> Model::WriteResults( const path& file ) const
 	{
+		SCONE_PROFILE_FUNCTION( GetProfiler() );
 		std::vector<path> files;
-		WriteStorageSto( m_Data, file + ".sto", ( file.parent_path().filename() / file.stem() ).str(), m_StoreDataInterval );
-		files.push_back( file + ".sto" );
+		if ( m_DataStream )
+		{
+			// streamed data is written during evaluation, m_Data only contains the most recent frames
+			SCONE_ERROR_IF( !m_DataStream->IsFinished(), "FinishStoreDataStream() must be called before WriteResults()" );
+			const auto stream_base_size = m_DataStream->GetFile().str().size() - 4; // without .sto
+			for ( const auto& stream_file : { m_DataStream->GetFile(), m_DataStream->GetBinaryFile(), m_DataStream->GetChannelFile() } )
+			{
+				if ( stream_file.empty() )
+					continue;
+				auto target_file = file + stream_file.str().substr( stream_base_size );
+				if ( stream_file.str() != target_file.str() )
+					SCONE_ERROR_IF( !xo::copy_file( stream_file, target_file, true ), "Could not copy " + stream_file.str() + " to " + target_file.str() );
+				files.push_back( target_file );
+			}
+		}
+		else
+		{
+			WriteStorageSto( m_Data, file + ".sto", ( file.parent_path().filename() / file.stem() ).str(), m_StoreDataInterval );
+			files.push_back( file + ".sto" );
+			if ( GetSconeSetting<bool>( "results.binary_storage" ) )
+			{
+				WriteStorageBinary( m_Data, file + ".stob", StorageEncoding::Float64, m_StoreDataInterval );
+				files.push_back( file + ".stob" );
+			}
+
+			// extract specific channels for debugging / analysis, in the same format as StorageStreamWriter
+			if ( GetSconeSetting<bool>( "results.extract_channels" ) )
+			{
+				xo::pattern_matcher match( GetSconeSetting<string>( "results.extract_channel_names" ) );
+				std::vector< index_t > indices;
+				std::vector< String > labels;
+				for ( index_t idx = 0; idx < m_Data.GetChannelCount(); ++idx )
+					if ( match( m_Data.GetLabels()[ idx ] ) )
+						indices.push_back( idx ), labels.push_back( m_Data.GetLabels()[ idx ] );
+				Storage<> sto( labels );
+				for ( index_t fidx = 0; fidx < m_Data.GetFrameCount(); ++fidx )
+				{
+					auto& frame = sto.AddFrame( m_Data.GetFrame( fidx ).GetTime() );
+					for ( index_t i = 0; i < indices.size(); ++i )
+						frame[ i ] = m_Data.GetValue( fidx, indices[ i ] );
+				}
+				WriteStorageTxt( sto, file + ".channels.txt", "time", m_StoreDataInterval );
+				files.push_back( file + ".channels.txt" );
+			}
+		}
 
 		if ( GetSconeSetting<bool>( "results.controller" ) )
 		{
@@ -462,18 +596,6 @@ namespace scone
 				xo::append( files, GetMeasure()->WriteResults( file ) );
 		}
 
-		// extract specific channels for debugging / analysis
-		if ( GetSconeSetting<bool>( "results.extract_channels" ) )
-		{
-			xo::storage< Real > sto;
-			sto.resize( GetData().GetFrameCount(), 0 );
-			xo::pattern_matcher match( GetSconeSetting<string>( "results.extract_channel_names" ) );
-			for ( index_t idx = 0; idx < GetData().GetChannelCount(); ++idx )
-				if ( const auto& label = GetData().GetLabels()[ idx ]; match( label ) )
-					sto.add_channel( label, GetData().GetChannelData( idx ) );
-			std::ofstream( file.str() + ".channels.txt" ) << sto;
-		}
-
 		return files;
 	}
 
@@ -577,7 +699,8 @@ namespace scone
 		m_SensorDelayAdapters.clear();
 
 		m_ShouldTerminate = false;
-		m_SensorDelayStorage.Clear();
+		m_SensorDelayBuffer.Clear();
+		m_MuscleSnapshot.Invalidate();
 		m_Data.Clear();
 		m_UserData.clear();
 		m_PrevStoreDataTime = 0;
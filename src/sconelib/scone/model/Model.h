@@ -27,6 +27,7 @@
 #include "scone/core/HasName.h"
 #include "scone/core/HasSignature.h"
 #include "scone/core/Storage.h"
+#include "scone/core/StorageStreamWriter.h"
 #include "scone/measures/Measure.h"
 #include "scone/core/Factories.h"
 
@@ -34,6 +35,9 @@
 #include <type_traits>
 #include <utility>
 #include "DelayBuffer.h"
+#include "SensorDelayBuffer.h"
+#include "MuscleSnapshot.h"
+#include "MomentArmMatrix.h"
 
 namespace scone
 {
@@ -124,6 +128,12 @@ namespace scone
 		virtual bool HasSimulationEnded() { return m_ShouldTerminate || GetTime() >= GetSimulationEndTime(); }
 		virtual void RequestTermination() { m_ShouldTerminate = true; }
 		virtual PropNode GetSimulationReport() const;
+
+		/// Reset the model to its initial state and recreate controllers and measures using new parameters.
+		/// Returns false if the model does not support this, in which case a new model must be created.
+		virtual bool Reset( const PropNode& props, Params& par ) { return false; }
+		/// Returns true if Reset() is supported by this model.
+		virtual bool CanReset() const { return false; }
 		virtual TimeInSeconds GetSimulationDuration() const { return m_SimulationTimer().secondsd(); }
 		virtual void UpdatePerformanceStats( const path& filename ) const {}
 		virtual std::vector<std::pair<String, std::pair<xo::time, size_t>>> GetBenchmarks() const { return {}; }
@@ -133,6 +143,13 @@ namespace scone
 		virtual Storage<Real, TimeInSeconds>::Frame& GetCurrentFrame() { SCONE_ASSERT( !m_Data.IsEmpty() ); return m_Data.Back(); }
 		virtual std::vector<path> WriteResults( const path& file_base ) const;
 
+		/// Write stored data to file_base.sto (and .stob / .channels.txt, depending on the results settings) during simulation,
+		/// keeping only the most recent window_frames in memory. The files are completed by FinishStoreDataStream().
+		void SetStoreDataStream( const path& file_base, size_t window_frames );
+
+		/// Write the remaining frames to the data stream and complete the files; call after the simulation has ended.
+		void FinishStoreDataStream();
+
 		// get dynamic model statistics
 		virtual Vec3 GetComPos() const = 0;
 		virtual Vec3 GetComVel() const = 0;
@@ -179,10 +196,16 @@ namespace scone
 
 		// create delayed sensors (old system)
 		SensorDelayAdapter& AcquireSensorDelayAdapter( Sensor& source );
-		Storage< Real >& GetSensorDelayStorage() { return m_SensorDelayStorage; }
+		SensorDelayBuffer& GetSensorDelayBuffer() { return m_SensorDelayBuffer; }
 		template< typename SensorT, typename... Args > SensorDelayAdapter& AcquireDelayedSensor( Args&&... args )
 		{ return AcquireSensorDelayAdapter( AcquireSensor< SensorT >( std::forward< Args >( args )... ) ); }
 
+		/// Muscle state at the current simulation step, see MuscleSnapshot
+		const MuscleSnapshot& GetMuscleSnapshot() const { return m_MuscleSnapshot; }
+		void InvalidateMuscleSnapshot() { m_MuscleSnapshot.Invalidate(); }
+		/// Moment arms of all muscles, computed at most once per muscle snapshot; requires a valid muscle snapshot
+		const MomentArmMatrix& GetMomentArmMatrix() const;
+
 		// get delayed sensor, recommended approach
 		DelayedSensorValue GetDelayedSensor( Sensor& sensor, TimeInSeconds delay );
 
@@ -257,11 +280,13 @@ namespace scone
 		void UpdateAnalyses();
 
 		void CreateControllers( const PropNode& pn, Params& par );
+		void ResetSimulation( const PropNode& props, Params& par );
 		virtual void SetController( ControllerUP c ) { SCONE_ASSERT( !m_Controller ); m_Controller = std::move( c ); }
 		void SetMeasure( MeasureUP m ) { SCONE_ASSERT( !m_Measure ); m_Measure = std::move( m ); }
 
 		virtual void StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const override;
 		virtual void StoreCurrentFrame();
+		void UpdateStoreDataStream();
 
 		virtual void AddExternalDisplayGeometries( const path& model_path );
 		virtual void Clear();
@@ -295,8 +320,13 @@ namespace scone
 
 		// simulation data
 		bool m_ShouldTerminate;
-		Storage< Real > m_SensorDelayStorage;
+		SensorDelayBuffer m_SensorDelayBuffer;
+		MuscleSnapshot m_MuscleSnapshot;
+		mutable MomentArmMatrix m_MomentArmMatrix;
 		Storage< Real, TimeInSeconds > m_Data;
+		std::unique_ptr< StorageStreamWriter > m_DataStream;
+		size_t m_DataStreamWindow;
+		index_t m_DataStreamIndex;
 		PropNode m_UserData;
 		TimeInSeconds m_PrevStoreDataTime;
 		int m_PrevStoreDataStep;
@@ -0,0 +1,98 @@
+/*
+** MomentArmMatrix.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "MomentArmMatrix.h"
+
+#include "Muscle.h"
+#include "Dof.h"
+#include "scone/core/Exception.h"
+
+namespace scone
+{
+	MomentArmMatrix::MomentArmMatrix() :
+		update_id_( NoIndex )
+	{}
+
+	void MomentArmMatrix::Update( const std::vector< Muscle* >& muscles, const std::vector< Dof* >& dofs, size_t update_id )
+	{
+		if ( row_begin_.size() != muscles.size() + 1 || dofs_.size() != dofs.size() )
+			CreatePattern( muscles, dofs );
+
+		for ( index_t mi = 0; mi < muscles.size(); ++mi )
+			for ( index_t k = row_begin_[ mi ]; k < row_begin_[ mi + 1 ]; ++k )
+				moment_arms_[ k ] = muscles[ mi ]->ComputeMomentArm( *entry_dofs_[ k ] );
+
+		update_id_ = update_id;
+	}
+
+	Real MomentArmMatrix::GetMomentArm( index_t muscle_idx, const Dof& dof ) const
+	{
+		SCONE_ASSERT( muscle_idx + 1 < row_begin_.size() );
+		for ( index_t k = row_begin_[ muscle_idx ]; k < row_begin_[ muscle_idx + 1 ]; ++k )
+			if ( entry_dofs_[ k ] == &dof )
+				return moment_arms_[ k ];
+		return 0.0;
+	}
+
+	Real MomentArmMatrix::GetMuscleMoment( const Dof& dof, const std::vector< Real >& muscle_forces ) const
+	{
+		auto di = GetDofIndex( dof );
+		Real mom = 0.0;
+		for ( index_t k = col_begin_[ di ]; k < col_begin_[ di + 1 ]; ++k )
+			mom += muscle_forces[ col_muscles_[ k ] ] * moment_arms_[ col_entries_[ k ] ];
+		return mom;
+	}
+
+	void MomentArmMatrix::CreatePattern( const std::vector< Muscle* >& muscles, const std::vector< Dof* >& dofs )
+	{
+		dofs_.assign( dofs.begin(), dofs.end() );
+		dof_indices_.clear();
+		for ( index_t di = 0; di < dofs_.size(); ++di )
+			dof_indices_.emplace( dofs_[ di ], di );
+
+		row_begin_.clear();
+		entry_dofs_.clear();
+		for ( const auto* mus : muscles )
+		{
+			row_begin_.push_back( entry_dofs_.size() );
+			for ( const auto* d : mus->GetDofs() )
+				entry_dofs_.push_back( d );
+		}
+		row_begin_.push_back( entry_dofs_.size() );
+		moment_arms_.assign( entry_dofs_.size(), 0.0 );
+
+		// muscles are visited in order, so each column is sorted by muscle
+		col_begin_.assign( dofs_.size() + 1, 0 );
+		col_muscles_.clear();
+		col_entries_.clear();
+		for ( index_t di = 0; di < dofs_.size(); ++di )
+		{
+			col_begin_[ di ] = col_muscles_.size();
+			for ( index_t mi = 0; mi < muscles.size(); ++mi )
+			{
+				for ( index_t k = row_begin_[ mi ]; k < row_begin_[ mi + 1 ]; ++k )
+				{
+					if ( entry_dofs_[ k ] == dofs_[ di ] )
+					{
+						col_muscles_.push_back( mi );
+						col_entries_.push_back( k );
+						break;
+					}
+				}
+			}
+		}
+		col_begin_[ dofs_.size() ] = col_muscles_.size();
+	}
+
+	index_t MomentArmMatrix::GetDofIndex( const Dof& dof ) const
+	{
+		auto it = dof_indices_.find( &dof );
+		SCONE_THROW_IF( it == dof_indices_.end(), "Could not find dof " + dof.GetName() );
+		return it->second;
+	}
+}
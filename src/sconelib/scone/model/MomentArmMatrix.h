@@ -0,0 +1,56 @@
+/*
+** MomentArmMatrix.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include <unordered_map>
+#include <vector>
+
+namespace scone
+{
+	class Muscle;
+	class Dof;
+
+	/// Sparse muscle x dof matrix with the moment arms of all muscles in a Model.
+	/// The sparsity pattern is taken from Muscle::GetDofs(), moment arms of other dofs are zero.
+	/// Values are computed by Model::GetMomentArmMatrix() at most once per MuscleSnapshot update.
+	class SCONE_API MomentArmMatrix
+	{
+	public:
+		MomentArmMatrix();
+
+		/// Compute the moment arms of all muscles, the sparsity pattern is created on the first call
+		void Update( const std::vector< Muscle* >& muscles, const std::vector< Dof* >& dofs, size_t update_id );
+		size_t GetUpdateId() const { return update_id_; }
+
+		/// Moment arm of muscle with index muscle_idx on a dof
+		Real GetMomentArm( index_t muscle_idx, const Dof& dof ) const;
+		/// Sum of the moments of all muscles on a dof, using muscle forces with the same order as the muscles
+		Real GetMuscleMoment( const Dof& dof, const std::vector< Real >& muscle_forces ) const;
+
+	private:
+		void CreatePattern( const std::vector< Muscle* >& muscles, const std::vector< Dof* >& dofs );
+		index_t GetDofIndex( const Dof& dof ) const;
+
+		size_t update_id_;
+		std::vector< const Dof* > dofs_;
+		std::unordered_map< const Dof*, index_t > dof_indices_;
+
+		// muscle-major (CSR) storage
+		std::vector< index_t > row_begin_; // muscle_count + 1
+		std::vector< const Dof* > entry_dofs_;
+		std::vector< Real > moment_arms_;
+
+		// dof-major index into moment_arms_, sorted by muscle
+		std::vector< index_t > col_begin_; // dof_count + 1
+		std::vector< index_t > col_muscles_;
+		std::vector< index_t > col_entries_;
+	};
+}
@@ -20,12 +20,22 @@
 
 namespace scone
 {
-	Muscle::Muscle() : Actuator()
+	Muscle::Muscle() :
+		Actuator(),
+		m_Snapshot( nullptr ),
+		m_SnapshotIndex( NoIndex )
 	{}
 
 	Muscle::~Muscle()
 	{}
 
+	Real Muscle::GetMomentArm( const Dof& dof ) const
+	{
+		if ( GetValidSnapshot() )
+			return GetModel().GetMomentArmMatrix().GetMomentArm( m_SnapshotIndex, dof );
+		else return HasMomentArm( dof ) ? ComputeMomentArm( dof ) : 0.0;
+	}
+
 	Real Muscle::GetNormalizedMomentArm( const Dof& dof ) const
 	{
 		Real mom = GetMomentArm( dof );
@@ -141,44 +151,50 @@ namespace scone
 
 	void Muscle::StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		Actuator::StoreData( frame, flags );
+		Actuator::StoreData( frame, flags ); // also begins m_StoreDataChannels
+		auto& ch = m_StoreDataChannels;
 
 		if ( flags( StoreDataTypes::ActuatorInput ) || flags( StoreDataTypes::MuscleProperties ) )
-			frame[ GetName() + ".excitation" ] = GetExcitation();
+			ch.Set( GetName(), ".excitation", GetExcitation() );
 
 		if ( flags( StoreDataTypes::MuscleProperties ) )
 		{
 			const auto& name = GetName();
 			if ( !flags( StoreDataTypes::State ) ) // activation is also part of state
-				frame[ name + ".activation" ] = GetActivation();
+				ch.Set( name, ".activation", GetActivation() );
 
 			// tendon / mtu properties
-			frame[ name + ".tendon_length" ] = GetTendonLength();
-			frame[ name + ".tendon_length_norm" ] = GetNormalizedTendonLength() - 1;
-			frame[ name + ".mtu_length" ] = GetLength();
-			frame[ name + ".mtu_velocity" ] = GetVelocity();
-			frame[ name + ".mtu_force" ] = GetForce();
-			frame[ name + ".mtu_force_norm" ] = GetNormalizedForce();
-			frame[ name + ".mtu_power" ] = GetForce() * GetVelocity();
+			ch.Set( name, ".tendon_length", GetTendonLength() );
+			ch.Set( name, ".tendon_length_norm", GetNormalizedTendonLength() - 1 );
+			ch.Set( name, ".mtu_length", GetLength() );
+			ch.Set( name, ".mtu_velocity", GetVelocity() );
+			ch.Set( name, ".mtu_force", GetForce() );
+			ch.Set( name, ".mtu_force_norm", GetNormalizedForce() );
+			ch.Set( name, ".mtu_power", GetForce() * GetVelocity() );
 
 			// fiber properties
-			frame[ name + ".cos_pennation_angle" ] = GetCosPennationAngle();
-			frame[ name + ".force_length_multiplier" ] = GetActiveForceLengthMultipler();
-			frame[ name + ".passive_fiber_force_norm" ] = GetPassiveFiberForce() / GetMaxIsometricForce();
-			frame[ name + ".fiber_length_norm" ] = GetNormalizedFiberLength();
-			frame[ name + ".fiber_velocity_norm" ] = GetNormalizedFiberVelocity();
+			ch.Set( name, ".cos_pennation_angle", GetCosPennationAngle() );
+			ch.Set( name, ".force_length_multiplier", GetActiveForceLengthMultipler() );
+			ch.Set( name, ".passive_fiber_force_norm", GetPassiveFiberForce() / GetMaxIsometricForce() );
+			ch.Set( name, ".fiber_length_norm", GetNormalizedFiberLength() );
+			ch.Set( name, ".fiber_velocity_norm", GetNormalizedFiberVelocity() );
 		}
 
 		if ( flags( StoreDataTypes::MuscleDofMomentPower ) )
 		{
-			for ( auto& d : GetDofs() )
+			const auto& dofs = GetDofs();
+			auto& labels = ch.GetLabels();
+			if ( labels.empty() )
+				for ( auto& d : dofs )
+					labels.emplace_back( GetName() + "." + d->GetName() );
+			for ( index_t i = 0; i < dofs.size(); ++i )
 			{
-				auto name = GetName() + "." + d->GetName();
+				const auto& d = dofs[ i ];
 				auto ma = GetMomentArm( *d );
 				auto mom = GetForce() * ma;
-				frame[ name + ".moment_arm" ] = ma;
-				frame[ name + ".moment" ] = mom;
-				frame[ name + ".power" ] = mom * d->GetVel();
+				ch.Set( labels[ i ], ".moment_arm", ma );
+				ch.Set( labels[ i ], ".moment", mom );
+				ch.Set( labels[ i ], ".power", mom * d->GetVel() );
 			}
 		}
 	}
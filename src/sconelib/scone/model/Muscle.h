@@ -15,6 +15,7 @@
 #include "scone/core/Storage.h"
 
 #include "Actuator.h"
+#include "MuscleSnapshot.h"
 
 #include <vector>
 #include "Side.h"
@@ -34,7 +35,10 @@ namespace scone
 		virtual const Body& GetInsertionBody() const = 0;
 		virtual const Model& GetModel() const = 0;
 
-		virtual Real GetMomentArm( const Dof& dof ) const = 0;
+		/// Moment arm on a dof, read from Model::GetMomentArmMatrix() when the muscle snapshot is valid
+		virtual Real GetMomentArm( const Dof& dof ) const;
+		/// Compute the moment arm on a dof the muscle crosses, used to update the MomentArmMatrix
+		virtual Real ComputeMomentArm( const Dof& dof ) const = 0;
 		virtual Real GetNormalizedMomentArm( const Dof& dof ) const;
 		virtual Real GetMoment( const Dof& dof ) const;
 
@@ -91,7 +95,15 @@ namespace scone
 		virtual void StoreData( Storage< Real >::Frame& frame, const StoreDataFlags& flags ) const override;
 		virtual PropNode GetInfo() const;
 
+		/// Link to the snapshot that stores the state of this muscle, see MuscleSnapshot
+		void SetSnapshot( const MuscleSnapshot* snapshot, index_t index ) { m_Snapshot = snapshot; m_SnapshotIndex = index; }
+
 	protected:
+		/// Returns the snapshot if it contains the current muscle state, nullptr otherwise
+		const MuscleSnapshot* GetValidSnapshot() const { return m_Snapshot && m_Snapshot->IsValid() ? m_Snapshot : nullptr; }
+		const MuscleSnapshot* m_Snapshot;
+		index_t m_SnapshotIndex;
+
 		void InitBodyJointDofs( const Body* b );
 		void InitJointsDofs();
 		mutable std::vector< const Joint* > m_Joints;
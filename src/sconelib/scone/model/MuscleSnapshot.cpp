@@ -0,0 +1,43 @@
+/*
+** MuscleSnapshot.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "MuscleSnapshot.h"
+
+#include "Muscle.h"
+
+namespace scone
+{
+	void MuscleSnapshot::Update( const std::vector< Muscle* >& muscles )
+	{
+		// muscles must query the simulation engine while the snapshot is being updated
+		valid_ = false;
+
+		const auto n = muscles.size();
+		force.resize( n );
+		length.resize( n );
+		velocity.resize( n );
+		fiber_length.resize( n );
+		fiber_velocity.resize( n );
+		activation.resize( n );
+
+		for ( index_t i = 0; i < n; ++i )
+		{
+			auto& mus = *muscles[ i ];
+			mus.SetSnapshot( this, i );
+			force[ i ] = mus.GetForce();
+			length[ i ] = mus.GetLength();
+			velocity[ i ] = mus.GetVelocity();
+			fiber_length[ i ] = mus.GetFiberLength();
+			fiber_velocity[ i ] = mus.GetFiberVelocity();
+			activation[ i ] = mus.GetActivation();
+		}
+
+		valid_ = true;
+		++update_count_;
+	}
+}
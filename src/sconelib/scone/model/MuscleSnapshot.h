@@ -0,0 +1,47 @@
+/*
+** MuscleSnapshot.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include <vector>
+
+namespace scone
+{
+	class Muscle;
+
+	/// State of all muscles in a Model at the current simulation step, stored in contiguous arrays.
+	/// The Model updates the snapshot once per step, after the system is realized. While the snapshot is valid,
+	/// Muscle getters read from it instead of querying the simulation engine.
+	class SCONE_API MuscleSnapshot
+	{
+	public:
+		MuscleSnapshot() : valid_( false ), update_count_( 0 ) {}
+
+		/// Read the state of all muscles and link each muscle to its index in the snapshot
+		void Update( const std::vector< Muscle* >& muscles );
+		/// Must be called whenever the simulation state changes outside Update()
+		void Invalidate() { valid_ = false; }
+		bool IsValid() const { return valid_; }
+		size_t GetMuscleCount() const { return force.size(); }
+		/// Number of updates, used to identify the simulation step of a snapshot
+		size_t GetUpdateCount() const { return update_count_; }
+
+		std::vector< Real > force;
+		std::vector< Real > length;
+		std::vector< Real > velocity;
+		std::vector< Real > fiber_length;
+		std::vector< Real > fiber_velocity;
+		std::vector< Real > activation;
+
+	private:
+		bool valid_;
+		size_t update_count_;
+	};
+}
@@ -10,7 +10,7 @@
 #include "SensorDelayAdapter.h"
 #include "Sensor.h"
 #include "scone/core/platform.h"
-#include "scone/core/Storage.h"
+#include "SensorDelayBuffer.h"
 #include "scone/core/string_tools.h"
 #include "xo/numerical/math.h"
 
@@ -22,7 +22,8 @@ namespace scone
 	m_InputSensor( source ),
 	m_Delay( default_delay )
 	{
-		m_StorageIdx = m_Model.GetSensorDelayStorage().AddChannel( source.GetName() );
+		m_StorageIdx = m_Model.GetSensorDelayBuffer().AddChannel( source.GetName() );
+		RequireDelay( default_delay );
 	}
 
 	SensorDelayAdapter::~SensorDelayAdapter()
@@ -35,26 +36,39 @@ namespace scone
 
 	Real SensorDelayAdapter::GetValue( Real delay ) const
 	{
-		return m_Model.GetSensorDelayStorage().GetInterpolatedValue( m_Model.GetTime() - delay * m_Model.sensor_delay_scaling_factor, m_StorageIdx );
+		// delays must be registered with RequireDelay() before the simulation starts
+		const auto& buf = m_Model.GetSensorDelayBuffer();
+		return buf.GetInterpolatedValue( m_Model.GetTime() - delay * m_Model.sensor_delay_scaling_factor, m_StorageIdx );
 	}
 
 	Real SensorDelayAdapter::GetAverageValue( int delay_samples, int window_size ) const
 	{
-		auto& sto = m_Model.GetSensorDelayStorage();
-		auto history_begin = xo::max( 0, (int)sto.GetFrameCount() - delay_samples - window_size / 2 );
-		auto history_end = xo::clamped( (int)sto.GetFrameCount() - delay_samples - window_size / 2 + window_size, 1, (int)sto.GetFrameCount() );
+		auto& buf = m_Model.GetSensorDelayBuffer();
+		buf.RequireFrames( delay_samples + window_size );
+		auto history_begin = xo::max( 0, (int)buf.GetFrameCount() - delay_samples - window_size / 2 );
+		auto history_end = xo::clamped( (int)buf.GetFrameCount() - delay_samples - window_size / 2 + window_size, 1, (int)buf.GetFrameCount() );
 
 		Real value = 0.0;
 		for ( auto i = history_begin; i < history_end; ++i )
-			value += sto.GetFrame( i )[ m_StorageIdx ];
+			value += buf.GetValue( i, m_StorageIdx );
 		return value / ( history_end - history_begin );
 	}
 
+	void SensorDelayAdapter::RequireDelay( TimeInSeconds delay )
+	{
+		m_Model.GetSensorDelayBuffer().RequireDelay( delay * m_Model.sensor_delay_scaling_factor );
+	}
+
+	void SensorDelayAdapter::RequireAverageValue( int delay_samples, int window_size )
+	{
+		m_Model.GetSensorDelayBuffer().RequireFrames( delay_samples + window_size );
+	}
+
 	void SensorDelayAdapter::UpdateStorage()
 	{
-		Storage< Real >& storage = m_Model.GetSensorDelayStorage();
-		SCONE_ASSERT( !storage.IsEmpty() && storage.Back().GetTime() == m_Model.GetTime() );
-		storage.Back()[ m_StorageIdx ] = m_InputSensor.GetValue();
+		auto& buf = m_Model.GetSensorDelayBuffer();
+		SCONE_ASSERT( !buf.IsEmpty() && buf.GetLatestTime() == m_Model.GetTime() );
+		buf.GetLatestFrame()[ m_StorageIdx ] = m_InputSensor.GetValue();
 	}
 
 	String SensorDelayAdapter::GetName() const
@@ -28,6 +28,11 @@ namespace scone
 		Real GetValue( Real delay ) const;
 		Real GetAverageValue( int delay_samples, int window_size ) const;
 
+		/// Make sure values with this delay remain available, call before the simulation starts
+		void RequireDelay( TimeInSeconds delay );
+		/// Make sure values for GetAverageValue() remain available, call before the simulation starts
+		void RequireAverageValue( int delay_samples, int window_size );
+
 		void UpdateStorage();
 		Sensor& GetInputSensor() { return m_InputSensor; }
 
@@ -0,0 +1,146 @@
+/*
+** SensorDelayBuffer.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "SensorDelayBuffer.h"
+
+#include "scone/core/Exception.h"
+#include "xo/container/container_tools.h"
+
+namespace scone
+{
+	const size_t initial_capacity = 64;
+	const size_t max_cached_positions = 32;
+
+	SensorDelayBuffer::SensorDelayBuffer() :
+		capacity_( initial_capacity ),
+		first_frame_( 0 ),
+		frame_count_( 0 ),
+		shared_count_( 0 ),
+		max_delay_( 0 ),
+		min_frames_( 0 ),
+		keep_all_( false )
+	{
+		times_.resize( capacity_ );
+	}
+
+	index_t SensorDelayBuffer::AddChannel( const String& label )
+	{
+		SCONE_ASSERT( shared_count_ == 0 );
+		Resize( capacity_, labels_.size() + 1 );
+		labels_.emplace_back( label );
+		return labels_.size() - 1;
+	}
+
+	void SensorDelayBuffer::AppendSharedFrames( s_ptr< const SharedFrames > frames )
+	{
+		SCONE_ASSERT( shared_count_ == 0 && frames->values.size() == frames->times.size() * GetChannelCount() );
+		SCONE_ASSERT( IsEmpty() || frames->times.empty() || frames->times.front() >= GetLatestTime() );
+		shared_count_ = frames->times.size();
+		shared_frames_ = std::move( frames );
+		positions_.clear();
+	}
+
+	Real* SensorDelayBuffer::AddFrame( TimeInSeconds time )
+	{
+		SCONE_ASSERT( shared_count_ == 0 && ( IsEmpty() || time >= GetLatestTime() ) );
+
+		// remove frames that are no longer needed; one extra frame is kept for interpolation,
+		// another in case values are requested at a time before the latest frame
+		if ( !keep_all_ )
+		{
+			const auto oldest_time = time - max_delay_;
+			while ( frame_count_ - first_frame_ > min_frames_ && first_frame_ + 2 < frame_count_ && times_[ Slot( first_frame_ + 2 ) ] <= oldest_time )
+				++first_frame_;
+		}
+
+		if ( frame_count_ - first_frame_ == capacity_ )
+			Resize( 2 * capacity_, GetChannelCount() );
+
+		const auto slot = Slot( frame_count_++ );
+		times_[ slot ] = time;
+		positions_.clear();
+		auto* values = &values_[ slot * GetChannelCount() ];
+		std::fill( values, values + GetChannelCount(), Real( 0 ) );
+		return values;
+	}
+
+	Real SensorDelayBuffer::GetValue( index_t frame_nr, index_t channel ) const
+	{
+		SCONE_ASSERT( frame_nr >= first_frame_ && frame_nr < GetFrameCount() && channel < GetChannelCount() );
+		return FrameValues( frame_nr )[ channel ];
+	}
+
+	Real SensorDelayBuffer::GetInterpolatedValue( TimeInSeconds time, index_t channel ) const
+	{
+		SCONE_ASSERT( !IsEmpty() && channel < GetChannelCount() );
+		SCONE_ASSERT_MSG( first_frame_ == 0 || time >= FrameTime( first_frame_ ), "Sensor delay was not registered with RequireDelay()" );
+		const auto& p = FindPosition( time );
+		return p.upper_weight * FrameValues( p.upper )[ channel ] + ( 1.0 - p.upper_weight ) * FrameValues( p.lower )[ channel ];
+	}
+
+	const SensorDelayBuffer::Position& SensorDelayBuffer::FindPosition( TimeInSeconds time ) const
+	{
+		// sensors with the same delay are read at the same time, so only a few positions are used per frame
+		for ( const auto& p : positions_ )
+			if ( p.time == time )
+				return p;
+		if ( positions_.size() >= max_cached_positions )
+			positions_.clear(); // values are read at many different times without adding frames
+
+		// find the first frame with a later time
+		const auto frame_count = GetFrameCount();
+		index_t lo = first_frame_, hi = frame_count;
+		while ( lo < hi )
+		{
+			auto mid = lo + ( hi - lo ) / 2;
+			if ( time < FrameTime( mid ) )
+				hi = mid;
+			else lo = mid + 1;
+		}
+
+		Position p{ time, lo, lo, 1.0 };
+		if ( lo == frame_count )
+			p.lower = p.upper = frame_count - 1; // time too high, use latest frame
+		else if ( lo > first_frame_ )
+		{
+			p.lower = lo - 1;
+			p.upper_weight = ( time - FrameTime( p.lower ) ) / ( FrameTime( p.upper ) - FrameTime( p.lower ) );
+		}
+		return positions_.emplace_back( p );
+	}
+
+	void SensorDelayBuffer::Resize( size_t capacity, size_t channels )
+	{
+		std::vector< TimeInSeconds > times( capacity );
+		std::vector< Real > values( capacity * channels, Real( 0 ) );
+		const auto copy_channels = std::min( channels, GetChannelCount() );
+		for ( auto frame_nr = first_frame_; frame_nr < frame_count_; ++frame_nr )
+		{
+			auto new_slot = frame_nr & ( capacity - 1 );
+			times[ new_slot ] = times_[ Slot( frame_nr ) ];
+			for ( index_t c = 0; c < copy_channels; ++c )
+				values[ new_slot * channels + c ] = values_[ Slot( frame_nr ) * GetChannelCount() + c ];
+		}
+		times_ = std::move( times );
+		values_ = std::move( values );
+		capacity_ = capacity;
+	}
+
+	void SensorDelayBuffer::Clear()
+	{
+		labels_.clear();
+		values_.clear();
+		first_frame_ = frame_count_ = 0;
+		shared_frames_.reset();
+		shared_count_ = 0;
+		max_delay_ = 0;
+		min_frames_ = 0;
+		keep_all_ = false;
+		positions_.clear();
+	}
+}
@@ -0,0 +1,87 @@
+/*
+** SensorDelayBuffer.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "scone/core/Exception.h"
+#include <vector>
+
+namespace scone
+{
+	/// Multi-channel ring buffer with sensor values, used by SensorDelayAdapter.
+	/// Only the frames needed for the largest requested delay are kept,
+	/// so memory use and lookup cost do not grow with the simulation duration.
+	class SCONE_API SensorDelayBuffer
+	{
+	public:
+		SensorDelayBuffer();
+
+		index_t AddChannel( const String& label );
+		size_t GetChannelCount() const { return labels_.size(); }
+		const std::vector< String >& GetLabels() const { return labels_; }
+
+		/// Keep enough frames to read values with this delay
+		void RequireDelay( TimeInSeconds delay ) { if ( delay > max_delay_ ) max_delay_ = delay; }
+		/// Keep at least this number of frames, to read values by frame number
+		void RequireFrames( size_t frames ) { if ( frames > min_frames_ ) min_frames_ = frames; }
+		/// Keep all frames, for buffers that are filled in advance
+		void KeepAllFrames() { keep_all_ = true; }
+
+		/// Frames computed in advance, which can be shared between buffers with the same channels
+		struct SharedFrames {
+			std::vector< TimeInSeconds > times;
+			std::vector< Real > values; // times.size() frames of GetChannelCount() values
+		};
+
+		/// Append shared frames after the current frames without copying; no frames can be added afterwards
+		void AppendSharedFrames( s_ptr< const SharedFrames > frames );
+
+		/// Add a frame and return its values, frames must be added in chronological order
+		Real* AddFrame( TimeInSeconds time );
+		Real* GetLatestFrame() { SCONE_ASSERT( !IsEmpty() && shared_count_ == 0 ); return &values_[ Slot( frame_count_ - 1 ) * GetChannelCount() ]; }
+		const Real* GetLatestFrame() const { SCONE_ASSERT( !IsEmpty() ); return FrameValues( GetFrameCount() - 1 ); }
+		TimeInSeconds GetLatestTime() const { SCONE_ASSERT( !IsEmpty() ); return FrameTime( GetFrameCount() - 1 ); }
+
+		bool IsEmpty() const { return GetFrameCount() == 0; }
+		/// Number of frames added since the last Clear(), including frames that are no longer kept
+		size_t GetFrameCount() const { return frame_count_ + shared_count_; }
+		/// Value of a frame by frame number, the frame must still be kept
+		Real GetValue( index_t frame_nr, index_t channel ) const;
+		/// Value linearly interpolated between frames, clamped to the oldest and latest frame
+		Real GetInterpolatedValue( TimeInSeconds time, index_t channel ) const;
+
+		void Clear();
+
+	private:
+		struct Position { TimeInSeconds time; index_t lower, upper; double upper_weight; };
+		const Position& FindPosition( TimeInSeconds time ) const;
+		index_t Slot( index_t frame_nr ) const { return frame_nr & ( capacity_ - 1 ); }
+		TimeInSeconds FrameTime( index_t frame_nr ) const {
+			return frame_nr < frame_count_ ? times_[ Slot( frame_nr ) ] : shared_frames_->times[ frame_nr - frame_count_ ];
+		}
+		const Real* FrameValues( index_t frame_nr ) const {
+			return frame_nr < frame_count_ ? &values_[ Slot( frame_nr ) * GetChannelCount() ] : &shared_frames_->values[ ( frame_nr - frame_count_ ) * GetChannelCount() ];
+		}
+		void Resize( size_t capacity, size_t channels );
+
+		std::vector< String > labels_;
+		std::vector< TimeInSeconds > times_;
+		std::vector< Real > values_; // capacity_ frames of GetChannelCount() values
+		size_t capacity_; // always a power of two
+		index_t first_frame_; // oldest frame that is kept
+		size_t frame_count_; // number of frames in this buffer, excluding shared frames
+		s_ptr< const SharedFrames > shared_frames_;
+		size_t shared_count_;
+		TimeInSeconds max_delay_;
+		size_t min_frames_;
+		bool keep_all_;
+		mutable std::vector< Position > positions_; // positions found since the latest frame was added
+	};
+}
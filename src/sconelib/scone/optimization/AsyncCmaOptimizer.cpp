@@ -0,0 +1,345 @@
+/*
+** AsyncCmaOptimizer.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "AsyncCmaOptimizer.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/Log.h"
+#include "scone/core/Settings.h"
+#include "scone/optimization/opt_tools.h"
+#include "scone/optimization/ModelObjective.h"
+
+#include "spot/stop_condition.h"
+#include "spot/file_reporter.h"
+#include "xo/numerical/math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+
+namespace scone
+{
+	AsyncCmaOptimizer::AsyncCmaOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir ) :
+		EsOptimizer( pn, scenario_pn, scenario_dir ),
+		optimizer( *m_Objective, completed_evaluator_ ),
+		INIT_MEMBER( pn, max_errors, max_errors_ ),
+		sigma_current_( EsOptimizer::sigma_ ),
+		update_count_( 0 ),
+		random_engine_( static_cast<unsigned int>( EsOptimizer::random_seed ) ),
+		stop_workers_( false ),
+		scenario_max_threads_( pn.has_key( "max_threads" ) )
+	{
+		const auto n = GetObjective().dim();
+		SCONE_ASSERT( n > 0 );
+
+		// candidates are always evaluated by concurrent workers
+		if ( auto* mo = dynamic_cast<ModelObjective*>( m_Objective.get() ) )
+			mo->SetSegmentThreads( 1 );
+
+		max_errors_ = max_errors; // copy to spot::optimizer::max_errors_
+		if ( lambda_ <= 0 )
+			lambda_ = 4 + int( 3 * std::log( double( n ) ) );
+		if ( mu_ <= 0 || mu_ > lambda_ )
+			mu_ = lambda_ / 2;
+		SCONE_ERROR_IF( surrogate, "AsyncCmaOptimizer does not support surrogate" );
+
+		// log weights and learning rates of sep-CMA-ES [Ros & Hansen, 2008]
+		for ( int i = 0; i < mu_; ++i )
+			weights_.push_back( std::log( mu_ + 0.5 ) - std::log( i + 1.0 ) );
+		const auto weight_sum = std::accumulate( weights_.begin(), weights_.end(), 0.0 );
+		double weight_sq_sum = 0.0;
+		for ( auto& w : weights_ )
+			weight_sq_sum += ( w /= weight_sum ) * w;
+		mu_eff_ = 1.0 / weight_sq_sum;
+
+		c_sigma_ = ( mu_eff_ + 2 ) / ( n + mu_eff_ + 5 );
+		d_sigma_ = 1 + 2 * std::max( 0.0, std::sqrt( ( mu_eff_ - 1 ) / ( n + 1 ) ) - 1 ) + c_sigma_;
+		c_cov_ = 4.0 / ( n + 4 );
+		const auto c_1_full = 2 / ( ( n + 1.3 ) * ( n + 1.3 ) + mu_eff_ );
+		const auto c_mu_full = std::min( 1 - c_1_full, 2 * ( mu_eff_ - 2 + 1 / mu_eff_ ) / ( ( n + 2.0 ) * ( n + 2.0 ) + mu_eff_ ) );
+		c_1_ = std::min( 1.0, c_1_full * ( n + 2 ) / 3 );
+		c_mu_ = std::min( 1 - c_1_, c_mu_full * ( n + 2 ) / 3 );
+		chi_n_ = std::sqrt( double( n ) ) * ( 1 - 1.0 / ( 4 * n ) + 1.0 / ( 21.0 * n * n ) );
+
+		for ( const auto& par : info() )
+		{
+			par_mean_.push_back( par.mean );
+			par_std_.push_back( par.std > 0 ? par.std : 1.0 );
+			par_range_.emplace_back( par.min, par.max );
+		}
+		mean_.assign( n, 0.0 );
+		cov_.assign( n, 1.0 );
+		path_sigma_.assign( n, 0.0 );
+		path_cov_.assign( n, 0.0 );
+		set_fitness_tracking_window_size( window_size );
+		if ( const auto& cp = GetResumeCheckpoint(); !cp.empty() )
+			RestoreCheckpoint( cp );
+
+		// stop conditions, generations before resuming count towards max_generations and min_progress_samples
+		add_stop_condition( std::make_unique< spot::max_steps_condition >( max_generations > generation_offset_ ? max_generations - generation_offset_ : 0 ) );
+		add_stop_condition( std::make_unique< spot::min_progress_condition >( min_progress, min_progress_samples > generation_offset_ ? min_progress_samples - generation_offset_ : 0 ) );
+		find_stop_condition< spot::flat_fitness_condition >().epsilon_ = flat_fitness_epsilon_;
+		if ( target_fitness_ == target_fitness_ )
+			add_stop_condition( std::make_unique< spot::target_fitness_condition>( target_fitness_ ) );
+
+		add_reporter( std::make_unique< EsTraceReporter >() );
+		if ( checkpoint_interval > 0 )
+			add_reporter( std::make_unique< EsCheckpointReporter >( checkpoint_interval ) );
+	}
+
+	AsyncCmaOptimizer::~AsyncCmaOptimizer()
+	{
+		StopWorkers();
+	}
+
+	void AsyncCmaOptimizer::SetOutputMode( OutputMode m )
+	{
+		xo_assert( output_mode_ == no_output ); // output mode can only be set once
+		output_mode_ = m;
+		if ( auto p = MakeSpotReporter( output_mode_ ) )
+			add_reporter( std::move( p ) );
+	}
+
+	void AsyncCmaOptimizer::Run()
+	{
+		// create output folder
+		PrepareOutputFolder();
+
+		// create file reporter
+		auto fr = std::make_unique< spot::file_reporter >( GetOutputFolder(), min_improvement_for_file_output, max_generations_without_file_output );
+		fr->output_fitness_history_ = GetSconeSetting<bool>( "optimizer.output_fitness_history" );
+		fr->output_par_history_ = GetSconeSetting<bool>( "optimizer.output_par_history" );
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		fr->step_offset_ = generation_offset_;
+#endif
+
+		add_reporter( std::move( fr ) );
+
+		run();
+
+		// evaluations that are still running are not used
+		StopWorkers();
+	}
+
+	void AsyncCmaOptimizer::internal_step()
+	{
+		if ( workers_.empty() )
+			StartWorkers();
+
+		// wait until lambda evaluations have finished, independent of when they were started
+		std::vector< Candidate > candidates;
+		{
+			std::unique_lock lock( mutex_ );
+			completed_cv_.wait( lock, [&]() { return completed_.size() >= size_t( lambda_ ); } );
+			auto last = completed_.begin() + lambda_;
+			candidates.assign( std::make_move_iterator( completed_.begin() ), std::make_move_iterator( last ) );
+			completed_.erase( completed_.begin(), last );
+		}
+
+		// let spot::optimizer process the results as if they were evaluated now
+		spot::search_point_vec pop;
+		pop.reserve( candidates.size() );
+		for ( auto& c : candidates )
+		{
+			pop.emplace_back( info(), c.values );
+			completed_evaluator_.results_.push_back( std::move( c.result ) );
+		}
+		current_step_fitnesses_ = evaluate( pop );
+
+		std::scoped_lock lock( mutex_ );
+		UpdateDistribution( candidates, current_step_fitnesses_ );
+	}
+
+	void AsyncCmaOptimizer::StartWorkers()
+	{
+		auto thread_count = scenario_max_threads_ ? max_threads : size_t( GetSconeSetting<int>( "optimizer.max_threads" ) );
+		if ( thread_count == 0 )
+			thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+		thread_count = std::min( thread_count, size_t( lambda_ ) ); // more threads would mostly evaluate outdated candidates
+
+		auto prio = static_cast<xo::thread_priority>( GetSconeSetting<int>( "optimizer.thread_priority" ) );
+
+		log::debug( "Starting ", thread_count, " evaluation threads" );
+		stop_workers_ = false;
+		stop_evaluations_ = std::make_unique< xo::stop_source >();
+		for ( size_t i = 0; i < thread_count; ++i )
+			workers_.emplace_back( [this, prio, st = stop_evaluations_->get_token()]() { WorkerLoop( prio, st ); } );
+	}
+
+	void AsyncCmaOptimizer::StopWorkers()
+	{
+		{
+			std::scoped_lock lock( mutex_ );
+			stop_workers_ = true;
+		}
+		if ( stop_evaluations_ )
+			stop_evaluations_->request_stop(); // running evaluations are canceled, their results are not used
+		for ( auto& w : workers_ )
+			w.join();
+		workers_.clear();
+	}
+
+	void AsyncCmaOptimizer::WorkerLoop( xo::thread_priority prio, const xo::stop_token& st )
+	{
+		xo::scoped_thread_priority prio_setter( prio );
+		const auto& obj = GetObjective();
+		for ( ;; )
+		{
+			spot::par_vec values;
+			std::vector< double > position;
+			{
+				std::scoped_lock lock( mutex_ );
+				if ( stop_workers_ )
+					return;
+				SampleCandidate( values, position );
+			}
+
+			// evaluate through the configured evaluator, so that distributed or scheduled evaluation is used as well
+			auto result = [&]() -> spot::result< spot::fitness_t > {
+				try { return std::move( evaluator_.evaluate( obj, { spot::search_point( info(), values ) }, st, spot::priority_t() ).front() ); }
+				catch ( std::exception& e ) { return xo::error_message( e.what() ); }
+			}();
+
+			{
+				std::scoped_lock lock( mutex_ );
+				completed_.push_back( Candidate{ std::move( values ), std::move( position ), std::move( result ) } );
+			}
+			completed_cv_.notify_one();
+		}
+	}
+
+	void AsyncCmaOptimizer::SampleCandidate( spot::par_vec& values, std::vector< double >& position )
+	{
+		const auto n = mean_.size();
+		values.resize( n );
+		position.resize( n );
+		for ( size_t i = 0; i < n; ++i )
+		{
+			position[ i ] = mean_[ i ] + sigma_current_ * std::sqrt( cov_[ i ] ) * normal_dist_( random_engine_ );
+			values[ i ] = xo::clamped( par_mean_[ i ] + par_std_[ i ] * position[ i ], par_range_[ i ].first, par_range_[ i ].second );
+		}
+	}
+
+	void AsyncCmaOptimizer::UpdateDistribution( const std::vector< Candidate >& candidates, const spot::fitness_vec& fitnesses )
+	{
+		// rank candidates, the steps are computed relative to the current distribution,
+		// because candidates may have been sampled from a distribution before one or more updates
+		std::vector< size_t > order( candidates.size() );
+		std::iota( order.begin(), order.end(), size_t( 0 ) );
+		if ( IsMinimizing() )
+			std::stable_sort( order.begin(), order.end(), [&]( size_t a, size_t b ) { return fitnesses[ a ] < fitnesses[ b ]; } );
+		else std::stable_sort( order.begin(), order.end(), [&]( size_t a, size_t b ) { return fitnesses[ a ] > fitnesses[ b ]; } );
+
+		const auto n = mean_.size();
+		std::vector< double > step_w( n, 0.0 ), step_sq_w( n, 0.0 );
+		for ( size_t k = 0; k < weights_.size(); ++k )
+		{
+			const auto& position = candidates[ order[ k ] ].position;
+			for ( size_t i = 0; i < n; ++i )
+			{
+				const auto step = ( position[ i ] - mean_[ i ] ) / sigma_current_;
+				step_w[ i ] += weights_[ k ] * step;
+				step_sq_w[ i ] += weights_[ k ] * step * step;
+			}
+		}
+
+		// evolution paths
+		++update_count_;
+		double path_sigma_sq = 0.0;
+		for ( size_t i = 0; i < n; ++i )
+		{
+			path_sigma_[ i ] = ( 1 - c_sigma_ ) * path_sigma_[ i ] + std::sqrt( c_sigma_ * ( 2 - c_sigma_ ) * mu_eff_ ) * step_w[ i ] / std::sqrt( cov_[ i ] );
+			path_sigma_sq += path_sigma_[ i ] * path_sigma_[ i ];
+		}
+		const auto path_sigma_norm = std::sqrt( path_sigma_sq );
+		const bool h_sigma = path_sigma_norm / std::sqrt( 1 - std::pow( 1 - c_sigma_, 2.0 * update_count_ ) ) < ( 1.4 + 2.0 / ( n + 1 ) ) * chi_n_;
+
+		// mean and diagonal covariance
+		for ( size_t i = 0; i < n; ++i )
+		{
+			path_cov_[ i ] = ( 1 - c_cov_ ) * path_cov_[ i ] + ( h_sigma ? std::sqrt( c_cov_ * ( 2 - c_cov_ ) * mu_eff_ ) * step_w[ i ] : 0.0 );
+			const auto rank_one = path_cov_[ i ] * path_cov_[ i ] + ( h_sigma ? 0.0 : c_cov_ * ( 2 - c_cov_ ) * cov_[ i ] );
+			cov_[ i ] = ( 1 - c_1_ - c_mu_ ) * cov_[ i ] + c_1_ * rank_one + c_mu_ * step_sq_w[ i ];
+			mean_[ i ] += sigma_current_ * step_w[ i ];
+		}
+
+		// step size
+		sigma_current_ *= std::exp( std::min( 1.0, ( c_sigma_ / d_sigma_ ) * ( path_sigma_norm / chi_n_ - 1 ) ) );
+	}
+
+	PropNode AsyncCmaOptimizer::GetCheckpoint() const
+	{
+		// evaluations that have not yet been used in an update are not stored, they are sampled again after resuming
+		std::scoped_lock lock( mutex_ );
+		std::vector< double > mean( mean_.size() ), std( mean_.size() );
+		for ( size_t i = 0; i < mean_.size(); ++i )
+		{
+			mean[ i ] = par_mean_[ i ] + par_std_[ i ] * mean_[ i ];
+			std[ i ] = par_std_[ i ] * sigma_current_ * std::sqrt( cov_[ i ] );
+		}
+		std::ostringstream random_state;
+		random_state << random_engine_ << ' ' << normal_dist_;
+
+		PropNode pn;
+		pn.set( "type", "AsyncCmaOptimizer" );
+		pn.set( "generation", current_step() + generation_offset_ );
+		pn.set( "best", best_fitness() );
+		pn.set( "sigma", sigma_current_ );
+		pn.set( "mean", EncodeCheckpointValues( mean ) );
+		pn.set( "std", EncodeCheckpointValues( std ) );
+		pn.set( "update_count", update_count_ );
+		pn.set( "par_mean", EncodeCheckpointValues( par_mean_ ) );
+		pn.set( "par_std", EncodeCheckpointValues( par_std_ ) );
+		pn.set( "dist_mean", EncodeCheckpointValues( mean_ ) );
+		pn.set( "dist_cov", EncodeCheckpointValues( cov_ ) );
+		pn.set( "path_sigma", EncodeCheckpointValues( path_sigma_ ) );
+		pn.set( "path_cov", EncodeCheckpointValues( path_cov_ ) );
+		pn.set( "random_state", random_state.str() );
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		pn.add_child( "state", spot::optimizer::get_state() );
+#endif
+		return pn;
+	}
+
+	void AsyncCmaOptimizer::RestoreCheckpoint( const PropNode& pn )
+	{
+		// restore the exact distribution
+		const auto n = mean_.size();
+		auto restore = [&]( const String& key, std::vector< double >& values ) {
+			auto v = DecodeCheckpointValues( pn.get<String>( key ) );
+			SCONE_ERROR_IF( v.size() != n, "Invalid checkpoint value for " + key );
+			values = std::move( v );
+		};
+		restore( "par_mean", par_mean_ );
+		restore( "par_std", par_std_ );
+		restore( "dist_mean", mean_ );
+		restore( "dist_cov", cov_ );
+		restore( "path_sigma", path_sigma_ );
+		restore( "path_cov", path_cov_ );
+		sigma_current_ = pn.get<double>( "sigma" );
+		update_count_ = pn.get<size_t>( "update_count" );
+		std::istringstream random_state( pn.get<String>( "random_state" ) );
+		random_state >> random_engine_ >> normal_dist_;
+		SCONE_ERROR_IF( random_state.fail(), "Invalid checkpoint value for random_state" );
+
+		// best fitness and fitness history, used by the stop conditions
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		if ( const auto* state = pn.try_get_child( "state" ) )
+			spot::optimizer::set_state( *state );
+#endif
+	}
+
+	std::vector< spot::result< spot::fitness_t > > AsyncCmaOptimizer::CompletedEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		SCONE_ASSERT( results_.size() == point_vec.size() );
+		auto results = std::move( results_ );
+		results_.clear();
+		return results;
+	}
+}
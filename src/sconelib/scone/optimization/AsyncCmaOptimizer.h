@@ -0,0 +1,92 @@
+/*
+** AsyncCmaOptimizer.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "EsOptimizer.h"
+#include "spot/optimizer.h"
+#include "xo/thread/thread_priority.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace scone
+{
+	/// Steady-state asynchronous CMA-ES with diagonal covariance (sep-CMA-ES), without a barrier between generations.
+	/** Evaluations run on ''min( lambda, max_threads )'' threads, and a new candidate is sampled as soon as a thread is free;
+	''max_threads'' is taken from the scenario if it is set there, and from the ''optimizer.max_threads'' setting otherwise.
+	Evaluations that are still running when the optimization stops are canceled.
+	The distribution is updated each time ''lambda'' evaluations have finished, in order of completion, using the positions at which
+	these candidates were sampled relative to the current distribution. Evaluations that take longer are therefore used in a later
+	update instead of delaying all other threads.
+	Candidates are evaluated through the evaluator of the optimizer, one candidate per call. Each update counts as one generation for status and file output, and for stop conditions.
+	Because results depend on the order in which evaluations finish, optimizations are not exactly reproducible. */
+	class SCONE_API AsyncCmaOptimizer : public EsOptimizer, public spot::optimizer
+	{
+	public:
+		AsyncCmaOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir );
+		virtual void SetOutputMode( OutputMode m ) override;
+		virtual ~AsyncCmaOptimizer();
+		virtual void Run() override;
+		virtual double GetBestFitness() const override { return best_fitness(); }
+		virtual PropNode GetCheckpoint() const override;
+
+		/// Maximum number of errors allowed during evaluation, use a negative value equates to ''lambda - max_errors''; default = 0
+		int max_errors; // for documentation only, copies value to spot::max_errors_ during construction
+
+	protected:
+		virtual void internal_step() override;
+
+	private:
+		struct Candidate {
+			spot::par_vec values;
+			std::vector< double > position; // unclamped sample in distribution units, which does not change with later updates
+			spot::result< spot::fitness_t > result;
+		};
+
+		// returns the results of candidates that have already been evaluated
+		class CompletedEvaluator : public spot::evaluator
+		{
+		public:
+			virtual std::vector< spot::result< spot::fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+			std::vector< spot::result< spot::fitness_t > > results_;
+		};
+
+		void StartWorkers();
+		void StopWorkers();
+		void WorkerLoop( xo::thread_priority prio, const xo::stop_token& st );
+		void SampleCandidate( spot::par_vec& values, std::vector< double >& position ); // requires mutex_
+		void UpdateDistribution( const std::vector< Candidate >& candidates, const spot::fitness_vec& fitnesses );
+		void RestoreCheckpoint( const PropNode& pn );
+
+		CompletedEvaluator completed_evaluator_; // passed to spot::optimizer, only used in internal_step()
+
+		// distribution, in units of the initial parameter std
+		std::vector< double > par_mean_, par_std_;
+		std::vector< std::pair< double, double > > par_range_;
+		std::vector< double > mean_, cov_, path_sigma_, path_cov_;
+		double sigma_current_;
+		std::vector< double > weights_;
+		double mu_eff_, c_sigma_, d_sigma_, c_cov_, c_1_, c_mu_, chi_n_;
+		size_t update_count_;
+		std::default_random_engine random_engine_;
+		std::normal_distribution< double > normal_dist_;
+
+		// evaluation threads
+		mutable std::mutex mutex_;
+		std::condition_variable completed_cv_;
+		std::vector< Candidate > completed_;
+		std::vector< std::thread > workers_;
+		bool stop_workers_;
+		u_ptr< xo::stop_source > stop_evaluations_;
+		const bool scenario_max_threads_; // use max_threads from the scenario instead of the global setting
+	};
+}
@@ -10,16 +10,18 @@
 
 #include "scone/core/Exception.h"
 #include "scone/optimization/opt_tools.h"
+#include "scone/optimization/ModelObjective.h"
 
 #include "spot/stop_condition.h"
 #include "spot/file_reporter.h"
 #include "scone/core/Settings.h"
+#include "scone/core/Log.h"
 
 namespace scone
 {
-	CmaOptimizer::CmaOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir ) :
-		EsOptimizer( pn, scenario_pn, scenario_dir ),
-		cma_optimizer( *m_Objective, GetSpotEvaluator(),
+	CmaOptimizer::CmaOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir, spot::evaluator* eval ) :
+		EsOptimizer( pn, scenario_pn, scenario_dir, eval ),
+		cma_optimizer( *m_Objective, evaluator_,
 			spot::cma_options{
 				EsOptimizer::lambda_,
 				EsOptimizer::random_seed,
@@ -27,23 +29,56 @@ namespace scone
 				pn.get<double>( "update_eigen_modulo", -1.0 )
 			}
 		),
-		INIT_MEMBER( pn, max_errors, max_errors_ )
+		INIT_MEMBER( pn, max_errors, max_errors_ ),
+		INIT_MEMBER( pn, prune_evaluations, false )
 	{
 		SCONE_ASSERT( GetObjective().dim()  > 0 );
 
 		max_errors_ = max_errors; // copy to spot::optimizer::max_errors_
+		set_fitness_tracking_window_size( window_size );
+
+		// restore the distribution, evolution paths, random engine, best fitness and fitness history
+		if ( const auto& cp = GetResumeCheckpoint(); !cp.empty() )
+		{
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+			set_state( cp.get_child( "state" ) );
+#else
+			SCONE_ERROR( "Resuming a CmaOptimizer requires SCONE_SPOT_OPTIMIZER_STATE" );
+#endif
+		}
+
 		lambda_ = lambda();
 		mu_ = mu();
 		sigma_ = sigma();
+		if ( surrogate_evaluator_ )
+			surrogate_evaluator_->SetMu( mu() );
 
-		set_fitness_tracking_window_size( window_size );
-
-		// stop conditions
-		add_stop_condition( std::make_unique< spot::max_steps_condition >( max_generations ) );
-		add_stop_condition( std::make_unique< spot::min_progress_condition >( min_progress, min_progress_samples ) );
+		// stop conditions, generations before resuming count towards max_generations and min_progress_samples
+		add_stop_condition( std::make_unique< spot::max_steps_condition >( max_generations > generation_offset_ ? max_generations - generation_offset_ : 0 ) );
+		add_stop_condition( std::make_unique< spot::min_progress_condition >( min_progress, min_progress_samples > generation_offset_ ? min_progress_samples - generation_offset_ : 0 ) );
 		find_stop_condition< spot::flat_fitness_condition >().epsilon_ = flat_fitness_epsilon_;
 		if ( target_fitness_ == target_fitness_ )
 			add_stop_condition( std::make_unique< spot::target_fitness_condition>( target_fitness_ ) );
+
+		// stop evaluations early if they can no longer be selected
+		if ( prune_evaluations )
+		{
+			if ( auto* mo = dynamic_cast<ModelObjective*>( m_Objective.get() ) )
+			{
+				auto pruning = std::make_unique< EvaluationPruning >( mu(), IsMinimizing() );
+				mo->SetEvaluationPruning( pruning.get() );
+				add_reporter( std::move( pruning ) );
+			}
+			else log::warning( "prune_evaluations is only supported for ModelObjectives" );
+		}
+
+		add_reporter( std::make_unique< EsTraceReporter >() );
+		if ( checkpoint_interval > 0 )
+		{
+			if ( SCONE_SPOT_OPTIMIZER_STATE_ENABLED )
+				add_reporter( std::make_unique< EsCheckpointReporter >( checkpoint_interval ) );
+			else log::warning( "CmaOptimizer checkpoints require SCONE_SPOT_OPTIMIZER_STATE, checkpoint_interval is ignored" );
+		}
 	}
 
 	void CmaOptimizer::SetOutputMode( OutputMode m )
@@ -63,9 +98,48 @@ namespace scone
 		auto fr = std::make_unique< spot::file_reporter >( GetOutputFolder(), min_improvement_for_file_output, max_generations_without_file_output );
 		fr->output_fitness_history_ = GetSconeSetting<bool>( "optimizer.output_fitness_history" );
 		fr->output_par_history_ = GetSconeSetting<bool>( "optimizer.output_par_history" );
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		fr->step_offset_ = generation_offset_;
+#endif
 
 		add_reporter( std::move( fr ) );
 
 		run();
 	}
+
+	void CmaOptimizer::internal_step()
+	{
+		if ( !surrogate_evaluator_ )
+			return cma_optimizer::internal_step();
+
+		// only the selected candidates are evaluated, so that reporters and stop conditions only see actual results
+		const auto& pop = sample_population();
+		const auto selected = surrogate_evaluator_->Select( pop );
+		spot::search_point_vec selected_pop;
+		selected_pop.reserve( selected.size() );
+		for ( auto i : selected )
+			selected_pop.push_back( pop[ i ] );
+		current_step_fitnesses_ = evaluate( selected_pop );
+
+		// candidates that were not evaluated are ranked below the others when updating the distribution
+		update_distribution( surrogate_evaluator_->Update( pop, selected, current_step_fitnesses_, IsMinimizing() ) );
+	}
+
+	PropNode CmaOptimizer::GetCheckpoint() const
+	{
+		// the state contains everything needed to continue exactly as if the optimization was not interrupted
+		PropNode pn;
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		pn.set( "type", "CmaOptimizer" );
+		pn.set( "generation", current_step() + generation_offset_ );
+		pn.set( "best", best_fitness() );
+		pn.set( "sigma", sigma() );
+		pn.set( "mean", EncodeCheckpointValues( current_mean() ) );
+		pn.set( "std", EncodeCheckpointValues( current_std() ) );
+		pn.add_child( "state", get_state() );
+		if ( surrogate_evaluator_ )
+			pn.add_child( "surrogate", surrogate_evaluator_->GetCheckpoint() );
+#endif
+		return pn;
+	}
 }
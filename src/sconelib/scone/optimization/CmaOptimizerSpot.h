@@ -17,13 +17,20 @@ namespace scone
 	class SCONE_API CmaOptimizer : public EsOptimizer, public spot::cma_optimizer
 	{
 	public:
-		CmaOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir );
+		CmaOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir, spot::evaluator* eval = nullptr );
 		virtual void SetOutputMode( OutputMode m ) override;
 		virtual ~CmaOptimizer() = default;
 		virtual void Run() override;
 		virtual double GetBestFitness() const override { return best_fitness(); }
+		virtual PropNode GetCheckpoint() const override;
 
 		/// Maximum number of errors allowed during evaluation, use a negative value equates to ''lambda - max_errors''; default = 0
 		int max_errors; // for documentation only, copies value to spot::max_errors_ during construction
+
+		/// Stop evaluations as soon as their result can no longer be among the ''mu'' best of the current generation; default = 0.
+		bool prune_evaluations;
+
+	protected:
+		virtual void internal_step() override;
 	};
 }
@@ -8,15 +8,44 @@
 
 #include "CmaPoolOptimizer.h"
 #include "CmaOptimizerSpot.h"
+#include "DistributedEvaluator.h"
+#include "ModelObjective.h"
 #include "spot/file_reporter.h"
 #include "opt_tools.h"
 #include "scone/core/Settings.h"
+#include "scone/core/Log.h"
+#include "spot/stop_condition.h"
+#include "xo/filesystem/filesystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
 
 namespace scone
 {
+	namespace
+	{
+		// stops the pool when all racing optimizations have been eliminated or have finished
+		struct racing_finished_condition : public spot::stop_condition
+		{
+			racing_finished_condition( const bool& finished ) : finished_( finished ) {}
+			virtual bool test( const spot::optimizer& opt ) override { return finished_; }
+			virtual String what() const override { return "All racing optimizations have finished"; }
+			const bool& finished_;
+		};
+
+		// number of generations, including those before resuming from a checkpoint
+		size_t GetGeneration( const spot::optimizer& o )
+		{
+			return o.current_step() + dynamic_cast<const Optimizer&>( o ).GetGenerationOffset();
+		}
+	}
+
 	CmaPoolOptimizer::CmaPoolOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir ) :
 	Optimizer( pn, scenario_pn, scenario_dir ),
-	optimizer_pool( *m_Objective, GetSpotEvaluator(), pn )
+	optimizer_pool( *m_Objective, InitEvaluator( nullptr ), pn ),
+	race_round_( 0 ),
+	race_finished_( false )
 	{
 		// re-initialize these parameters because we want different defaults
 		INIT_PROP( pn, prediction_window_, window_size );
@@ -28,8 +57,23 @@ namespace scone
 		INIT_PROP( pn, active_optimizations_, 6 );
 		INIT_PROP( pn, concurrent_optimizations_, 2 );
 		INIT_PROP( pn, random_seed_, 1 );
+		INIT_PROP( pn, schedule_by_cost_, true );
+		INIT_PROP( pn, racing_, false );
+		INIT_PROP( pn, racing_min_generations_, prediction_start_ );
+		INIT_PROP( pn, racing_eta_, 2.0 );
+		INIT_PROP( pn, racing_spawn_, 0 );
+		INIT_PROP( pn, racing_spawn_std_factor_, 0.5 );
+		SCONE_ERROR_IF( racing_ && racing_eta_ <= 1.0, "racing_eta must be larger than 1" );
+		SCONE_ERROR_IF( racing_ && racing_min_generations_ == 0, "racing_min_generations must be larger than 0" );
 
 		auto flag_parameters = CmaOptimizer( pn, scenario_pn, scenario_dir );
+
+		if ( checkpoint_interval > 0 )
+		{
+			if ( SCONE_SPOT_OPTIMIZER_STATE_ENABLED )
+				add_reporter( std::make_unique< EsCheckpointReporter >( checkpoint_interval ) );
+			else log::warning( "CmaPoolOptimizer checkpoints require SCONE_SPOT_OPTIMIZER_STATE, checkpoint_interval is ignored" );
+		}
 	}
 
 	void CmaPoolOptimizer::Run()
@@ -37,33 +81,40 @@ namespace scone
 		// create output folder
 		PrepareOutputFolder();
 
-		// fill the pool
-		for ( int i = 0; i < optimizations_; ++i )
+		// share a work queue between optimizations, unless evaluations are distributed to other machines
+		if ( schedule_by_cost_ && !distributed_evaluator_ )
 		{
-			// reuse the props from CmaPoolOptimizer
-			props_.push_back( scenario_pn_copy_.get_child( "CmaPoolOptimizer" ) );
-			props_.back().set( "random_seed", random_seed_ + i ); // new seed
-			props_.back().set( "type", "CmaOptimizer" ); // change type
-			props_.back().set( "output_root", GetOutputFolder() ); // make sure output is written to subdirectory
-			props_.back().set( "log_level", (int)xo::log::level::never ); // children don't log?
-
-			// create optimizer
-			auto o = std::make_unique< CmaOptimizer >( props_.back(), scenario_pn_copy_, m_Objective->GetExternalResourceDir() );
-			o->PrepareOutputFolder();
-
-			auto fr = std::make_unique< spot::file_reporter >( o->GetOutputFolder(), o->min_improvement_for_file_output, o->max_generations_without_file_output );
-			fr->output_fitness_history_ = GetSconeSetting<bool>( "optimizer.output_fitness_history" );
-			fr->output_par_history_ = GetSconeSetting<bool>( "optimizer.output_par_history" );
-			o->add_reporter( std::move( fr ) );
-
-			o->SetOutputMode( output_mode_ );
-			push_back( std::move( o ) );
+			auto thread_prio = static_cast<xo::thread_priority>( GetSconeSetting<int>( "optimizer.thread_priority" ) );
+			scheduler_ = std::make_unique< EvaluationScheduler >( max_threads, thread_prio );
+			if ( auto* mo = dynamic_cast<ModelObjective*>( m_Objective.get() ) )
+				mo->SetSegmentThreads( 1 );
 		}
 
+		// fill the pool, or continue the optimizations from the checkpoint
+		if ( const auto& cp = GetResumeCheckpoint(); !cp.empty() )
+			RestoreCheckpoint( cp );
+		else
+		{
+			for ( int i = 0; i < optimizations_; ++i )
+				AddOptimization( random_seed_ + i );
+			if ( racing_ )
+			{
+				for ( auto& o : optimizers_ )
+					race_.push_back( RaceEntry{ o.get(), 0, true, false } );
+				log::info( "Racing ", race_.size(), " optimizations, first round is ", racing_min_generations_, " generations" );
+			}
+		}
+
+		if ( racing_ )
+			add_stop_condition( std::make_unique< racing_finished_condition >( race_finished_ ) );
+
 		// add reporters
 		auto fr = std::make_unique< spot::file_reporter >( GetOutputFolder(), min_improvement_for_file_output, max_generations_without_file_output );
 		fr->output_fitness_history_ = GetSconeSetting<bool>( "optimizer.output_fitness_history" );
 		fr->output_par_history_ = GetSconeSetting<bool>( "optimizer.output_par_history" );
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		fr->step_offset_ = generation_offset_;
+#endif
 		add_reporter( std::move( fr ) );
 
 		add_reporter( std::make_unique< CmaPoolOptimizerReporter >() );
@@ -74,6 +125,183 @@ namespace scone
 		run();
 	}
 
+	Optimizer& CmaPoolOptimizer::AddOptimization( long random_seed, const path& spawn_par_file )
+	{
+		// reuse the props from CmaPoolOptimizer
+		props_.push_back( scenario_pn_copy_.get_child( "CmaPoolOptimizer" ) );
+		props_.back().set( "random_seed", random_seed ); // new seed
+		props_.back().set( "type", "CmaOptimizer" ); // change type
+		props_.back().set( "output_root", GetOutputFolder() ); // make sure output is written to subdirectory
+		props_.back().set( "log_level", (int)xo::log::level::never ); // children don't log?
+		props_.back().set( "checkpoint_interval", 0 ); // checkpoints are written by the pool
+		props_.back().set( "resume_folder", "" ); // new optimizations are not resumed, even if the pool is
+		if ( !spawn_par_file.empty() )
+		{
+			// init sections are applied last, so this overrides any other initialization
+			auto& init_pn = props_.back().add_child( "init" );
+			init_pn.set( "file", spawn_par_file );
+			init_pn.set( "std_factor", racing_spawn_std_factor_ );
+		}
+
+		return CreateOptimization( props_.back() );
+	}
+
+	Optimizer& CmaPoolOptimizer::ResumeOptimization( const path& folder )
+	{
+		// reuse the props stored in the checkpoint of the optimization
+		props_.push_back( LoadCheckpoint( folder ).get_child( "props" ) );
+		props_.back().set( "resume_folder", folder );
+		return CreateOptimization( props_.back() );
+	}
+
+	Optimizer& CmaPoolOptimizer::CreateOptimization( PropNode& props )
+	{
+		// child optimizations share the scheduler or distributed evaluator of the pool
+		auto* eval = scheduler_ ? static_cast<spot::evaluator*>( scheduler_.get() ) : distributed_evaluator_.get();
+		auto o = std::make_unique< CmaOptimizer >( props, scenario_pn_copy_, m_Objective->GetExternalResourceDir(), eval );
+		o->PrepareOutputFolder();
+
+		auto fr = std::make_unique< spot::file_reporter >( o->GetOutputFolder(), o->min_improvement_for_file_output, o->max_generations_without_file_output );
+		fr->output_fitness_history_ = GetSconeSetting<bool>( "optimizer.output_fitness_history" );
+		fr->output_par_history_ = GetSconeSetting<bool>( "optimizer.output_par_history" );
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		fr->step_offset_ = o->GetGenerationOffset();
+#endif
+		o->add_reporter( std::move( fr ) );
+
+		o->SetOutputMode( output_mode_ );
+		auto& result = *o;
+		push_back( std::move( o ) );
+		return result;
+	}
+
+	double CmaPoolOptimizer::GetBestFitness() const
+	{
+		if ( !racing_ )
+			return best_fitness();
+
+		// the pool itself does not evaluate during racing
+		auto best = info().worst_fitness();
+		for ( const auto& e : race_ )
+			if ( IsMinimizing() ? e.opt->best_fitness() < best : e.opt->best_fitness() > best )
+				best = e.opt->best_fitness();
+		return best;
+	}
+
+	void CmaPoolOptimizer::internal_step()
+	{
+		if ( racing_ )
+			RacingStep();
+		else optimizer_pool::internal_step();
+	}
+
+	void CmaPoolOptimizer::RacingStep()
+	{
+		// step the optimizations that have not yet reached the budget of this round, in parallel
+		std::vector< RaceEntry* > entries;
+		for ( auto& e : race_ )
+			if ( e.active && !e.finished && GetGeneration( *e.opt ) < RacingBudget( e ) )
+				entries.push_back( &e );
+
+		// no more than concurrent_optimizations at once, starting with those that are furthest behind
+		auto concurrent = std::max( size_t( 1 ), size_t( concurrent_optimizations_ ) );
+		if ( entries.size() > concurrent )
+		{
+			std::stable_sort( entries.begin(), entries.end(), []( const RaceEntry* a, const RaceEntry* b ) {
+				return GetGeneration( *a->opt ) < GetGeneration( *b->opt ); } );
+			entries.resize( concurrent );
+		}
+
+		std::vector< std::future< const spot::stop_condition* > > steps;
+		for ( auto* e : entries )
+			steps.push_back( std::async( std::launch::async, [e]() { return e->opt->step(); } ) );
+		for ( size_t i = 0; i < entries.size(); ++i )
+		{
+			if ( auto* sc = steps[ i ].get() )
+			{
+				entries[ i ]->finished = true;
+				log::info( "Racing: ", dynamic_cast<Optimizer&>( *entries[ i ]->opt ).id(), " finished after ", GetGeneration( *entries[ i ]->opt ), " generations: ", sc->what() );
+			}
+		}
+
+		// the round is finished when no optimization needs more generations
+		if ( std::none_of( race_.begin(), race_.end(), [&]( const RaceEntry& e ) {
+			return e.active && !e.finished && GetGeneration( *e.opt ) < RacingBudget( e ); } ) )
+			FinishRacingRound();
+	}
+
+	void CmaPoolOptimizer::FinishRacingRound()
+	{
+		std::vector< RaceEntry* > active;
+		for ( auto& e : race_ )
+		{
+			if ( e.active && !e.finished && GetGeneration( *e.opt ) >= max_generations )
+				e.finished = true; // the budget cannot increase any further
+			if ( e.active && !e.finished )
+				active.push_back( &e );
+		}
+
+		if ( active.empty() )
+		{
+			log::info( "Racing: all optimizations have finished" );
+			race_finished_ = true;
+			return;
+		}
+
+		// rank by predicted fitness and keep the best 1 / eta, the last one keeps running until it finishes
+		std::stable_sort( active.begin(), active.end(), [&]( const RaceEntry* a, const RaceEntry* b ) {
+			auto fa = RacingScore( *a->opt ), fb = RacingScore( *b->opt );
+			return IsMinimizing() ? fa < fb : fa > fb; } );
+		auto keep = std::max( size_t( 1 ), size_t( std::ceil( active.size() / racing_eta_ ) ) );
+		for ( size_t i = 0; i < active.size(); ++i )
+		{
+			auto& o = dynamic_cast<Optimizer&>( *active[ i ]->opt );
+			auto score = RacingScore( *active[ i ]->opt );
+			if ( i < keep )
+				log::info( "Racing round ", race_round_, ": continuing ", o.id(), " (rank ", i + 1, ", predicted ", score, ")" );
+			else
+			{
+				log::info( "Racing round ", race_round_, ": stopping ", o.id(), " (rank ", i + 1, ", predicted ", score, ")" );
+				active[ i ]->active = false;
+				o.OutputStatus( "finished", "Stopped by racing in round " + to_str( race_round_ ) );
+			}
+		}
+		++race_round_;
+
+		// start new optimizations near the leader
+		auto& leader = dynamic_cast<Optimizer&>( *active.front()->opt );
+		for ( size_t i = 0; i < racing_spawn_ && race_.size() < 2 * optimizations_; ++i )
+		{
+			auto par_files = xo::find_files( leader.GetOutputFolder(), "*.par", true, 1 );
+			auto it = std::max_element( par_files.begin(), par_files.end(), []( const path& a, const path& b ) {
+				return std::atoi( a.filename().str().c_str() ) < std::atoi( b.filename().str().c_str() ); } ); // filenames start with the generation
+			if ( it == par_files.end() )
+			{
+				log::info( "Racing round ", race_round_, ": no parameter file found for ", leader.id(), ", not starting new optimizations" );
+				break;
+			}
+			auto& o = AddOptimization( random_seed_ + long( race_.size() ), *it );
+			race_.push_back( RaceEntry{ optimizers_.back().get(), race_round_, true, false } );
+			log::info( "Racing round ", race_round_, ": starting ", o.id(), " near ", leader.id(), " using ", it->filename() );
+		}
+	}
+
+	size_t CmaPoolOptimizer::RacingBudget( const RaceEntry& e ) const
+	{
+		// optimizations that were started later get the budget of the first round when they first compete
+		auto rounds = race_round_ - e.first_round;
+		auto budget = racing_min_generations_ * std::pow( racing_eta_, double( rounds ) );
+		return budget < double( max_generations ) ? size_t( budget ) : max_generations;
+	}
+
+	double CmaPoolOptimizer::RacingScore( const spot::optimizer& o ) const
+	{
+		// predicted fitness is only used when there is enough history for a prediction
+		if ( GetGeneration( o ) >= prediction_start_ )
+			return o.predicted_fitness( prediction_look_ahead_ );
+		else return o.best_fitness();
+	}
+
 	void CmaPoolOptimizer::SetOutputMode( OutputMode m )
 	{
 		output_mode_ = m;
@@ -81,6 +309,56 @@ namespace scone
 			dynamic_cast<Optimizer&>( *o ).SetOutputMode( m );
 	}
 
+	PropNode CmaPoolOptimizer::GetCheckpoint() const
+	{
+		PropNode pn;
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		pn.set( "type", "CmaPoolOptimizer" );
+		pn.set( "generation", current_step() + generation_offset_ );
+		pn.set( "best", GetBestFitness() );
+		pn.set( "race_round", race_round_ );
+		pn.set( "race_finished", race_finished_ );
+		for ( size_t i = 0; i < optimizers_.size(); ++i )
+		{
+			auto& opt_pn = pn.add_child( "optimization" );
+			opt_pn.set( "folder", dynamic_cast<const Optimizer&>( *optimizers_[ i ] ).GetOutputFolder().filename() );
+			if ( racing_ )
+			{
+				opt_pn.set( "first_round", race_[ i ].first_round );
+				opt_pn.set( "active", race_[ i ].active );
+				opt_pn.set( "finished", race_[ i ].finished );
+			}
+		}
+		pn.add_child( "state", get_state() );
+#endif
+		return pn;
+	}
+
+	void CmaPoolOptimizer::WriteCheckpoint() const
+	{
+		// the pool checkpoint is written last, because it refers to the checkpoints of the optimizations
+		for ( const auto& o : optimizers_ )
+			dynamic_cast<const Optimizer&>( *o ).WriteCheckpoint();
+		Optimizer::WriteCheckpoint();
+	}
+
+	void CmaPoolOptimizer::RestoreCheckpoint( const PropNode& pn )
+	{
+		race_round_ = pn.get<size_t>( "race_round" );
+		race_finished_ = pn.get<bool>( "race_finished" );
+		for ( const auto& [key, opt_pn] : pn.select( "optimization" ) )
+		{
+			ResumeOptimization( GetOutputFolder() / opt_pn.get<String>( "folder" ) );
+			if ( racing_ )
+				race_.push_back( RaceEntry{ optimizers_.back().get(), opt_pn.get<size_t>( "first_round" ), opt_pn.get<bool>( "active" ), opt_pn.get<bool>( "finished" ) } );
+		}
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+		if ( const auto* state = pn.try_get_child( "state" ) )
+			set_state( *state );
+#endif
+		log::info( "Continuing ", optimizers_.size(), " optimizations", racing_ ? " in racing round " + to_str( race_round_ ) : String() );
+	}
+
 	void CmaPoolOptimizerReporter::on_start( const spot::optimizer& opt )
 	{
 		auto& cma = dynamic_cast<const CmaPoolOptimizer&>( opt );
@@ -99,7 +377,20 @@ namespace scone
 		for ( const auto& o : pool.optimizers() )
 		{
 			auto& cma = dynamic_cast<const EsOptimizer&>( *o );
-			for ( auto&& pn : cma.GetStatusMessages() )
+			auto messages = cma.GetStatusMessages();
+
+			// add the fraction of all threads used by this optimization to its latest generation status
+			if ( auto* scheduler = pool.GetScheduler() )
+			{
+				auto it = std::find_if( messages.rbegin(), messages.rend(), []( const PropNode& pn ) { return pn.has_key( "step" ); } );
+				if ( it != messages.rend() )
+				{
+					it->set( "thread_utilization", scheduler->GetUtilization( cma.GetObjective() ) );
+					it->set( "evaluation_cost", scheduler->GetPredictedCost( cma.GetObjective() ) );
+				}
+			}
+
+			for ( auto&& pn : messages )
 				pool.OutputStatus( std::move( pn ) );
 		}
 	}
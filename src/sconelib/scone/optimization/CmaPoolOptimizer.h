@@ -9,9 +9,12 @@
 #pragma once
 
 #include "Optimizer.h"
+#include "EvaluationScheduler.h"
 #include "spot/optimizer_pool.h"
 #include "xo/system/log_sink.h"
 
+#include <deque>
+
 namespace scone
 {
 	/// Multiple CMA-ES optimizations than run in a prioritized fashion, based on their predicted fitness.
@@ -30,10 +33,52 @@ namespace scone
 		/// Random seed of the first optimization; default = 1.
 		long random_seed_;
 
-		virtual double GetBestFitness() const override { return best_fitness(); }
+		/// Evaluate all optimizations on a shared work queue, starting the most expensive evaluations first, see EvaluationScheduler; default = 1.
+		bool schedule_by_cost_;
+
+		/// Allocate generations using successive halving: all optimizations run ''racing_min_generations'' generations,
+		/// after which only the best ''1 / racing_eta'' continue for ''racing_eta'' times as many generations, etc.
+		/// No more than ''concurrent_optimizations'' are stepped at the same time; default = 0.
+		bool racing_;
+
+		/// Number of generations of the first racing round; default = prediction_start.
+		size_t racing_min_generations_;
+
+		/// Factor by which the number of optimizations decreases and the number of generations increases each racing round; default = 2.
+		double racing_eta_;
+
+		/// Number of new optimizations started near the leader after each racing round, up to twice ''optimizations'' in total; default = 0.
+		size_t racing_spawn_;
+
+		/// Factor applied to the standard deviations of the leader for new optimizations; default = 0.5.
+		double racing_spawn_std_factor_;
+
+		virtual double GetBestFitness() const override;
+		const EvaluationScheduler* GetScheduler() const { return scheduler_.get(); }
+
+		/// The pool checkpoint contains the racing state, each optimization writes its own checkpoint to its own folder
+		virtual PropNode GetCheckpoint() const override;
+		virtual void WriteCheckpoint() const override;
 
 	protected:
-		std::vector< PropNode > props_;
+		virtual void internal_step() override;
+
+		Optimizer& AddOptimization( long random_seed, const path& spawn_par_file = path() );
+		Optimizer& ResumeOptimization( const path& folder );
+		Optimizer& CreateOptimization( PropNode& props );
+		void RestoreCheckpoint( const PropNode& pn );
+
+		std::deque< PropNode > props_; // deque, because optimizations keep references to their props
+
+	private:
+		struct RaceEntry { spot::optimizer* opt; size_t first_round; bool active; bool finished; };
+		void RacingStep();
+		void FinishRacingRound();
+		size_t RacingBudget( const RaceEntry& e ) const;
+		double RacingScore( const spot::optimizer& o ) const;
+		std::vector< RaceEntry > race_;
+		size_t race_round_;
+		bool race_finished_;
 	};
 
 	class SCONE_API CmaPoolOptimizerReporter : public spot::reporter
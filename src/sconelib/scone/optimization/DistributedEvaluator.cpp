@@ -0,0 +1,618 @@
+/*
+** DistributedEvaluator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "DistributedEvaluator.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/Factories.h"
+#include "scone/core/Log.h"
+#include "scone/core/string_tools.h"
+#include "scone/core/system_tools.h"
+#include "scone/optimization/Objective.h"
+#include "scone/optimization/ParInitSettings.h"
+#include "scone/optimization/Params.h"
+
+#include "xo/serialization/prop_node_serializer_zml.h"
+#include "xo/system/error_code.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
+
+namespace scone
+{
+	namespace
+	{
+		using net_clock = std::chrono::steady_clock;
+		constexpr auto heartbeat_interval = std::chrono::seconds( 1 );
+
+		double SecondsSince( net_clock::time_point t ) { return std::chrono::duration< double >( net_clock::now() - t ).count(); }
+
+		// each message has a header followed by a payload, all values are in native byte order
+		enum class MessageType : uint32_t { hello = 1, heartbeat, setup, task, result };
+		struct MessageHeader { MessageType type; uint32_t size; };
+
+		class MessageWriter
+		{
+		public:
+			MessageWriter( MessageType type ) : type_( type ), data_( sizeof( MessageHeader ) ) {}
+
+			template< typename T > void Write( const T& value ) {
+				static_assert( std::is_trivially_copyable_v< T > );
+				auto* p = reinterpret_cast<const char*>( &value );
+				data_.insert( data_.end(), p, p + sizeof( T ) );
+			}
+			void WriteString( const String& s ) {
+				Write( uint32_t( s.size() ) );
+				data_.insert( data_.end(), s.begin(), s.end() );
+			}
+			void WriteValues( const spot::par_vec& values ) {
+				Write( uint32_t( values.size() ) );
+				for ( const auto& v : values )
+					Write( double( v ) );
+			}
+			bool Send( Socket& s ) {
+				WriteHeader();
+				return s.Send( data_.data(), data_.size() );
+			}
+			void AppendTo( std::vector< char >& buffer ) {
+				WriteHeader();
+				buffer.insert( buffer.end(), data_.begin(), data_.end() );
+			}
+
+		private:
+			void WriteHeader() {
+				MessageHeader h{ type_, uint32_t( data_.size() - sizeof( MessageHeader ) ) };
+				std::memcpy( data_.data(), &h, sizeof( h ) );
+			}
+			MessageType type_;
+			std::vector< char > data_;
+		};
+
+		class MessageReader
+		{
+		public:
+			MessageReader( const char* data, size_t size ) : pos_( data ), end_( data + size ) {}
+
+			template< typename T > T Read() {
+				SCONE_ERROR_IF( size_t( end_ - pos_ ) < sizeof( T ), "Invalid message" );
+				T value;
+				std::memcpy( &value, pos_, sizeof( T ) );
+				pos_ += sizeof( T );
+				return value;
+			}
+			String ReadString() {
+				auto n = Read< uint32_t >();
+				SCONE_ERROR_IF( size_t( end_ - pos_ ) < n, "Invalid message" );
+				String s( pos_, n );
+				pos_ += n;
+				return s;
+			}
+			spot::par_vec ReadValues() {
+				auto n = Read< uint32_t >();
+				spot::par_vec values;
+				values.reserve( n );
+				for ( uint32_t i = 0; i < n; ++i )
+					values.push_back( spot::par_t( Read< double >() ) );
+				return values;
+			}
+
+		private:
+			const char* pos_;
+			const char* end_;
+		};
+	}
+
+	struct DistributedEvaluator::Batch
+	{
+		Batch( const spot::search_point_vec& p ) : points( p ), scenario_id( 0 ), fitness( p.size() ), errors( p.size() ), done( p.size(), false ), remaining( p.size() ) {}
+		const spot::search_point_vec& points;
+		uint32_t scenario_id;
+		std::vector< spot::fitness_t > fitness;
+		std::vector< String > errors;
+		std::vector< bool > done;
+		size_t remaining;
+	};
+
+	struct DistributedEvaluator::Worker
+	{
+		Worker( Socket&& s ) : socket( std::move( s ) ), name( socket.GetPeerName() ), last_message( net_clock::now() ) {}
+		Socket socket;
+		String name;
+		size_t capacity = 0; // number of parallel evaluations, zero until the worker has introduced itself
+		std::vector< bool > has_scenario; // scenarios that were sent to this worker, by scenario id
+		std::vector< char > buffer; // received data that does not yet form a complete message
+		net_clock::time_point last_message;
+		std::unordered_map< uint64_t, Task > tasks; // tasks sent to this worker, by task id
+		std::vector< char > outbox; // messages that are waiting to be sent
+		std::mutex send_mutex; // keeps messages in order when sent from different threads
+		bool lost = false;
+	};
+
+	DistributedEvaluator::DistributedEvaluator( int port, double worker_timeout, bool allow_remote_workers ) :
+		port_( port ),
+		worker_timeout_( worker_timeout ),
+		allow_remote_workers_( allow_remote_workers ),
+		running_( false ),
+		next_task_id_( 0 )
+	{}
+
+	DistributedEvaluator::~DistributedEvaluator()
+	{
+		// closing the connections stops the workers
+		running_ = false;
+		if ( server_thread_.joinable() )
+			server_thread_.join();
+	}
+
+	void DistributedEvaluator::AddScenario( const spot::objective& o, const PropNode& scenario_pn, const path& scenario_dir )
+	{
+		xo::error_code ec;
+		std::ostringstream str;
+		str << xo::prop_node_serializer_zml( scenario_pn, &ec );
+		auto dir = path( std::filesystem::absolute( scenario_dir.str() ).string() ); // workers can have a different working directory
+
+		// scenario ids are never reused, so that workers never evaluate a task with a different scenario
+		std::scoped_lock lock( mutex_ );
+		auto it = std::find_if( scenarios_.begin(), scenarios_.end(), [&]( const Scenario& s ) { return s.zml == str.str() && s.dir.str() == dir.str(); } );
+		if ( it == scenarios_.end() )
+			it = scenarios_.insert( scenarios_.end(), Scenario{ str.str(), dir } );
+		objective_scenarios_[ &o ] = uint32_t( it - scenarios_.begin() );
+	}
+
+	void DistributedEvaluator::RemoveScenario( const spot::objective& o )
+	{
+		std::scoped_lock lock( mutex_ );
+		objective_scenarios_.erase( &o );
+	}
+
+	int DistributedEvaluator::GetPort()
+	{
+		std::scoped_lock lock( mutex_ );
+		if ( !running_ )
+			StartServer();
+		return port_;
+	}
+
+	std::vector< spot::result< spot::fitness_t > > DistributedEvaluator::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		Batch batch( point_vec );
+		{
+			std::unique_lock lock( mutex_ );
+			auto scenario_it = objective_scenarios_.find( &o );
+			SCONE_ERROR_IF( scenario_it == objective_scenarios_.end(), "No scenario was set for distributed evaluation" );
+			batch.scenario_id = scenario_it->second;
+			if ( !running_ )
+				StartServer();
+			if ( workers_.empty() )
+				log::info( "Waiting for workers to connect on port ", port_ );
+
+			for ( size_t i = 0; i < point_vec.size(); ++i )
+				pending_tasks_.push_back( Task{ &batch, i } );
+			AssignTasks();
+			lock.unlock();
+			SendMessages();
+			lock.lock();
+
+			while ( batch.remaining > 0 && !st.stop_requested() )
+				batch_done_.wait_for( lock, std::chrono::milliseconds( 100 ) );
+
+			if ( batch.remaining > 0 )
+			{
+				// forget about unfinished work, results that are received later are ignored
+				auto is_canceled = [&]( const Task& t ) { return t.batch == &batch; };
+				pending_tasks_.erase( std::remove_if( pending_tasks_.begin(), pending_tasks_.end(), is_canceled ), pending_tasks_.end() );
+				for ( auto& w : workers_ )
+					for ( auto it = w->tasks.begin(); it != w->tasks.end(); )
+						it = is_canceled( it->second ) ? w->tasks.erase( it ) : std::next( it );
+			}
+		}
+
+		// results are stored by index, so their order does not depend on which worker was first
+		std::vector< spot::result< spot::fitness_t > > results;
+		results.reserve( point_vec.size() );
+		for ( size_t i = 0; i < point_vec.size(); ++i )
+		{
+			if ( !batch.done[ i ] )
+				results.emplace_back( xo::error_message( "Optimization canceled" ) );
+			else if ( !batch.errors[ i ].empty() )
+				results.emplace_back( xo::error_message( batch.errors[ i ] ) );
+			else results.emplace_back( batch.fitness[ i ] );
+		}
+		return results;
+	}
+
+	size_t DistributedEvaluator::GetWorkerCount() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return workers_.size();
+	}
+
+	void DistributedEvaluator::StartServer()
+	{
+		listener_ = Socket::Listen( port_, !allow_remote_workers_ );
+		port_ = listener_.GetLocalPort();
+		running_ = true;
+		server_thread_ = std::thread( &DistributedEvaluator::ServerLoop, this );
+	}
+
+	void DistributedEvaluator::ServerLoop()
+	{
+		while ( running_ )
+		{
+			std::vector< const Socket* > sockets{ &listener_ };
+			{
+				std::scoped_lock lock( mutex_ );
+				for ( const auto& w : workers_ )
+					sockets.push_back( &w->socket );
+			}
+
+			auto readable = WaitForReadable( sockets, 0.1 );
+
+			{
+				std::scoped_lock lock( mutex_ );
+				for ( auto idx : readable )
+				{
+					if ( idx == 0 )
+						AcceptWorker();
+					else ReceiveMessages( *workers_[ idx - 1 ] ); // new workers are appended, so indices remain valid
+				}
+
+				for ( auto& w : workers_ )
+				{
+					if ( !w->lost && SecondsSince( w->last_message ) > worker_timeout_ )
+					{
+						log::warning( "Worker ", w->name, " did not respond for ", worker_timeout_, " seconds" );
+						w->lost = true;
+					}
+				}
+
+				RemoveLostWorkers();
+				AssignTasks();
+			}
+			SendMessages();
+		}
+
+		std::scoped_lock lock( mutex_ );
+		workers_.clear();
+		listener_.Close();
+	}
+
+	void DistributedEvaluator::AcceptWorker()
+	{
+		if ( auto s = listener_.Accept(); s.IsValid() )
+		{
+			s.SetSendTimeout( worker_timeout_ ); // workers that stop receiving are dropped
+			workers_.emplace_back( std::make_shared< Worker >( std::move( s ) ) );
+		}
+	}
+
+	void DistributedEvaluator::ReceiveMessages( Worker& w )
+	{
+		char data[ 65536 ];
+		auto n = w.socket.Receive( data, sizeof( data ) );
+		if ( n == 0 )
+		{
+			w.lost = true;
+			return;
+		}
+		w.last_message = net_clock::now();
+		w.buffer.insert( w.buffer.end(), data, data + n );
+
+		size_t pos = 0;
+		try
+		{
+			MessageHeader h;
+			while ( w.buffer.size() - pos >= sizeof( h ) )
+			{
+				std::memcpy( &h, w.buffer.data() + pos, sizeof( h ) );
+				if ( w.buffer.size() - pos - sizeof( h ) < h.size )
+					break; // incomplete
+				MessageReader msg( w.buffer.data() + pos + sizeof( h ), h.size );
+				pos += sizeof( h ) + h.size;
+
+				switch ( h.type )
+				{
+				case MessageType::hello:
+					w.capacity = std::max< size_t >( 1, msg.Read< uint32_t >() );
+					log::info( "Worker ", w.name, " connected, using ", w.capacity, " threads" );
+					break;
+				case MessageType::heartbeat:
+					break;
+				case MessageType::result:
+				{
+					auto id = msg.Read< uint64_t >();
+					auto success = msg.Read< uint8_t >() != 0;
+					auto fitness = msg.Read< double >();
+					auto error = msg.ReadString();
+					if ( auto it = w.tasks.find( id ); it != w.tasks.end() )
+					{
+						auto& b = *it->second.batch;
+						auto i = it->second.index;
+						if ( !b.done[ i ] )
+						{
+							b.fitness[ i ] = spot::fitness_t( fitness );
+							b.errors[ i ] = success ? String() : ( error.empty() ? String( "Evaluation failed" ) : error );
+							b.done[ i ] = true;
+							if ( --b.remaining == 0 )
+								batch_done_.notify_all();
+						}
+						w.tasks.erase( it );
+					}
+					break;
+				}
+				default: SCONE_THROW( "Invalid message type" );
+				}
+			}
+		}
+		catch ( std::exception& e )
+		{
+			log::error( "Error receiving from worker ", w.name, ": ", e.what() );
+			w.lost = true;
+		}
+		w.buffer.erase( w.buffer.begin(), w.buffer.begin() + pos );
+	}
+
+	void DistributedEvaluator::AssignTasks()
+	{
+		for ( auto& w : workers_ )
+		{
+			while ( !w->lost && w->tasks.size() < w->capacity && !pending_tasks_.empty() )
+			{
+				auto task = pending_tasks_.front();
+				pending_tasks_.pop_front();
+
+				const auto sid = task.batch->scenario_id;
+				if ( sid >= w->has_scenario.size() || !w->has_scenario[ sid ] )
+				{
+					MessageWriter msg( MessageType::setup );
+					msg.Write( sid );
+					msg.WriteString( scenarios_[ sid ].dir.str() );
+					msg.WriteString( scenarios_[ sid ].zml );
+					msg.AppendTo( w->outbox );
+					w->has_scenario.resize( std::max( w->has_scenario.size(), size_t( sid ) + 1 ), false );
+					w->has_scenario[ sid ] = true;
+				}
+
+				auto id = next_task_id_++;
+				w->tasks[ id ] = task; // also when sending fails, so the task is re-queued
+
+				MessageWriter msg( MessageType::task );
+				msg.Write( id );
+				msg.Write( sid );
+				msg.WriteValues( task.batch->points[ task.index ].values() );
+				msg.AppendTo( w->outbox );
+			}
+		}
+	}
+
+	void DistributedEvaluator::SendMessages()
+	{
+		// sending can block, so it is done without holding mutex_
+		std::vector< std::shared_ptr< Worker > > workers;
+		{
+			std::scoped_lock lock( mutex_ );
+			for ( const auto& w : workers_ )
+				if ( !w->outbox.empty() )
+					workers.push_back( w ); // keeps the connection open, also if the worker is removed
+		}
+
+		for ( auto& w : workers )
+		{
+			std::scoped_lock send_lock( w->send_mutex );
+			std::vector< char > data;
+			{
+				std::scoped_lock lock( mutex_ );
+				data.swap( w->outbox );
+			}
+			if ( !data.empty() && !w->socket.Send( data.data(), data.size() ) )
+			{
+				std::scoped_lock lock( mutex_ );
+				w->lost = true;
+			}
+		}
+	}
+
+	void DistributedEvaluator::RemoveLostWorkers()
+	{
+		for ( auto it = workers_.begin(); it != workers_.end(); )
+		{
+			auto& w = **it;
+			if ( w.lost )
+			{
+				// unfinished work is evaluated first by the remaining workers
+				for ( const auto& [id, task] : w.tasks )
+					pending_tasks_.push_front( task );
+				if ( !w.tasks.empty() )
+					log::warning( "Lost connection to worker ", w.name, ", re-queued ", w.tasks.size(), " evaluations" );
+				else log::info( "Worker ", w.name, " disconnected" );
+				it = workers_.erase( it );
+			}
+			else ++it;
+		}
+	}
+
+	namespace
+	{
+		// scenario and objective used by a worker, shared by all tasks that were received after setup
+		struct WorkerScenario {
+			PropNode scenario_pn;
+			ObjectiveUP objective;
+			String error;
+		};
+
+		struct WorkerTask {
+			uint64_t id;
+			std::shared_ptr< const WorkerScenario > scenario;
+			spot::par_vec values;
+		};
+
+		std::shared_ptr< const WorkerScenario > CreateWorkerScenario( const String& scenario, const path& scenario_dir )
+		{
+			auto ws = std::make_shared< WorkerScenario >();
+			try
+			{
+				ws->scenario_pn = xo::parse_zml( scenario.c_str() );
+				auto opt_fp = FindFactoryProps( GetOptimizerFactory(), ws->scenario_pn, "Optimizer" );
+				ws->objective = CreateObjective( FindFactoryProps( GetObjectiveFactory(), opt_fp.props(), "Objective" ), scenario_dir );
+
+				// parameters locked by the optimizer are not part of the search point
+				for ( auto& [key, init_pn] : opt_fp.props().select( "init" ) )
+					if ( auto init = ParInitSettings( init_pn ); init.locked )
+						ws->objective->info().import_locked( FindFile( init.file ) );
+				log::info( "Created objective with ", ws->objective->dim(), " parameters from ", scenario_dir );
+			}
+			catch ( std::exception& e )
+			{
+				ws->error = e.what();
+				log::error( "Could not create objective: ", e.what() );
+			}
+			return ws;
+		}
+
+		// returns the fitness and an error message, which is empty on success
+		std::pair< double, String > EvaluateTask( const WorkerTask& t )
+		{
+			if ( !t.scenario || !t.scenario->objective )
+				return { 0.0, "Could not create objective" + ( t.scenario ? ": " + t.scenario->error : String() ) };
+			try
+			{
+				const auto& obj = *t.scenario->objective;
+				SCONE_ERROR_IF( t.values.size() != obj.dim(), "Received " + to_str( t.values.size() ) + " parameters, expected " + to_str( obj.dim() ) );
+				SearchPoint point( obj.info(), t.values );
+				auto r = obj.evaluate( point, xo::stop_token() );
+				if ( r )
+					return { double( r.value() ), String() };
+				else return { 0.0, r.error().message() };
+			}
+			catch ( std::exception& e )
+			{
+				return { 0.0, e.what() };
+			}
+		}
+	}
+
+	void RunDistributedWorker( const String& host, int port, size_t thread_count, double timeout )
+	{
+		if ( thread_count == 0 )
+			thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+
+		// keep trying, so that workers can be started before the optimization
+		Socket socket = Socket::Connect( host, port );
+		for ( auto start = net_clock::now(); !socket.IsValid(); socket = Socket::Connect( host, port ) )
+		{
+			SCONE_ERROR_IF( SecondsSince( start ) > timeout, "Could not connect to " + host + ":" + to_str( port ) );
+			std::this_thread::sleep_for( std::chrono::seconds( 1 ) );
+		}
+		socket.SetSendTimeout( timeout ); // an optimizer that stops receiving is treated as a closed connection
+		log::info( "Connected to ", host, ":", port, ", evaluating using ", thread_count, " threads" );
+
+		std::mutex send_mutex;
+		auto send = [&]( MessageWriter& msg ) { std::scoped_lock lock( send_mutex ); msg.Send( socket ); };
+
+		std::mutex task_mutex;
+		std::condition_variable task_cv;
+		std::deque< WorkerTask > tasks;
+		bool done = false;
+
+		MessageWriter hello( MessageType::hello );
+		hello.Write( uint32_t( thread_count ) );
+		send( hello );
+
+		std::vector< std::thread > threads;
+		threads.emplace_back( [&]() {
+			std::unique_lock lock( task_mutex );
+			while ( !task_cv.wait_for( lock, heartbeat_interval, [&]() { return done; } ) )
+			{
+				lock.unlock();
+				MessageWriter msg( MessageType::heartbeat );
+				send( msg );
+				lock.lock();
+			}
+		} );
+		for ( size_t i = 0; i < thread_count; ++i )
+		{
+			threads.emplace_back( [&]() {
+				for ( ;; )
+				{
+					WorkerTask task;
+					{
+						std::unique_lock lock( task_mutex );
+						task_cv.wait( lock, [&]() { return done || !tasks.empty(); } );
+						if ( done )
+							return;
+						task = std::move( tasks.front() );
+						tasks.pop_front();
+					}
+					auto [fitness, error] = EvaluateTask( task );
+					MessageWriter msg( MessageType::result );
+					msg.Write( task.id );
+					msg.Write( uint8_t( error.empty() ) );
+					msg.Write( fitness );
+					msg.WriteString( error );
+					send( msg );
+				}
+			} );
+		}
+
+		// receive until the connection is closed
+		String error;
+		try
+		{
+			std::unordered_map< uint32_t, std::shared_ptr< const WorkerScenario > > scenarios;
+			MessageHeader h;
+			std::vector< char > payload;
+			while ( socket.ReceiveAll( &h, sizeof( h ) ) )
+			{
+				payload.resize( h.size );
+				if ( h.size > 0 && !socket.ReceiveAll( payload.data(), h.size ) )
+					break;
+				MessageReader msg( payload.data(), payload.size() );
+				if ( h.type == MessageType::setup )
+				{
+					auto sid = msg.Read< uint32_t >();
+					auto dir = path( msg.ReadString() );
+					scenarios[ sid ] = CreateWorkerScenario( msg.ReadString(), dir );
+				}
+				else if ( h.type == MessageType::task )
+				{
+					auto id = msg.Read< uint64_t >();
+					auto sid = msg.Read< uint32_t >();
+					auto values = msg.ReadValues();
+					auto it = scenarios.find( sid );
+					{
+						std::scoped_lock lock( task_mutex );
+						tasks.push_back( WorkerTask{ id, it != scenarios.end() ? it->second : nullptr, std::move( values ) } );
+					}
+					task_cv.notify_one();
+				}
+				else SCONE_THROW( "Invalid message type" );
+			}
+		}
+		catch ( std::exception& e )
+		{
+			error = e.what();
+		}
+
+		{
+			std::scoped_lock lock( task_mutex );
+			done = true;
+		}
+		task_cv.notify_all();
+		for ( auto& t : threads )
+			t.join();
+		socket.Close();
+
+		SCONE_ERROR_IF( !error.empty(), error );
+		log::info( "Connection to ", host, ":", port, " was closed" );
+	}
+}
@@ -0,0 +1,92 @@
+/*
+** DistributedEvaluator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/PropNode.h"
+#include "scone/core/Socket.h"
+#include "scone/core/system_tools.h"
+#include "spot/evaluator.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace scone
+{
+	/// Evaluates search points in worker processes that connect via TCP, using ''sconecmd --worker <host>:<port>''.
+	/** Workers receive the scenario of each objective that is evaluated and create their own objective from it;
+	external resources (models, etc.) are found using the scenario folder of the optimizer, which must therefore also be
+	accessible from the workers. Every task contains the id of its scenario, so a single evaluator can be shared by
+	different optimizations (e.g. in a CmaPoolOptimizer).
+	Workers evaluate as many points in parallel as they have threads, and send heartbeats while connected.
+	Workers that disconnect or stop sending heartbeats are dropped, and their unfinished work is re-queued.
+	Only workers on the same computer can connect, unless allow_remote_workers is set.
+	Results are always returned in the order of the search points, independent of which worker evaluated them. */
+	class SCONE_API DistributedEvaluator : public spot::evaluator
+	{
+	public:
+		DistributedEvaluator( int port, double worker_timeout, bool allow_remote_workers = false );
+		virtual ~DistributedEvaluator();
+
+		/// Set the scenario that workers use to create objective o, must be called before o is evaluated
+		void AddScenario( const spot::objective& o, const PropNode& scenario_pn, const path& scenario_dir );
+
+		/// Forget the scenario of objective o, must be called before o is destroyed
+		void RemoveScenario( const spot::objective& o );
+
+		virtual std::vector< spot::result< spot::fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+
+		size_t GetWorkerCount() const;
+
+		/// Port on which workers connect, starts listening if needed; when constructed with port 0, a free port is assigned
+		int GetPort();
+
+	private:
+		struct Batch;
+		struct Task { Batch* batch; size_t index; };
+		struct Worker;
+		struct Scenario { String zml; path dir; };
+
+		void StartServer();
+		void ServerLoop();
+		void AcceptWorker();
+		void ReceiveMessages( Worker& w );
+		void AssignTasks();
+		void SendMessages();
+		void RemoveLostWorkers();
+
+		int port_;
+		const double worker_timeout_;
+		const bool allow_remote_workers_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable batch_done_;
+		Socket listener_;
+		std::thread server_thread_;
+		std::atomic_bool running_;
+
+		std::vector< std::shared_ptr< Worker > > workers_; // only added or removed by the server thread
+		std::deque< Task > pending_tasks_;
+		uint64_t next_task_id_;
+
+		std::vector< Scenario > scenarios_; // by scenario id, objectives with identical scenarios share an id
+		std::unordered_map< const spot::objective*, uint32_t > objective_scenarios_;
+	};
+
+	/// Connect to a DistributedEvaluator and evaluate search points until the connection is closed.
+	/// Uses all hardware threads if thread_count is 0; keeps trying to connect for timeout seconds,
+	/// and disconnects if sending a result is blocked for more than timeout seconds.
+	SCONE_API void RunDistributedWorker( const String& host, int port, size_t thread_count, double timeout );
+}
@@ -7,28 +7,77 @@
 */
 
 #include "EsOptimizer.h"
+#include "EvaluationPruning.h"
 #include "xo/string/string_tools.h"
 #include "xo/filesystem/filesystem.h"
 #include "spot/optimizer.h"
 #include "scone/core/Log.h"
+#include "scone/core/TraceRecorder.h"
+#include "opt_tools.h"
 #include "xo/container/container_algorithms.h"
 
 namespace scone
 {
 	const long DEFAULT_RANDOM_SEED = 123;
 
-	EsOptimizer::EsOptimizer( const PropNode& props, const PropNode& scenario_pn, const path& scenario_dir ) :
+	EsOptimizer::EsOptimizer( const PropNode& props, const PropNode& scenario_pn, const path& scenario_dir, spot::evaluator* eval ) :
 		Optimizer( props, scenario_pn, scenario_dir ),
 		mu_( 0 ),
 		lambda_( 0 ),
 		sigma_( 1.0 ),
-		max_attempts( 100 )
+		max_attempts( 100 ),
+		evaluator_( InitEvaluator( eval ) )
 	{
 		INIT_PROP( props, lambda_, 0 );
 		INIT_PROP( props, mu_, 0 );
 		INIT_PROP( props, sigma_, 1.0 );
 		INIT_PROP( props, random_seed, DEFAULT_RANDOM_SEED );
 		INIT_PROP( props, flat_fitness_epsilon_, 1e-6 );
+		INIT_PROP( props, surrogate, false );
+		INIT_PROP( props, surrogate_exploration, 2 );
+		INIT_PROP( props, surrogate_min_fraction, 0.0 );
+		if ( surrogate )
+			surrogate_evaluator_ = std::make_unique< SurrogateEvaluator >( surrogate_exploration, surrogate_min_fraction, static_cast<unsigned int>( random_seed ) );
+
+		// the distribution is restored by the subclasses, the surrogate archive is restored here
+		if ( surrogate_evaluator_ )
+			if ( const auto* surrogate_pn = GetResumeCheckpoint().try_get_child( "surrogate" ) )
+				surrogate_evaluator_->RestoreCheckpoint( *surrogate_pn );
+	}
+
+	EsTraceReporter::EsTraceReporter() :
+		recording_( false )
+	{}
+
+	void EsTraceReporter::on_pre_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop )
+	{
+		recording_ = IsTraceRecording();
+		if ( recording_ )
+			RecordTraceEvent( "EvaluateGeneration", 'B' );
+	}
+
+	void EsTraceReporter::on_post_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop, const spot::fitness_vec& fitnesses, bool new_best )
+	{
+		if ( recording_ )
+			RecordTraceEvent( "EvaluateGeneration", 'E' );
+		recording_ = false;
+	}
+
+	EsCheckpointReporter::EsCheckpointReporter( size_t interval ) :
+		interval_( interval )
+	{}
+
+	void EsCheckpointReporter::on_post_step( const spot::optimizer& opt )
+	{
+		// the interval counts all generations, so a resumed optimization writes at the same generations
+		auto& o = dynamic_cast<const Optimizer&>( opt );
+		if ( ( opt.current_step() + o.GetGenerationOffset() ) % interval_ == 0 )
+			o.WriteCheckpoint();
+	}
+
+	void EsCheckpointReporter::on_stop( const spot::optimizer& opt, const spot::stop_condition& s )
+	{
+		dynamic_cast<const Optimizer&>( opt ).WriteCheckpoint();
 	}
 
 	String EsOptimizer::GetClassSignature() const
@@ -36,6 +85,8 @@ namespace scone
 		auto str = Optimizer::GetClassSignature();
 		if ( random_seed != DEFAULT_RANDOM_SEED )
 			str += xo::stringf( ".R%d", random_seed );
+		if ( surrogate )
+			str += ".S";
 		return str;
 	}
 
@@ -82,14 +133,20 @@ namespace scone
 	{
 		auto& es_opt = dynamic_cast<const EsOptimizer&>( opt );
 
-		number_of_evaluations_ += pop.size();
+		auto* surrogate = es_opt.GetSurrogateEvaluator();
+		number_of_evaluations_ += pop.size(); // only contains the evaluated candidates if surrogate is enabled
 		auto t = timer_().secondsd();
 
 		// report results
 		auto pn = es_opt.GetStatusPropNode();
-		pn.set( "step", opt.current_step() );
+		pn.set( "step", opt.current_step() + es_opt.GetGenerationOffset() );
 		pn.set( "step_best", opt.current_step_best_fitness() );
-		pn.set( "step_median", xo::median( opt.current_step_fitnesses() ) );
+		spot::fitness_vec step_results; // pruned results are not actual results
+		for ( auto f : opt.current_step_fitnesses() )
+			if ( !EvaluationPruning::IsPrunedResult( f ) )
+				step_results.push_back( f );
+		if ( !step_results.empty() )
+			pn.set( "step_median", xo::median( step_results ) );
 		pn.set( "trend_offset", opt.fitness_trend().offset() );
 		pn.set( "trend_slope", opt.fitness_trend().slope() );
 		pn.set( "progress", opt.progress() );
@@ -97,10 +154,15 @@ namespace scone
 		pn.set( "time", t );
 		pn.set( "number_of_evaluations", number_of_evaluations_ );
 		pn.set( "evaluations_per_sec", number_of_evaluations_ / t );
+		if ( surrogate )
+		{
+			pn.set( "surrogate_fraction", surrogate->GetFraction() );
+			pn.set( "surrogate_rank_correlation", surrogate->GetRankCorrelation() );
+		}
 		if ( new_best )
 		{
 			pn.set( "best", opt.best_fitness() );
-			pn.set( "best_gen", opt.current_step() );
+			pn.set( "best_gen", opt.current_step() + es_opt.GetGenerationOffset() );
 		}
 		es_opt.OutputStatus( std::move( pn ) );
 	}
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "Optimizer.h"
+#include "SurrogateEvaluator.h"
 #include "scone/core/Exception.h"
 #include "spot/reporter.h"
 #include "xo/time/timer.h"
@@ -19,7 +20,7 @@ namespace scone
 	class SCONE_API EsOptimizer : public Optimizer
 	{
 	public:
-		EsOptimizer( const PropNode& props, const PropNode& scenario_pn, const path& scenario_dir );
+		EsOptimizer( const PropNode& props, const PropNode& scenario_pn, const path& scenario_dir, spot::evaluator* eval = nullptr );
 		EsOptimizer( const EsOptimizer& ) = delete;
 		EsOptimizer& operator=( const EsOptimizer& ) = delete;
 		virtual ~EsOptimizer() = default;
@@ -41,8 +42,24 @@ namespace scone
 		/// Epsilon value to detect flat fitness; default = 1e-6.
 		double flat_fitness_epsilon_;
 
+		/// Pre-screen candidates with a surrogate model and only evaluate the most promising ones (CmaOptimizer only), see SurrogateEvaluator; default = 0.
+		bool surrogate;
+
+		/// Number of candidates that are not among the best predicted, but are evaluated for exploration (if ''surrogate'' = 1); default = 2.
+		size_t surrogate_exploration;
+
+		/// Minimum fraction of candidates that is evaluated (if ''surrogate'' = 1), at least ''mu'' candidates are always evaluated; default = 0.
+		double surrogate_min_fraction;
+
 		int max_attempts;
 
+		const SurrogateEvaluator* GetSurrogateEvaluator() const { return surrogate_evaluator_.get(); }
+
+	protected:
+		/// Evaluator passed during construction, or the one created by InitEvaluator() if none was passed
+		spot::evaluator& evaluator_;
+		u_ptr< SurrogateEvaluator > surrogate_evaluator_;
+
 	private: // non-copyable and non-assignable
 		virtual String GetClassSignature() const override;
 	};
@@ -58,4 +75,24 @@ namespace scone
 		xo::timer timer_;
 		size_t number_of_evaluations_;
 	};
+
+	/// Records a trace event for the evaluation of each generation, see TraceRecorder.h
+	class SCONE_API EsTraceReporter : public spot::reporter
+	{
+	public:
+		EsTraceReporter();
+		virtual void on_pre_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop ) override;
+		virtual void on_post_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop, const spot::fitness_vec& fitnesses, bool new_best ) override;
+		bool recording_;
+	};
+
+	/// Writes a checkpoint every ''checkpoint_interval'' generations and when the optimization stops
+	class SCONE_API EsCheckpointReporter : public spot::reporter
+	{
+	public:
+		EsCheckpointReporter( size_t interval );
+		virtual void on_post_step( const spot::optimizer& opt ) override;
+		virtual void on_stop( const spot::optimizer& opt, const spot::stop_condition& s ) override;
+		size_t interval_;
+	};
 }
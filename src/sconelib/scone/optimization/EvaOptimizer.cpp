@@ -33,7 +33,7 @@ namespace scone
 
 	EvaOptimizer::EvaOptimizer( const PropNode& pn, const PropNode& scenario_pn, const path& scenario_dir ) :
 		EsOptimizer( pn, scenario_pn, scenario_dir ),
-		eva_optimizer( *m_Objective, GetSpotEvaluator(), make_eva_options( pn ) ),
+		eva_optimizer( *m_Objective, evaluator_, make_eva_options( pn ) ),
 		INIT_MEMBER( pn, max_errors, max_errors_ )
 	{
 		SCONE_ASSERT( GetObjective().dim() > 0 );
@@ -50,6 +50,8 @@ namespace scone
 		find_stop_condition< spot::flat_fitness_condition >().epsilon_ = flat_fitness_epsilon_;
 		if ( target_fitness_ == target_fitness_ )
 			add_stop_condition( std::make_unique< spot::target_fitness_condition>( target_fitness_ ) );
+
+		add_reporter( std::make_unique< EsTraceReporter >() );
 	}
 
 	void EvaOptimizer::SetOutputMode( OutputMode m )
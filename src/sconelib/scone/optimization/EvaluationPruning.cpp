@@ -0,0 +1,79 @@
+/*
+** EvaluationPruning.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "EvaluationPruning.h"
+
+#include "scone/core/Log.h"
+#include <algorithm>
+
+namespace scone
+{
+	EvaluationPruning::EvaluationPruning( size_t mu, bool minimize ) :
+		mu_( mu ),
+		minimize_( minimize ),
+		evaluation_count_( 0 ),
+		pruned_count_( 0 ),
+		evaluated_time_( 0.0 ),
+		pruned_time_( 0.0 )
+	{
+		best_costs_.reserve( mu_ );
+	}
+
+	bool EvaluationPruning::IsRejected( fitness_t bound ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		return best_costs_.size() == mu_ && Cost( bound ) > best_costs_.back();
+	}
+
+	void EvaluationPruning::AddResult( fitness_t fitness, TimeInSeconds simulation_time )
+	{
+		std::scoped_lock lock( mutex_ );
+		++evaluation_count_;
+		evaluated_time_ += simulation_time;
+		const auto cost = Cost( fitness );
+		if ( cost != cost )
+			return; // NaN results are never selected
+		if ( best_costs_.size() == mu_ && mu_ > 0 && cost < best_costs_.back() )
+			best_costs_.pop_back();
+		if ( best_costs_.size() < mu_ )
+			best_costs_.insert( std::upper_bound( best_costs_.begin(), best_costs_.end(), cost ), cost );
+	}
+
+	void EvaluationPruning::AddPruned( TimeInSeconds simulation_time )
+	{
+		std::scoped_lock lock( mutex_ );
+		++pruned_count_;
+		pruned_time_ += simulation_time;
+	}
+
+	size_t EvaluationPruning::GetPrunedCount() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return pruned_count_;
+	}
+
+	TimeInSeconds EvaluationPruning::GetSavedTime() const
+	{
+		// estimate, assumes pruned evaluations would have lasted as long as the average completed evaluation
+		std::scoped_lock lock( mutex_ );
+		if ( evaluation_count_ == 0 )
+			return 0.0;
+		return std::max( 0.0, pruned_count_ * evaluated_time_ / evaluation_count_ - pruned_time_ );
+	}
+
+	void EvaluationPruning::on_pre_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop )
+	{
+		std::scoped_lock lock( mutex_ );
+		best_costs_.clear();
+	}
+
+	void EvaluationPruning::on_stop( const spot::optimizer& opt, const spot::stop_condition& s )
+	{
+		log::info( "Pruned ", GetPrunedCount(), " evaluations, saving an estimated ", GetSavedTime(), "s of simulation time" );
+	}
+}
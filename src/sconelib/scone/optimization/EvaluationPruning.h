@@ -0,0 +1,62 @@
+/*
+** EvaluationPruning.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "spot/reporter.h"
+#include "xo/numerical/constants.h"
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+namespace scone
+{
+	using spot::fitness_t;
+
+	/// Stops evaluations that can no longer be among the ''mu'' best of the current generation.
+	/** Evaluations report their final result via AddResult(); an evaluation is rejected once the bound on its
+	result is worse than the ''mu'' best results already found in the same generation.
+	Because at least ''mu'' candidates are better, the selected candidates are the same as without pruning.
+	Rejected evaluations report GetPrunedResult(), which is worse than any actual result and is excluded from reporting. */
+	class SCONE_API EvaluationPruning : public spot::reporter
+	{
+	public:
+		EvaluationPruning( size_t mu, bool minimize );
+
+		/// Returns true if a result bound is worse than the ''mu'' best results of the current generation
+		bool IsRejected( fitness_t bound ) const;
+		void AddResult( fitness_t fitness, TimeInSeconds simulation_time );
+		void AddPruned( TimeInSeconds simulation_time );
+
+		/// Result of a pruned evaluation, which is worse than any actual result
+		fitness_t GetPrunedResult() const { return minimize_ ? xo::constants<fitness_t>::infinity() : -xo::constants<fitness_t>::infinity(); }
+		/// Returns true if a result was reported by a pruned evaluation
+		static bool IsPrunedResult( fitness_t f ) { return std::isinf( f ); }
+
+		size_t GetPrunedCount() const;
+		TimeInSeconds GetSavedTime() const;
+
+		virtual void on_pre_evaluate_population( const spot::optimizer& opt, const spot::search_point_vec& pop ) override;
+		virtual void on_stop( const spot::optimizer& opt, const spot::stop_condition& s ) override;
+
+	private:
+		fitness_t Cost( fitness_t f ) const { return minimize_ ? f : -f; }
+
+		const size_t mu_;
+		const bool minimize_;
+		mutable std::mutex mutex_;
+		std::vector< fitness_t > best_costs_; // sorted, at most mu_
+
+		size_t evaluation_count_;
+		size_t pruned_count_;
+		TimeInSeconds evaluated_time_;
+		TimeInSeconds pruned_time_;
+	};
+}
@@ -0,0 +1,245 @@
+/*
+** EvaluationScheduler.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "EvaluationScheduler.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/Log.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+namespace scone
+{
+	struct EvaluationScheduler::Batch
+	{
+		Batch( const spot::objective& o, const spot::search_point_vec& p, const xo::stop_token& st, spot::priority_t prio, Client& c ) :
+			objective( o ), points( p ), stop( st ), priority( prio ), client( c ),
+			fitness( p.size() ), errors( p.size() ), done( p.size(), false ), pending( p.size() ), running( 0 ) {}
+		const spot::objective& objective;
+		const spot::search_point_vec& points;
+		const xo::stop_token& stop;
+		spot::priority_t priority;
+		Client& client;
+		std::vector< spot::fitness_t > fitness;
+		std::vector< String > errors;
+		std::vector< bool > done;
+		size_t pending;
+		size_t running;
+	};
+
+	EvaluationScheduler::EvaluationScheduler( size_t thread_count, xo::thread_priority prio ) :
+		stop_( false ),
+		next_sequence_( 0 ),
+		started_( false ),
+		removed_busy_time_( 0.0 )
+	{
+		if ( thread_count == 0 )
+			thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+		for ( size_t i = 0; i < thread_count; ++i )
+			threads_.emplace_back( [this, prio]() { ThreadLoop( prio ); } );
+	}
+
+	EvaluationScheduler::~EvaluationScheduler()
+	{
+		{
+			std::scoped_lock lock( mutex_ );
+			stop_ = true;
+		}
+		task_available_.notify_all();
+		for ( auto& t : threads_ )
+			t.join();
+	}
+
+	std::vector< spot::result< spot::fitness_t > > EvaluationScheduler::evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio )
+	{
+		std::unique_lock lock( mutex_ );
+		if ( !started_ )
+		{
+			start_time_ = clock::now();
+			started_ = true;
+		}
+
+		auto [client_it, is_new_client] = clients_.try_emplace( &o );
+		if ( is_new_client )
+			client_it->second.start_time = clock::now();
+
+		Batch batch( o, point_vec, st, prio, client_it->second );
+		for ( size_t i = 0; i < point_vec.size(); ++i )
+			pending_tasks_.push_back( Task{ &batch, i, next_sequence_++ } );
+		task_available_.notify_all();
+
+		while ( ( batch.pending > 0 || batch.running > 0 ) && !st.stop_requested() )
+			batch_done_.wait_for( lock, std::chrono::milliseconds( 100 ) );
+
+		if ( batch.pending > 0 )
+		{
+			// remove unstarted work, running evaluations receive the stop request via their stop_token
+			auto is_canceled = [&]( const Task& t ) { return t.batch == &batch; };
+			pending_tasks_.erase( std::remove_if( pending_tasks_.begin(), pending_tasks_.end(), is_canceled ), pending_tasks_.end() );
+			batch.pending = 0;
+		}
+		batch_done_.wait( lock, [&]() { return batch.running == 0; } );
+		lock.unlock();
+
+		std::vector< spot::result< spot::fitness_t > > results;
+		results.reserve( point_vec.size() );
+		for ( size_t i = 0; i < point_vec.size(); ++i )
+		{
+			if ( !batch.done[ i ] )
+				results.emplace_back( xo::error_message( "Optimization canceled" ) );
+			else if ( !batch.errors[ i ].empty() )
+				results.emplace_back( xo::error_message( batch.errors[ i ] ) );
+			else results.emplace_back( batch.fitness[ i ] );
+		}
+		return results;
+	}
+
+	double EvaluationScheduler::GetPredictedCost( const spot::objective& o ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto it = clients_.find( &o );
+		return it != clients_.end() ? PredictCost( it->second ) : PredictCost( Client() );
+	}
+
+	double EvaluationScheduler::GetUtilization( const spot::objective& o ) const
+	{
+		std::scoped_lock lock( mutex_ );
+		auto it = clients_.find( &o );
+		if ( it == clients_.end() )
+			return 0.0;
+		auto t = std::chrono::duration< double >( clock::now() - it->second.start_time ).count() * threads_.size();
+		return t > 0 ? it->second.busy_time / t : 0.0;
+	}
+
+	double EvaluationScheduler::GetUtilization() const
+	{
+		std::scoped_lock lock( mutex_ );
+		double busy_time = removed_busy_time_;
+		for ( const auto& [o, c] : clients_ )
+			busy_time += c.busy_time;
+		auto t = ElapsedThreadTime();
+		return t > 0 ? busy_time / t : 0.0;
+	}
+
+	size_t EvaluationScheduler::GetPendingTaskCount() const
+	{
+		std::scoped_lock lock( mutex_ );
+		return pending_tasks_.size();
+	}
+
+	void EvaluationScheduler::RemoveClient( const spot::objective& o )
+	{
+		// a new objective at the same address must not inherit the statistics of o
+		std::scoped_lock lock( mutex_ );
+		if ( auto it = clients_.find( &o ); it != clients_.end() )
+		{
+			removed_busy_time_ += it->second.busy_time;
+			clients_.erase( it );
+		}
+	}
+
+	void EvaluationScheduler::ThreadLoop( xo::thread_priority prio )
+	{
+		xo::scoped_thread_priority prio_setter( prio );
+		std::unique_lock lock( mutex_ );
+		for ( ;; )
+		{
+			task_available_.wait( lock, [&]() { return stop_ || !pending_tasks_.empty(); } );
+			if ( stop_ )
+				return;
+
+			auto task_idx = SelectTask();
+			auto task = pending_tasks_[ task_idx ];
+			pending_tasks_.erase( pending_tasks_.begin() + task_idx );
+			auto& b = *task.batch;
+			--b.pending;
+			++b.running;
+			lock.unlock();
+
+			auto t0 = clock::now();
+			String error;
+			spot::fitness_t fitness = 0;
+			try
+			{
+				auto r = b.objective.evaluate( b.points[ task.index ], b.stop );
+				if ( r )
+					fitness = r.value();
+				else error = r.error().message();
+			}
+			catch ( std::exception& e )
+			{
+				error = e.what();
+			}
+			auto duration = std::chrono::duration< double >( clock::now() - t0 ).count();
+			auto cost = GetEvaluationCost( b.objective, duration );
+
+			lock.lock();
+			b.fitness[ task.index ] = fitness;
+			b.errors[ task.index ] = std::move( error );
+			b.done[ task.index ] = true;
+			--b.running;
+
+			// running average for the first evaluations, exponential average afterwards
+			auto& c = b.client;
+			c.busy_time += duration;
+			c.evaluation_count++;
+			auto alpha = std::max( 0.1, 1.0 / c.evaluation_count );
+			c.predicted_cost += alpha * ( cost - c.predicted_cost );
+
+			if ( b.pending == 0 && b.running == 0 )
+				batch_done_.notify_all();
+		}
+	}
+
+	size_t EvaluationScheduler::SelectTask() const
+	{
+		// longest predicted evaluation first, then the batch with most remaining work, then priority, then first come
+		size_t best_idx = 0;
+		auto best_key = std::make_tuple( -1.0, -1.0, spot::priority_t(), size_t( 0 ) );
+		for ( size_t i = 0; i < pending_tasks_.size(); ++i )
+		{
+			const auto& t = pending_tasks_[ i ];
+			auto cost = PredictCost( t.batch->client );
+			auto key = std::make_tuple( cost, cost * t.batch->pending, t.batch->priority, std::numeric_limits< size_t >::max() - t.sequence );
+			if ( i == 0 || key > best_key )
+			{
+				best_idx = i;
+				best_key = key;
+			}
+		}
+		return best_idx;
+	}
+
+	double EvaluationScheduler::PredictCost( const Client& c ) const
+	{
+		if ( c.evaluation_count > 0 )
+			return c.predicted_cost;
+
+		// use the average of the objectives with a history
+		double total = 0.0;
+		size_t count = 0;
+		for ( const auto& [o, other] : clients_ )
+		{
+			if ( other.evaluation_count > 0 )
+			{
+				total += other.predicted_cost;
+				++count;
+			}
+		}
+		return count > 0 ? total / count : 0.0;
+	}
+
+	double EvaluationScheduler::ElapsedThreadTime() const
+	{
+		if ( !started_ )
+			return 0.0;
+		return std::chrono::duration< double >( clock::now() - start_time_ ).count() * threads_.size();
+	}
+}
@@ -0,0 +1,84 @@
+/*
+** EvaluationScheduler.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "spot/evaluator.h"
+#include "xo/thread/thread_priority.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace scone
+{
+	/// Evaluator that runs the batches of multiple optimizations on a single work queue, ordered by predicted evaluation cost.
+	/** The cost of evaluating a search point is predicted per objective, from the duration of its previous evaluations.
+	The most expensive evaluations are started first, which reduces the time until all batches are finished (makespan).
+	Objectives without history are predicted to have the average cost of the others. Evaluations with equal costs are
+	ordered by the remaining work of their batch, then by priority. All threads serve all optimizations, so threads
+	that are no longer needed by an optimization are immediately used by the others. */
+	class SCONE_API EvaluationScheduler : public spot::evaluator
+	{
+	public:
+		EvaluationScheduler( size_t thread_count, xo::thread_priority prio );
+		virtual ~EvaluationScheduler();
+
+		virtual std::vector< spot::result< spot::fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override;
+
+		size_t GetThreadCount() const { return threads_.size(); }
+
+		/// Predicted duration of evaluating a single search point of objective o, in seconds
+		double GetPredictedCost( const spot::objective& o ) const;
+
+		/// Fraction of the available thread time used by evaluations of objective o, since its first batch
+		double GetUtilization( const spot::objective& o ) const;
+
+		/// Fraction of the available thread time used by all evaluations, since the first evaluation
+		double GetUtilization() const;
+
+		/// Number of evaluations that are waiting for a thread
+		size_t GetPendingTaskCount() const;
+
+		/// Remove the statistics of objective o, must be called before o is destroyed
+		void RemoveClient( const spot::objective& o );
+
+	protected:
+		/// Cost of an evaluation of objective o that took duration seconds, used to predict the cost of next evaluations
+		virtual double GetEvaluationCost( const spot::objective& o, double duration ) const { return duration; }
+
+	private:
+		using clock = std::chrono::steady_clock;
+		struct Client { double predicted_cost = 0.0; double busy_time = 0.0; size_t evaluation_count = 0; clock::time_point start_time; };
+		struct Batch;
+		struct Task { Batch* batch; size_t index; size_t sequence; };
+
+		void ThreadLoop( xo::thread_priority prio );
+		size_t SelectTask() const; // requires mutex_
+		double PredictCost( const Client& c ) const; // requires mutex_
+		double ElapsedThreadTime() const; // requires mutex_
+
+		mutable std::mutex mutex_;
+		std::condition_variable task_available_;
+		std::condition_variable batch_done_;
+		std::vector< std::thread > threads_;
+		bool stop_;
+
+		std::vector< Task > pending_tasks_;
+		size_t next_sequence_;
+		std::unordered_map< const spot::objective*, Client > clients_;
+		clock::time_point start_time_;
+		bool started_;
+		double removed_busy_time_; // busy time of clients that have been removed
+	};
+}
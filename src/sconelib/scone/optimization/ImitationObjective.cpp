@@ -14,7 +14,6 @@
 #include "scone/core/string_tools.h"
 #include "scone/core/system_tools.h"
 #include "scone/core/Factories.h"
-#include "scone/core/StorageIo.h"
 #include "scone/model/Muscle.h"
 #include "scone/core/profiler_config.h"
 
@@ -26,42 +25,57 @@
 namespace scone
 {
 	ImitationObjective::ImitationObjective( const PropNode& pn, const path& find_file_folder ) :
-	ModelObjective( pn, find_file_folder )
+	ModelObjective( pn, find_file_folder ),
+	file( FindFile( pn.get<path>( "file" ) ) ),
+	m_Storage( file )
 	{
-		file = FindFile( pn.get<path>( "file" ) );
 		INIT_PROP( pn, frame_delta, 1 );
+		INIT_PROP( pn, parallel_segments, 1 );
+		INIT_PROP( pn, segment_warmup, 0.5 );
 
 		if ( signature_postfix.empty() )
 			signature_postfix = "Imitation";
 
-		// prepare data
-		ReadStorageSto( m_Storage, file );
 		model_->AddExternalResource(file);
 
 		// make sure data and model are compatible
 		auto state = model_->GetState();
-		SCONE_THROW_IF( state.GetSize() > m_Storage.GetChannelCount(), "File and model are incompatible for ImitationObjective" );
+		SCONE_THROW_IF( state.GetSize() > m_Storage->GetChannelCount(), "File and model are incompatible for ImitationObjective" );
 		for ( index_t i = 0; i < state.GetSize(); ++i )
-			SCONE_THROW_IF( state.GetName( i ) != m_Storage.GetLabels()[ i ], "File and model are incompatible for ImitationObjective" );
+			SCONE_THROW_IF( state.GetName( i ) != m_Storage->GetLabels()[ i ], "File and model are incompatible for ImitationObjective" );
 
 		// find excitation channels
 		m_ExcitationChannels.reserve( model_->GetMuscles().size() );
 		for ( auto& mus : model_->GetMuscles() )
 		{
-			m_ExcitationChannels.push_back( m_Storage.TryGetChannelIndex( mus->GetName() + ".excitation" ) );
+			m_ExcitationChannels.push_back( m_Storage->TryGetChannelIndex( mus->GetName() + ".excitation" ) );
 			SCONE_THROW_IF( m_ExcitationChannels.back() == NoIndex, "Could not find excitation for " + mus->GetName() );
 		}
 
 		// find sensor channels
-		auto& ds = model_->GetSensorDelayStorage();
+		auto& ds = model_->GetSensorDelayBuffer();
 		m_SensorChannels.reserve( ds.GetChannelCount() );
 		for ( index_t ds_idx = 0; ds_idx < ds.GetChannelCount(); ++ds_idx )
 		{
 			auto& sensor_name = ds.GetLabels()[ ds_idx ];
-			m_SensorChannels.push_back( m_Storage.TryGetChannelIndex( sensor_name ) );
+			m_SensorChannels.push_back( m_Storage->TryGetChannelIndex( sensor_name ) );
 			SCONE_THROW_IF( m_SensorChannels.back() == NoIndex, "Could not find sensor for " + sensor_name );
 		}
 
+		// sensor values of all frames after the first, which are shared by all evaluated models
+		auto sensor_frames = std::make_shared< SensorDelayBuffer::SharedFrames >();
+		const auto frame_count = m_Storage->GetFrameCount();
+		sensor_frames->times.reserve( frame_count );
+		sensor_frames->values.reserve( frame_count * m_SensorChannels.size() );
+		for ( index_t fidx = 1; fidx < frame_count; ++fidx )
+		{
+			const auto& sf = m_Storage->GetFrame( fidx );
+			sensor_frames->times.push_back( sf.GetTime() );
+			for ( auto sensor_idx : m_SensorChannels )
+				sensor_frames->values.push_back( sf[ sensor_idx ] );
+		}
+		m_SensorFrames = std::move( sensor_frames );
+
 		AddExternalResources( *model_ );
 	}
 
@@ -76,16 +90,7 @@ namespace scone
 		{
 			model.GetUserData()[ "IM_fra" ] = 0;
 			model.GetUserData()[ "IM_res" ] = 0.0;
-
-			// add sensor data
-			auto& ds = model.GetSensorDelayStorage();
-			for ( index_t fidx = 1; fidx < m_Storage.GetFrameCount(); ++fidx )
-			{
-				auto sf = m_Storage.GetFrame( fidx );
-				ds.AddFrame( sf.GetTime() );
-				for ( index_t cidx = 0; cidx < m_SensorChannels.size(); ++cidx )
-					ds.Back()[ cidx ] = sf[ m_SensorChannels[ cidx ] ];
-			}
+			InitSensorDelayBuffer( model );
 		}
 
 		// compute result
@@ -94,14 +99,9 @@ namespace scone
 		index_t frame_count = 0;
 
 		{
-			for ( index_t fidx = frame_start * frame_delta; fidx < m_Storage.GetFrameCount() && m_Storage.GetFrame( fidx ).GetTime() <= t; fidx += frame_delta )
+			for ( index_t fidx = frame_start * frame_delta; fidx < m_Storage->GetFrameCount() && m_Storage->GetFrame( fidx ).GetTime() <= t; fidx += frame_delta )
 			{
-				auto f = m_Storage.GetFrame( fidx );
-
-				// set state and compare output
-				model.SetStateValues( f.GetValues(), f.GetTime() );
-				for ( index_t cidx = 0; cidx < m_ExcitationChannels.size(); ++cidx )
-					result += abs( model.GetMuscles()[ cidx ]->GetExcitation() - f[ m_ExcitationChannels[ cidx ] ] );
+				result += EvaluateFrame( model, fidx );
 				++frame_count;
 			}
 		}
@@ -115,11 +115,72 @@ namespace scone
 		}
 	}
 
+	void ImitationObjective::InitSensorDelayBuffer( Model& model ) const
+	{
+		model.GetSensorDelayBuffer().AppendSharedFrames( m_SensorFrames );
+	}
+
+	double ImitationObjective::EvaluateFrame( Model& model, index_t frame_idx ) const
+	{
+		const auto& f = m_Storage->GetFrame( frame_idx );
+
+		// Storage frames are not contiguous, copy the state channels into a buffer that is reused by this thread
+		thread_local std::vector< Real > state_values;
+		state_values.resize( model.GetState().GetSize() );
+		for ( index_t i = 0; i < state_values.size(); ++i )
+			state_values[ i ] = f[ i ];
+
+		// set state and compare output
+		double result = 0.0;
+		model.SetStateValues( state_values, f.GetTime() );
+		for ( index_t cidx = 0; cidx < m_ExcitationChannels.size(); ++cidx )
+			result += abs( model.GetMuscles()[ cidx ]->GetExcitation() - f[ m_ExcitationChannels[ cidx ] ] );
+		return result;
+	}
+
+	result<fitness_t> ImitationObjective::evaluate( const SearchPoint& point, const xo::stop_token& st ) const
+	{
+		if ( parallel_segments <= 1 )
+			return ModelObjective::evaluate( point, st );
+
+		// evaluated frames are 0, frame_delta, 2 * frame_delta, ...
+		const auto duration = GetDuration();
+		size_t eval_count = 0;
+		while ( eval_count * frame_delta < m_Storage->GetFrameCount() && m_Storage->GetFrame( eval_count * frame_delta ).GetTime() <= duration )
+			++eval_count;
+		const auto segment_count = std::min( parallel_segments, eval_count );
+
+		std::vector< double > results( segment_count, 0.0 );
+		EvaluateSegments( point, segment_count, [&]( Model& model, index_t segment_idx ) {
+			InitSensorDelayBuffer( model );
+			const auto begin = segment_idx * eval_count / segment_count * frame_delta;
+			const auto end = ( segment_idx + 1 ) * eval_count / segment_count * frame_delta;
+
+			// warm up controller state with the frames before the segment
+			const auto warmup_time = m_Storage->GetFrame( begin ).GetTime() - segment_warmup;
+			auto warmup_begin = begin;
+			while ( warmup_begin >= frame_delta && m_Storage->GetFrame( warmup_begin - frame_delta ).GetTime() >= warmup_time )
+				warmup_begin -= frame_delta;
+			for ( index_t fidx = warmup_begin; fidx < begin; fidx += frame_delta )
+				EvaluateFrame( model, fidx );
+
+			for ( index_t fidx = begin; fidx < end && !st.stop_requested(); fidx += frame_delta )
+				results[ segment_idx ] += EvaluateFrame( model, fidx );
+		} );
+		if ( st.stop_requested() )
+			return xo::error_message( "Optimization canceled" );
+
+		double result = 0.0;
+		for ( auto r : results )
+			result += r;
+		return 100 * result / m_ExcitationChannels.size() / eval_count;
+	}
+
 	TimeInSeconds ImitationObjective::GetDuration() const
 	{
 		// find last frame, keeping frame_delta in mind
-		auto lastFrame = ( m_Storage.GetFrameCount() - 1 ) / frame_delta * frame_delta;
-		return m_Storage.GetFrame( lastFrame ).GetTime();
+		auto lastFrame = ( m_Storage->GetFrameCount() - 1 ) / frame_delta * frame_delta;
+		return m_Storage->GetFrame( lastFrame ).GetTime();
 	}
 
 	fitness_t ImitationObjective::GetResult( Model& m ) const
@@ -16,7 +16,8 @@
 
 #include <vector>
 #include "xo/filesystem/path.h"
-#include "scone/core/Storage.h"
+#include "scone/core/ReferenceStorage.h"
+#include "scone/model/SensorDelayBuffer.h"
 #include "ModelObjective.h"
 
 namespace scone
@@ -28,20 +29,32 @@ namespace scone
 		ImitationObjective( const PropNode& props, const path& find_file_folder );
 		virtual ~ImitationObjective();
 
-		/// File containing the existing simulation results (.sto).
+		/// File containing the existing simulation results (.sto, .txt or .stob).
 		path file;
 
 		/// Number of frames to skip during each evaluation step; default = 1.
 		size_t frame_delta;
 
+		/// Number of time segments that are evaluated concurrently, each using a separate model; default = 1.
+		/// Segments only run concurrently with optimizer.evaluator = 0, otherwise the threads are used for candidates.
+		size_t parallel_segments;
+
+		/// Playback duration before each segment, to initialize controller state; default = 0.5.
+		TimeInSeconds segment_warmup;
+
+		virtual result<fitness_t> evaluate( const SearchPoint& point, const xo::stop_token& st ) const override;
 		virtual void AdvanceSimulationTo( Model& m, TimeInSeconds t ) const override;
 		virtual TimeInSeconds GetDuration() const override;
 		virtual fitness_t GetResult( Model& m ) const override;
 		virtual PropNode GetReport( Model& m ) const override;
 
 	private:
-		Storage<> m_Storage;
+		void InitSensorDelayBuffer( Model& model ) const;
+		double EvaluateFrame( Model& model, index_t frame_idx ) const;
+
+		ReferenceStorage m_Storage;
 		std::vector< index_t > m_ExcitationChannels;
 		std::vector< index_t > m_SensorChannels;
+		s_ptr< const SensorDelayBuffer::SharedFrames > m_SensorFrames;
 	};
 }
@@ -13,11 +13,15 @@
 #include "xo/filesystem/filesystem.h"
 #include "opt_tools.h"
 #include "scone/core/profiler_config.h"
+#include "xo/numerical/constants.h"
+#include <future>
 
 namespace scone
 {
 	ModelObjective::ModelObjective( const PropNode& props, const path& find_file_folder ) :
 		Objective( props, find_file_folder ),
+		INIT_MEMBER( props, reuse_models, true ),
+		INIT_MEMBER( props, use_param_binding_plan, true ),
 		evaluation_step_size_( XO_IS_DEBUG_BUILD ? 0.01 : 0.25 )
 	{
 		// create internal model using the ORIGINAL prop_node to flag unused model props and create par_info_
@@ -43,30 +47,60 @@ namespace scone
 
 		signature_ = model_->GetSignature();
 
+		// only reuse models that can be reset, other models would be destroyed and rebuilt each evaluation
+		if ( reuse_models && !model_->CanReset() )
+		{
+			log::debug( "Model does not support reset, models are created for each evaluation" );
+			reuse_models = false;
+		}
+
 		AddExternalResources( *model_ );
+
+		if ( use_param_binding_plan )
+			param_binding_plan_ = std::make_unique< ParamBindingPlan >( info_ );
 	}
 
 	result<fitness_t> ModelObjective::evaluate( const SearchPoint& point, const xo::stop_token& st ) const
 	{
 		if ( !st.stop_requested() )
 		{
-			SearchPoint params( point );
-			auto model = CreateModelFromParams( params );
-			return EvaluateModel( *model, st );
+			auto model = AcquireModelFromPoint( point );
+			auto result = EvaluateModel( *model, st );
+			ReleaseModel( std::move( model ) );
+			return result;
 		}
 		else return xo::error_message( "Optimization canceled" );
 	}
 
 	result<fitness_t> ModelObjective::EvaluateModel( Model& m, const xo::stop_token& st ) const
 	{
+		ScopedTraceEvent trace_event( "ModelObjective::EvaluateModel" );
 		m.SetSimulationEndTime( GetDuration() );
 		for ( TimeInSeconds t = evaluation_step_size_; !m.HasSimulationEnded(); t += evaluation_step_size_ )
 		{
 			if ( st.stop_requested() )
 				return xo::error_message( "Optimization canceled" );
 			AdvanceSimulationTo( m, t );
+
+			if ( pruning_ && !m.HasSimulationEnded() )
+			{
+				// stop if this candidate can no longer be selected, the result is marked as pruned
+				if ( pruning_->IsRejected( GetResultBound( m ) ) )
+				{
+					pruning_->AddPruned( m.GetTime() );
+					return pruning_->GetPrunedResult();
+				}
+			}
 		}
-		return GetResult( m );
+		auto result = GetResult( m );
+		if ( pruning_ )
+			pruning_->AddResult( result, m.GetTime() );
+		return result;
+	}
+
+	fitness_t ModelObjective::GetResultBound( Model& m ) const
+	{
+		return info_.minimize() ? -xo::constants<fitness_t>::infinity() : xo::constants<fitness_t>::infinity();
 	}
 
 	ModelUP ModelObjective::CreateModelFromParams( Params& par ) const
@@ -83,6 +117,109 @@ namespace scone
 		return model;
 	}
 
+	bool ModelObjective::ResetModelFromParams( Model& model, Params& par ) const
+	{
+		if ( !model.Reset( model_props.props(), par ) )
+			return false;
+
+		model.SetSimulationEndTime( GetDuration() );
+
+		if ( controller_props ) // A controller was defined OUTSIDE the model prop_node
+			model.CreateController( controller_props, par );
+
+		if ( measure_props ) // A measure was defined OUTSIDE the model prop_node
+			model.CreateMeasure( measure_props, par );
+
+		return true;
+	}
+
+	ModelUP ModelObjective::AcquireModel( Params& par ) const
+	{
+		ScopedTraceEvent trace_event( "ModelObjective::AcquireModel" );
+		if ( reuse_models )
+		{
+			ModelUP model;
+			{
+				std::scoped_lock lock( model_pool_mutex_ );
+				if ( !model_pool_.empty() )
+				{
+					model = std::move( model_pool_.back() );
+					model_pool_.pop_back();
+				}
+			}
+			if ( model )
+			{
+				if ( ResetModelFromParams( *model, par ) )
+					return model;
+				std::call_once( reset_fallback_warning_, [&]() {
+					log::warning( "Could not reset model, a new model is created instead" );
+				} );
+			}
+		}
+		return CreateModelFromParams( par );
+	}
+
+	ModelUP ModelObjective::AcquireModelFromPoint( const SearchPoint& point ) const
+	{
+		if ( param_binding_plan_ )
+		{
+			ParamBindingPoint params( point, *param_binding_plan_ );
+			auto model = AcquireModel( params );
+			params.FinishConstruction();
+			return model;
+		}
+		else
+		{
+			SearchPoint params( point );
+			return AcquireModel( params );
+		}
+	}
+
+	void ModelObjective::ReleaseModel( ModelUP model ) const
+	{
+		if ( reuse_models && model->CanReset() )
+		{
+			std::scoped_lock lock( model_pool_mutex_ );
+			model_pool_.emplace_back( std::move( model ) );
+		}
+	}
+
+	void ModelObjective::EvaluateSegments( const SearchPoint& point, size_t segment_count, const std::function< void( Model&, index_t ) >& func ) const
+	{
+		if ( segment_count > segment_threads_ )
+			std::call_once( segment_threads_warning_, [&]() {
+				log::warning( "Evaluating ", segment_count, " time segments using at most ", segment_threads_, " concurrent thread(s)" );
+			} );
+
+		auto evaluate_segment = [&]( index_t idx ) {
+			auto model = AcquireModelFromPoint( point );
+			func( *model, idx );
+			ReleaseModel( std::move( model ) );
+		};
+
+		if ( segment_threads_ <= 1 )
+		{
+			// evaluations already run in parallel, more threads would only oversubscribe
+			for ( index_t idx = 0; idx < segment_count; ++idx )
+				evaluate_segment( idx );
+			return;
+		}
+
+		// evaluate at most segment_threads_ segments at the same time
+		for ( index_t first = 0; first < segment_count; first += segment_threads_ )
+		{
+			std::vector< std::future< void > > segments;
+			for ( index_t idx = first; idx < std::min( first + segment_threads_, segment_count ); ++idx )
+				segments.emplace_back( std::async( std::launch::async, evaluate_segment, idx ) );
+
+			// wait for all segments before rethrowing any exception
+			for ( auto& s : segments )
+				s.wait();
+			for ( auto& s : segments )
+				s.get();
+		}
+	}
+
 	ModelUP ModelObjective::CreateModelFromParFile( const path& parfile ) const
 	{
 		SearchPoint params( info_ );
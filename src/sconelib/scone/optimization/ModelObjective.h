@@ -11,6 +11,11 @@
 #include "scone/optimization/Objective.h"
 #include "scone/model/Model.h"
 #include "scone/core/Factories.h"
+#include "EvaluationPruning.h"
+#include "ParamBindingPlan.h"
+#include <functional>
+#include <algorithm>
+#include <mutex>
 
 namespace scone
 {
@@ -21,16 +26,30 @@ namespace scone
 		ModelObjective( const PropNode& props, const path& find_file_folder );
 		virtual ~ModelObjective() = default;
 
+		/// Reuse models between evaluations by resetting them instead of creating new ones, if the model supports this; default = 1.
+		bool reuse_models;
+
+		/// Record the parameters requested by the first model construction, to fetch them by index in later constructions; default = 1.
+		bool use_param_binding_plan;
+
 		virtual result<fitness_t> evaluate( const SearchPoint& point, const xo::stop_token& st ) const override;
 		virtual result<fitness_t> EvaluateModel( Model& m, const xo::stop_token& st ) const;
 
 		virtual void AdvanceSimulationTo( Model& m, TimeInSeconds t ) const = 0;
 		virtual TimeInSeconds GetDuration() const = 0;
 		virtual fitness_t GetResult( Model& m ) const = 0;
+		virtual fitness_t GetResultBound( Model& m ) const; // best result that can still be achieved
 		virtual PropNode GetReport( Model& m ) const = 0;
 
 		virtual ModelUP CreateModelFromParams( Params& point ) const;
 		ModelUP CreateModelFromParFile( const path& parfile ) const;
+		bool ResetModelFromParams( Model& model, Params& point ) const;
+
+		/// Stop evaluations early when they are rejected by pruning, or disable with nullptr
+		void SetEvaluationPruning( EvaluationPruning* pruning ) { pruning_ = pruning; }
+
+		/// Maximum number of time segments evaluated concurrently, 1 when evaluations already run concurrently; default = 1
+		void SetSegmentThreads( size_t threads ) { segment_threads_ = std::max( threads, size_t( 1 ) ); }
 
 		virtual std::vector<path> WriteResults( const path& file_base ) override;
 
@@ -46,6 +65,25 @@ namespace scone
 		String signature_; // cached variable, because we need to create a model to get the signature
 		virtual String GetClassSignature() const override { return signature_; }
 		TimeInSeconds evaluation_step_size_;
+
+		ModelUP AcquireModel( Params& par ) const;
+		ModelUP AcquireModelFromPoint( const SearchPoint& point ) const;
+		void ReleaseModel( ModelUP model ) const;
+
+		/// Call func( model, segment_idx ) for each segment, each using its own model
+		void EvaluateSegments( const SearchPoint& point, size_t segment_count, const std::function< void( Model&, index_t ) >& func ) const;
+
+	private:
+
+		// models that can be reset for a next evaluation, at most one per concurrent evaluation
+		mutable std::vector< ModelUP > model_pool_;
+		mutable std::mutex model_pool_mutex_;
+
+		EvaluationPruning* pruning_ = nullptr;
+		size_t segment_threads_ = 1;
+		mutable std::once_flag segment_threads_warning_;
+		mutable std::once_flag reset_fallback_warning_;
+		mutable std::unique_ptr< ParamBindingPlan > param_binding_plan_;
 	};
 
 	/// Create ModelObjective from a PropNode
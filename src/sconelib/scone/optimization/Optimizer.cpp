@@ -13,9 +13,12 @@
 #include "scone/core/string_tools.h"
 #include "scone/core/Factories.h"
 #include "scone/core/math.h"
+#include "scone/core/Settings.h"
 #include "scone/optimization/Objective.h"
 #include "scone/optimization/ModelObjective.h"
 #include "scone/optimization/opt_tools.h"
+#include "scone/optimization/DistributedEvaluator.h"
+#include "scone/optimization/EvaluationScheduler.h"
 
 #include "xo/filesystem/filesystem.h"
 #include "xo/container/prop_node_tools.h"
@@ -41,7 +44,11 @@ namespace scone
 		m_Objective( CreateObjective( FindFactoryProps( GetObjectiveFactory(), props, "Objective" ), scenario_dir ) ),
 		m_BestFitness( m_Objective->info().worst_fitness() ),
 		output_mode_( no_output ),
-		scenario_pn_copy_( scenario_pn )
+		scenario_pn_copy_( scenario_pn ),
+		props_copy_( props ),
+		generation_offset_( 0 ),
+		scenario_evaluator_( nullptr ),
+		scheduler_client_( nullptr )
 	{
 		INIT_PROP( props, output_root, GetFolder( SCONE_RESULTS_FOLDER ) );
 		log_level_ = static_cast<xo::log::level>( props.get<int>( "log_level", (int)xo::log::level::info ) );
@@ -50,6 +57,11 @@ namespace scone
 		INIT_PROP( props, thread_priority, (int)xo::thread_priority::lowest );
 		INIT_PROP( props, show_optimization_time, false );
 
+		// time segments can use the full thread budget only if candidates are evaluated one at a time,
+		// concurrent evaluators already use all threads for candidates
+		if ( auto* mo = dynamic_cast<ModelObjective*>( m_Objective.get() ) )
+			mo->SetSegmentThreads( GetSconeSetting<int>( "optimizer.evaluator" ) == 0 ? max_threads : 1 );
+
 		INIT_PROP( props, init_file, path( "" ) );
 		INIT_PROP( props, use_init_file, true );
 		INIT_PROP( props, init_file_std_factor, 1.0 );
@@ -70,6 +82,15 @@ namespace scone
 
 		INIT_PROP( props, target_fitness_, std::numeric_limits<double>::quiet_NaN() );
 
+		INIT_PROP( props, checkpoint_interval, size_t( 0 ) );
+		INIT_PROP( props, resume_folder, path( "" ) );
+		if ( !resume_folder.empty() )
+		{
+			resume_checkpoint_ = LoadCheckpoint( resume_folder );
+			generation_offset_ = resume_checkpoint_.get<size_t>( "generation" );
+			log::info( "Resuming optimization from ", resume_folder, ", continuing from generation ", generation_offset_ );
+		}
+
 		// initialize parameters from init_file
 		auto& info = GetObjective().info();
 		if ( use_init_file && !init_file.empty() )
@@ -100,7 +121,34 @@ namespace scone
 	}
 
 	Optimizer::~Optimizer()
-	{}
+	{
+		if ( scenario_evaluator_ )
+			scenario_evaluator_->RemoveScenario( *m_Objective );
+		if ( scheduler_client_ )
+			scheduler_client_->RemoveClient( *m_Objective );
+	}
+
+	spot::evaluator& Optimizer::InitEvaluator( spot::evaluator* eval )
+	{
+		// a distributed evaluator is owned by the optimizer that creates it, and is passed to its child optimizations
+		if ( !eval && GetSconeSetting<int>( "optimizer.evaluator" ) == 4 )
+		{
+			distributed_evaluator_ = std::make_unique<DistributedEvaluator>( GetSconeSetting<int>( "optimizer.distributed_port" ),
+				GetSconeSetting<double>( "optimizer.distributed_timeout" ), GetSconeSetting<bool>( "optimizer.distributed_remote" ) );
+			eval = distributed_evaluator_.get();
+		}
+		auto& e = eval ? *eval : GetSpotEvaluator();
+
+		// distributed workers create their own objective from the scenario
+		if ( auto* de = dynamic_cast<DistributedEvaluator*>( &e ) )
+		{
+			de->AddScenario( *m_Objective, scenario_pn_copy_, m_Objective->GetExternalResourceDir() );
+			scenario_evaluator_ = de;
+		}
+		else if ( auto* es = dynamic_cast<EvaluationScheduler*>( &e ) )
+			scheduler_client_ = es;
+		return e;
+	}
 
 	const path& Optimizer::GetOutputFolder() const
 	{
@@ -157,10 +205,32 @@ namespace scone
 		return s;
 	}
 
+	void Optimizer::WriteCheckpoint() const
+	{
+		auto pn = GetCheckpoint();
+		if ( pn.empty() )
+			return log::warning( "Optimizer does not support checkpoints" );
+
+		pn.add_child( "props", props_copy_ );
+		SaveCheckpoint( pn, GetOutputFolder() );
+	}
+
 	void Optimizer::PrepareOutputFolder()
 	{
 		SCONE_ASSERT( output_folder_.empty() );
 
+		if ( !resume_folder.empty() )
+		{
+			// continue in the existing folder, which already contains the config and resources
+			output_folder_ = resume_folder;
+			id_ = output_folder_.filename().str();
+			if ( log_level_ < xo::log::level::never )
+				log_sink_ = std::make_unique<xo::log::file_sink>(
+					GetOutputFolder() / "optimization.log", log_level_, xo::log::sink_mode::current_thread );
+			GetObjective().SetExternalResourceDir( GetOutputFolder() );
+			return;
+		}
+
 		auto p = output_root / GetSignature();
 		log::debug( "Creating folder ", p );
 		output_folder_ = xo::create_unique_directory( p );
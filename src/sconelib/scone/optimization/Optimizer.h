@@ -16,9 +16,13 @@
 #include <deque>
 #include <mutex>
 #include "ParInitSettings.h"
+#include "spot/evaluator.h"
 
 namespace scone
 {
+	class DistributedEvaluator;
+	class EvaluationScheduler;
+
 	/// Base class for Optimizers.
 	class SCONE_API Optimizer : public HasSignature
 	{
@@ -81,6 +85,13 @@ namespace scone
 		/// Target fitness value, stop optimization if better; default = not set.
 		double target_fitness_;
 
+		/// Write a checkpoint file (checkpoint.zml) to the output folder every checkpoint_interval generations; default = 0 (never).
+		size_t checkpoint_interval;
+
+		/// Output folder of an optimization to resume from its checkpoint, results are added to this folder; default = "" (none).
+		/// It is usually more convenient to use ''sconecmd --resume <folder>''.
+		path resume_folder;
+
 		Objective& GetObjective() { return *m_Objective; }
 		const Objective& GetObjective() const { return *m_Objective; }
 		virtual void Run() = 0;
@@ -110,10 +121,27 @@ namespace scone
 
 		void PrepareOutputFolder();
 
+		/// Get the state needed to resume the optimization, or an empty PropNode if this is not supported
+		virtual PropNode GetCheckpoint() const { return PropNode(); }
+
+		/// Write the checkpoint to the output folder, replacing the previous checkpoint atomically
+		virtual void WriteCheckpoint() const;
+
+		/// Checkpoint read from resume_folder, empty if the optimization is not resumed
+		const PropNode& GetResumeCheckpoint() const { return resume_checkpoint_; }
+
+		/// Number of generations completed before the optimization was resumed from a checkpoint
+		size_t GetGenerationOffset() const { return generation_offset_; }
+
 	protected:
 		ObjectiveUP m_Objective;
 		virtual String GetClassSignature() const override;
 
+		/// Get the evaluator for m_Objective: eval if it is set, otherwise the evaluator from the optimizer.evaluator setting
+		spot::evaluator& InitEvaluator( spot::evaluator* eval );
+		u_ptr< DistributedEvaluator > distributed_evaluator_; // only if created by InitEvaluator()
+		u_ptr< EvaluationScheduler > scheduler_; // shared by child optimizations, owned here so that it outlives them
+
 		// current status
 		double m_BestFitness;
 
@@ -128,6 +156,13 @@ namespace scone
 		u_ptr< xo::log::file_sink > log_sink_;
 
 		PropNode scenario_pn_copy_; // copy for creating props in output folder
+		PropNode props_copy_; // copy for resuming from a checkpoint
+		PropNode resume_checkpoint_;
+		size_t generation_offset_;
+
+	private:
+		DistributedEvaluator* scenario_evaluator_; // has the scenario of m_Objective
+		EvaluationScheduler* scheduler_client_; // has the evaluation statistics of m_Objective
 	};
 
 	template< typename T >
@@ -0,0 +1,113 @@
+/*
+** ParamBindingPlan.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "ParamBindingPlan.h"
+
+#include "scone/core/Exception.h"
+#include "scone/core/Log.h"
+
+namespace scone
+{
+	namespace
+	{
+		spot::par_vec MakeIndexValues( size_t dim )
+		{
+			spot::par_vec values( dim );
+			for ( index_t i = 0; i < dim; ++i )
+				values[ i ] = spot::par_t( i );
+			return values;
+		}
+	}
+
+	ParamBindingPlan::ParamBindingPlan( const ObjectiveInfo& info ) :
+		state_( empty ),
+		index_point_( info, MakeIndexValues( info.dim() ) )
+	{}
+
+	bool ParamBindingPlan::TryBeginRecording()
+	{
+		int expected = empty;
+		return state_.compare_exchange_strong( expected, recording );
+	}
+
+	void ParamBindingPlan::FinishRecording( std::vector< Binding >&& bindings )
+	{
+		SCONE_ASSERT( state_ == recording );
+		bindings_ = std::move( bindings );
+		positions_.clear();
+		for ( index_t i = 0; i < bindings_.size(); ++i )
+			positions_.emplace( bindings_[ i ].name, i ); // keeps the first position
+		log::debug( "Recorded parameter binding plan with ", bindings_.size(), " parameter requests" );
+		state_ = ready;
+	}
+
+	void ParamBindingPlan::AbortRecording()
+	{
+		SCONE_ASSERT( state_ == recording );
+		state_ = empty;
+	}
+
+	index_t ParamBindingPlan::FindPosition( const String& name ) const
+	{
+		auto it = positions_.find( name );
+		return it != positions_.end() ? it->second : NoIndex;
+	}
+
+	index_t ParamBindingPlan::FindIndex( const String& name ) const
+	{
+		if ( auto idx = index_point_.try_get( name ) )
+			return index_t( *idx );
+		else return NoIndex;
+	}
+
+	ParamBindingPoint::ParamBindingPoint( const SearchPoint& point, ParamBindingPlan& plan ) :
+		SearchPoint( point ),
+		plan_( plan ),
+		replay_( plan.IsReady() ),
+		record_( !replay_ && plan.TryBeginRecording() ),
+		next_( 0 )
+	{}
+
+	ParamBindingPoint::~ParamBindingPoint()
+	{
+		if ( record_ )
+			plan_.AbortRecording(); // construction did not finish
+	}
+
+	ParamBindingPoint::ParValue ParamBindingPoint::try_get( const String& name ) const
+	{
+		if ( replay_ )
+		{
+			const auto& bindings = plan_.GetBindings();
+			auto pos = next_ < bindings.size() && bindings[ next_ ].name == name ? next_ : plan_.FindPosition( name );
+			if ( pos != NoIndex )
+			{
+				// continue after this request, also when out of sync with the plan
+				next_ = pos + 1;
+				const auto idx = bindings[ pos ].index;
+				return idx != NoIndex ? ParValue( values()[ idx ] ) : ParValue();
+			}
+			else return SearchPoint::try_get( name );
+		}
+		else if ( record_ )
+		{
+			recorded_.push_back( { name, plan_.FindIndex( name ) } );
+			return SearchPoint::try_get( name );
+		}
+		else return SearchPoint::try_get( name );
+	}
+
+	void ParamBindingPoint::FinishConstruction()
+	{
+		if ( record_ )
+		{
+			plan_.FinishRecording( std::move( recorded_ ) );
+			record_ = false;
+		}
+	}
+}
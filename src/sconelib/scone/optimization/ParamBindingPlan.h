@@ -0,0 +1,79 @@
+/*
+** ParamBindingPlan.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/types.h"
+#include "Params.h"
+
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace scone
+{
+	/// Sequence of parameters requested during model construction, recorded during the first construction.
+	/// Later constructions fetch the parameter values by index, instead of searching the parameters by name.
+	class SCONE_API ParamBindingPlan
+	{
+	public:
+		struct Binding {
+			String name;
+			index_t index; // NoIndex if the name is not a parameter
+		};
+
+		ParamBindingPlan( const ObjectiveInfo& info );
+		ParamBindingPlan( const ParamBindingPlan& ) = delete;
+		ParamBindingPlan& operator=( const ParamBindingPlan& ) = delete;
+
+		/// Returns true if the calling construction should record the plan, only one construction records
+		bool TryBeginRecording();
+		void FinishRecording( std::vector< Binding >&& bindings );
+		void AbortRecording();
+
+		/// Returns true if bindings can be used
+		bool IsReady() const { return state_ == ready; }
+		const std::vector< Binding >& GetBindings() const { return bindings_; }
+		/// Position of the first binding with name, or NoIndex
+		index_t FindPosition( const String& name ) const;
+		/// Index of parameter with name, or NoIndex; used while recording
+		index_t FindIndex( const String& name ) const;
+
+	private:
+		enum State { empty, recording, ready };
+		std::atomic< int > state_;
+		std::vector< Binding > bindings_;
+		std::unordered_map< String, index_t > positions_;
+		SearchPoint index_point_; // parameter values are their own index
+	};
+
+	/// SearchPoint that fetches parameter values using a ParamBindingPlan, or records the plan if it is empty.
+	/// Requests that do not match the plan are resolved by name, construction results are always the same.
+	class SCONE_API ParamBindingPoint : public SearchPoint
+	{
+	public:
+		using ParValue = decltype( std::declval< const SearchPoint& >().try_get( std::declval< const String& >() ) );
+
+		ParamBindingPoint( const SearchPoint& point, ParamBindingPlan& plan );
+		virtual ~ParamBindingPoint();
+
+		virtual ParValue try_get( const String& name ) const override;
+
+		/// Must be called after successful model construction, to store a recorded plan
+		void FinishConstruction();
+
+	private:
+		ParamBindingPlan& plan_;
+		bool replay_;
+		bool record_;
+		mutable index_t next_;
+		mutable std::vector< ParamBindingPlan::Binding > recorded_;
+	};
+}
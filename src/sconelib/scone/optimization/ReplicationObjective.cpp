@@ -55,7 +55,9 @@ namespace scone
 		INIT_MEMBER( pn, use_muscle_activation, false ),
 		INIT_MEMBER( pn, muscle_activation_rate_, 100.0 ),
 		INIT_MEMBER( pn, muscle_deactivation_rate_, 25.0 ),
-		INIT_MEMBER( pn, fixed_control_step_size, 0.005 )
+		INIT_MEMBER( pn, fixed_control_step_size, 0.005 ),
+		INIT_MEMBER( pn, parallel_segments, 1 ),
+		INIT_MEMBER( pn, segment_warmup, 0.5 )
 	{
 		file = FindFile( pn.get<path>( "file" ) );
 
@@ -66,7 +68,7 @@ namespace scone
 		}
 
 		// prepare data
-		ReadStorageSto( storage_, file );
+		ReadStorage( storage_, file );
 		AddExternalResource( file );
 
 		SCONE_THROW_IF( storage_.IsEmpty(), file.str() + " contains no data" );
@@ -112,7 +114,7 @@ namespace scone
 
 			auto& state_values = state_storage_.emplace_back( state_channels_.size() );
 			for ( index_t state_idx = 0; state_idx < state_channels_.size(); ++state_idx )
-				state_values[ state_idx ] = f.GetValues()[ state_channels_[ state_idx ] ];
+				state_values[ state_idx ] = f[ state_channels_[ state_idx ] ];
 		}
 	}
 
@@ -140,108 +142,140 @@ namespace scone
 					mud[ "RPL_mus" ][ muscles[ idx ]->GetName() + ".error" ] = 0;
 		}
 
-		// intermediate values
-		std::vector<double> state_values( state_channels_.size() );
-		std::vector<double> errors( muscles.size(), 0.0 );
-		double total_error = 0.0;
-		size_t samples = 0;
-
 		// initialize activations
 		auto& act_pn = mud[ "RPL_act" ];
-		std::vector<double> activations( muscles.size() );
+		PlaybackState ps( muscles.size() );
 		for ( index_t idx = 0; idx < muscles.size(); ++idx )
-			activations[ idx ] = get_exact( act_pn[ idx ] );
+			ps.activations[ idx ] = get_exact( act_pn[ idx ] );
 
 		// loop over data
 		auto t = model.GetTime() == 0.0 ? 0.0 : model.GetTime() + model.fixed_control_step_size;
 		while ( t < end_time && !model.HasSimulationEnded() )
 		{
-#if 1 // set to 0 to disable this optimization
-			auto state_storage_idx = xo::round_cast<index_t>( t / fixed_control_step_size );
-			SCONE_ASSERT( state_storage_idx < storage_indices_.size() );
-			const auto& f = storage_.GetFrame( storage_indices_[ state_storage_idx ] );
-			model.AdvancePlayback( state_storage_[ state_storage_idx ], t );
-#else
-			const auto& f = storage_.GetClosestFrame( t );
-			for ( index_t state_idx = 0; state_idx < state_channels_.size(); ++state_idx )
-				state_values[ state_idx ] = f.GetValues()[ state_channels_[ state_idx ] ];
-			model.AdvancePlayback( state_values, t );
-#endif
-
-			// update activations based on computed excitations
-			const auto dt = model.fixed_control_step_size;
-			if ( t > 0.0 )
-			{
-				double cd = muscle_deactivation_rate_;
-				double c1 = muscle_activation_rate_ - cd;
-				for ( index_t idx = 0; idx < muscles.size(); ++idx ) {
-					auto u = muscles[ idx ]->GetExcitation();
-					activations[ idx ] = u - ( u - activations[ idx ] ) * std::exp( -c1 * u * dt - cd * dt );
-				}
-			}
-			else for ( index_t idx = 0; idx < muscles.size(); ++idx )
-				activations[ idx ] = muscles[ idx ]->GetExcitation();
-
-			// always store new activation and org excitation
-			if ( store_data )
-			{
-				for ( const auto& [midx, cidx] : muscle_excitation_map_ )
-				{
-					const auto& mus = *muscles[ midx ];
-					model.GetCurrentFrame()[ mus.GetName() + ".activation_new" ] = activations[ midx ];
-					model.GetCurrentFrame()[ mus.GetName() + ".excitation_org" ] = f[ cidx ];
-				}
-			}
-
-			// compare excitations
-			if ( t >= start_time )
-			{
-				double frame_error = 0.0;
-				for ( const auto& [midx, cidx] : muscle_excitation_map_ )
-				{
-					const Muscle& mus = *muscles[ midx ];
-					auto excitation_diff = mus.GetExcitation() - f[ cidx ];
-					auto activation_diff = activations[ midx ] - mus.GetActivation();
-					auto diff = use_muscle_activation ? activation_diff : excitation_diff;
-					auto error = use_squared_error ? xo::squared( diff ) : std::abs( diff );
-					frame_error += error;
-					if ( store_data )
-					{
-						model.GetCurrentFrame()[ mus.GetName() + ".excitation_diff" ] = excitation_diff;
-						model.GetCurrentFrame()[ mus.GetName() + ".activation_diff" ] = activation_diff;
-						model.GetCurrentFrame()[ mus.GetName() + ".error" ] = error;
-					}
-					if ( store_muscle_results )
-						errors[ midx ] += error;
-				}
-				total_error += frame_error;
-				++samples;
-			}
+			PlaybackFrame( model, t, t <= 0.0, t >= start_time, store_data, ps );
 
 			t += model.fixed_control_step_size;
 			if ( stop_time != 0 && t > stop_time )
 				model.RequestTermination();
 		}
 
-		if ( samples > 0 )
+		if ( ps.samples > 0 )
 		{
-			auto scale_factor = use_squared_error ? 1000 : 100;
-			total_error = scale_factor * total_error / muscles.size();
+			auto scale_factor = GetErrorScale();
+			auto total_error = scale_factor * ps.total_error / muscles.size();
 			//log::trace( "t=", t, " frames=", frame_count, " start=", frame_start, " result=", result );
 			set_exact( mud[ "RPL_err" ], get_exact( mud[ "RPL_err" ] ) + total_error );
-			set_exact( mud[ "RPL_smp" ], get_exact( mud[ "RPL_smp" ] ) + samples );
+			set_exact( mud[ "RPL_smp" ], get_exact( mud[ "RPL_smp" ] ) + ps.samples );
 			if ( store_muscle_results )
 				for ( index_t idx = 0; idx < muscles.size(); ++idx ) {
 					auto& rpl_mus_pn = mud[ "RPL_mus" ][ muscles[ idx ]->GetName() + ".error" ];
-					set_exact( rpl_mus_pn, get_exact( rpl_mus_pn ) + scale_factor * errors[ idx ] );
+					set_exact( rpl_mus_pn, get_exact( rpl_mus_pn ) + scale_factor * ps.errors[ idx ] );
 				}
 		}
 
 		if ( t > 0 && !model.HasSimulationEnded() ) {
 			// keep activations for next round
 			for ( index_t idx = 0; idx < muscles.size(); ++idx )
-				set_exact( act_pn[ idx ], activations[ idx ] );
+				set_exact( act_pn[ idx ], ps.activations[ idx ] );
+		}
+	}
+
+	void ReplicationObjective::PlaybackFrame( Model& model, TimeInSeconds t, bool init_activations, bool compare, bool store_data, PlaybackState& ps ) const
+	{
+		const auto& muscles = model.GetMuscles();
+		auto state_storage_idx = xo::round_cast<index_t>( t / fixed_control_step_size );
+		SCONE_ASSERT( state_storage_idx < storage_indices_.size() );
+		const auto& f = storage_.GetFrame( storage_indices_[ state_storage_idx ] );
+		model.AdvancePlayback( state_storage_[ state_storage_idx ], t );
+
+		// update activations based on computed excitations
+		auto& activations = ps.activations;
+		const auto dt = model.fixed_control_step_size;
+		if ( !init_activations )
+		{
+			double cd = muscle_deactivation_rate_;
+			double c1 = muscle_activation_rate_ - cd;
+			for ( index_t idx = 0; idx < muscles.size(); ++idx ) {
+				auto u = muscles[ idx ]->GetExcitation();
+				activations[ idx ] = u - ( u - activations[ idx ] ) * std::exp( -c1 * u * dt - cd * dt );
+			}
+		}
+		else for ( index_t idx = 0; idx < muscles.size(); ++idx )
+			activations[ idx ] = muscles[ idx ]->GetExcitation();
+
+		// always store new activation and org excitation
+		if ( store_data )
+		{
+			for ( const auto& [midx, cidx] : muscle_excitation_map_ )
+			{
+				const auto& mus = *muscles[ midx ];
+				model.GetCurrentFrame()[ mus.GetName() + ".activation_new" ] = activations[ midx ];
+				model.GetCurrentFrame()[ mus.GetName() + ".excitation_org" ] = f[ cidx ];
+			}
+		}
+
+		// compare excitations
+		if ( compare )
+		{
+			double frame_error = 0.0;
+			for ( const auto& [midx, cidx] : muscle_excitation_map_ )
+			{
+				const Muscle& mus = *muscles[ midx ];
+				auto excitation_diff = mus.GetExcitation() - f[ cidx ];
+				auto activation_diff = activations[ midx ] - mus.GetActivation();
+				auto diff = use_muscle_activation ? activation_diff : excitation_diff;
+				auto error = use_squared_error ? xo::squared( diff ) : std::abs( diff );
+				frame_error += error;
+				if ( store_data )
+				{
+					model.GetCurrentFrame()[ mus.GetName() + ".excitation_diff" ] = excitation_diff;
+					model.GetCurrentFrame()[ mus.GetName() + ".activation_diff" ] = activation_diff;
+					model.GetCurrentFrame()[ mus.GetName() + ".error" ] = error;
+				}
+				ps.errors[ midx ] += error;
+			}
+			ps.total_error += frame_error;
+			++ps.samples;
+		}
+	}
+
+	result<fitness_t> ReplicationObjective::evaluate( const SearchPoint& point, const xo::stop_token& st ) const
+	{
+		if ( parallel_segments <= 1 )
+			return ModelObjective::evaluate( point, st );
+
+		// frames that are played back, segments start at equally spaced frames
+		size_t frame_count = 0;
+		while ( frame_count < storage_indices_.size() && frame_count * fixed_control_step_size <= stop_time )
+			++frame_count;
+		const auto segment_count = std::min( parallel_segments, frame_count );
+		const auto warmup_frames = xo::round_cast<size_t>( segment_warmup / fixed_control_step_size );
+
+		std::vector< PlaybackState > results( segment_count, PlaybackState( model_->GetMuscles().size() ) );
+		EvaluateSegments( point, segment_count, [&]( Model& model, index_t segment_idx ) {
+			SCONE_ASSERT( model.fixed_control_step_size == fixed_control_step_size );
+			const auto begin = segment_idx * frame_count / segment_count;
+			const auto end = ( segment_idx + 1 ) * frame_count / segment_count;
+			const auto warmup_begin = begin > warmup_frames ? begin - warmup_frames : 0;
+			auto& ps = results[ segment_idx ];
+			for ( index_t frame_idx = warmup_begin; frame_idx < end && !st.stop_requested(); ++frame_idx )
+			{
+				const auto t = frame_idx * fixed_control_step_size;
+				PlaybackFrame( model, t, frame_idx == warmup_begin, frame_idx >= begin && t >= start_time, false, ps );
+			}
+		} );
+		if ( st.stop_requested() )
+			return xo::error_message( "Optimization canceled" );
+
+		double total_error = 0.0;
+		size_t samples = 0;
+		for ( const auto& ps : results )
+		{
+			total_error += ps.total_error;
+			samples += ps.samples;
 		}
+		SCONE_ERROR_IF( samples == 0, "No samples to compare" );
+		return GetErrorScale() * total_error / model_->GetMuscles().size() / samples;
 	}
 
 	TimeInSeconds ReplicationObjective::GetDuration() const
@@ -27,7 +27,7 @@ namespace scone
 		ReplicationObjective( const PropNode& props, const path& find_file_folder );
 		virtual ~ReplicationObjective();
 
-		/// File containing the existing simulation results (.sto).
+		/// File containing the existing simulation results (.sto, .txt or .stob).
 		path file;
 
 		TimeInSeconds start_time;
@@ -39,12 +39,30 @@ namespace scone
 		Real muscle_deactivation_rate_;
 		Real fixed_control_step_size;
 
+		/// Number of time segments that are evaluated concurrently, each using a separate model; default = 1.
+		/// Segments only run concurrently with optimizer.evaluator = 0, otherwise the threads are used for candidates.
+		size_t parallel_segments;
+
+		/// Playback duration before each segment, to initialize controller and delay states; default = 0.5.
+		TimeInSeconds segment_warmup;
+
+		virtual result<fitness_t> evaluate( const SearchPoint& point, const xo::stop_token& st ) const override;
 		virtual void AdvanceSimulationTo( Model& m, TimeInSeconds t ) const override;
 		virtual TimeInSeconds GetDuration() const override;
 		virtual fitness_t GetResult( Model& m ) const override;
 		virtual PropNode GetReport( Model& m ) const override;
 
 	private:
+		struct PlaybackState {
+			PlaybackState( size_t muscle_count ) : activations( muscle_count ), errors( muscle_count ) {}
+			std::vector<double> activations;
+			std::vector<double> errors;
+			double total_error = 0.0;
+			size_t samples = 0;
+		};
+		void PlaybackFrame( Model& model, TimeInSeconds t, bool init_activations, bool compare, bool store_data, PlaybackState& ps ) const;
+		double GetErrorScale() const { return use_squared_error ? 1000 : 100; }
+
 		Storage<> storage_;
 		std::vector<index_t> state_channels_;
 		xo::flat_map< index_t, index_t > muscle_excitation_map_;
@@ -0,0 +1,297 @@
+/*
+** SurrogateEvaluator.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "SurrogateEvaluator.h"
+#include "EvaluationPruning.h"
+
+#include "scone/core/Exception.h"
+#include "opt_tools.h"
+#include "xo/numerical/constants.h"
+#include "xo/numerical/math.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+
+namespace scone
+{
+	namespace
+	{
+		// solve A * x = b in place for symmetric positive definite A (n x n, row-major), returns false if A is not positive definite
+		bool SolveCholesky( std::vector< double >& a, std::vector< double >& b, size_t n )
+		{
+			for ( size_t j = 0; j < n; ++j )
+			{
+				double d = a[ j * n + j ];
+				for ( size_t k = 0; k < j; ++k )
+					d -= a[ j * n + k ] * a[ j * n + k ];
+				if ( d <= 0 )
+					return false;
+				a[ j * n + j ] = std::sqrt( d );
+				for ( size_t i = j + 1; i < n; ++i )
+				{
+					double s = a[ i * n + j ];
+					for ( size_t k = 0; k < j; ++k )
+						s -= a[ i * n + k ] * a[ j * n + k ];
+					a[ i * n + j ] = s / a[ j * n + j ];
+				}
+			}
+			for ( size_t i = 0; i < n; ++i )
+			{
+				for ( size_t k = 0; k < i; ++k )
+					b[ i ] -= a[ i * n + k ] * b[ k ];
+				b[ i ] /= a[ i * n + i ];
+			}
+			for ( size_t i = n; i-- > 0; )
+			{
+				for ( size_t k = i + 1; k < n; ++k )
+					b[ i ] -= a[ k * n + i ] * b[ k ];
+				b[ i ] /= a[ i * n + i ];
+			}
+			return true;
+		}
+
+		// Kendall's tau-a between two sequences
+		double RankCorrelation( const std::vector< double >& a, const std::vector< double >& b )
+		{
+			const auto n = a.size();
+			if ( n < 2 )
+				return 0.0;
+			double sum = 0.0;
+			for ( size_t i = 0; i < n; ++i )
+				for ( size_t j = i + 1; j < n; ++j )
+				{
+					auto s = ( a[ i ] - a[ j ] ) * ( b[ i ] - b[ j ] );
+					sum += s > 0 ? 1.0 : s < 0 ? -1.0 : 0.0;
+				}
+			return 2.0 * sum / ( n * ( n - 1 ) );
+		}
+
+		// indices that sort values in ascending order
+		std::vector< index_t > SortedIndices( const std::vector< double >& values )
+		{
+			std::vector< index_t > idx( values.size() );
+			std::iota( idx.begin(), idx.end(), index_t( 0 ) );
+			std::stable_sort( idx.begin(), idx.end(), [&]( index_t i, index_t j ) { return values[ i ] < values[ j ]; } );
+			return idx;
+		}
+	}
+
+	SurrogateEvaluator::SurrogateEvaluator( size_t exploration, double min_fraction, unsigned int random_seed ) :
+		mu_( 0 ),
+		exploration_( exploration ),
+		min_fraction_( min_fraction ),
+		random_engine_( random_seed ),
+		fraction_( 1.0 ),
+		rank_correlation_( 0.0 ),
+		generation_count_( 0 ),
+		last_evaluation_count_( 0 )
+	{}
+
+	std::vector< index_t > SurrogateEvaluator::Select( const spot::search_point_vec& point_vec )
+	{
+		const auto n = point_vec.size();
+		const auto dim = n > 0 ? point_vec.front().size() : 0;
+
+		// predict costs, if there is enough data to fit the surrogate
+		const auto capacity = std::max( 4 * n, std::min< size_t >( 2 * ( 2 * dim + 1 ), 500 ) );
+		predicted_.clear();
+		if ( archive_.size() >= 2 * n && Fit( capacity ) )
+		{
+			predicted_.reserve( n );
+			for ( const auto& p : point_vec )
+				predicted_.push_back( Predict( p ) );
+		}
+
+		// select the best predicted points, plus random other points for exploration
+		order_.resize( n );
+		std::iota( order_.begin(), order_.end(), index_t( 0 ) );
+		auto count = n;
+		if ( !predicted_.empty() )
+		{
+			order_ = SortedIndices( predicted_ );
+			const auto min_count = std::min( n, mu_ + exploration_ );
+			count = std::clamp( size_t( std::ceil( fraction_ * n ) ), min_count, n );
+			const auto best_count = count - std::min( exploration_, count - std::min( mu_, count ) );
+			std::shuffle( order_.begin() + best_count, order_.end(), random_engine_ );
+			std::sort( order_.begin() + best_count, order_.begin() + count, [&]( index_t i, index_t j ) { return predicted_[ i ] < predicted_[ j ]; } );
+			std::sort( order_.begin() + count, order_.end(), [&]( index_t i, index_t j ) { return predicted_[ i ] < predicted_[ j ]; } );
+		}
+		last_evaluation_count_ = count;
+
+		return std::vector< index_t >( order_.begin(), order_.begin() + count );
+	}
+
+	spot::fitness_vec SurrogateEvaluator::Update( const spot::search_point_vec& point_vec, const std::vector< index_t >& selected, const spot::fitness_vec& fitnesses, bool minimize )
+	{
+		SCONE_ASSERT( point_vec.size() == order_.size() && selected.size() == fitnesses.size() && selected.size() <= order_.size() );
+		const auto n = point_vec.size();
+		const auto count = selected.size();
+		auto cost = [&]( double fitness ) { return minimize ? fitness : -fitness; };
+
+		// add results to the archive and compare with the predictions
+		spot::fitness_vec ranking_fitnesses( n );
+		std::vector< double > predicted_costs, actual_costs;
+		double best_cost = xo::constants< double >::max(), worst_cost = xo::constants< double >::lowest();
+		for ( index_t i = 0; i < count; ++i )
+		{
+			const auto idx = selected[ i ];
+			const auto c = cost( fitnesses[ i ] );
+			// failed evaluations get the worst possible fitness, pruned evaluations have no actual result
+			if ( c == c && std::abs( c ) < xo::constants< double >::max() && !EvaluationPruning::IsPrunedResult( fitnesses[ i ] ) )
+			{
+				archive_.push_back( Sample{ std::vector< double >( point_vec[ idx ].values().begin(), point_vec[ idx ].values().end() ), c } );
+				best_cost = std::min( best_cost, c );
+				worst_cost = std::max( worst_cost, c );
+				if ( !predicted_.empty() )
+				{
+					predicted_costs.push_back( predicted_[ idx ] );
+					actual_costs.push_back( c );
+				}
+			}
+			ranking_fitnesses[ idx ] = fitnesses[ i ];
+		}
+
+		// points that were not evaluated are worse than all evaluated points, in order of prediction
+		if ( count < n )
+		{
+			const auto step = std::max( { worst_cost - best_cost, 1e-6 * std::abs( worst_cost ), 1e-9 } ) / n;
+			for ( index_t i = count; i < n; ++i )
+			{
+				// if all evaluations have failed, the other points are considered failed as well
+				const auto c = worst_cost >= best_cost ? worst_cost + ( i - count + 1 ) * step : xo::constants< double >::max();
+				ranking_fitnesses[ order_[ i ] ] = spot::fitness_t( minimize ? c : -c );
+			}
+		}
+
+		// adapt the fraction of evaluated points to the quality of the predictions
+		if ( !predicted_.empty() )
+		{
+			const auto tau = RankCorrelation( predicted_costs, actual_costs );
+			rank_correlation_ = generation_count_++ == 0 ? tau : 0.7 * rank_correlation_ + 0.3 * tau;
+			fraction_ = std::clamp( 1.0 - rank_correlation_, min_fraction_, 1.0 );
+		}
+
+		return ranking_fitnesses;
+	}
+
+	PropNode SurrogateEvaluator::GetCheckpoint() const
+	{
+		std::vector< double > points, costs;
+		for ( const auto& s : archive_ )
+		{
+			points.insert( points.end(), s.x.begin(), s.x.end() );
+			costs.push_back( s.cost );
+		}
+		std::ostringstream random_state;
+		random_state << random_engine_;
+
+		PropNode pn;
+		pn.set( "points", EncodeCheckpointValues( points ) );
+		pn.set( "costs", EncodeCheckpointValues( costs ) );
+		pn.set( "fraction", fraction_ );
+		pn.set( "rank_correlation", rank_correlation_ );
+		pn.set( "generation_count", generation_count_ );
+		pn.set( "random_state", random_state.str() );
+		return pn;
+	}
+
+	void SurrogateEvaluator::RestoreCheckpoint( const PropNode& pn )
+	{
+		auto points = DecodeCheckpointValues( pn.get<String>( "points" ) );
+		auto costs = DecodeCheckpointValues( pn.get<String>( "costs" ) );
+		SCONE_ERROR_IF( costs.empty() ? !points.empty() : points.size() % costs.size() != 0, "Invalid surrogate archive in checkpoint" );
+		const auto dim = costs.empty() ? 0 : points.size() / costs.size();
+		archive_.clear();
+		for ( index_t i = 0; i < costs.size(); ++i )
+			archive_.push_back( Sample{ std::vector< double >( points.begin() + i * dim, points.begin() + ( i + 1 ) * dim ), costs[ i ] } );
+		fraction_ = pn.get<double>( "fraction" );
+		rank_correlation_ = pn.get<double>( "rank_correlation" );
+		generation_count_ = pn.get<size_t>( "generation_count" );
+		std::istringstream random_state( pn.get<String>( "random_state" ) );
+		random_state >> random_engine_;
+		SCONE_ERROR_IF( random_state.fail(), "Invalid checkpoint value for random_state" );
+	}
+
+	bool SurrogateEvaluator::Fit( size_t capacity )
+	{
+		while ( archive_.size() > capacity )
+			archive_.pop_front();
+		const auto n = archive_.size();
+		const auto dim = archive_.front().x.size();
+		const auto features = 2 * dim + 1;
+
+		// normalize search point values
+		mean_.assign( dim, 0.0 );
+		scale_.assign( dim, 0.0 );
+		for ( const auto& s : archive_ )
+			for ( index_t d = 0; d < dim; ++d )
+				mean_[ d ] += s.x[ d ] / n;
+		for ( const auto& s : archive_ )
+			for ( index_t d = 0; d < dim; ++d )
+				scale_[ d ] += xo::squared( s.x[ d ] - mean_[ d ] ) / n;
+		for ( auto& s : scale_ )
+			s = s > 0 ? 1.0 / std::sqrt( s ) : 1.0;
+
+		// fit to ranks instead of costs, which makes the surrogate insensitive to outliers (e.g. penalties)
+		std::vector< double > costs( n );
+		for ( index_t i = 0; i < n; ++i )
+			costs[ i ] = archive_[ i ].cost;
+		std::vector< double > y( n );
+		auto ranks = SortedIndices( costs );
+		for ( index_t r = 0; r < n; ++r )
+			y[ ranks[ r ] ] = double( r ) / n - 0.5;
+
+		// kernel ridge regression, the number of samples is usually lower than the number of features
+		std::vector< double > phi( n * features );
+		for ( index_t i = 0; i < n; ++i )
+		{
+			auto* f = &phi[ i * features ];
+			f[ 0 ] = 1.0;
+			for ( index_t d = 0; d < dim; ++d )
+			{
+				const auto z = ( archive_[ i ].x[ d ] - mean_[ d ] ) * scale_[ d ];
+				f[ 1 + d ] = z;
+				f[ 1 + dim + d ] = z * z - 1.0;
+			}
+		}
+		std::vector< double > gram( n * n );
+		double trace = 0.0;
+		for ( index_t i = 0; i < n; ++i )
+			for ( index_t j = 0; j <= i; ++j )
+			{
+				gram[ i * n + j ] = gram[ j * n + i ] = std::inner_product( &phi[ i * features ], &phi[ ( i + 1 ) * features ], &phi[ j * features ], 0.0 );
+				if ( i == j )
+					trace += gram[ i * n + i ];
+			}
+		const auto ridge = 1e-3 * trace / n;
+		for ( index_t i = 0; i < n; ++i )
+			gram[ i * n + i ] += ridge;
+		if ( !SolveCholesky( gram, y, n ) )
+			return false;
+
+		weights_.assign( features, 0.0 );
+		for ( index_t i = 0; i < n; ++i )
+			for ( index_t k = 0; k < features; ++k )
+				weights_[ k ] += y[ i ] * phi[ i * features + k ];
+		return true;
+	}
+
+	double SurrogateEvaluator::Predict( const spot::search_point& p ) const
+	{
+		const auto dim = mean_.size();
+		const auto& x = p.values();
+		double result = weights_[ 0 ];
+		for ( index_t d = 0; d < dim; ++d )
+		{
+			const auto z = ( x[ d ] - mean_[ d ] ) * scale_[ d ];
+			result += weights_[ 1 + d ] * z + weights_[ 1 + dim + d ] * ( z * z - 1.0 );
+		}
+		return result;
+	}
+}
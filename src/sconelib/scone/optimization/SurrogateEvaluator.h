@@ -0,0 +1,73 @@
+/*
+** SurrogateEvaluator.h
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#pragma once
+
+#include "scone/core/platform.h"
+#include "scone/core/PropNode.h"
+#include "scone/core/types.h"
+#include "spot/evaluator.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace scone
+{
+	/// Pre-screens search points using a surrogate model, so that only the most promising points are evaluated.
+	/** The surrogate is a quadratic model without interaction terms, fitted to the fitness ranks of recently evaluated points.
+	Each generation, the ''mu'' best predicted points are evaluated, plus ''exploration'' randomly chosen other points.
+	More points are evaluated when the rank correlation (Kendall's tau) between predicted and actual fitness is low.
+	For ranking, points that are not evaluated get a fitness that is worse than all evaluated points, in order of their prediction,
+	so that the selection of an ES optimizer only depends on evaluated points. These fitness values are not reported. */
+	class SCONE_API SurrogateEvaluator
+	{
+	public:
+		SurrogateEvaluator( size_t exploration, double min_fraction, unsigned int random_seed );
+
+		/// Minimum number of points to evaluate each generation, should be the ''mu'' of the optimizer
+		void SetMu( size_t mu ) { mu_ = mu; }
+
+		/// Select the points to evaluate, returns their indices in point_vec
+		std::vector< index_t > Select( const spot::search_point_vec& point_vec );
+
+		/// Add the fitness of the selected points to the surrogate, except failed or pruned results; returns the fitness of all points to be used for ranking
+		spot::fitness_vec Update( const spot::search_point_vec& point_vec, const std::vector< index_t >& selected, const spot::fitness_vec& fitnesses, bool minimize );
+
+		/// Number of points evaluated during the most recent generation
+		size_t GetLastEvaluationCount() const { return last_evaluation_count_; }
+		/// Fraction of points to evaluate in the next generation
+		double GetFraction() const { return fraction_; }
+		/// Average rank correlation between predicted and actual fitness
+		double GetRankCorrelation() const { return rank_correlation_; }
+
+		/// Archive, adaptation and random state, the model itself is fitted from the archive
+		PropNode GetCheckpoint() const;
+		void RestoreCheckpoint( const PropNode& pn );
+
+	private:
+		struct Sample { std::vector< double > x; double cost; };
+		bool Fit( size_t capacity );
+		double Predict( const spot::search_point& p ) const;
+
+		size_t mu_;
+		const size_t exploration_;
+		const double min_fraction_;
+		std::default_random_engine random_engine_;
+
+		std::deque< Sample > archive_;
+		std::vector< double > mean_, scale_; // normalization of search point values
+		std::vector< double > weights_; // weights of the features
+		std::vector< double > predicted_; // predicted costs of the points passed to Select(), empty if there is no fit
+		std::vector< index_t > order_; // indices of the points passed to Select(), selected points first
+		double fraction_;
+		double rank_correlation_;
+		size_t generation_count_;
+		size_t last_evaluation_count_;
+	};
+}
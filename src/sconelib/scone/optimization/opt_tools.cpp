@@ -27,6 +27,14 @@
 #include "EsOptimizer.h"
 #include "spot/console_reporter.h"
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+
 using xo::timer;
 
 namespace scone
@@ -45,22 +53,31 @@ namespace scone
 
 	PropNode EvaluateScenario( const PropNode& scenario_pn, const path& par_file, const path& output_base )
 	{
-		bool store_data = !output_base.empty();
-
 		auto opt = CreateOptimizer( scenario_pn, par_file.parent_path() );
 		auto mo = dynamic_cast<ModelObjective*>( &opt->GetObjective() );
+		SCONE_ERROR_IF( !mo, "Scenario does not contain a ModelObjective" );
 
 		// report unused properties
 		LogUnusedProperties( scenario_pn );
 
+		return EvaluateParFile( *mo, par_file, output_base );
+	}
+
+	PropNode EvaluateParFile( ModelObjective& mo, const path& par_file, const path& output_base )
+	{
+		bool store_data = !output_base.empty();
+
 		// create model
 		bool has_par_file = par_file.extension_no_dot() == "par";
-		ModelUP model = has_par_file ? mo->CreateModelFromParFile( par_file ) : mo->CreateModelFromParams( mo->info() );
+		ModelUP model = has_par_file ? mo.CreateModelFromParFile( par_file ) : mo.CreateModelFromParams( mo.info() );
 
 		model->SetStoreData( store_data );
+		if ( store_data && GetSconeSetting<bool>( "results.stream_data" ) )
+			model->SetStoreDataStream( output_base, GetSconeSetting<int>( "results.stream_window" ) );
 
 		timer tmr;
-		auto result = mo->EvaluateModel( *model, xo::stop_token() );
+		auto result = mo.EvaluateModel( *model, xo::stop_token() );
+		model->FinishStoreDataStream();
 		auto duration = tmr().secondsd();
 
 		// write results
@@ -72,13 +89,155 @@ namespace scone
 
 		// collect statistics
 		PropNode statistics;
-		statistics.set( "result", mo->GetReport( *model ) );
+		if ( result )
+			statistics.set( "fitness", result.value() );
+		statistics.set( "result", mo.GetReport( *model ) );
 		statistics.set( "simulation time", model->GetTime() );
 		statistics.set( "performance (x real-time)", model->GetTime() / duration );
 
 		return statistics;
 	}
 
+	namespace
+	{
+		// calls fn( i ) for i in [0, n) on at most thread_count threads, including the calling thread
+		void ParallelFor( size_t n, size_t thread_count, const std::function<void( size_t )>& fn )
+		{
+			std::atomic<size_t> next = 0;
+			auto worker = [&]() { for ( auto i = next++; i < n; i = next++ ) fn( i ); };
+			std::vector<std::thread> threads;
+			for ( size_t t = 1; t < std::min( thread_count, n ); ++t )
+				threads.emplace_back( worker );
+			worker();
+			for ( auto& t : threads )
+				t.join();
+		}
+
+		// adds the values of all children in pn to columns, using dot-separated keys
+		void AddReportColumns( const PropNode& pn, const String& prefix, std::vector<std::pair<String, String>>& columns )
+		{
+			for ( const auto& [key, child] : pn )
+			{
+				auto name = prefix.empty() ? key : prefix + '.' + key;
+				if ( !child.get_str().empty() )
+					columns.emplace_back( name, child.get_str() );
+				AddReportColumns( child, name, columns );
+			}
+		}
+	}
+
+	PropNode EvaluateParFiles( const std::vector<path>& par_files, size_t thread_count, const std::function<void( PropNode& )>& prepare_scenario )
+	{
+		if ( thread_count == 0 )
+			thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+
+		// group files by scenario, so that each scenario and model is loaded only once
+		std::vector<path> scenario_files;
+		std::vector<size_t> file_scenarios( par_files.size() );
+		std::vector<String> file_errors( par_files.size() );
+		std::map<String, size_t> scenario_indices;
+		for ( size_t i = 0; i < par_files.size(); ++i )
+		{
+			try
+			{
+				auto scenario_file = FindScenario( par_files[ i ] );
+				auto [it, inserted] = scenario_indices.emplace( scenario_file.str(), scenario_files.size() );
+				if ( inserted )
+					scenario_files.push_back( scenario_file );
+				file_scenarios[ i ] = it->second;
+			}
+			catch ( std::exception& e )
+			{
+				file_errors[ i ] = e.what();
+				log::error( "Could not find scenario for ", par_files[ i ], ": ", e.what() );
+			}
+		}
+		log::info( "Evaluating ", par_files.size(), " files of ", scenario_files.size(), " scenarios using ", thread_count, " threads" );
+
+		std::vector<OptimizerUP> optimizers( scenario_files.size() );
+		std::vector<String> scenario_errors( scenario_files.size() );
+		ParallelFor( scenario_files.size(), thread_count, [&]( size_t i ) {
+			try
+			{
+				auto scenario_pn = LoadScenario( scenario_files[ i ], true );
+				if ( prepare_scenario )
+					prepare_scenario( scenario_pn );
+				optimizers[ i ] = CreateOptimizer( scenario_pn, scenario_files[ i ].parent_path() );
+				SCONE_ERROR_IF( !dynamic_cast<ModelObjective*>( &optimizers[ i ]->GetObjective() ), "Scenario does not contain a ModelObjective" );
+				LogUnusedProperties( scenario_pn );
+			}
+			catch ( std::exception& e )
+			{
+				optimizers[ i ].reset();
+				scenario_errors[ i ] = e.what();
+				log::error( "Could not load ", scenario_files[ i ], ": ", e.what() );
+			}
+		} );
+
+		std::vector<PropNode> results( par_files.size() );
+		ParallelFor( par_files.size(), thread_count, [&]( size_t i ) {
+			try
+			{
+				SCONE_ERROR_IF( !file_errors[ i ].empty(), file_errors[ i ] );
+				const auto& opt = optimizers[ file_scenarios[ i ] ];
+				SCONE_ERROR_IF( !opt, scenario_errors[ file_scenarios[ i ] ] );
+				results[ i ] = EvaluateParFile( dynamic_cast<ModelObjective&>( opt->GetObjective() ), par_files[ i ], par_files[ i ] );
+			}
+			catch ( std::exception& e )
+			{
+				results[ i ].set( "error", String( e.what() ) );
+				log::error( "Could not evaluate ", par_files[ i ], ": ", e.what() );
+			}
+		} );
+
+		PropNode pn;
+		for ( size_t i = 0; i < par_files.size(); ++i )
+			pn.add_child( par_files[ i ].str(), results[ i ] );
+		return pn;
+	}
+
+	void WriteEvaluationSummary( const PropNode& results, const path& file )
+	{
+		// columns of measure reports are added in order of appearance, files without a value get an empty cell
+		std::vector<String> headers{ "file", "fitness", "simulation_time", "realtime_factor", "error" };
+		std::vector<std::map<String, String>> rows;
+		for ( const auto& [par_file, stats] : results )
+		{
+			auto& row = rows.emplace_back();
+			row[ "file" ] = par_file;
+			row[ "fitness" ] = stats.get<String>( "fitness", "" );
+			row[ "simulation_time" ] = stats.get<String>( "simulation time", "" );
+			row[ "realtime_factor" ] = stats.get<String>( "performance (x real-time)", "" );
+			row[ "error" ] = stats.get<String>( "error", "" );
+			std::vector<std::pair<String, String>> report;
+			if ( auto* report_pn = stats.try_get_child( "result" ) )
+			{
+				if ( !report_pn->get_str().empty() )
+					report.emplace_back( "result", report_pn->get_str() );
+				AddReportColumns( *report_pn, "result", report );
+			}
+			for ( auto& [name, value] : report )
+			{
+				if ( std::find( headers.begin(), headers.end(), name ) == headers.end() )
+					headers.push_back( name );
+				row[ name ] = value;
+			}
+		}
+
+		std::ofstream str( file.str() );
+		SCONE_ERROR_IF( !str.good(), "Could not write " + file.str() );
+		for ( size_t i = 0; i < headers.size(); ++i )
+			str << ( i > 0 ? "\t" : "" ) << headers[ i ];
+		str << std::endl;
+		for ( auto& row : rows )
+		{
+			for ( size_t i = 0; i < headers.size(); ++i )
+				str << ( i > 0 ? "\t" : "" ) << row[ headers[ i ] ];
+			str << std::endl;
+		}
+		log::info( "Evaluation summary written to ", file );
+	}
+
 	path FindScenario( const path& file )
 	{
 		if ( file.extension_no_dot() == "scone" || file.extension_no_dot() == "xml" )
@@ -142,6 +301,8 @@ namespace scone
 			pooled_eval.set_max_threads( max_threads, thread_prio );
 			return pooled_eval;
 		}
+		else if ( eval == 4 )
+			SCONE_ERROR( "Distributed evaluators are created by the optimizer, see Optimizer::InitEvaluator()" );
 		else SCONE_THROW( "Invalid evaluator setting" );
 	}
 
@@ -159,4 +320,52 @@ namespace scone
 		default: SCONE_THROW( "Unknown output mode" );
 		}
 	}
+
+	void SaveCheckpoint( const PropNode& checkpoint_pn, const path& folder )
+	{
+		// write to a temporary file first, so an interrupted write never corrupts the previous checkpoint
+		const auto file = folder / "checkpoint.zml";
+		const auto tmp_file = folder / "checkpoint.tmp.zml";
+		xo::save_file( checkpoint_pn, tmp_file );
+		std::error_code ec;
+		std::filesystem::rename( tmp_file.str(), file.str(), ec );
+		SCONE_ERROR_IF( ec, "Could not write " + file.str() + ": " + ec.message() );
+	}
+
+	PropNode LoadCheckpoint( const path& folder )
+	{
+		const auto file = folder / "checkpoint.zml";
+		SCONE_ERROR_IF( !xo::file_exists( file ), "Could not find checkpoint file " + file.str() );
+		return xo::load_file( file, "zml" );
+	}
+
+	PropNode LoadResumeScenario( const path& folder )
+	{
+		auto checkpoint_pn = LoadCheckpoint( folder );
+		auto* props = checkpoint_pn.try_get_child( "props" );
+		SCONE_ERROR_IF( !props, "Checkpoint in " + folder.str() + " does not contain optimizer properties" );
+		auto opt_pn = *props;
+		opt_pn.set( "resume_folder", folder );
+		PropNode scenario_pn;
+		scenario_pn.add_child( checkpoint_pn.get<String>( "type" ), opt_pn );
+		return scenario_pn;
+	}
+
+	String EncodeCheckpointValues( const std::vector<double>& values )
+	{
+		std::ostringstream str;
+		str.precision( std::numeric_limits<double>::max_digits10 );
+		for ( size_t i = 0; i < values.size(); ++i )
+			str << ( i > 0 ? " " : "" ) << values[ i ];
+		return str.str();
+	}
+
+	std::vector<double> DecodeCheckpointValues( const String& str )
+	{
+		std::vector<double> values;
+		std::istringstream istr( str );
+		for ( double v; istr >> v; )
+			values.push_back( v );
+		return values;
+	}
 }
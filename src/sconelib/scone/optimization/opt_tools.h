@@ -18,6 +18,9 @@
 #include "spot/evaluator.h"
 #include "spot/reporter.h"
 
+#include <functional>
+#include <vector>
+
 namespace scone
 {
 	// Log unused properties
@@ -26,6 +29,17 @@ namespace scone
 	// Creates and evaluates SimulationObjective. Logs unused properties.
 	SCONE_API PropNode EvaluateScenario( const PropNode& scenario_pn, const path& par_file, const path& output_base );
 
+	// Evaluates a model with parameters from par_file using an existing objective, writes results if output_base is not empty.
+	// Different .par files can be evaluated concurrently with the same objective.
+	SCONE_API PropNode EvaluateParFile( ModelObjective& mo, const path& par_file, const path& output_base );
+
+	// Evaluates .par files concurrently and writes their results next to each file, returns the statistics of each file.
+	// Files with the same scenario share a single objective, prepare_scenario (optional) is applied to each loaded scenario.
+	SCONE_API PropNode EvaluateParFiles( const std::vector<path>& par_files, size_t thread_count, const std::function<void( PropNode& )>& prepare_scenario = {} );
+
+	// Writes a tab-separated table with the statistics and measure report of each file in the result of EvaluateParFiles()
+	SCONE_API void WriteEvaluationSummary( const PropNode& results, const path& file );
+
 	// Returns .scone file for a given .par file, or returns argument if already .scone.
 	SCONE_API path FindScenario( const path& scenario_or_par_file );
 
@@ -38,9 +52,24 @@ namespace scone
 	// Loads a scenario prop_node, optionally adding empty versions when missing
 	SCONE_API PropNode LoadScenario( const path& scenario_file, bool add_missing_version = false );
 
-	// Gets spot::evaluator based on SCONE settings
+	// Gets shared spot::evaluator based on SCONE settings, distributed evaluators are created by Optimizer::InitEvaluator()
 	SCONE_API spot::evaluator& GetSpotEvaluator();
 
 	// Gets spot::evaluator based on SCONE settings
 	SCONE_API std::unique_ptr<spot::reporter> MakeSpotReporter( Optimizer::OutputMode m );
+
+	// Writes checkpoint.zml to an optimization output folder; the previous checkpoint is replaced only after writing succeeded
+	SCONE_API void SaveCheckpoint( const PropNode& checkpoint_pn, const path& folder );
+
+	// Loads checkpoint.zml from an optimization output folder
+	SCONE_API PropNode LoadCheckpoint( const path& folder );
+
+	// Creates a scenario that resumes the optimization in folder from its checkpoint
+	SCONE_API PropNode LoadResumeScenario( const path& folder );
+
+	// Converts a vector of values to a string for storing in a checkpoint, without loss of precision
+	SCONE_API String EncodeCheckpointValues( const std::vector<double>& values );
+
+	// Converts a string from EncodeCheckpointValues() back to a vector of values
+	SCONE_API std::vector<double> DecodeCheckpointValues( const String& str );
 }
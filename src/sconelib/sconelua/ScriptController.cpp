@@ -22,23 +22,26 @@ namespace scone
 		Controller( pn, par, model, loc ),
 		script_file( FindFile( pn.get<path>( "script_file" ) ) ),
 		INIT_MEMBER( pn, external_files, std::vector<path>() ),
+		lua_model_( new LuaModel( model ) ),
+		lua_frame_( new LuaFrame() ),
 		script_( new lua_script( script_file, pn, par, model ) )
 	{
 		// optional functions
 		if ( auto f = script_->try_find_function( "init" ) )
 			init_ = f;
 		if ( auto f = script_->try_find_function( "store_data" ) )
-			store_ = f;
+			store_ = [f, lf = script_->make_object( lua_frame_.get() )]() { f( lf ); };
 
-		// update is required
-		update_ = script_->find_function( "update" );
+		// update is required, the model wrapper is passed to Lua only once
+		update_ = [f = script_->find_function( "update" ), lm = script_->make_object( lua_model_.get() )]( double t ) {
+			return f.call<bool>( lm, t );
+		};
 
 		if ( init_ )
 		{
 			LuaParams lp( par );
-			LuaModel lm( model );
 			auto side = static_cast<double>( loc.GetSide() );
-			init_( &lm, &lp, side );
+			init_( lua_model_.get(), &lp, side );
 		}
 
 		// add lua files as external resources
@@ -54,8 +57,8 @@ namespace scone
 	{
 		if ( store_ )
 		{
-			LuaFrame lf( frame );
-			store_( &lf );
+			lua_frame_->frame_ = &frame;
+			store_();
 		}
 	}
 
@@ -63,8 +66,7 @@ namespace scone
 	{
 		SCONE_PROFILE_FUNCTION( model.GetProfiler() );
 
-		LuaModel lm( model );
-		return update_( &lm, timestamp );
+		return update_( timestamp );
 	}
 
 	String ScriptController::GetClassSignature() const
@@ -50,9 +50,11 @@ namespace scone
 		virtual bool ComputeControls( Model& model, double timestamp ) override;
 		virtual String GetClassSignature() const override;
 
+		u_ptr< struct LuaModel > lua_model_;
+		u_ptr< struct LuaFrame > lua_frame_;
 		u_ptr< class lua_script > script_;
 		std::function<void( struct LuaModel*, struct LuaParams*, double )> init_;
-		std::function<bool( struct LuaModel*, double )> update_;
-		std::function<double( struct LuaFrame* )> store_;
+		std::function<bool( double )> update_;
+		std::function<void()> store_;
 	};
 }
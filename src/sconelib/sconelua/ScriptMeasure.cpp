@@ -11,25 +11,29 @@ namespace scone
 		Measure( pn, par, model, loc ),
 		script_file( FindFile( pn.get<path>( "script_file" ) ) ),
 		INIT_MEMBER( pn, external_files, std::vector<path>() ),
-		script_( new lua_script( script_file, pn, par, const_cast<Model&>( model ) ) ) // const_cast is needed because Lua doesn't care about const
+		lua_model_( new LuaModel( const_cast<Model&>( model ) ) ), // const_cast is needed because Lua doesn't care about const
+		lua_frame_( new LuaFrame() ),
+		script_( new lua_script( script_file, pn, par, const_cast<Model&>( model ) ) )
 	{
+		// the model wrapper is passed to Lua only once
+		auto lm = script_->make_object( lua_model_.get() );
+
 		// optional functions
 		if ( auto f = script_->try_find_function( "init" ) )
 			init_ = f;
 		if ( auto f = script_->try_find_function( "update" ) )
-			update_ = f;
+			update_ = [f, lm]( double t ) { return f.call<bool>( lm, t ); };
 		if ( auto f = script_->try_find_function( "store_data" ) )
-			store_ = f;
+			store_ = [f, lf = script_->make_object( lua_frame_.get() )]() { f( lf ); };
 
 		// result is required
-		result_ = script_->find_function( "result" );
+		result_ = [f = script_->find_function( "result" ), lm]() { return f.call<double>( lm ); };
 
 		if ( init_ )
 		{
-			LuaModel lm( const_cast<Model&>( model ) );
 			LuaParams lp( par );
 			auto side = static_cast<double>( loc.GetSide() );
-			init_( &lm, &lp, side );
+			init_( lua_model_.get(), &lp, side );
 		}
 
 		// add lua files as external resources
@@ -38,10 +42,12 @@ namespace scone
 			model.AddExternalResource( FindFile( f ) );
 	}
 
+	ScriptMeasure::~ScriptMeasure()
+	{}
+
 	double ScriptMeasure::ComputeResult( const Model& model )
 	{
-		LuaModel lm( const_cast<Model&>( model ) );
-		auto value = result_( &lm );
+		auto value = result_();
 		GetReport().set_value( value );
 		return value;
 	}
@@ -51,10 +57,7 @@ namespace scone
 		SCONE_PROFILE_FUNCTION( model.GetProfiler() );
 
 		if ( update_ )
-		{
-			LuaModel lm( const_cast<Model&>( model ) );
-			return update_( &lm, timestamp );
-		}
+			return update_( timestamp );
 		else return false;
 	}
 
@@ -62,8 +65,8 @@ namespace scone
 	{
 		if ( store_ )
 		{
-			LuaFrame lf( frame );
-			store_( &lf );
+			lua_frame_->frame_ = &frame;
+			store_();
 		}
 	}
 
@@ -41,7 +41,8 @@ namespace scone
 	{
 	public:
 		ScriptMeasure( const PropNode& props, Params& par, const Model& model, const Location& loc );
-		
+		virtual ~ScriptMeasure();
+
 		virtual double ComputeResult( const Model& model ) override;
 		virtual bool UpdateMeasure( const Model& model, double timestamp ) override;
 		virtual void StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const override;
@@ -56,10 +57,12 @@ namespace scone
 		virtual String GetClassSignature() const override;
 
 	private:
+		u_ptr< struct LuaModel > lua_model_;
+		u_ptr< struct LuaFrame > lua_frame_;
 		u_ptr< class lua_script > script_;
 		std::function<void( struct LuaModel*, struct LuaParams*, double )> init_;
-		std::function<bool( struct LuaModel*, double )> update_;
-		std::function<double( struct LuaModel* )> result_;
-		std::function<void( struct LuaFrame* )> store_;
+		std::function<bool( double )> update_;
+		std::function<double()> result_;
+		std::function<void()> store_;
 	};
 }
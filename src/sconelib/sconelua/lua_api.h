@@ -70,18 +70,19 @@ namespace scone
 	/// Access to writing data for scone Analysis window
 	struct LuaFrame
 	{
-		LuaFrame( Storage<Real>::Frame& f ) : frame_( f ) {}
+		LuaFrame() : frame_( nullptr ) {}
+		LuaFrame( Storage<Real>::Frame& f ) : frame_( &f ) {}
 
 		/// set a numeric value for channel named key
-		void set_value( LuaString key, LuaNumber value ) { frame_[ key ] = value; }
+		void set_value( LuaString key, LuaNumber value ) { ( *frame_ )[ key ] = value; }
 		/// set a numeric value for channel named key
-		void set_vec3( LuaString key, LuaVec3 v ) { string s( key ); frame_[ s + "_x" ] = v.x; frame_[ s + "_y" ] = v.y; frame_[ s + "_z" ] = v.z; }
+		void set_vec3( LuaString key, LuaVec3 v ) { string s( key ); ( *frame_ )[ s + "_x" ] = v.x; ( *frame_ )[ s + "_y" ] = v.y; ( *frame_ )[ s + "_z" ] = v.z; }
 		/// set a boolean (true or false) value for channel named key
-		void set_bool( LuaString key, bool b ) { frame_[ key ] = b ? 1.0 : 0.0; }
+		void set_bool( LuaString key, bool b ) { ( *frame_ )[ key ] = b ? 1.0 : 0.0; }
 		/// get time of current frame
-		LuaNumber time() { return frame_.GetTime(); }
+		LuaNumber time() { return frame_->GetTime(); }
 
-		Storage<Real>::Frame& frame_;
+		Storage<Real>::Frame* frame_; // reassigned by the owner before each call, so the wrapper can be reused
 	};
 
 	/// Actuator type for use in lua scripting.
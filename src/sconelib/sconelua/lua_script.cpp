@@ -5,8 +5,63 @@
 #include "scone/model/Actuator.h"
 #include "lua_api.h"
 
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
 namespace scone
 {
+	namespace
+	{
+		// precompiled script, stored with the modification time of the file it was compiled from
+		struct lua_bytecode
+		{
+			std::filesystem::file_time_type file_time;
+			String data;
+		};
+
+		std::mutex g_bytecode_mutex;
+		std::unordered_map< String, s_ptr< const lua_bytecode > > g_bytecode_cache;
+
+		int append_bytecode( lua_State* L, const void* p, size_t size, void* ud )
+		{
+			static_cast<String*>( ud )->append( static_cast<const char*>( p ), size );
+			return 0;
+		}
+
+		// load the script as a function on the Lua stack, from the bytecode cache if the file has not changed
+		int load_script( lua_State* L, const path& file )
+		{
+			const auto filename = file.str();
+			const auto chunkname = "@" + filename;
+			std::error_code ec;
+			const auto file_time = std::filesystem::last_write_time( filename, ec );
+
+			s_ptr< const lua_bytecode > bytecode;
+			if ( !ec )
+			{
+				std::scoped_lock lock( g_bytecode_mutex );
+				if ( auto it = g_bytecode_cache.find( filename ); it != g_bytecode_cache.end() && it->second->file_time == file_time )
+					bytecode = it->second;
+			}
+			if ( bytecode )
+				return luaL_loadbufferx( L, bytecode->data.data(), bytecode->data.size(), chunkname.c_str(), "b" );
+
+			auto status = luaL_loadfilex( L, filename.c_str(), nullptr );
+			if ( status == LUA_OK && !ec )
+			{
+				auto bc = std::make_shared< lua_bytecode >();
+				bc->file_time = file_time;
+				if ( lua_dump( L, append_bytecode, &bc->data, 0 ) == 0 ) // keep debug info for error messages
+				{
+					std::scoped_lock lock( g_bytecode_mutex );
+					g_bytecode_cache[ filename ] = std::move( bc );
+				}
+			}
+			return status;
+		}
+	}
+
 	lua_script::lua_script( const path& script_file, const PropNode& pn, Params& par, Model& model ) :
 		script_file_( script_file )
 	{
@@ -25,12 +80,15 @@ namespace scone
 			lua_[ "scone" ][ prop.first ] = prop.second.get<string>();
 
 		// load script
-		auto script = lua_.load_file( script_file_.str() );
-		if ( !script.valid() )
+		lua_State* L = lua_;
+		if ( load_script( L, script_file_ ) != LUA_OK )
 		{
-			sol::error err = script;
-			SCONE_ERROR( "Error in " + script_file_.filename().str() + ": " + err.what() );
+			String msg = lua_tostring( L, -1 );
+			lua_pop( L, 1 );
+			SCONE_ERROR( "Error in " + script_file_.filename().str() + ": " + msg );
 		}
+		sol::protected_function script( L, -1 );
+		lua_pop( L, 1 );
 
 		// run once to define functions
 		auto res = script();
@@ -8,6 +8,9 @@
 
 namespace scone
 {
+	/// Lua state running a script file.
+	/** Scripts are compiled once per process and stored as bytecode, which is recompiled when the file changes.
+	Each script gets a fresh Lua state, so changes made by a script (e.g. to library tables) never affect other evaluations. */
 	class lua_script
 	{
 	public:
@@ -16,6 +19,10 @@ namespace scone
 
 		sol::function find_function( const String& name );
 		sol::function try_find_function( const String& name );
+
+		/// create a Lua reference to a wrapper object, so that it can be passed without creating new userdata on each call
+		template< typename T > sol::object make_object( T* ptr ) { return sol::make_object( lua_, ptr ); }
+
 		xo::path script_file_;
 
 	private:
@@ -29,7 +29,6 @@ namespace scone
 	MuscleOpenSim3::MuscleOpenSim3( ModelOpenSim3& model, OpenSim::Muscle& mus ) :
 		m_Model( model ),
 		m_osMus( mus ),
-		m_MomentArmCacheTimeStamp( -1 ),
 		m_MinActivation( 0 ) // will be set correctly below
 	{
 		InitJointsDofs();
@@ -140,38 +139,30 @@ namespace scone
 		return *FindByName( m_Model.GetBodies(), pps.get( pps.getSize() - 1 ).getBodyName() );
 	}
 
-	Real MuscleOpenSim3::GetMomentArm( const Dof& dof ) const
+	Real MuscleOpenSim3::ComputeMomentArm( const Dof& dof ) const
 	{
-		auto t = GetModel().GetTime();
-		if ( m_MomentArmCacheTimeStamp != t )
-		{
-			for ( auto& d : GetDofs() )
-			{
-				const DofOpenSim3& dof_sb = dynamic_cast<const DofOpenSim3&>( *d );
-				auto mom = m_osMus.getGeometryPath().computeMomentArm( m_Model.GetTkState(), dof_sb.GetOsCoordinate() );
-				if ( fabs( mom ) < MOMENT_ARM_EPSILON || dof_sb.GetOsCoordinate().getLocked( m_Model.GetTkState() ) )
-					mom = 0;
-				m_MomentArmCache[ &dof ] = mom;
-			}
-		}
-
-		return m_MomentArmCache[ &dof ];
+		const DofOpenSim3& dof_sb = dynamic_cast<const DofOpenSim3&>( dof );
+		auto mom = m_osMus.getGeometryPath().computeMomentArm( m_Model.GetTkState(), dof_sb.GetOsCoordinate() );
+		if ( fabs( mom ) < MOMENT_ARM_EPSILON || dof_sb.GetOsCoordinate().getLocked( m_Model.GetTkState() ) )
+			mom = 0;
+		return mom;
 	}
 
 	void MuscleOpenSim3::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		Muscle::StoreData( frame, flags );
+		Muscle::StoreData( frame, flags ); // also begins m_StoreDataChannels
 		if ( flags.get<StoreDataTypes::DebugData>() )
 		{
+			auto& ch = m_StoreDataChannels;
 			auto f_t = m_osMus.getTendonForce( m_Model.GetTkState() ) / m_osMus.getCosPennationAngle( m_Model.GetTkState() ) / m_osMus.getMaxIsometricForce();
 			auto f_pe = m_osMus.getPassiveFiberForce( m_Model.GetTkState() ) / m_osMus.getMaxIsometricForce();
 			auto f_ce = m_osMus.getActiveForceLengthMultiplier( m_Model.GetTkState() ) * m_osMus.getActivation( m_Model.GetTkState() );
-			frame[ GetName() + ".inv_ce_vel" ] = ( f_t - f_pe ) / f_ce;
-			frame[ GetName() + ".ce_vel_norm" ] = m_osMus.getNormalizedFiberVelocity( m_Model.GetTkState() );
-			frame[ GetName() + ".ce_vel" ] = m_osMus.getFiberVelocity( m_Model.GetTkState() );
-			frame[ GetName() + ".inv_ce_vel_ft" ] = f_t;
-			frame[ GetName() + ".inv_ce_vel_fpe" ] = f_pe;
-			frame[ GetName() + ".inv_ce_vel_fce" ] = f_ce;
+			ch.Set( GetName(), ".inv_ce_vel", ( f_t - f_pe ) / f_ce );
+			ch.Set( GetName(), ".ce_vel_norm", m_osMus.getNormalizedFiberVelocity( m_Model.GetTkState() ) );
+			ch.Set( GetName(), ".ce_vel", m_osMus.getFiberVelocity( m_Model.GetTkState() ) );
+			ch.Set( GetName(), ".inv_ce_vel_ft", f_t );
+			ch.Set( GetName(), ".inv_ce_vel_fpe", f_pe );
+			ch.Set( GetName(), ".inv_ce_vel_fce", f_ce );
 		}
 	}
 
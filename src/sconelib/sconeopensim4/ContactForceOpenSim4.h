@@ -32,6 +32,7 @@ namespace scone
 		virtual const Vec3& GetPoint() const override;
 		virtual std::tuple<const Vec3&, const Vec3&, const Vec3&> GetForceMomentPoint() const override;
 		ForceValue GetForceValue() const override;
+		void ClearCachedValues() { m_LastNumDynamicsRealizations = -1; }
 
 	private:
 		const OpenSim::Force& m_osForce;
@@ -78,12 +78,14 @@ namespace scone
 
 	void DofOpenSim4::SetPos( Real pos, bool enforce_constraints )
 	{
+		m_Model.InvalidateMuscleSnapshot();
 		if ( !m_osCoord.getLocked( m_Model.GetTkState() ) )
 			m_osCoord.setValue( m_Model.GetTkState(), pos, enforce_constraints );
 	}
 
 	void DofOpenSim4::SetVel( Real vel )
 	{
+		m_Model.InvalidateMuscleSnapshot();
 		if ( !m_osCoord.getLocked( m_Model.GetTkState() ) )
 			m_osCoord.setSpeedValue( m_Model.GetTkState(), vel );
 	}
@@ -79,6 +79,7 @@ namespace scone
 		m_EndTime( xo::constants<TimeInSeconds>::max() ),
 		m_Mass( 0.0 ),
 		m_BW( 0.0 ),
+		m_CanReset( true ),
 		INIT_MEMBER( props, safe_mode, false )
 	{
 		SCONE_PROFILE_FUNCTION( GetProfiler() );
@@ -146,8 +147,12 @@ namespace scone
 
 			{
 				// change model properties
+				// these are part of the OpenSim system, so Reset() is not possible
 				if ( auto* model_pars = props.try_get_child( "Properties" ) )
+				{
 					SetProperties( *model_pars, par );
+					m_CanReset = false;
+				}
 
 				// create controller dispatcher (ownership is automatically passed to OpenSim::Model)
 				m_pControllerDispatcher = new ControllerDispatcher( *this );
@@ -181,6 +186,7 @@ namespace scone
 						// modelComponent takes ownership of the stateComponent
 						auto modelComponent = new OpenSim::StateComponentOpenSim4( stateComponent.release() );
 						m_pOsimModel->addComponent( modelComponent );
+						m_CanReset = false;
 					}
 				}
 			}
@@ -243,43 +249,18 @@ namespace scone
 				AddExternalResource( state_init_file );
 			}
 
-			// update state variables if they are being optimized
-			if ( initial_state_offset )
+			// keep the initial state for Reset()
+			if ( m_CanReset )
 			{
-				auto inc_pat = xo::pattern_matcher( initial_state_offset_include, ";" );
-				auto ex_pat = xo::pattern_matcher( initial_state_offset_exclude + ";*/activation;*/fiber_length", ";" );
-				for ( index_t i = 0; i < m_State.GetSize(); ++i )
-				{
-					const String& state_name = m_State.GetName( i );
-					if ( inc_pat( state_name ) && !ex_pat( state_name ) )
-					{
-						auto par_name = initial_state_offset_symmetric ? GetNameNoSide( state_name ) : state_name;
-						m_State[ i ] += par.get( par_name + ".offset", *initial_state_offset );
-					}
-				}
+				m_pInitialTkState = std::make_unique<SimTK::State>( GetTkState() );
+				m_InitialStateValues = m_State.GetValues();
 			}
 
-			// apply and fix state
-			if ( !initial_load_dof.empty() && initial_load > 0 && !GetContactGeometries().empty() )
-			{
-				CopyStateToTk();
-				FixTkState( initial_load * GetBW() );
-				CopyStateFromTk();
-			}
+			InitStateFromParams( par );
 		}
 
 		// Realize acceleration because controllers may need it and in this way the results are consistent
-		{
-			SCONE_PROFILE_SCOPE( GetProfiler(), "RealizeSystem" );
-			// Create a manager to run the simulation. Can change manager options to save run time and memory or print more information
-			m_pOsimManager = std::make_unique<OpenSim::Manager>( *m_pOsimModel );
-			m_pOsimManager->setWriteToStorage( false );
-			m_pOsimManager->setPerformAnalyses( false );
-			//m_pOsimManager->setInitialTime( 0.0 );
-			//m_pOsimManager->setFinalTime( 0.0 );
-
-			m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
-		}
+		InitManager();
 
 		// create and initialize controllers
 		CreateControllers( props, par );
@@ -288,6 +269,40 @@ namespace scone
 
 	ModelOpenSim4::~ModelOpenSim4() {}
 
+	bool ModelOpenSim4::Reset( const PropNode& props, Params& par )
+	{
+		SCONE_PROFILE_FUNCTION( GetProfiler() );
+
+		if ( !m_CanReset )
+			return false;
+
+		ResetSimulation( props, par );
+
+		// reset OpenSim simulation objects
+		for ( auto* bf : m_BodyForces )
+			bf->setNull();
+		for ( auto& cf : m_ContactForces )
+			static_cast<ContactForceOpenSim4&>( *cf ).ClearCachedValues();
+		m_pTkTimeStepper.reset();
+		m_pTkIntegrator->resetAllStatistics();
+		m_PrevIntStep = -1;
+		m_PrevTime = 0.0;
+
+		// restore the initial state and apply parameters
+		{
+			SCONE_PROFILE_SCOPE( GetProfiler(), "InitState" );
+			m_pTkState = &m_pOsimModel->updWorkingState();
+			*m_pTkState = *m_pInitialTkState;
+			m_State.SetValues( m_InitialStateValues );
+			InitStateFromParams( par );
+		}
+
+		InitManager();
+		CreateControllers( props, par );
+
+		return true;
+	}
+
 	const OpenSim::PhysicalFrame* find_osim_body( const OpenSim::Model& model, int mbidx ) {
 		if ( mbidx > 0 ) {
 			auto& bodies = model.getBodySet();
@@ -630,6 +645,7 @@ namespace scone
 					// store initial frame
 					m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
 					CopyStateFromTk();
+					m_MuscleSnapshot.Update( m_MusclePtrs );
 					StoreCurrentFrame();
 				}
 			}
@@ -647,6 +663,7 @@ namespace scone
 
 				{
 					SCONE_PROFILE_SCOPE( GetProfiler(), "SimTK::TimeStepper::stepTo" );
+					InvalidateMuscleSnapshot();
 					auto st = xo::scoped_timer_starter( m_SimulationTimer );
 					auto status = m_pTkTimeStepper->stepTo( target_time );
 					if ( status == SimTK::Integrator::EndOfSimulation )
@@ -665,6 +682,12 @@ namespace scone
 					m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
 				}
 
+				// read the muscle state once, it is used by sensors, controllers, measures and StoreData
+				{
+					SCONE_PROFILE_SCOPE( GetProfiler(), "MuscleSnapshot::Update" );
+					m_MuscleSnapshot.Update( m_MusclePtrs );
+				}
+
 				// update the sensor delays, analyses, and store data
 				UpdateSensorDelayAdapters();
 				UpdateAnalyses();
@@ -837,6 +860,46 @@ namespace scone
 			log::trace( "Moved ", initial_load_dof, " to ", new_ty, "; force=", force, "; goal=", force_threshold );
 	}
 
+	void ModelOpenSim4::InitStateFromParams( Params& par )
+	{
+		// update state variables if they are being optimized
+		if ( initial_state_offset )
+		{
+			auto inc_pat = xo::pattern_matcher( initial_state_offset_include, ";" );
+			auto ex_pat = xo::pattern_matcher( initial_state_offset_exclude + ";*/activation;*/fiber_length", ";" );
+			for ( index_t i = 0; i < m_State.GetSize(); ++i )
+			{
+				const String& state_name = m_State.GetName( i );
+				if ( inc_pat( state_name ) && !ex_pat( state_name ) )
+				{
+					auto par_name = initial_state_offset_symmetric ? GetNameNoSide( state_name ) : state_name;
+					m_State[ i ] += par.get( par_name + ".offset", *initial_state_offset );
+				}
+			}
+		}
+
+		// apply and fix state
+		if ( !initial_load_dof.empty() && initial_load > 0 && !GetContactGeometries().empty() )
+		{
+			CopyStateToTk();
+			FixTkState( initial_load * GetBW() );
+			CopyStateFromTk();
+		}
+	}
+
+	void ModelOpenSim4::InitManager()
+	{
+		SCONE_PROFILE_SCOPE( GetProfiler(), "RealizeSystem" );
+		// Create a manager to run the simulation. Can change manager options to save run time and memory or print more information
+		m_pOsimManager = std::make_unique<OpenSim::Manager>( *m_pOsimModel );
+		m_pOsimManager->setWriteToStorage( false );
+		m_pOsimManager->setPerformAnalyses( false );
+		//m_pOsimManager->setInitialTime( 0.0 );
+		//m_pOsimManager->setFinalTime( 0.0 );
+
+		m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
+	}
+
 	void ModelOpenSim4::InitStateFromTk()
 	{
 		SCONE_ASSERT( GetState().GetSize() == 0 );
@@ -856,6 +919,7 @@ namespace scone
 
 	void ModelOpenSim4::CopyStateToTk()
 	{
+		InvalidateMuscleSnapshot();
 		SCONE_ASSERT( m_State.GetSize() >= GetOsimModel().getNumStateVariables() );
 		GetOsimModel().setStateVariableValues( GetTkState(),
 			SimTK::Vector( static_cast<int>( m_State.GetSize() ), &m_State.GetValues()[ 0 ] ) );
@@ -896,6 +960,7 @@ namespace scone
 
 	void ModelOpenSim4::UpdateStateFromDofs()
 	{
+		InvalidateMuscleSnapshot();
 		CopyStateFromTk();
 		m_pOsimModel->getMultibodySystem().realize( GetTkState(), SimTK::Stage::Acceleration );
 		InitializeController();
@@ -935,6 +1000,7 @@ namespace scone
 
 	void ModelOpenSim4::InitializeOpenSimMuscleActivations( double override_activation )
 	{
+		InvalidateMuscleSnapshot();
 		for ( auto iter = GetMuscles().begin(); iter != GetMuscles().end(); ++iter )
 		{
 			OpenSim::Muscle& osmus = dynamic_cast<MuscleOpenSim4*>( *iter )->GetOsMuscle();
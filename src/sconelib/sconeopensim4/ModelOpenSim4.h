@@ -109,7 +109,7 @@ namespace scone
 		const SimTK::Integrator& GetTkIntegrator() const { return *m_pTkIntegrator; }
 		SimTK::State& GetTkState() { return *m_pTkState; }
 		const SimTK::State& GetTkState() const { return *m_pTkState; }
-		void SetTkState( SimTK::State& s ) { m_pTkState = &s; }
+		void SetTkState( SimTK::State& s ) { m_pTkState = &s; InvalidateMuscleSnapshot(); }
 
 		virtual const String& GetName() const override;
 
@@ -127,11 +127,15 @@ namespace scone
 		void InitializeOpenSimMuscleActivations( double override_activation = 0.0 );
 		void InitializeController();
 		virtual void UpdateStateFromDofs() override;
+		virtual bool Reset( const PropNode& props, Params& par ) override;
+		virtual bool CanReset() const override { return m_CanReset; }
 
 		static String GetOpenSimBuildVersion();
 
 	private:
 		void InitStateFromTk();
+		void InitStateFromParams( Params& par );
+		void InitManager();
 		void CopyStateFromTk();
 		void CopyStateToTk();
 		index_t FindStateIndex( const String& state_name, int version );
@@ -157,6 +161,9 @@ namespace scone
 		ControllerDispatcher* m_pControllerDispatcher; // owned by OpenSim::Model
 
 		State m_State; // model state
+		std::unique_ptr< SimTK::State > m_pInitialTkState; // state before applying parameters, used by Reset()
+		std::vector< Real > m_InitialStateValues;
+		bool m_CanReset;
 		int m_PrevIntStep;
 		double m_PrevTime;
 		TimeInSeconds m_EndTime;
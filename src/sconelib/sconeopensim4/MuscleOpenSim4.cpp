@@ -29,7 +29,6 @@ namespace scone
 	MuscleOpenSim4::MuscleOpenSim4( ModelOpenSim4& model, OpenSim::Muscle& mus ) :
 		m_Model( model ),
 		m_osMus( mus ),
-		m_MomentArmCacheTimeStamp( -1 ),
 		m_MinActivation( xo::constantsd::lowest() ) // will be set correctly below
 	{
 		InitJointsDofs();
@@ -62,6 +61,8 @@ namespace scone
 
 	Real MuscleOpenSim4::GetForce() const
 	{
+		if ( auto* s = GetValidSnapshot() )
+			return s->force[ m_SnapshotIndex ];
 		// OpenSim: why can't I just use getWorkingState()?
 		// OpenSim: why must I update to Dynamics for getForce()?
 		m_Model.GetOsimModel().getMultibodySystem().realize( m_Model.GetTkState(), SimTK::Stage::Velocity );
@@ -76,12 +77,16 @@ namespace scone
 
 	Real MuscleOpenSim4::GetLength() const
 	{
+		if ( auto* s = GetValidSnapshot() )
+			return s->length[ m_SnapshotIndex ];
 		m_Model.GetOsimModel().getMultibodySystem().realize( m_Model.GetTkState(), SimTK::Stage::Position );
 		return m_osMus.getLength( m_Model.GetTkState() );
 	}
 
 	Real MuscleOpenSim4::GetVelocity() const
 	{
+		if ( auto* s = GetValidSnapshot() )
+			return s->velocity[ m_SnapshotIndex ];
 		m_Model.GetOsimModel().getMultibodySystem().realize( m_Model.GetTkState(), SimTK::Stage::Velocity );
 		return m_osMus.getLengtheningSpeed( m_Model.GetTkState() );
 	}
@@ -103,11 +108,15 @@ namespace scone
 
 	Real MuscleOpenSim4::GetFiberLength() const
 	{
+		if ( auto* s = GetValidSnapshot() )
+			return s->fiber_length[ m_SnapshotIndex ];
 		return m_osMus.getFiberLength( m_Model.GetTkState() );
 	}
 
 	Real MuscleOpenSim4::GetNormalizedFiberLength() const
 	{
+		if ( auto* s = GetValidSnapshot() )
+			return s->fiber_length[ m_SnapshotIndex ] / m_osMus.getOptimalFiberLength();
 		m_Model.GetOsimModel().getMultibodySystem().realize( m_Model.GetTkState(), SimTK::Stage::Position );
 		return m_osMus.getNormalizedFiberLength( m_Model.GetTkState() );
 	}
@@ -119,12 +128,14 @@ namespace scone
 
 	Real MuscleOpenSim4::GetFiberVelocity() const
 	{
+		if ( auto* s = GetValidSnapshot() )
+			return s->fiber_velocity[ m_SnapshotIndex ];
 		return m_osMus.getFiberVelocity( m_Model.GetTkState() );
 	}
 
 	Real MuscleOpenSim4::GetNormalizedFiberVelocity() const
 	{
-		return m_osMus.getFiberVelocity( m_Model.GetTkState() ) / m_osMus.getOptimalFiberLength();
+		return GetFiberVelocity() / m_osMus.getOptimalFiberLength();
 	}
 
 	const Body& MuscleOpenSim4::GetOriginBody() const
@@ -139,38 +150,30 @@ namespace scone
 		return *FindByName( m_Model.GetBodies(), pps.get( pps.getSize() - 1 ).getBodyName() );
 	}
 
-	Real MuscleOpenSim4::GetMomentArm( const Dof& dof ) const
+	Real MuscleOpenSim4::ComputeMomentArm( const Dof& dof ) const
 	{
-		auto t = GetModel().GetTime();
-		if ( m_MomentArmCacheTimeStamp != t )
-		{
-			for ( auto& d : GetDofs() )
-			{
-				const DofOpenSim4& dof_sb = dynamic_cast<const DofOpenSim4&>( *d );
-				auto mom = m_osMus.getGeometryPath().computeMomentArm( m_Model.GetTkState(), dof_sb.GetOsCoordinate() );
-				if ( fabs( mom ) < MOMENT_ARM_EPSILON || dof_sb.GetOsCoordinate().getLocked( m_Model.GetTkState() ) )
-					mom = 0;
-				m_MomentArmCache[ &dof ] = mom;
-			}
-		}
-
-		return m_MomentArmCache[ &dof ];
+		const DofOpenSim4& dof_sb = dynamic_cast<const DofOpenSim4&>( dof );
+		auto mom = m_osMus.getGeometryPath().computeMomentArm( m_Model.GetTkState(), dof_sb.GetOsCoordinate() );
+		if ( fabs( mom ) < MOMENT_ARM_EPSILON || dof_sb.GetOsCoordinate().getLocked( m_Model.GetTkState() ) )
+			mom = 0;
+		return mom;
 	}
 
 	void MuscleOpenSim4::StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const
 	{
-		Muscle::StoreData( frame, flags );
+		Muscle::StoreData( frame, flags ); // also begins m_StoreDataChannels
 		if ( flags.get<StoreDataTypes::DebugData>() )
 		{
+			auto& ch = m_StoreDataChannels;
 			auto f_t = m_osMus.getTendonForce( m_Model.GetTkState() ) / m_osMus.getCosPennationAngle( m_Model.GetTkState() ) / m_osMus.getMaxIsometricForce();
 			auto f_pe = m_osMus.getPassiveFiberForce( m_Model.GetTkState() ) / m_osMus.getMaxIsometricForce();
 			auto f_ce = m_osMus.getActiveForceLengthMultiplier( m_Model.GetTkState() ) * m_osMus.getActivation( m_Model.GetTkState() );
-			frame[ GetName() + ".inv_ce_vel" ] = ( f_t - f_pe ) / f_ce;
-			frame[ GetName() + ".ce_vel_norm" ] = m_osMus.getNormalizedFiberVelocity( m_Model.GetTkState() );
-			frame[ GetName() + ".ce_vel" ] = m_osMus.getFiberVelocity( m_Model.GetTkState() );
-			frame[ GetName() + ".inv_ce_vel_ft" ] = f_t;
-			frame[ GetName() + ".inv_ce_vel_fpe" ] = f_pe;
-			frame[ GetName() + ".inv_ce_vel_fce" ] = f_ce;
+			ch.Set( GetName(), ".inv_ce_vel", ( f_t - f_pe ) / f_ce );
+			ch.Set( GetName(), ".ce_vel_norm", m_osMus.getNormalizedFiberVelocity( m_Model.GetTkState() ) );
+			ch.Set( GetName(), ".ce_vel", m_osMus.getFiberVelocity( m_Model.GetTkState() ) );
+			ch.Set( GetName(), ".inv_ce_vel_ft", f_t );
+			ch.Set( GetName(), ".inv_ce_vel_fpe", f_pe );
+			ch.Set( GetName(), ".inv_ce_vel_fce", f_ce );
 		}
 	}
 
@@ -222,6 +225,8 @@ namespace scone
 
 	Real MuscleOpenSim4::GetActivation() const
 	{
+		if ( auto* s = GetValidSnapshot() )
+			return s->activation[ m_SnapshotIndex ];
 		return m_osMus.getActivation( m_Model.GetTkState() );
 	}
 
@@ -240,6 +245,7 @@ namespace scone
 
 	void MuscleOpenSim4::InitializeActivation( Real a )
 	{
+		m_Model.InvalidateMuscleSnapshot();
 		m_osMus.setExcitation( m_Model.GetTkState(), a );
 		m_osMus.setActivation( m_Model.GetTkState(), a );
 	}
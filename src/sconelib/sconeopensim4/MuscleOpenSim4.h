@@ -76,7 +76,7 @@ namespace scone
 		OpenSim::Muscle& GetOsMuscle() { return m_osMus; }
 
 		virtual const String& GetName() const override;
-		virtual Real GetMomentArm( const Dof& dof ) const override;
+		virtual Real ComputeMomentArm( const Dof& dof ) const override;
 
 		void StoreData( Storage<Real>::Frame& frame, const StoreDataFlags& flags ) const override;
 
@@ -84,7 +84,5 @@ namespace scone
 		ModelOpenSim4& m_Model;
 		OpenSim::Muscle& m_osMus;
 		double m_MinActivation;
-		mutable TimeInSeconds m_MomentArmCacheTimeStamp;
-		mutable xo::flat_map< const Dof*, Real > m_MomentArmCache;
 	};
 }
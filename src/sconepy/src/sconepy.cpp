@@ -1,5 +1,6 @@
 #include "sconepy.h"
 #include "sconepy_tools.h"
+#include "sconepy_vec_model.h"
 
 #include "scone/core/version.h"
 #include "xo/system/log_sink.h"
@@ -20,6 +21,16 @@ PYBIND11_MODULE( sconepy, m ) {
 	m.def( "set_log_level", []( int l ) { console_sink.set_log_level( xo::log::level( l ) ); } );
 	m.def( "evaluate_par_file", &scone::evaluate_par_file );
 	m.def( "load_model", &scone::load_model );
+	m.def( "observation_channels", &scone::get_observation_channel_names );
+
+	// layouts for the Model array accessors, which fill the array passed as 'into' (float32 or float64) or return a new array
+	static const scone::observation_layout dof_value_layout( { "dof_pos", "dof_vel" } );
+	static const scone::observation_layout actuator_input_layout( { "actuator_input" } );
+	static const scone::observation_layout muscle_fiber_length_layout( { "muscle_fiber_length" } );
+	static const scone::observation_layout muscle_fiber_velocity_layout( { "muscle_fiber_velocity" } );
+	static const scone::observation_layout muscle_force_layout( { "muscle_force" } );
+	static const scone::observation_layout muscle_activation_layout( { "muscle_activation" } );
+	static const scone::observation_layout muscle_excitation_layout( { "muscle_excitation" } );
 
 	py::class_<scone::Vec3>( m, "Vec3" )
 		.def_readwrite( "x", &scone::Vec3::x )
@@ -114,17 +125,53 @@ PYBIND11_MODULE( sconepy, m ) {
 		.def( "actuators", []( scone::Model& m ) { return &m.GetActuators(); }, py::return_value_policy::reference )
 		.def( "set_actuator_inputs", &scone::set_actuator_values )
 		.def( "muscles", []( scone::Model& m ) { return &m.GetMuscles(); }, py::return_value_policy::reference )
-		.def( "dof_value_array", []( scone::Model& m ) { return py::array( py::cast( scone::get_dof_values<double>( m ) ) ); } )
-		.def( "actuator_input_array", []( scone::Model& m ) { return py::array( py::cast( scone::get_actuator_values<double>( m ) ) ); } )
-		.def( "muscle_fiber_length_array", []( scone::Model& m ) { return py::array( py::cast( scone::get_muscle_lengths<double>( m ) ) ); } )
-		.def( "muscle_fiber_velocity_array", []( scone::Model& m ) { return py::array( py::cast( scone::get_muscle_velocities<double>( m ) ) ); } )
-		.def( "muscle_force_array", []( scone::Model& m ) { return py::array( py::cast( scone::get_muscle_forces<double>( m ) ) ); } )
-		.def( "muscle_activation_array", []( scone::Model& m ) { return py::array( py::cast( scone::get_muscle_activations<double>( m ) ) ); } )
-		.def( "muscle_excitation_array", []( scone::Model& m ) { return py::array( py::cast( scone::get_muscle_excitations<double>( m ) ) ); } )
+		.def( "dof_value_array", []( scone::Model& m, py::object into ) { return dof_value_layout.observe( m, into ); }, py::arg( "into" ) = py::none() )
+		.def( "actuator_input_array", []( scone::Model& m, py::object into ) { return actuator_input_layout.observe( m, into ); }, py::arg( "into" ) = py::none() )
+		.def( "muscle_fiber_length_array", []( scone::Model& m, py::object into ) { return muscle_fiber_length_layout.observe( m, into ); }, py::arg( "into" ) = py::none() )
+		.def( "muscle_fiber_velocity_array", []( scone::Model& m, py::object into ) { return muscle_fiber_velocity_layout.observe( m, into ); }, py::arg( "into" ) = py::none() )
+		.def( "muscle_force_array", []( scone::Model& m, py::object into ) { return muscle_force_layout.observe( m, into ); }, py::arg( "into" ) = py::none() )
+		.def( "muscle_activation_array", []( scone::Model& m, py::object into ) { return muscle_activation_layout.observe( m, into ); }, py::arg( "into" ) = py::none() )
+		.def( "muscle_excitation_array", []( scone::Model& m, py::object into ) { return muscle_excitation_layout.observe( m, into ); }, py::arg( "into" ) = py::none() )
+		.def( "observe", []( scone::Model& m, const scone::observation_layout& layout, py::object into ) { return layout.observe( m, into ); }, py::arg( "layout" ), py::arg( "into" ) = py::none() )
 		.def( "init_muscle_activations", &scone::init_muscle_activations )
 		.def( "advance_simulation_to", &scone::Model::AdvanceSimulationTo )
 		.def( "time", &scone::Model::GetTime )
 		.def( "set_store_data", &scone::Model::SetStoreData )
 		.def( "write_results", &scone::write_results )
 		;
+
+	py::class_<scone::observation_layout>( m, "ObservationLayout" )
+		.def( py::init<const std::vector<std::string>&>() )
+		.def( "size", &scone::observation_layout::size )
+		.def( "channels", &scone::observation_layout::channels )
+		;
+
+	// forwards attributes to the current model at its index, models may be re-created during reset
+	py::class_<scone::VecModel::model_ref>( m, "VecModelRef" )
+		.def( "__getattr__", []( py::object self, const std::string& name ) {
+			auto& ref = self.cast<scone::VecModel::model_ref&>();
+			return py::cast( &ref.get(), py::return_value_policy::reference_internal, self ).attr( name.c_str() );
+		} )
+		;
+
+	py::class_<scone::VecModel>( m, "VecModel" )
+		.def( py::init<const std::string&, size_t, size_t, bool>(), py::arg( "file" ), py::arg( "count" ), py::arg( "threads" ) = 0, py::arg( "auto_reset" ) = true )
+		.def( "size", &scone::VecModel::size )
+		.def( "model", &scone::VecModel::model_handle, py::keep_alive<0, 1>() )
+		.def( "step", &scone::VecModel::step, py::call_guard<py::gil_scoped_release>() )
+		.def( "reset", &scone::VecModel::reset, py::call_guard<py::gil_scoped_release>() )
+		.def( "reset_model", &scone::VecModel::reset_model, py::call_guard<py::gil_scoped_release>() )
+		.def( "set_simulation_end_time", &scone::VecModel::set_simulation_end_time )
+		.def( "set_actuator_inputs", &scone::VecModel::set_actuator_inputs )
+		.def( "actuator_input_array", &scone::VecModel::actuator_input_array )
+		.def( "dof_value_array", &scone::VecModel::dof_value_array )
+		.def( "muscle_fiber_length_array", &scone::VecModel::muscle_fiber_length_array )
+		.def( "muscle_fiber_velocity_array", &scone::VecModel::muscle_fiber_velocity_array )
+		.def( "muscle_force_array", &scone::VecModel::muscle_force_array )
+		.def( "muscle_activation_array", &scone::VecModel::muscle_activation_array )
+		.def( "com_pos_array", &scone::VecModel::com_pos_array )
+		.def( "com_vel_array", &scone::VecModel::com_vel_array )
+		.def( "time_array", &scone::VecModel::time_array )
+		.def( "terminated_array", &scone::VecModel::terminated_array )
+		;
 }
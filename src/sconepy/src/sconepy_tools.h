@@ -12,6 +12,7 @@
 #include "spot/par_io.h"
 #include "scone/model/Muscle.h"
 #include "scone/model/Dof.h"
+#include "scone/model/Body.h"
 
 namespace fs = std::filesystem;
 
@@ -117,9 +118,108 @@ namespace scone
 	};
 
 	py::array get_muscle_lengths( const scone::Model& model, bool dbl ) {
-		return py::array( py::cast( dbl ? get_muscle_lengths<double>( model ) : get_muscle_lengths<double>( model ) ) );
+		return dbl ? py::array( py::cast( get_muscle_lengths<double>( model ) ) ) : py::array( py::cast( get_muscle_lengths<float>( model ) ) );
 	};
 
+	// writes values to a contiguous float32 or float64 array
+	struct array_writer {
+		float* f = nullptr;
+		double* d = nullptr;
+		void operator()( double v ) { if ( f ) *f++ = static_cast<float>( v ); else *d++ = v; }
+		void operator()( const Vec3& v ) { ( *this )( v.x ); ( *this )( v.y ); ( *this )( v.z ); }
+		void operator()( const Quat& q ) { ( *this )( q.w ); ( *this )( q.x ); ( *this )( q.y ); ( *this )( q.z ); }
+	};
+
+	// fills into (if not None) or a new float64 array with size values, using gather( array_writer& )
+	template< typename F > py::array write_array( size_t size, const py::object& into, F gather ) {
+		if ( into.is_none() ) {
+			py::array_t<double> a( size );
+			array_writer w{ nullptr, a.mutable_data() };
+			gather( w );
+			return std::move( a );
+		}
+		auto a = into.cast<py::array>();
+		SCONE_ERROR_IF( !( a.flags() & py::array::c_style ), "Array must be C-contiguous" );
+		check_array_length( size, a.size() );
+		array_writer w;
+		if ( py::isinstance<py::array_t<float>>( a ) )
+			w.f = static_cast<float*>( a.mutable_data() );
+		else if ( py::isinstance<py::array_t<double>>( a ) )
+			w.d = static_cast<double*>( a.mutable_data() );
+		else SCONE_THROW( "Array must be of type float32 or float64" );
+		gather( w );
+		return a;
+	}
+
+	// model quantity that can be part of an observation, muscle values are normalized
+	struct observation_channel {
+		const char* name;
+		size_t( *size )( const Model& );
+		void( *gather )( const Model&, array_writer& );
+	};
+
+	const std::vector<observation_channel>& get_observation_channels() {
+		static const std::vector<observation_channel> channels = {
+			{ "dof_pos", []( const Model& m ) { return m.GetDofs().size(); }, []( const Model& m, array_writer& w ) { for ( auto* d : m.GetDofs() ) w( d->GetPos() ); } },
+			{ "dof_vel", []( const Model& m ) { return m.GetDofs().size(); }, []( const Model& m, array_writer& w ) { for ( auto* d : m.GetDofs() ) w( d->GetVel() ); } },
+			{ "muscle_fiber_length", []( const Model& m ) { return m.GetMuscles().size(); }, []( const Model& m, array_writer& w ) { for ( auto* mus : m.GetMuscles() ) w( mus->GetNormalizedFiberLength() ); } },
+			{ "muscle_fiber_velocity", []( const Model& m ) { return m.GetMuscles().size(); }, []( const Model& m, array_writer& w ) { for ( auto* mus : m.GetMuscles() ) w( mus->GetNormalizedFiberVelocity() ); } },
+			{ "muscle_force", []( const Model& m ) { return m.GetMuscles().size(); }, []( const Model& m, array_writer& w ) { for ( auto* mus : m.GetMuscles() ) w( mus->GetNormalizedForce() ); } },
+			{ "muscle_activation", []( const Model& m ) { return m.GetMuscles().size(); }, []( const Model& m, array_writer& w ) { for ( auto* mus : m.GetMuscles() ) w( mus->GetActivation() ); } },
+			{ "muscle_excitation", []( const Model& m ) { return m.GetMuscles().size(); }, []( const Model& m, array_writer& w ) { for ( auto* mus : m.GetMuscles() ) w( mus->GetExcitation() ); } },
+			{ "actuator_input", []( const Model& m ) { return m.GetActuators().size(); }, []( const Model& m, array_writer& w ) { for ( auto* a : m.GetActuators() ) w( a->GetInput() ); } },
+			{ "body_com_pos", []( const Model& m ) { return 3 * m.GetBodies().size(); }, []( const Model& m, array_writer& w ) { for ( auto* b : m.GetBodies() ) w( b->GetComPos() ); } },
+			{ "body_com_vel", []( const Model& m ) { return 3 * m.GetBodies().size(); }, []( const Model& m, array_writer& w ) { for ( auto* b : m.GetBodies() ) w( b->GetComVel() ); } },
+			{ "body_orientation", []( const Model& m ) { return 4 * m.GetBodies().size(); }, []( const Model& m, array_writer& w ) { for ( auto* b : m.GetBodies() ) w( b->GetOrientation() ); } },
+			{ "body_ang_vel", []( const Model& m ) { return 3 * m.GetBodies().size(); }, []( const Model& m, array_writer& w ) { for ( auto* b : m.GetBodies() ) w( b->GetAngVel() ); } },
+			{ "com_pos", []( const Model& m ) { return size_t( 3 ); }, []( const Model& m, array_writer& w ) { w( m.GetComPos() ); } },
+			{ "com_vel", []( const Model& m ) { return size_t( 3 ); }, []( const Model& m, array_writer& w ) { w( m.GetComVel() ); } },
+			{ "time", []( const Model& m ) { return size_t( 1 ); }, []( const Model& m, array_writer& w ) { w( m.GetTime() ); } },
+		};
+		return channels;
+	}
+
+	// list of observation channels, resolved once and gathered in a single call
+	class observation_layout {
+	public:
+		observation_layout( const std::vector<std::string>& names ) {
+			const auto& channels = get_observation_channels();
+			for ( const auto& name : names ) {
+				auto it = std::find_if( channels.begin(), channels.end(), [&]( const observation_channel& c ) { return name == c.name; } );
+				SCONE_ERROR_IF( it == channels.end(), "Unknown observation channel: " + name );
+				channels_.push_back( &*it );
+			}
+		}
+		size_t size( const Model& m ) const {
+			size_t s = 0;
+			for ( auto* c : channels_ )
+				s += c->size( m );
+			return s;
+		}
+		std::vector<std::string> channels() const {
+			std::vector<std::string> names;
+			for ( auto* c : channels_ )
+				names.emplace_back( c->name );
+			return names;
+		}
+		py::array observe( const Model& m, const py::object& into ) const {
+			return write_array( size( m ), into, [&]( array_writer& w ) {
+				for ( auto* c : channels_ )
+					c->gather( m, w );
+			} );
+		}
+
+	private:
+		std::vector<const observation_channel*> channels_;
+	};
+
+	std::vector<std::string> get_observation_channel_names() {
+		std::vector<std::string> names;
+		for ( const auto& c : get_observation_channels() )
+			names.emplace_back( c.name );
+		return names;
+	}
+
 	fs::path to_fs( const xo::path& p ) { return fs::path( p.str() ); }
 
 	void write_results( const scone::Model& m, std::string f ) {
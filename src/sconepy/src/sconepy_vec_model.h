@@ -0,0 +1,298 @@
+#pragma once
+
+#include "sconepy.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "xo/filesystem/path.h"
+#include "xo/serialization/prop_node_serializer_zml.h"
+#include "scone/core/Exception.h"
+#include "scone/core/Factories.h"
+#include "scone/model/Model.h"
+#include "scone/model/Actuator.h"
+#include "scone/model/Muscle.h"
+#include "scone/model/Dof.h"
+#include "spot/par_io.h"
+
+namespace scone
+{
+	// runs a loop body on persistent threads, the calling thread also participates
+	class parallel_loop
+	{
+	public:
+		parallel_loop( size_t thread_count ) {
+			for ( size_t i = 1; i < thread_count; ++i )
+				threads_.emplace_back( [this]() { worker(); } );
+		}
+		~parallel_loop() {
+			{
+				std::scoped_lock lock( mutex_ );
+				stop_ = true;
+			}
+			start_cv_.notify_all();
+			for ( auto& t : threads_ )
+				t.join();
+		}
+
+		// call fn( i ) for i in [0, n), rethrows the first exception after all iterations have finished
+		void run( size_t n, const std::function<void( size_t )>& fn ) {
+			{
+				std::scoped_lock lock( mutex_ );
+				fn_ = &fn;
+				count_ = n;
+				next_ = 0;
+				busy_ = threads_.size();
+				error_ = nullptr;
+				++generation_;
+			}
+			start_cv_.notify_all();
+			process();
+			std::unique_lock lock( mutex_ );
+			done_cv_.wait( lock, [this]() { return busy_ == 0; } );
+			fn_ = nullptr;
+			if ( error_ )
+				std::rethrow_exception( error_ );
+		}
+
+	private:
+		void worker() {
+			size_t generation = 0;
+			for ( ;; ) {
+				{
+					std::unique_lock lock( mutex_ );
+					start_cv_.wait( lock, [&]() { return stop_ || generation_ != generation; } );
+					if ( stop_ )
+						return;
+					generation = generation_;
+				}
+				process();
+				{
+					std::scoped_lock lock( mutex_ );
+					--busy_;
+				}
+				done_cv_.notify_one();
+			}
+		}
+		void process() {
+			for ( auto i = next_++; i < count_; i = next_++ ) {
+				try { ( *fn_ )( i ); }
+				catch ( ... ) {
+					std::scoped_lock lock( mutex_ );
+					if ( !error_ )
+						error_ = std::current_exception();
+				}
+			}
+		}
+
+		std::vector<std::thread> threads_;
+		std::mutex mutex_;
+		std::condition_variable start_cv_;
+		std::condition_variable done_cv_;
+		const std::function<void( size_t )>* fn_ = nullptr;
+		size_t count_ = 0;
+		std::atomic<size_t> next_ = 0;
+		size_t busy_ = 0;
+		size_t generation_ = 0;
+		bool stop_ = false;
+		std::exception_ptr error_;
+	};
+
+	// N models built from the same scenario, stepped in parallel
+	// observations and actions use preallocated (N, k) numpy arrays, which are returned without copying
+	class VecModel
+	{
+	public:
+		VecModel( const std::string& file, size_t count, size_t thread_count, bool auto_reset ) :
+			file_( file ),
+			model_pn_( xo::load_zml( file_ ) ),
+			model_fp_( FindFactoryProps( GetModelFactory(), model_pn_, "Model" ) ),
+			models_( count ),
+			auto_reset_( auto_reset ),
+			end_time_( std::numeric_limits<double>::quiet_NaN() ),
+			loop_( thread_count > 0 ? thread_count : std::max( 1u, std::thread::hardware_concurrency() ) )
+		{
+			SCONE_ERROR_IF( count == 0, "VecModel requires at least one model" );
+			loop_.run( count, [this]( size_t i ) { models_[ i ] = create_model(); } );
+
+			const auto& m = *models_.front();
+			dof_count_ = m.GetDofs().size();
+			actuator_count_ = m.GetActuators().size();
+			auto muscle_count = m.GetMuscles().size();
+
+			dof_values_ = buffer<double>( count, 2 * dof_count_ );
+			muscle_fiber_length_ = buffer<double>( count, muscle_count );
+			muscle_fiber_velocity_ = buffer<double>( count, muscle_count );
+			muscle_force_ = buffer<double>( count, muscle_count );
+			muscle_activation_ = buffer<double>( count, muscle_count );
+			com_pos_ = buffer<double>( count, 3 );
+			com_vel_ = buffer<double>( count, 3 );
+			actuator_inputs_ = buffer<double>( count, actuator_count_ );
+			time_ = buffer<double>( count );
+			terminated_ = buffer<bool>( count );
+
+			std::fill( actuator_inputs_.data, actuator_inputs_.data + count * actuator_count_, 0.0 );
+			for ( size_t i = 0; i < count; ++i ) {
+				*terminated_.row( i ) = false;
+				update_observations( i );
+			}
+		}
+		VecModel( const VecModel& ) = delete;
+		VecModel& operator=( const VecModel& ) = delete;
+
+		// refers to a model by index, so it remains valid when the model is replaced during a reset
+		struct model_ref {
+			VecModel* vec_model;
+			size_t index;
+			Model& get() const { return vec_model->model( index ); }
+		};
+
+		size_t size() const { return models_.size(); }
+		Model& model( size_t i ) { return *models_.at( i ); }
+		model_ref model_handle( size_t i ) {
+			SCONE_ERROR_IF( i >= models_.size(), "Invalid model index" );
+			return model_ref{ this, i };
+		}
+
+		// apply actuator inputs, advance all models by dt and update observations
+		// terminated models are reset if auto_reset is enabled, their observations are from after the reset
+		void step( double dt ) {
+			loop_.run( models_.size(), [this, dt]( size_t i ) {
+				auto& m = *models_[ i ];
+				const auto* input = actuator_inputs_.row( i );
+				for ( auto* act : m.GetActuators() ) {
+					act->ClearInput();
+					act->AddInput( *input++ );
+				}
+				m.AdvanceSimulationTo( m.GetTime() + dt );
+				bool terminated = m.HasSimulationEnded();
+				*terminated_.row( i ) = terminated;
+				if ( terminated && auto_reset_ )
+					reset_model_impl( i );
+				update_observations( i );
+			} );
+		}
+
+		// reset all models and update observations
+		void reset() {
+			loop_.run( models_.size(), [this]( size_t i ) { reset_model( i ); } );
+		}
+
+		// reset a single model, the model is re-created if it does not support Reset()
+		// references to the model itself may become invalid, model_ref handles refer to the new model
+		void reset_model( size_t i ) {
+			SCONE_ERROR_IF( i >= models_.size(), "Invalid model index" );
+			reset_model_impl( i );
+			*terminated_.row( i ) = false;
+			update_observations( i );
+		}
+
+		void set_simulation_end_time( double t ) {
+			end_time_ = t;
+			for ( auto& m : models_ )
+				m->SetSimulationEndTime( t );
+		}
+
+		void set_actuator_inputs( const py::array_t<double, py::array::c_style | py::array::forcecast>& values ) {
+			SCONE_ERROR_IF( values.ndim() != 2 || size_t( values.shape( 0 ) ) != models_.size() || size_t( values.shape( 1 ) ) != actuator_count_,
+				stringf( "Invalid array shape; expected (%d, %d)", models_.size(), actuator_count_ ) );
+			std::copy( values.data(), values.data() + values.size(), actuator_inputs_.data );
+		}
+
+		py::array_t<double> dof_value_array() const { return dof_values_.array; }
+		py::array_t<double> muscle_fiber_length_array() const { return muscle_fiber_length_.array; }
+		py::array_t<double> muscle_fiber_velocity_array() const { return muscle_fiber_velocity_.array; }
+		py::array_t<double> muscle_force_array() const { return muscle_force_.array; }
+		py::array_t<double> muscle_activation_array() const { return muscle_activation_.array; }
+		py::array_t<double> com_pos_array() const { return com_pos_.array; }
+		py::array_t<double> com_vel_array() const { return com_vel_.array; }
+		py::array_t<double> actuator_input_array() const { return actuator_inputs_.array; }
+		py::array_t<double> time_array() const { return time_.array; }
+		py::array_t<bool> terminated_array() const { return terminated_.array; }
+
+	private:
+		// numpy array with (N, k) or (N) layout, data is accessed without the GIL through a pointer obtained at construction
+		template< typename T > struct buffer {
+			buffer() = default;
+			buffer( size_t rows, size_t columns ) : array( { rows, columns } ), data( array.mutable_data() ), columns( columns ) {}
+			buffer( size_t rows ) : array( rows ), data( array.mutable_data() ), columns( 1 ) {}
+			T* row( size_t i ) const { return data + i * columns; }
+			py::array_t<T> array;
+			T* data = nullptr;
+			size_t columns = 0;
+		};
+
+		ModelUP create_model() const {
+			spot::null_objective_info par;
+			auto model = CreateModel( model_fp_, par, file_.parent_path() );
+			model->AddExternalResource( file_ );
+			if ( end_time_ == end_time_ )
+				model->SetSimulationEndTime( end_time_ );
+			return model;
+		}
+
+		void reset_model_impl( size_t i ) {
+			spot::null_objective_info par;
+			if ( !models_[ i ]->Reset( model_fp_.props(), par ) )
+				models_[ i ] = create_model();
+			else if ( end_time_ == end_time_ )
+				models_[ i ]->SetSimulationEndTime( end_time_ );
+		}
+
+		// write observations of model i, called from the parallel loop without holding the GIL
+		void update_observations( size_t i ) {
+			const auto& m = *models_[ i ];
+			auto* dv = dof_values_.row( i );
+			for ( const auto* d : m.GetDofs() )
+				*dv++ = d->GetPos();
+			for ( const auto* d : m.GetDofs() )
+				*dv++ = d->GetVel();
+
+			auto* fl = muscle_fiber_length_.row( i );
+			auto* fv = muscle_fiber_velocity_.row( i );
+			auto* f = muscle_force_.row( i );
+			auto* a = muscle_activation_.row( i );
+			for ( const auto* mus : m.GetMuscles() ) {
+				*fl++ = mus->GetNormalizedFiberLength();
+				*fv++ = mus->GetNormalizedFiberVelocity();
+				*f++ = mus->GetNormalizedForce();
+				*a++ = mus->GetActivation();
+			}
+
+			auto com_pos = m.GetComPos();
+			auto com_vel = m.GetComVel();
+			auto* cp = com_pos_.row( i );
+			auto* cv = com_vel_.row( i );
+			cp[ 0 ] = com_pos.x; cp[ 1 ] = com_pos.y; cp[ 2 ] = com_pos.z;
+			cv[ 0 ] = com_vel.x; cv[ 1 ] = com_vel.y; cv[ 2 ] = com_vel.z;
+			*time_.row( i ) = m.GetTime();
+		}
+
+		xo::path file_;
+		PropNode model_pn_;
+		FactoryProps model_fp_; // refers to model_pn_
+		std::vector<ModelUP> models_;
+		bool auto_reset_;
+		double end_time_;
+		size_t dof_count_ = 0;
+		size_t actuator_count_ = 0;
+
+		buffer<double> dof_values_;
+		buffer<double> muscle_fiber_length_;
+		buffer<double> muscle_fiber_velocity_;
+		buffer<double> muscle_force_;
+		buffer<double> muscle_activation_;
+		buffer<double> com_pos_;
+		buffer<double> com_vel_;
+		buffer<double> actuator_inputs_;
+		buffer<double> time_;
+		buffer<bool> terminated_;
+
+		parallel_loop loop_; // destroyed first, so no threads are running when the models are destroyed
+	};
+}
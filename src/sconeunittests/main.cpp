@@ -12,6 +12,7 @@
 #include "xo/system/test_case.h"
 #include "xo/serialization/prop_node_serializer_zml.h"
 #include "scenario_test.h"
+#include "storage_test.h"
 #include "xo/utility/arg_parser.h"
 #include "scone/core/version.h"
 
@@ -59,6 +60,9 @@ int main( int argc, const char* argv[] )
 		}
 #endif
 
+		if ( args.has_flag( "add-benchmarks" ) )
+			scone::add_storage_benchmark();
+
 		return xo::test::run_tests_async();
 	}
 	catch ( std::exception& e )
@@ -0,0 +1,437 @@
+/*
+** model_test.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "scone/sconelib_config.h"
+#include "scone/core/Factories.h"
+#include "scone/core/string_tools.h"
+#include "scone/core/system_tools.h"
+#include "scone/controllers/NeuralNetworkController.h"
+#include "scone/model/Dof.h"
+#include "scone/model/Model.h"
+#include "scone/model/MomentArmMatrix.h"
+#include "scone/model/Muscle.h"
+#include "scone/optimization/ModelObjective.h"
+#include "scone/optimization/opt_tools.h"
+#include "scone/optimization/ParamBindingPlan.h"
+
+#include "xo/filesystem/filesystem.h"
+#include "xo/system/test_case.h"
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+
+using namespace scone;
+
+namespace
+{
+	// creates the optimizer of an example scenario, with a shorter simulation duration
+	OptimizerUP CreateExampleOptimizer( const String& scenario, TimeInSeconds duration )
+	{
+		auto folder = GetFolder( SCONE_ROOT_FOLDER ) / "scenarios/Examples";
+		auto scenario_pn = LoadScenario( folder / scenario );
+		scenario_pn.set_query( "CmaOptimizer.SimulationObjective.max_duration", to_str( duration ), '.' );
+		return CreateOptimizer( scenario_pn, folder );
+	}
+
+	// returns true if both storages contain exactly the same data
+	bool HaveEqualData( const Storage<>& a, const Storage<>& b )
+	{
+		if ( a.GetLabels() != b.GetLabels() || a.GetFrameCount() != b.GetFrameCount() )
+			return false;
+		for ( index_t f = 0; f < a.GetFrameCount(); ++f )
+			for ( index_t c = 0; c < a.GetChannelCount(); ++c )
+				if ( a.GetValue( f, c ) != b.GetValue( f, c ) )
+					return false;
+		return true;
+	}
+
+	// records the name and value of each parameter request during model construction
+	template< typename PointT > struct ParamRequestLog : public PointT
+	{
+		template< typename... Args > ParamRequestLog( Args&&... args ) : PointT( std::forward< Args >( args )... ) {}
+		virtual ParamBindingPoint::ParValue try_get( const String& name ) const override {
+			auto value = PointT::try_get( name );
+			requests.push_back( name + ( value ? stringf( "=%.17g", double( *value ) ) : String( " (none)" ) ) );
+			return value;
+		}
+		mutable std::vector< String > requests;
+	};
+
+	// muscle state read through the Muscle getters
+	std::vector< Real > GetMuscleValues( const Model& model )
+	{
+		std::vector< Real > values;
+		for ( const auto* mus : model.GetMuscles() )
+			values.insert( values.end(), { mus->GetForce(), mus->GetLength(), mus->GetVelocity(), mus->GetFiberLength(), mus->GetFiberVelocity(), mus->GetActivation() } );
+		return values;
+	}
+
+	// muscle state stored in a snapshot, in the same order as GetMuscleValues()
+	std::vector< Real > GetSnapshotValues( const MuscleSnapshot& s )
+	{
+		std::vector< Real > values;
+		for ( index_t i = 0; i < s.GetMuscleCount(); ++i )
+			values.insert( values.end(), { s.force[ i ], s.length[ i ], s.velocity[ i ], s.fiber_length[ i ], s.fiber_velocity[ i ], s.activation[ i ] } );
+		return values;
+	}
+
+	// per-neuron virtual update of NeuralNetworkController layers, as used before the update was instantiated per activation function
+	struct GenericOutputUpdater {
+		virtual ~GenericOutputUpdater() = default;
+		virtual void Update( std::vector<NN::Neuron>&, const double dt ) = 0;
+	};
+
+	template< typename F > struct GenericBasicOutputUpdater : public GenericOutputUpdater {
+		virtual void Update( std::vector<NN::Neuron>& nv, const double dt ) override {
+			for ( auto& n : nv )
+				n.output_ = F::update( n.input_ + n.offset_ );
+		}
+	};
+
+	template< typename F > struct GenericDynamicOutputUpdater : public GenericOutputUpdater {
+		GenericDynamicOutputUpdater( double act_rate, double deact_rate ) : act_rate_( act_rate ), deact_rate_( deact_rate ) {}
+		virtual void Update( std::vector<NN::Neuron>& nv, const double dt ) override {
+			for ( auto& n : nv ) {
+				auto ds = n.input_ + n.offset_ - n.sum_;
+				n.sum_ += dt * ds * ( ds > 0 ? act_rate_ : deact_rate_ );
+				n.output_ = F::update( n.sum_ );
+			}
+		}
+		double act_rate_, deact_rate_;
+	};
+
+	u_ptr< GenericOutputUpdater > MakeGenericOutputUpdater( const String& activation, double act_rate, double deact_rate )
+	{
+		if ( activation == "linear" ) return std::make_unique< GenericBasicOutputUpdater<NN::linear> >();
+		if ( activation == "relu" ) return std::make_unique< GenericBasicOutputUpdater<NN::relu> >();
+		if ( activation == "leaky_relu" ) return std::make_unique< GenericBasicOutputUpdater<NN::leaky_relu> >();
+		if ( activation == "tanh" ) return std::make_unique< GenericBasicOutputUpdater<NN::tanh> >();
+		if ( activation == "tanh_norm" ) return std::make_unique< GenericBasicOutputUpdater<NN::tanh_norm> >();
+		if ( activation == "tanh_norm_01" ) return std::make_unique< GenericBasicOutputUpdater<NN::tanh_norm_01> >();
+		if ( activation == "dyn_leaky_relu" ) return std::make_unique< GenericDynamicOutputUpdater<NN::leaky_relu> >( act_rate, deact_rate );
+		SCONE_ERROR( "Unknown activation function: " + activation );
+	}
+}
+
+XO_TEST_CASE( neural_network_output_update_test )
+{
+	// the layer update must give the same outputs as the generic per-neuron update, for all activation functions
+	const size_t neuron_count = 37, first_neuron = 5;
+	const double act_rate = 100.0, deact_rate = 25.0, dt = 0.001;
+	for ( String activation : { "linear", "relu", "leaky_relu", "tanh", "tanh_norm", "tanh_norm_01", "dyn_leaky_relu" } )
+	{
+		PropNode pn;
+		pn.set( "activation", activation );
+		pn.set( "act_rate", act_rate );
+		pn.set( "deact_rate", deact_rate );
+		auto updater = NN::make_update_function( pn, "relu" );
+		auto generic_updater = MakeGenericOutputUpdater( activation, act_rate, deact_rate );
+
+		// the layer starts at first_neuron, to check that neurons outside the layer are not updated
+		std::vector< NN::Neuron > neurons;
+		NN::NeuronArrays na;
+		na.resize( first_neuron + neuron_count );
+		for ( index_t i = 0; i < neuron_count; ++i )
+		{
+			neurons.emplace_back( 0.1 * std::sin( 3.0 * i ) );
+			na.offset_[ first_neuron + i ] = neurons.back().offset_;
+		}
+
+		bool equal = true;
+		for ( int step = 0; step < 20; ++step )
+		{
+			for ( index_t i = 0; i < neuron_count; ++i )
+				neurons[ i ].input_ = na.input_[ first_neuron + i ] = std::cos( 0.7 * i + 0.3 * step ) - 0.2;
+			generic_updater->Update( neurons, dt );
+			NN::UpdateOutputs( updater, na, first_neuron, first_neuron + neuron_count, dt );
+			for ( index_t i = 0; i < neuron_count; ++i )
+				equal &= na.output_[ first_neuron + i ] == neurons[ i ].output_ && na.sum_[ first_neuron + i ] == neurons[ i ].sum_;
+		}
+		for ( index_t i = 0; i < first_neuron; ++i )
+			equal &= na.output_[ i ] == 0.0 && na.sum_[ i ] == 0.0;
+		XO_CHECK_MESSAGE( equal, activation );
+	}
+}
+
+#if SCONE_OPENSIM_4_ENABLED
+
+XO_TEST_CASE( model_reset_test )
+{
+	auto opt = CreateExampleOptimizer( "Gait - H0918 - OpenSim4.scone", 0.5 );
+	auto& mo = dynamic_cast<ModelObjective&>( opt->GetObjective() );
+	auto par = SearchPoint( mo.info() );
+
+	auto fresh = mo.CreateModelFromParams( par );
+	fresh->SetStoreData( true );
+	mo.EvaluateModel( *fresh, xo::stop_token() );
+
+	// data stored after each reset must be identical to that of a new model
+	auto model = mo.CreateModelFromParams( par );
+	model->SetStoreData( true );
+	mo.EvaluateModel( *model, xo::stop_token() );
+	for ( int reset = 0; reset < 2; ++reset )
+	{
+		XO_CHECK( mo.ResetModelFromParams( *model, par ) );
+		mo.EvaluateModel( *model, xo::stop_token() );
+		XO_CHECK( HaveEqualData( model->GetData(), fresh->GetData() ) );
+		XO_CHECK( mo.GetResult( *model ) == mo.GetResult( *fresh ) );
+	}
+}
+
+XO_TEST_CASE( muscle_snapshot_test )
+{
+	auto opt = CreateExampleOptimizer( "Gait - H0918 - OpenSim4.scone", 0.5 );
+	auto& mo = dynamic_cast<ModelObjective&>( opt->GetObjective() );
+	auto par = SearchPoint( mo.info() );
+	auto model = mo.CreateModelFromParams( par );
+	const auto& snapshot = model->GetMuscleSnapshot();
+	auto& knee = *FindByName( model->GetDofs(), "knee_angle_r" );
+
+	// the snapshot must contain the same values as direct queries
+	auto check_snapshot = [&]() {
+		XO_CHECK( snapshot.IsValid() );
+		auto snapshot_values = GetSnapshotValues( snapshot );
+		XO_CHECK( GetMuscleValues( *model ) == snapshot_values );
+		model->InvalidateMuscleSnapshot();
+		XO_CHECK( GetMuscleValues( *model ) == snapshot_values );
+	};
+
+	model->AdvanceSimulationTo( 0.1 );
+	check_snapshot();
+
+	// changing the state invalidates the snapshot, until the next step
+	model->AdvanceSimulationTo( 0.2 );
+	XO_CHECK( snapshot.IsValid() );
+	knee.SetPos( knee.GetPos() + 0.1 );
+	XO_CHECK( !snapshot.IsValid() );
+	model->AdvanceSimulationTo( 0.3 );
+	check_snapshot();
+
+	model->AdvanceSimulationTo( 0.4 );
+	XO_CHECK( snapshot.IsValid() );
+	knee.SetVel( knee.GetVel() + 0.1 );
+	XO_CHECK( !snapshot.IsValid() );
+	model->AdvanceSimulationTo( 0.5 );
+	check_snapshot();
+}
+
+XO_TEST_CASE( moment_arm_matrix_test )
+{
+	auto opt = CreateExampleOptimizer( "Gait - H0918 - OpenSim4.scone", 0.5 );
+	auto& mo = dynamic_cast<ModelObjective&>( opt->GetObjective() );
+	auto par = SearchPoint( mo.info() );
+	auto model = mo.CreateModelFromParams( par );
+	model->AdvanceSimulationTo( 0.1 );
+	XO_CHECK( model->GetMuscleSnapshot().IsValid() );
+
+	const auto& muscles = model->GetMuscles();
+	const auto& dofs = model->GetDofs();
+	const auto& mam = model->GetMomentArmMatrix();
+	std::vector< Real > moment_arms, dof_moments;
+	for ( index_t mi = 0; mi < muscles.size(); ++mi )
+		for ( const auto* dof : dofs )
+			moment_arms.push_back( mam.GetMomentArm( mi, *dof ) );
+	for ( const auto* dof : dofs )
+		dof_moments.push_back( mam.GetMuscleMoment( *dof, model->GetMuscleSnapshot().force ) );
+
+	// compare with values computed by the muscles
+	model->InvalidateMuscleSnapshot();
+	index_t k = 0;
+	for ( const auto* mus : muscles )
+		for ( const auto* dof : dofs )
+			XO_CHECK( mus->GetMomentArm( *dof ) == moment_arms[ k++ ] );
+	for ( index_t di = 0; di < dofs.size(); ++di )
+	{
+		Real moment = 0.0;
+		for ( const auto* mus : muscles )
+			moment += mus->GetForce() * mus->GetMomentArm( *dofs[ di ] );
+		XO_CHECK_MESSAGE( std::abs( moment - dof_moments[ di ] ) <= 1e-9 * ( 1.0 + std::abs( moment ) ), dofs[ di ]->GetName() );
+	}
+}
+
+XO_TEST_CASE( param_binding_plan_test )
+{
+	auto opt = CreateExampleOptimizer( "Gait - H0918 - OpenSim4.scone", 0.5 );
+	auto& mo = dynamic_cast<ModelObjective&>( opt->GetObjective() );
+	std::vector< double > values;
+	for ( const auto& par : mo.info() )
+		values.push_back( par.mean + 0.1 * ( values.size() + 1 ) * par.std );
+	auto point = SearchPoint( mo.info(), values );
+
+	ParamRequestLog< SearchPoint > original( point );
+	mo.CreateModelFromParams( original );
+	XO_CHECK( !original.requests.empty() );
+
+	// the first construction records the plan, the second replays it
+	ParamBindingPlan plan( mo.info() );
+	for ( int i = 0; i < 2; ++i )
+	{
+		ParamRequestLog< ParamBindingPoint > bound( point, plan );
+		mo.CreateModelFromParams( bound );
+		bound.FinishConstruction();
+		XO_CHECK( plan.IsReady() );
+		XO_CHECK( bound.requests == original.requests );
+	}
+}
+
+XO_TEST_CASE( evaluation_pruning_test )
+{
+	auto opt = CreateExampleOptimizer( "Gait - H0918 - OpenSim4.scone", 1.0 );
+	auto& mo = dynamic_cast<ModelObjective&>( opt->GetObjective() );
+	const size_t point_count = 8, mu = 3;
+	const auto cost = [&]( fitness_t f ) { return mo.info().minimize() ? f : -f; };
+
+	// deterministic candidates around the initial mean
+	std::vector< SearchPoint > points;
+	for ( index_t p = 0; p < point_count; ++p )
+	{
+		std::vector< double > values;
+		for ( const auto& par : mo.info() )
+			values.push_back( par.mean + 0.5 * ( double( ( 3 * p + values.size() ) % 5 ) - 2.0 ) * par.std );
+		points.emplace_back( mo.info(), values );
+	}
+
+	auto evaluate_all = [&]() {
+		std::vector< fitness_t > results;
+		for ( const auto& point : points )
+			results.push_back( mo.evaluate( point, xo::stop_token() ).value() );
+		return results;
+	};
+	auto rank_order = [&]( const std::vector< fitness_t >& results ) {
+		std::vector< index_t > order( results.size() );
+		std::iota( order.begin(), order.end(), index_t( 0 ) );
+		std::stable_sort( order.begin(), order.end(), [&]( index_t a, index_t b ) { return cost( results[ a ] ) < cost( results[ b ] ); } );
+		return order;
+	};
+
+	auto full = evaluate_all();
+	EvaluationPruning pruning( mu, mo.info().minimize() );
+	mo.SetEvaluationPruning( &pruning );
+	auto pruned = evaluate_all();
+	mo.SetEvaluationPruning( nullptr );
+
+	// the selected candidates and their results must be unaffected by pruning
+	auto full_order = rank_order( full );
+	auto pruned_order = rank_order( pruned );
+	for ( index_t i = 0; i < mu; ++i )
+	{
+		XO_CHECK( pruned_order[ i ] == full_order[ i ] );
+		XO_CHECK( pruned[ pruned_order[ i ] ] == full[ full_order[ i ] ] );
+	}
+
+	// other results are either complete or explicitly marked as pruned
+	for ( index_t i = 0; i < point_count; ++i )
+		XO_CHECK( pruned[ i ] == full[ i ] || EvaluationPruning::IsPrunedResult( pruned[ i ] ) );
+	XO_CHECK( pruning.GetPrunedCount() == size_t( std::count_if( pruned.begin(), pruned.end(), EvaluationPruning::IsPrunedResult ) ) );
+}
+
+
+XO_TEST_CASE( evaluate_par_files_test )
+{
+	// two files of a result folder with a scenario, and one file without scenario
+	auto opt = CreateExampleOptimizer( "Gait - H0918 - OpenSim4.scone", 0.2 );
+	opt->output_root = xo::temp_directory_path() / "SCONE/evaluate_par_files_test";
+	opt->PrepareOutputFolder();
+	auto& mo = dynamic_cast<ModelObjective&>( opt->GetObjective() );
+	const auto folder = opt->GetOutputFolder();
+	const auto missing_folder = folder / "missing_scenario";
+	xo::create_directories( missing_folder );
+	std::vector< path > files{ folder / "a.par", folder / "b.par", missing_folder / "c.par" };
+	std::vector< double > values;
+	for ( const auto& par : mo.info() )
+		values.push_back( par.mean + 0.5 * par.std );
+	std::ofstream( files[ 0 ].str() ) << SearchPoint( mo.info() );
+	std::ofstream( files[ 1 ].str() ) << SearchPoint( mo.info(), values );
+	std::ofstream( files[ 2 ].str() ) << SearchPoint( mo.info() );
+
+	// files are evaluated with their own objective, results must equal separate evaluation
+	auto results = EvaluateParFiles( files, 2 );
+	XO_CHECK( results.size() == files.size() );
+	for ( index_t i = 0; i < 2; ++i )
+	{
+		const auto& stats = results.get_child( files[ i ].str() );
+		auto expected = EvaluateParFile( mo, files[ i ], path() );
+		XO_CHECK( !stats.has_key( "error" ) );
+		XO_CHECK_MESSAGE( stats.get< double >( "fitness" ) == expected.get< double >( "fitness" ), files[ i ].filename().str() );
+	}
+	XO_CHECK( results.get_child( files[ 0 ].str() ).get< double >( "fitness" ) != results.get_child( files[ 1 ].str() ).get< double >( "fitness" ) );
+	const auto& missing = results.get_child( files[ 2 ].str() );
+	XO_CHECK( missing.has_key( "error" ) && !missing.has_key( "fitness" ) );
+
+	// one row per file, with the fixed columns followed by the measure report
+	const auto summary_file = folder / "evaluation_summary.txt";
+	WriteEvaluationSummary( results, summary_file );
+	std::vector< std::vector< String > > rows;
+	std::ifstream str( summary_file.str() );
+	for ( String line; std::getline( str, line ); )
+	{
+		auto& cells = rows.emplace_back( 1 );
+		for ( auto c : line )
+		{
+			if ( c == '\t' )
+				cells.emplace_back();
+			else cells.back().push_back( c );
+		}
+	}
+	XO_CHECK( rows.size() == files.size() + 1 );
+	const std::vector< String > fixed_headers{ "file", "fitness", "simulation_time", "realtime_factor", "error" };
+	const auto& headers = rows.front();
+	XO_CHECK( headers.size() > fixed_headers.size() && std::equal( fixed_headers.begin(), fixed_headers.end(), headers.begin() ) );
+	for ( auto it = headers.begin() + fixed_headers.size(); it != headers.end(); ++it )
+		XO_CHECK_MESSAGE( it->rfind( "result", 0 ) == 0, *it );
+	for ( index_t i = 0; i < files.size(); ++i )
+	{
+		const auto& row = rows[ i + 1 ];
+		XO_CHECK( row.size() == headers.size() );
+		XO_CHECK( row[ 0 ] == files[ i ].str() );
+		XO_CHECK( row[ 1 ] == results.get_child( files[ i ].str() ).get< String >( "fitness", "" ) );
+		XO_CHECK( row[ 4 ].empty() == ( i < 2 ) );
+	}
+	const auto& error_row = rows.back();
+	XO_CHECK( error_row[ 1 ].empty() && std::all_of( error_row.begin() + fixed_headers.size(), error_row.end(), []( const String& s ) { return s.empty(); } ) );
+}
+#endif
+
+#if SCONE_OPENSIM_3_ENABLED || SCONE_OPENSIM_4_ENABLED
+
+XO_TEST_CASE( segmented_evaluation_test )
+{
+	auto folder = GetFolder( SCONE_ROOT_FOLDER ) / "scenarios/UnitTests/OpenSim3";
+	auto scenario_pn = LoadScenario( folder / "Jump - Imitation.scone" );
+#if !SCONE_OPENSIM_3_ENABLED
+	// the model file is also supported by OpenSim 4
+	for ( auto& [ key, child ] : scenario_pn.get_child( "CmaOptimizer" ).get_child( "ImitationObjective" ) )
+		if ( key == "OpenSimModel" )
+			key = "ModelOpenSim4";
+#endif
+	auto opt = CreateOptimizer( scenario_pn, folder );
+
+	// the warm-up is shorter than a segment, so all but the first segment start from a truncated history
+	const size_t segment_count = 4;
+	const TimeInSeconds segment_warmup = 0.1;
+	scenario_pn.set_query( "CmaOptimizer.ImitationObjective.parallel_segments", to_str( segment_count ), '.' );
+	scenario_pn.set_query( "CmaOptimizer.ImitationObjective.segment_warmup", to_str( segment_warmup ), '.' );
+	auto seg_opt = CreateOptimizer( scenario_pn, folder );
+
+	auto& obj = dynamic_cast<ModelObjective&>( opt->GetObjective() );
+	auto& seg_obj = dynamic_cast<ModelObjective&>( seg_opt->GetObjective() );
+	XO_CHECK( seg_obj.GetDuration() / segment_count > segment_warmup );
+	auto point = SearchPoint( obj.info() );
+	auto fitness = obj.evaluate( point, xo::stop_token() ).value();
+
+	// states are set from data and feed-forward control depends only on time,
+	// so segmented results match up to summation order
+	for ( size_t threads : { 1, 2, 4 } )
+	{
+		seg_obj.SetSegmentThreads( threads );
+		auto seg_fitness = seg_obj.evaluate( point, xo::stop_token() ).value();
+		XO_CHECK_MESSAGE( std::abs( seg_fitness - fitness ) <= 1e-6 * std::abs( fitness ), stringf( "threads=%d: %g != %g", int( threads ), seg_fitness, fitness ) );
+	}
+}
+
+#endif
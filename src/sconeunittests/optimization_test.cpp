@@ -8,17 +8,144 @@
 
 #include "scone/core/Factories.h"
 #include "scone/core/math.h"
+#include "scone/core/Socket.h"
+#include "scone/core/string_tools.h"
 #include "scone/optimization/CmaOptimizerSpot.h"
+#include "scone/optimization/CmaPoolOptimizer.h"
+#include "scone/optimization/DistributedEvaluator.h"
+#include "scone/optimization/EvaluationScheduler.h"
 #include "scone/optimization/Objective.h"
 #include "scone/optimization/opt_tools.h"
 
+#include "spot/async_evaluator.h"
 #include "xo/filesystem/filesystem.h"
 #include "xo/filesystem/path.h"
 #include "xo/serialization/serialize.h"
 #include "xo/system/test_case.h"
 
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
 using namespace scone;
 
+namespace
+{
+	path GetOptimizationTestFolder()
+	{
+		return scone::GetFolder( scone::SCONE_ROOT_FOLDER ) / "resources/unittestdata/optimization_test";
+	}
+
+	// optimizations that should reach their target fitness, limited to two threads and 1000 generations
+	PropNode LoadTargetFitnessScenario( const String& filename )
+	{
+		PropNode pn = xo::load_file( GetOptimizationTestFolder() / filename );
+		pn.set_query( "Optimizer.max_threads", "2", '.' );
+		pn.set_query( "Optimizer.max_generations", "1000", '.' );
+		return pn;
+	}
+
+	// returns the best fitness
+	double RunTargetFitnessOptimization( Optimizer& o, const PropNode& pn )
+	{
+		o.output_root = xo::temp_directory_path() / "SCONE/optimization_test";
+		xo::log_unaccessed( pn );
+		o.Run();
+		return o.GetBestFitness();
+	}
+
+	// objective with a fixed evaluation cost, which logs its cost when an evaluation starts
+	class CostObjective : public Objective
+	{
+	public:
+		CostObjective( double cost, std::vector< double >& log, std::mutex& log_mutex ) :
+			Objective( PropNode(), path() ), cost_( cost ), log_( log ), log_mutex_( log_mutex ) {
+			info().add( ParInfo( "x", 0.0, 1.0, -10.0, 10.0 ) );
+		}
+		virtual fitness_t evaluate( const SearchPoint& point ) const override { return 1000 * cost_ + point.values()[ 0 ]; }
+		virtual result<fitness_t> evaluate( const SearchPoint& point, const xo::stop_token& st ) const override {
+			{
+				std::scoped_lock lock( log_mutex_ );
+				log_.push_back( cost_ );
+			}
+			return evaluate( point );
+		}
+		double GetCost() const { return cost_; }
+
+	private:
+		double cost_;
+		std::vector< double >& log_;
+		std::mutex& log_mutex_;
+	};
+
+	// objective that keeps its evaluation thread busy until it is released
+	class GateObjective : public Objective
+	{
+	public:
+		GateObjective( std::shared_future< void > release ) : Objective( PropNode(), path() ), release_( release ) {
+			info().add( ParInfo( "x", 0.0, 1.0, -10.0, 10.0 ) );
+		}
+		virtual fitness_t evaluate( const SearchPoint& point ) const override { return 0.0; }
+		virtual result<fitness_t> evaluate( const SearchPoint& point, const xo::stop_token& st ) const override {
+			started_.set_value();
+			release_.wait();
+			return evaluate( point );
+		}
+		void WaitUntilStarted() const { started_.get_future().wait(); }
+
+	private:
+		std::shared_future< void > release_;
+		mutable std::promise< void > started_;
+	};
+
+	// scheduler that uses the cost of CostObjective instead of measured durations, so that its schedule is deterministic
+	class FakeCostScheduler : public EvaluationScheduler
+	{
+	public:
+		using EvaluationScheduler::EvaluationScheduler;
+
+	protected:
+		virtual double GetEvaluationCost( const spot::objective& o, double duration ) const override {
+			auto* co = dynamic_cast<const CostObjective*>( &o );
+			return co ? co->GetCost() : duration;
+		}
+	};
+
+	template< typename F >
+	void WaitUntil( F condition )
+	{
+		while ( !condition() )
+			std::this_thread::yield();
+	}
+
+	// evaluator that counts the number of evaluated points
+	class CountingEvaluator : public spot::evaluator
+	{
+	public:
+		CountingEvaluator( size_t max_threads ) : eval_( max_threads ), count_( 0 ) {}
+		virtual std::vector< spot::result< spot::fitness_t > > evaluate( const spot::objective& o, const spot::search_point_vec& point_vec, const xo::stop_token& st, spot::priority_t prio ) override {
+			count_ += point_vec.size();
+			return eval_.evaluate( o, point_vec, st, prio );
+		}
+		size_t GetCount() const { return count_; }
+
+	private:
+		spot::async_evaluator eval_;
+		size_t count_;
+	};
+
+	spot::search_point_vec MakeSearchPoints( const Objective& o, size_t count )
+	{
+		spot::search_point_vec points;
+		for ( size_t i = 0; i < count; ++i )
+			points.emplace_back( o.info(), std::vector< double >{ double( i ) } );
+		return points;
+	}
+}
+
 XO_TEST_CASE( optimization_test )
 {
 	auto test_folder = scone::GetFolder( scone::SCONE_ROOT_FOLDER ) / "resources/unittestdata/optimization_test";
@@ -30,3 +157,261 @@ XO_TEST_CASE( optimization_test )
 
 	XO_CHECK_MESSAGE( o->GetBestFitness() < 1000.0, to_str( o->GetBestFitness() ) );
 }
+
+XO_TEST_CASE( surrogate_optimization_test )
+{
+	// run the same optimization with and without surrogate
+	size_t evaluations[ 2 ];
+	for ( int surrogate : { 0, 1 } )
+	{
+		PropNode pn = LoadTargetFitnessScenario( "ellipsoid_10_surrogate.xml" );
+		pn.set_query( "Optimizer.surrogate", to_str( surrogate ), '.' );
+		CountingEvaluator eval( 2 ); // CmaOptimizer uses the global evaluator, which ignores max_threads
+		CmaOptimizer o( FindFactoryProps( GetOptimizerFactory(), pn, "Optimizer" ).props(), pn, GetOptimizationTestFolder(), &eval );
+		auto best = RunTargetFitnessOptimization( o, pn );
+		evaluations[ surrogate ] = eval.GetCount();
+
+		// both must reach the target, with fewer candidates than lambda evaluated each generation if surrogate is enabled
+		XO_CHECK_MESSAGE( best < 1e-6, stringf( "surrogate=%d best=%g", surrogate, best ) );
+		if ( surrogate )
+			XO_CHECK( o.GetSurrogateEvaluator() && o.GetSurrogateEvaluator()->GetFraction() < 1.0 );
+	}
+
+	// the surrogate should require fewer evaluations to reach the same fitness
+	XO_CHECK_MESSAGE( evaluations[ 1 ] < evaluations[ 0 ], stringf( "%d >= %d", int( evaluations[ 1 ] ), int( evaluations[ 0 ] ) ) );
+}
+
+XO_TEST_CASE( async_optimization_test )
+{
+	const PropNode pn = LoadTargetFitnessScenario( "ellipsoid_10_async.xml" );
+	OptimizerUP o = CreateOptimizer( pn, GetOptimizationTestFolder() );
+	auto best = RunTargetFitnessOptimization( *o, pn );
+
+	XO_CHECK_MESSAGE( best < 1e-6, to_str( best ) );
+}
+
+XO_TEST_CASE( racing_optimization_test )
+{
+	const PropNode pn = xo::load_file( GetOptimizationTestFolder() / "ellipsoid_10_racing.xml" );
+	OptimizerUP o = CreateOptimizer( pn, GetOptimizationTestFolder() );
+	RunTargetFitnessOptimization( *o, pn );
+	auto& pool = dynamic_cast<CmaPoolOptimizer&>( *o );
+
+	std::vector< size_t > steps;
+	for ( const auto& opt : pool.optimizers() )
+		steps.push_back( opt->current_step() );
+	XO_CHECK( steps.size() == pool.optimizations_ );
+
+	// each round, the best 1 / racing_eta continue for racing_eta times as many generations
+	size_t survivors = pool.optimizations_, total = 0, prev_budget = 0;
+	for ( double budget = double( pool.racing_min_generations_ ); prev_budget < pool.max_generations; budget *= pool.racing_eta_ )
+	{
+		auto round_budget = std::min( size_t( budget ), pool.max_generations );
+		auto count = size_t( std::count_if( steps.begin(), steps.end(), [&]( size_t s ) { return s >= round_budget; } ) );
+		XO_CHECK_MESSAGE( count == survivors, "budget=" + to_str( round_budget ) + " count=" + to_str( count ) );
+		total += survivors * ( round_budget - prev_budget );
+		prev_budget = round_budget;
+		survivors = std::max( size_t( 1 ), size_t( std::ceil( survivors / pool.racing_eta_ ) ) );
+	}
+	XO_CHECK_MESSAGE( std::accumulate( steps.begin(), steps.end(), size_t( 0 ) ) == total, to_str( total ) );
+}
+
+XO_TEST_CASE( resume_optimization_test )
+{
+	auto test_folder = scone::GetFolder( scone::SCONE_ROOT_FOLDER ) / "resources/unittestdata/optimization_test";
+	PropNode pn = xo::load_file( test_folder / "ellipsoid_10_async.xml" );
+	pn.set_query( "Optimizer.max_generations", "20", '.' );
+	pn.set_query( "Optimizer.checkpoint_interval", "10", '.' );
+	OptimizerUP o = CreateOptimizer( pn, test_folder );
+	o->output_root = xo::temp_directory_path() / "SCONE/optimization_test";
+	o->Run();
+
+	// continue in the same folder, from the checkpoint written when the first run stopped
+	auto resume_pn = LoadResumeScenario( o->GetOutputFolder() );
+	resume_pn.set_query( "AsyncCmaOptimizer.max_generations", "40", '.' );
+	OptimizerUP r = CreateOptimizer( resume_pn, o->GetOutputFolder() );
+	XO_CHECK( dynamic_cast<EsOptimizer&>( *r ).GetGenerationOffset() == 20 );
+	r->Run();
+
+	XO_CHECK( r->GetOutputFolder() == o->GetOutputFolder() );
+	XO_CHECK_MESSAGE( r->GetBestFitness() < o->GetBestFitness(), to_str( r->GetBestFitness() ) );
+}
+
+#if SCONE_SPOT_OPTIMIZER_STATE_ENABLED
+namespace
+{
+	void CheckResumeDeterminism( xo::test::test_case& XO_ACTIVE_TEST_CASE, const String& filename )
+	{
+		// resuming after n generations must give the same result as running n + m generations straight through
+		const size_t n = 20, m = 30;
+		PropNode pn = xo::load_file( GetOptimizationTestFolder() / filename );
+		pn.set_query( "Optimizer.max_generations", to_str( n + m ), '.' );
+		OptimizerUP straight = CreateOptimizer( pn, GetOptimizationTestFolder() );
+		RunTargetFitnessOptimization( *straight, pn );
+
+		pn.set_query( "Optimizer.max_generations", to_str( n ), '.' );
+		pn.set_query( "Optimizer.checkpoint_interval", to_str( n ), '.' );
+		OptimizerUP first = CreateOptimizer( pn, GetOptimizationTestFolder() );
+		RunTargetFitnessOptimization( *first, pn );
+
+		auto resume_pn = LoadResumeScenario( first->GetOutputFolder() );
+		resume_pn.set_query( "CmaOptimizer.max_generations", to_str( n + m ), '.' );
+		OptimizerUP resumed = CreateOptimizer( resume_pn, first->GetOutputFolder() );
+		resumed->Run();
+
+		auto& s = dynamic_cast<CmaOptimizer&>( *straight );
+		auto& r = dynamic_cast<CmaOptimizer&>( *resumed );
+		XO_CHECK( r.GetGenerationOffset() == n );
+		XO_CHECK( r.GetGenerationOffset() + r.current_step() == s.current_step() );
+		XO_CHECK_MESSAGE( r.best_fitness() == s.best_fitness(), to_str( r.best_fitness() ) + " != " + to_str( s.best_fitness() ) );
+		XO_CHECK( r.current_mean() == s.current_mean() );
+		XO_CHECK( r.current_std() == s.current_std() );
+	}
+}
+
+XO_TEST_CASE( resume_determinism_test )
+{
+	CheckResumeDeterminism( XO_ACTIVE_TEST_CASE, "schwefel_5.xml" );
+	CheckResumeDeterminism( XO_ACTIVE_TEST_CASE, "ellipsoid_10_surrogate.xml" ); // includes the surrogate archive
+}
+#endif
+
+XO_TEST_CASE( distributed_evaluation_test )
+{
+	// two objectives with different scenarios share one evaluator, like the optimizations in a CmaPoolOptimizer
+	auto test_folder = GetOptimizationTestFolder();
+	const PropNode pn1 = xo::load_file( test_folder / "ellipsoid_10_async.xml" );
+	const PropNode pn2 = xo::load_file( test_folder / "schwefel_5.xml" );
+	OptimizerUP o1 = CreateOptimizer( pn1, test_folder );
+	OptimizerUP o2 = CreateOptimizer( pn2, test_folder );
+	const auto& obj1 = o1->GetObjective();
+	const auto& obj2 = o2->GetObjective();
+	auto make_points = []( const Objective& obj ) {
+		spot::search_point_vec points;
+		for ( int i = 0; i < 16; ++i )
+		{
+			std::vector< double > values;
+			for ( const auto& par : obj.info() )
+				values.push_back( par.mean + par.std * std::sin( i + 0.1 * values.size() ) );
+			points.emplace_back( obj.info(), values );
+		}
+		return points;
+	};
+	auto points1 = make_points( obj1 );
+	auto points2 = make_points( obj2 );
+
+	const String host = "127.0.0.1";
+	auto de = std::make_unique< DistributedEvaluator >( 0, 10.0 );
+	de->AddScenario( obj1, pn1, test_folder );
+	de->AddScenario( obj2, pn2, test_folder );
+	const int port = de->GetPort();
+	XO_CHECK( port != 0 );
+	auto results1 = std::async( std::launch::async, [&]() { return de->evaluate( obj1, points1, xo::stop_token(), spot::priority_t() ); } );
+	auto results2 = std::async( std::launch::async, [&]() { return de->evaluate( obj2, points2, xo::stop_token(), spot::priority_t() ); } );
+
+	// this worker disconnects as soon as it receives work, which must then be evaluated by the others
+	{
+		Socket s = Socket::Connect( host, port );
+		for ( int i = 0; i < 100 && !s.IsValid(); ++i, s = Socket::Connect( host, port ) )
+			std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+		XO_CHECK( s.IsValid() );
+		const uint32_t hello[] = { 1, sizeof( uint32_t ), 4 }; // message type, payload size, thread count
+		XO_CHECK( s.Send( hello, sizeof( hello ) ) );
+		uint32_t header[ 2 ];
+		XO_CHECK( s.ReceiveAll( header, sizeof( header ) ) );
+	}
+
+	std::vector< std::thread > workers;
+	for ( int i = 0; i < 2; ++i )
+	{
+		workers.emplace_back( [&]() {
+			try { RunDistributedWorker( host, port, 2, 10.0 ); }
+			catch ( std::exception& e ) { log::error( e.what() ); }
+		} );
+	}
+
+	auto check_results = [&]( const Objective& obj, const spot::search_point_vec& points, const std::vector< spot::result< spot::fitness_t > >& r ) {
+		XO_CHECK( r.size() == points.size() );
+		for ( size_t i = 0; i < r.size(); ++i )
+		{
+			auto expected = obj.evaluate( points[ i ], xo::stop_token() );
+			XO_CHECK_MESSAGE( r[ i ] && r[ i ].value() == expected.value(), to_str( i ) );
+		}
+	};
+	check_results( obj1, points1, results1.get() );
+	check_results( obj2, points2, results2.get() );
+
+	// closing the connections stops the workers
+	de.reset();
+	for ( auto& w : workers )
+		w.join();
+}
+
+XO_TEST_CASE( evaluation_scheduler_test )
+{
+	std::vector< double > log;
+	std::mutex log_mutex;
+	std::vector< u_ptr< CostObjective > > objectives;
+	for ( auto cost : { 1.0, 4.0, 2.0 } )
+		objectives.emplace_back( std::make_unique< CostObjective >( cost, log, log_mutex ) );
+
+	// a single thread, so that evaluations start in the order of the schedule
+	FakeCostScheduler scheduler( 1, xo::thread_priority::lowest );
+	for ( auto& o : objectives )
+		scheduler.evaluate( *o, MakeSearchPoints( *o, 1 ), xo::stop_token(), spot::priority_t() ); // predict costs
+	for ( auto& o : objectives )
+		XO_CHECK( scheduler.GetPredictedCost( *o ) == o->GetCost() );
+
+	// all batches are queued while the thread is busy, after which the most expensive evaluations must start first
+	std::promise< void > release;
+	GateObjective gate( release.get_future().share() );
+	auto blocked = std::async( std::launch::async, [&]() { return scheduler.evaluate( gate, MakeSearchPoints( gate, 1 ), xo::stop_token(), spot::priority_t() ); } );
+	gate.WaitUntilStarted();
+	const size_t batch_size = 4;
+	std::vector< spot::search_point_vec > points;
+	std::vector< std::future< std::vector< spot::result< spot::fitness_t > > > > results;
+	for ( auto& o : objectives )
+		points.push_back( MakeSearchPoints( *o, batch_size ) );
+	log.clear();
+	for ( size_t i = 0; i < objectives.size(); ++i )
+		results.push_back( std::async( std::launch::async, [&, i]() { return scheduler.evaluate( *objectives[ i ], points[ i ], xo::stop_token(), spot::priority_t() ); } ) );
+	WaitUntil( [&]() { return scheduler.GetPendingTaskCount() == objectives.size() * batch_size; } );
+	release.set_value();
+	XO_CHECK( blocked.get().front() );
+
+	// results must equal sequential evaluation
+	for ( size_t i = 0; i < objectives.size(); ++i )
+	{
+		auto r = results[ i ].get();
+		XO_CHECK( r.size() == batch_size );
+		for ( size_t j = 0; j < r.size(); ++j )
+			XO_CHECK( r[ j ] && r[ j ].value() == objectives[ i ]->evaluate( points[ i ][ j ] ) );
+	}
+	XO_CHECK( log.size() == objectives.size() * batch_size );
+	XO_CHECK_MESSAGE( std::is_sorted( log.rbegin(), log.rend() ), "Evaluations did not start in order of cost" );
+
+	// canceling returns errors for evaluations that were not started
+	std::promise< void > cancel_release;
+	GateObjective cancel_gate( cancel_release.get_future().share() );
+	auto cancel_blocked = std::async( std::launch::async, [&]() { return scheduler.evaluate( cancel_gate, MakeSearchPoints( cancel_gate, 1 ), xo::stop_token(), spot::priority_t() ); } );
+	cancel_gate.WaitUntilStarted();
+	log.clear();
+	xo::stop_source stop;
+	const size_t cancel_size = 10;
+	auto cancel_points = MakeSearchPoints( *objectives[ 1 ], cancel_size );
+	auto canceled = std::async( std::launch::async, [&]() { return scheduler.evaluate( *objectives[ 1 ], cancel_points, stop.get_token(), spot::priority_t() ); } );
+	WaitUntil( [&]() { return scheduler.GetPendingTaskCount() == cancel_size; } );
+	stop.request_stop();
+	auto r = canceled.get();
+	XO_CHECK( r.size() == cancel_size );
+	XO_CHECK( std::none_of( r.begin(), r.end(), []( const auto& cr ) { return bool( cr ); } ) );
+	XO_CHECK( scheduler.GetPendingTaskCount() == 0 );
+	cancel_release.set_value();
+	XO_CHECK( cancel_blocked.get().front() );
+	XO_CHECK( log.empty() );
+
+	// removed clients lose their statistics, so that a new objective at the same address starts fresh
+	scheduler.RemoveClient( *objectives[ 0 ] );
+	XO_CHECK( scheduler.GetUtilization( *objectives[ 0 ] ) == 0.0 );
+	XO_CHECK( scheduler.GetPredictedCost( *objectives[ 0 ] ) != objectives[ 0 ]->GetCost() );
+}
@@ -0,0 +1,391 @@
+/*
+** storage_test.cpp
+**
+** Copyright (C) 2013-2019 Thomas Geijtenbeek and contributors. All rights reserved.
+**
+** This file is part of SCONE. For more information, see http://scone.software.
+*/
+
+#include "storage_test.h"
+#include "scone/core/Storage.h"
+#include "scone/core/HasData.h"
+#include "scone/core/ReferenceStorage.h"
+#include "scone/core/StorageIo.h"
+#include "scone/core/StorageStreamWriter.h"
+#include "scone/core/Log.h"
+#include "scone/core/string_tools.h"
+#include "scone/model/SensorDelayBuffer.h"
+
+#include "xo/system/test_case.h"
+#include "xo/time/timer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <vector>
+
+using namespace scone;
+
+XO_TEST_CASE( storage_test )
+{
+	Storage<> sto;
+	sto.AddChannel( "a" );
+	for ( index_t i = 0; i < 1000; ++i )
+	{
+		auto& f = sto.AddFrame( 0.01 * i );
+		f[ 0 ] = Real( i );
+		f[ "b" ] = Real( 2 * i );
+	}
+	sto.AddChannel( "c", 7.0 );
+
+	XO_CHECK( sto.GetFrameCount() == 1000 );
+	XO_CHECK( sto.GetChannelCount() == 3 );
+	XO_CHECK( sto.GetFrame( 999 )[ "b" ] == 1998.0 );
+	XO_CHECK( sto.GetFrame( 500 )[ 2 ] == 7.0 );
+
+	// copies must refer to their own data
+	Storage<> copy = sto;
+	sto.GetFrame( 10 )[ 0 ] = -1.0;
+	XO_CHECK( copy.GetFrame( 10 )[ 0 ] == 10.0 );
+
+	// channel views and channel data
+	auto b = copy.GetChannel( 1 );
+	auto b_data = copy.GetChannelData( 1 );
+	XO_CHECK( b.size() == copy.GetFrameCount() && b_data.size() == copy.GetFrameCount() );
+	for ( index_t i = 0; i < b.size(); i += 97 )
+		XO_CHECK( b[ i ] == b_data[ i ] && b[ i ] == copy.GetFrame( i )[ 1 ] );
+
+	// slicing and interpolation
+	auto slice = copy.CopySlice( 0, 0, 10 );
+	XO_CHECK( slice.GetFrameCount() == 100 );
+	XO_CHECK( slice.GetFrame( 3 )[ "b" ] == 60.0 );
+	XO_CHECK( std::abs( copy.ComputeInterpolatedValue( 5.005, 0 ) - 500.5 ) < 1e-9 );
+
+	// cursors must match ComputeInterpolatedFrame, for small steps, jumps and decreasing times
+	auto cursor = copy.GetCursor();
+	const std::vector< index_t > channels = { 2, 0 };
+	Real values[ 3 ];
+	for ( double t : { -1.0, 0.0, 0.003, 0.01, 0.0149, 0.5, 0.5, 7.777, 3.001, 3.0, 9.99, 12.0, 0.004 } )
+	{
+		auto f = copy.ComputeInterpolatedFrame( t );
+		auto cf = cursor.Seek( t );
+		XO_CHECK( cf.lower_frame == f.lower_frame && cf.upper_frame == f.upper_frame && cf.upper_weight == f.upper_weight );
+		cursor.Interpolate( t, channels, values );
+		XO_CHECK( values[ 0 ] == f.value( 2 ) && values[ 1 ] == f.value( 0 ) );
+		cursor.Interpolate( t, values );
+		XO_CHECK( values[ 0 ] == f.value( 0 ) && values[ 1 ] == f.value( 1 ) && values[ 2 ] == f.value( 2 ) );
+	}
+}
+
+XO_TEST_CASE( store_data_channels_test )
+{
+	// cached channel indices must be resolved again after the storage is cleared, even if it has new channels
+	Storage<> sto;
+	StoreDataChannels ch;
+	const String a = "a", b = "b";
+	ch.Begin( sto.AddFrame( 0.0 ) ).Set( a, 1.0 );
+	auto layout_id = sto.GetLayoutId();
+	sto.Clear();
+	XO_CHECK( sto.GetLayoutId() != layout_id );
+
+	auto& f = sto.AddFrame( 0.0 );
+	f[ b ] = 2.0;
+	ch.Begin( f ).Set( a, 3.0 );
+	XO_CHECK( sto.GetChannelCount() == 2 );
+	XO_CHECK( f[ b ] == 2.0 && f[ a ] == 3.0 );
+}
+
+XO_TEST_CASE( store_data_channels_label_test )
+{
+	// labels are matched by value, a string that changes its value at the same address gets its own channel
+	Storage<> sto;
+	StoreDataChannels ch;
+	String label = "a";
+	ch.Begin( sto.AddFrame( 0.0 ) ).Set( label, 1.0 );
+	label = "b";
+	auto& f = sto.AddFrame( 1.0 );
+	ch.Begin( f ).Set( label, 2.0 );
+	XO_CHECK( sto.GetChannelCount() == 2 );
+	XO_CHECK( f[ "b" ] == 2.0 && f[ "a" ] == 0.0 );
+
+	// equal labels from different strings use the resolved channel, without adding channels
+	ch.Begin( sto.AddFrame( 2.0 ) ).Set( String( "b" ), 3.0 );
+	ch.Set( String( "pre" ), ".post", 4.0 );
+	const String pre = "pre";
+	ch.Begin( sto.AddFrame( 3.0 ) ).Set( "b", 5.0 );
+	ch.Set( pre, ".post", 6.0 );
+	XO_CHECK( sto.GetChannelCount() == 3 );
+	XO_CHECK( sto.GetFrame( 2 )[ "b" ] == 3.0 && sto.GetFrame( 2 )[ "pre.post" ] == 4.0 );
+	XO_CHECK( sto.GetFrame( 3 )[ "b" ] == 5.0 && sto.GetFrame( 3 )[ "pre.post" ] == 6.0 );
+}
+
+namespace
+{
+	void StorageBenchmark( xo::test::test_case& XO_ACTIVE_TEST_CASE )
+	{
+		const size_t channels = 2000;
+		const size_t frames = 5000;
+
+		// reference: one heap-allocated row per frame
+		xo::timer t;
+		std::vector< std::unique_ptr< std::vector< Real > > > rows;
+		for ( index_t f = 0; f < frames; ++f )
+		{
+			rows.push_back( std::make_unique< std::vector< Real > >( channels ) );
+			for ( index_t c = 0; c < channels; ++c )
+				( *rows.back() )[ c ] = Real( f + c );
+		}
+		auto rows_fill_time = t();
+		Real rows_sum = 0.0;
+		for ( index_t c = 0; c < channels; ++c )
+			for ( index_t f = 0; f < frames; ++f )
+				rows_sum += ( *rows[ f ] )[ c ];
+		auto rows_scan_time = t() - rows_fill_time;
+		auto rows_bytes = frames * ( sizeof( std::unique_ptr< std::vector< Real > > ) + sizeof( std::vector< Real > ) + channels * sizeof( Real ) );
+
+		// columnar Storage
+		std::vector< String > labels;
+		for ( index_t c = 0; c < channels; ++c )
+			labels.push_back( "channel" + std::to_string( c ) );
+		auto sto_start_time = t();
+		Storage<> sto( labels );
+		for ( index_t f = 0; f < frames; ++f )
+		{
+			auto& frame = sto.AddFrame( Real( f ) );
+			for ( index_t c = 0; c < channels; ++c )
+				frame[ c ] = Real( f + c );
+		}
+		auto sto_fill_time = t() - sto_start_time;
+		Real sto_sum = 0.0;
+		for ( index_t c = 0; c < channels; ++c )
+		{
+			auto channel = sto.GetChannel( c );
+			for ( index_t ci = 0; ci < channel.GetChunkCount(); ++ci )
+			{
+				auto* data = channel.GetChunkData( ci );
+				for ( index_t i = 0; i < channel.GetChunkSize( ci ); ++i )
+					sto_sum += data[ i ];
+			}
+		}
+		auto sto_scan_time = t() - sto_start_time - sto_fill_time;
+		auto sto_bytes = sto.GetFrameCapacity() * channels * sizeof( Real ) + frames * sizeof( Storage<>::Frame );
+
+		XO_CHECK( rows_sum == sto_sum );
+		log::info( "Storage per-frame: allocs=", frames + 1, " estimated_bytes=", rows_bytes, " fill=", rows_fill_time, " scan=", rows_scan_time );
+		log::info( "Storage columnar:  allocs=", sto.GetFrameCapacity() / Storage<>::chunk_frame_count, " estimated_bytes=", sto_bytes, " fill=", sto_fill_time, " scan=", sto_scan_time );
+	}
+}
+
+void scone::add_storage_benchmark()
+{
+	xo::test::add_test_case( "storage_benchmark", StorageBenchmark );
+}
+
+XO_TEST_CASE( storage_binary_test )
+{
+	Storage<> sto;
+	sto.AddChannel( "a" );
+	sto.AddChannel( "b.c" );
+	for ( index_t i = 0; i < 1000; ++i )
+	{
+		auto& f = sto.AddFrame( 0.001 * i );
+		f[ 0 ] = 1000.0 + std::sin( 0.01 * i );
+		f[ 1 ] = Real( i );
+	}
+
+	for ( auto enc : { StorageEncoding::Float64, StorageEncoding::Float32, StorageEncoding::DeltaFloat32 } )
+	{
+		const xo::path file( "storage_binary_test.stob" );
+		WriteStorageBinary( sto, file, enc );
+		Storage<> sto2;
+		ReadStorage( sto2, file );
+		XO_CHECK( sto2.GetFrameCount() == sto.GetFrameCount() );
+		XO_CHECK( sto2.GetLabels() == sto.GetLabels() );
+		XO_CHECK( sto2.GetFrame( 999 ).GetTime() == sto.GetFrame( 999 ).GetTime() );
+		Real max_error = 0.0;
+		for ( index_t i = 0; i < sto.GetFrameCount(); ++i )
+			for ( index_t c = 0; c < sto.GetChannelCount(); ++c )
+				max_error = std::max( max_error, std::abs( sto2.GetValue( i, c ) - sto.GetValue( i, c ) ) );
+		XO_CHECK( enc == StorageEncoding::Float64 ? max_error == 0.0 : max_error < 1e-3 );
+
+		if ( enc != StorageEncoding::DeltaFloat32 )
+		{
+			StorageFileView view( file );
+			XO_CHECK( view.GetFrameCount() == sto.GetFrameCount() && view.GetChannelCount() == 2 );
+			XO_CHECK( view.TryGetChannelIndex( "b.c" ) == 1 );
+			XO_CHECK( view.GetValue( 777, 1 ) == 777.0 );
+		}
+		std::remove( file.c_str() );
+	}
+}
+
+XO_TEST_CASE( storage_binary_header_test )
+{
+	Storage<> sto;
+	sto.AddChannel( "a" );
+	sto.AddChannel( "b" );
+	for ( index_t i = 0; i < 100; ++i )
+		sto.AddFrame( 0.01 * i )[ 0 ] = Real( i );
+
+	// frame_count, channel_count and label_size that do not fit the file must be rejected, including values that overflow
+	const xo::path file( "storage_binary_header_test.stob" );
+	for ( std::streamoff offset : { 16, 24, 40 } )
+	{
+		for ( std::uint64_t value : { std::uint64_t( 101 ), std::uint64_t( 1 ) << 62, ~std::uint64_t( 0 ) } )
+		{
+			WriteStorageBinary( sto, file, StorageEncoding::Float32 );
+			{
+				std::fstream str( file.str(), std::ios::in | std::ios::out | std::ios::binary );
+				str.seekp( offset );
+				str.write( reinterpret_cast<const char*>( &value ), sizeof( value ) );
+			}
+			bool rejected = false;
+			try { StorageFileView view( file ); }
+			catch ( std::exception& ) { rejected = true; }
+			XO_CHECK_MESSAGE( rejected, stringf( "offset=%d value=%llu", int( offset ), (unsigned long long)value ) );
+		}
+	}
+	std::remove( file.c_str() );
+}
+
+XO_TEST_CASE( storage_stream_test )
+{
+	Storage<> sto;
+	sto.AddChannel( "a" );
+	for ( index_t i = 0; i < 600; ++i )
+		sto.AddFrame( 0.01 * i )[ 0 ] = Real( i );
+
+	sto.AddChannel( "b.activation" );
+	for ( index_t i = 0; i < 600; ++i )
+		sto.GetFrame( i )[ 1 ] = 0.001 * i + 1e-9;
+
+	// all outputs are written chunk by chunk, channels that are added after streaming has started are skipped
+	const xo::path file( "storage_stream_test.sto" ), binary_file( "storage_stream_test.stob" ), channel_file( "storage_stream_test.channels.txt" );
+	{
+		StorageStreamWriter writer( file, "test" );
+		writer.AddBinaryOutput( binary_file );
+		writer.AddChannelOutput( channel_file, "*.activation" );
+		writer.Write( sto, 0, 300 );
+		sto.AddChannel( "c" );
+		writer.Write( sto, 300, 600 );
+		writer.Finish();
+	}
+
+	Storage<> sto2;
+	ReadStorageSto( sto2, file );
+	XO_CHECK( sto2.GetFrameCount() == 600 && sto2.GetChannelCount() == 2 );
+	XO_CHECK( sto2.GetFrame( 599 )[ 0 ] == 599.0 );
+
+	// binary output is lossless
+	Storage<> sto3;
+	ReadStorageBinary( sto3, binary_file );
+	XO_CHECK( sto3.GetFrameCount() == 600 && sto3.GetChannelCount() == 2 );
+	bool equal = true;
+	for ( index_t i = 0; i < 600; ++i )
+		equal &= sto3.GetFrame( i ).GetTime() == sto.GetFrame( i ).GetTime() && sto3.GetFrame( i )[ 1 ] == sto.GetFrame( i )[ 1 ];
+	XO_CHECK( equal );
+
+	Storage<> sto4;
+	ReadStorageTxt( sto4, channel_file );
+	XO_CHECK( sto4.GetFrameCount() == 600 && sto4.GetChannelCount() == 1 && sto4.GetLabels()[ 0 ] == "b.activation" );
+
+	std::remove( file.c_str() );
+	std::remove( binary_file.c_str() );
+	std::remove( channel_file.c_str() );
+}
+
+XO_TEST_CASE( sensor_delay_buffer_test )
+{
+	// delayed values must match interpolated values from a full Storage
+	Storage<> sto;
+	sto.AddChannel( "a" );
+	SensorDelayBuffer buf;
+	buf.AddChannel( "a" );
+	buf.RequireDelay( 0.02 );
+	TimeInSeconds t = 0.0;
+	for ( index_t i = 0; i < 10000; ++i )
+	{
+		sto.AddFrame( t )[ 0 ] = std::sin( 7 * t );
+		buf.AddFrame( t )[ 0 ] = std::sin( 7 * t );
+		for ( auto delay : { 0.0, 0.005, 0.0123, 0.02 } )
+			XO_CHECK( buf.GetInterpolatedValue( t - delay, 0 ) == sto.GetInterpolatedValue( t - delay, 0 ) );
+		t += 0.0005 + 0.0005 * ( i % 13 ) / 13.0;
+	}
+	XO_CHECK( buf.GetFrameCount() == sto.GetFrameCount() );
+}
+
+XO_TEST_CASE( reference_storage_shared_frames_test )
+{
+	Storage<> sto;
+	sto.AddChannel( "q" );
+	sto.AddChannel( "s.a" );
+	sto.AddChannel( "s.b" );
+	for ( index_t i = 0; i < 200; ++i )
+	{
+		auto& f = sto.AddFrame( 0.005 * i );
+		f[ 0 ] = Real( i );
+		f[ 1 ] = std::sin( 0.05 * i );
+		f[ 2 ] = std::cos( 0.03 * i );
+	}
+	const xo::path file( "reference_storage_test.sto" );
+	WriteStorageSto( sto, file, "test" );
+
+	// references that are created concurrently read the file once and share its data
+	std::vector< std::future< u_ptr< ReferenceStorage > > > futures;
+	for ( index_t i = 0; i < 4; ++i )
+		futures.push_back( std::async( std::launch::async, [&]() { return std::make_unique< ReferenceStorage >( file, 0.005 ); } ) );
+	std::vector< u_ptr< ReferenceStorage > > refs;
+	for ( auto& f : futures )
+		refs.push_back( f.get() );
+	for ( auto& r : refs )
+	{
+		XO_CHECK( &r->GetStorage() == &refs[ 0 ]->GetStorage() );
+		XO_CHECK( r->GetFrame( 0.5 ).values && r->GetFrame( 0.5 ).values == refs[ 0 ]->GetFrame( 0.5 ).values );
+	}
+	const auto& ref_sto = refs[ 0 ]->GetStorage();
+	XO_CHECK( ref_sto.GetFrameCount() == 200 && ref_sto.GetChannelCount() == 3 );
+
+	// sensor frames after the first, as created by each ImitationObjective
+	auto make_buffer = [&]( const ReferenceStorage& ref ) {
+		std::vector< index_t > channels{ ref->TryGetChannelIndex( "s.a" ), ref->TryGetChannelIndex( "s.b" ) };
+		auto frames = std::make_shared< SensorDelayBuffer::SharedFrames >();
+		for ( index_t fidx = 1; fidx < ref->GetFrameCount(); ++fidx )
+		{
+			frames->times.push_back( ref->GetFrame( fidx ).GetTime() );
+			for ( auto c : channels )
+				frames->values.push_back( ref->GetFrame( fidx )[ c ] );
+		}
+		auto buf = std::make_unique< SensorDelayBuffer >();
+		buf->AddChannel( "s.a" );
+		buf->AddChannel( "s.b" );
+		buf->KeepAllFrames();
+		auto* values = buf->AddFrame( ref->GetFrame( 0 ).GetTime() );
+		for ( index_t i = 0; i < channels.size(); ++i )
+			values[ i ] = ref->GetFrame( 0 )[ channels[ i ] ];
+		buf->AppendSharedFrames( frames );
+		return buf;
+	};
+	auto buf1 = make_buffer( *refs[ 0 ] );
+	auto buf2 = make_buffer( *refs[ 1 ] );
+	XO_CHECK( buf1->GetFrameCount() == ref_sto.GetFrameCount() && buf2->GetFrameCount() == ref_sto.GetFrameCount() );
+
+	// both objectives must get identical sensor values, which match the reference data
+	auto cursor = ref_sto.GetCursor();
+	bool equal = true;
+	for ( index_t i = 0; i < 400; ++i )
+	{
+		const TimeInSeconds t = 0.0024 * i;
+		const auto frame = cursor.Seek( t );
+		for ( index_t c = 0; c < 2; ++c )
+		{
+			const auto v = buf1->GetInterpolatedValue( t, c );
+			equal &= v == buf2->GetInterpolatedValue( t, c );
+			equal &= std::abs( v - frame.value( c + 1 ) ) < 1e-12;
+		}
+	}
+	XO_CHECK( equal );
+	std::remove( file.c_str() );
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace scone
+{
+	/// Adds storage_benchmark, which allocates a large Storage and is therefore not part of the default test run
+	void add_storage_benchmark();
+}